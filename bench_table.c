@@ -0,0 +1,66 @@
+#include "bench_table.h"
+
+/*
+ * Benchmark result table: see bench_table.h.
+ */
+
+_Static_assert(sizeof(bench_table_t) <= 0x400u, "bench_table_t must fit the 1 KB link.ld slot");
+
+volatile bench_table_t bench_table __attribute__((section(".bench_table")));
+
+void bench_table_begin(uint32_t cycle_source, uint32_t counter_overhead, uint32_t run_id) {
+    bench_table.done = 0u;
+    bench_table.count = 0u;
+    bench_table.capacity = BENCH_TABLE_MAX;
+    bench_table.version = BENCH_TABLE_VERSION;
+    bench_table.cycle_source = cycle_source;
+    bench_table.counter_overhead = counter_overhead;
+    bench_table.run_id = run_id;
+    bench_table.magic = BENCH_TABLE_MAGIC;
+}
+
+static uint32_t less_overhead(uint32_t cycles) {
+    uint32_t overhead = bench_table.counter_overhead;
+    return (cycles > overhead) ? (cycles - overhead) : 0u;
+}
+
+void bench_table_add(uint32_t id, const char *name, uint32_t *samples, uint32_t n,
+                     uint32_t mmio_stores, uint32_t mmio_bytes) {
+    uint32_t slot = bench_table.count;
+    volatile bench_record_t *r;
+    uint32_t median;
+
+    if (slot >= BENCH_TABLE_MAX || n == 0u) {
+        return;
+    }
+
+    // Insertion sort: n is a handful of repetitions
+    for (uint32_t i = 1; i < n; ++i) {
+        uint32_t v = samples[i];
+        uint32_t j = i;
+        while (j > 0u && samples[j - 1u] > v) {
+            samples[j] = samples[j - 1u];
+            --j;
+        }
+        samples[j] = v;
+    }
+    median = samples[n >> 1];
+    if ((n & 1u) == 0u) {
+        median = (samples[(n >> 1) - 1u] >> 1) + (median >> 1) + (samples[(n >> 1) - 1u] & median & 1u);
+    }
+
+    r = &bench_table.records[slot];
+    r->id = id;
+    r->name = name;
+    r->iterations = n;
+    r->cycles_min = less_overhead(samples[0]);
+    r->cycles_median = less_overhead(median);
+    r->cycles_max = less_overhead(samples[n - 1u]);
+    r->mmio_stores = mmio_stores;
+    r->mmio_bytes = mmio_bytes;
+    bench_table.count = slot + 1u;
+}
+
+void bench_table_end(void) {
+    bench_table.done = 1u;
+}
@@ -0,0 +1,66 @@
+#ifndef BENCH_TABLE_H
+#define BENCH_TABLE_H
+
+#include <stdint.h>
+
+/*
+ * Benchmark result table.
+ *
+ * One fixed-format table per program, placed by link.ld in the last 1 KB
+ * of RAM (BENCH_TABLE_ADDR, NOLOAD), so every benchmark reports the same
+ * way and the host can find it without symbols: tools/rvsim --bench-out
+ * writes it as CSV at exit, and tools/bench_compare reads it from that CSV
+ * or straight from a RAM dump (.bin / .mem) and compares two runs.
+ *
+ * A program calls bench_table_begin once, bench_table_add per benchmark
+ * with the per-iteration cycle samples, and bench_table_end when every
+ * record is final. Names are pointers into the program image, so a host
+ * reading a full RAM dump can resolve them.
+ */
+
+#define BENCH_TABLE_ADDR        0x7C00u         /* link.ld: ORIGIN(RAM) + LENGTH(RAM) - 0x400 */
+#define BENCH_TABLE_MAGIC       0x48434E42u     /* "BNCH" */
+#define BENCH_TABLE_VERSION     1u
+#define BENCH_TABLE_MAX         31u
+
+// header.cycle_source
+#define BENCH_SOURCE_CYCLE_CSR  0u              /* Zicntr cycle */
+#define BENCH_SOURCE_NONE       1u              /* no counter: cycles read 0 */
+
+typedef struct {
+    uint32_t id;                /* stable across builds; the comparison key */
+    const char *name;
+    uint32_t iterations;
+    uint32_t cycles_min;        /* per iteration, counter overhead removed */
+    uint32_t cycles_median;
+    uint32_t cycles_max;
+    uint32_t mmio_stores;       /* per iteration */
+    uint32_t mmio_bytes;        /* per iteration */
+} bench_record_t;
+
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t count;             /* records in use */
+    uint32_t capacity;          /* BENCH_TABLE_MAX */
+    uint32_t done;              /* 1 once every record is final */
+    uint32_t cycle_source;      /* BENCH_SOURCE_* */
+    uint32_t counter_overhead;  /* cycles subtracted from every sample */
+    uint32_t run_id;            /* free for the program (seed, variant, ...) */
+    bench_record_t records[BENCH_TABLE_MAX];
+} bench_table_t;
+
+extern volatile bench_table_t bench_table;
+
+// Reset the table; done stays 0 until bench_table_end
+void bench_table_begin(uint32_t cycle_source, uint32_t counter_overhead, uint32_t run_id);
+
+// Append a record from n per-iteration cycle samples (sorted in place).
+// The overhead given to bench_table_begin is removed from min/median/max.
+// Records past BENCH_TABLE_MAX are dropped.
+void bench_table_add(uint32_t id, const char *name, uint32_t *samples, uint32_t n,
+                     uint32_t mmio_stores, uint32_t mmio_bytes);
+
+void bench_table_end(void);
+
+#endif
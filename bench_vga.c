@@ -0,0 +1,337 @@
+/*
+ * VGA driver microbenchmark suite.
+ *
+ * Times every public entry point of vga_driver.h / vga_driver.c and records,
+ * per API, cycles per call (min, median and max over BENCH_REPS calls)
+ * together with the number of MMIO stores and bytes each call issues.
+ * Results land in the common benchmark table (bench_table.h, record id =
+ * BENCH_* below); read it with tools/rvsim --bench-out or from a RAM dump
+ * once bench_done == 1.
+ *
+ * Cycle source:
+ *  - default: the Zicntr `cycle` CSR (rdcycle). The instruction is emitted
+ *    with .insn so the program still builds with -march=rv32i. tools/rvsim
+ *    implements the counter, so this build also runs in the simulator.
+ *  - -DBENCH_NO_CYCLE_CSR (make PROGRAM=bench_vga EXTRA_CFLAGS=...): for cores
+ *    without counters. Cycles and MMIO counts read as 0; instead every
+ *    measured batch is bracketed by stores to bench_marker (id, then
+ *    id | BENCH_MARKER_END), so the batch can be timed, and its stores
+ *    counted, from a mem_memlog trace.
+ *
+ * MMIO counts are measured around each call with hpmcounter5 (stores
+ * outside RAM) and hpmcounter8 (bytes of those stores), as tools/rvsim
+ * implements them, and the record keeps the largest count of any call.
+ * Only the counter reads sit between the two samples, so a driver change
+ * that adds or widens frame-buffer stores shows up in tools/bench_compare.
+ *
+ * With -DVGA_DMA (run with tools/rvsim --dma) the driver hands large fills
+ * and copies to the blit/fill engine. Each timed call ends with
+ * vga_dma_wait(), so cycles are to completion and compare directly with
+ * the CPU build. The MMIO counts are then the CPU's own stores, engine
+ * register writes included; the engine's frame-buffer writes are not CPU
+ * stores and are not counted.
+ */
+
+#include <stdint.h>
+#include "bench_table.h"
+#include "vga_driver.h"
+#include "vga_bitmap.h"
+#include "vga_compositor.h"
+#include "vga_gradient.h"
+#include "vga_rowcache.h"
+#include "vga_sprite.h"
+#include "vga_strip.h"
+
+#define BENCH_REPS          8u
+#define BENCH_MARKER_END    0x80000000u
+
+// Record ids: append only, tools/bench_compare matches runs by id
+enum {
+    BENCH_COLOR_ADDR,
+    BENCH_PACK_TWO_PIXELS,
+    BENCH_WRITE_SINGLE_PIXEL_BYTE,
+    BENCH_WRITE_RGB_BYTE,
+    BENCH_WRITE_QUAD_4_PIXELS,
+    BENCH_WRITE_QUAD_8_PIXELS,
+    BENCH_WRITE_RGB_ROW_BYTES,
+    BENCH_FILL_RGB_ROW_CONSTANT,
+    BENCH_WRITE_RGB_ROW_R_CONST_GB,
+    BENCH_WRITE_RGB_ROW_RB_CONST_G,
+    BENCH_WRITE_RGB_COLUMN_BYTES,
+    BENCH_FILL_RGB_COLUMN_CONSTANT,
+    BENCH_WRITE_RGB_COLUMN_R_CONST_GB,
+    BENCH_WRITE_RGB_COLUMN_RB_CONST_G,
+    BENCH_FULL_FRAME_FILL,
+    BENCH_SWAP_FRAME,
+    BENCH_COMPOSE_FRAME,
+    BENCH_GRADIENT_ROW,
+    BENCH_GRADIENT_COLUMN,
+    BENCH_GRADIENT_RECT_FULL,
+    BENCH_MASK_OVERLAP,
+    BENCH_STRIP_FLUSH,
+    BENCH_FILL_RGB_RECT_FULL,
+    BENCH_ROWCACHE_FRAME,
+    BENCH_BITMAP_LUT_BUILD,
+    BENCH_BITMAP_DRAW,
+    BENCH_COUNT
+};
+
+volatile uint32_t bench_done = 0;
+volatile uint32_t bench_marker = 0;
+
+static uint8_t row_r[VGA_WIDTH_BYTES];
+static uint8_t row_g[VGA_WIDTH_BYTES];
+static uint8_t row_b[VGA_WIDTH_BYTES];
+static uint8_t col_r[VGA_HEIGHT];
+static uint8_t col_g[VGA_HEIGHT];
+static uint8_t col_b[VGA_HEIGHT];
+static Color block_4[16];
+static Color block_8[64];
+
+/* Sink so the pure helpers (color_addr, pack_two_pixels) are not discarded. */
+static volatile uint32_t bench_sink;
+
+#ifdef BENCH_NO_CYCLE_CSR
+#define BENCH_CYCLE_SOURCE  BENCH_SOURCE_NONE
+#else
+#define BENCH_CYCLE_SOURCE  BENCH_SOURCE_CYCLE_CSR
+#endif
+
+_Static_assert(BENCH_COUNT <= BENCH_TABLE_MAX, "too many benchmarks for bench_table");
+
+static inline uint32_t read_cycles(void) {
+#ifdef BENCH_NO_CYCLE_CSR
+    return 0u;
+#else
+    uint32_t c;
+    /* csrrs c, cycle(0xC00), x0 == rdcycle; imm is 0xC00 as signed 12-bit. */
+    __asm__ volatile (".insn i 0x73, 2, %0, x0, -1024" : "=r"(c));
+    return c;
+#endif
+}
+
+static inline uint32_t read_mmio_stores(void) {
+#ifdef BENCH_NO_CYCLE_CSR
+    return 0u;
+#else
+    uint32_t c;
+    /* csrrs c, hpmcounter5(0xC05), x0 */
+    __asm__ volatile (".insn i 0x73, 2, %0, x0, -1019" : "=r"(c));
+    return c;
+#endif
+}
+
+static inline uint32_t read_mmio_bytes(void) {
+#ifdef BENCH_NO_CYCLE_CSR
+    return 0u;
+#else
+    uint32_t c;
+    /* csrrs c, hpmcounter8(0xC08), x0 */
+    __asm__ volatile (".insn i 0x73, 2, %0, x0, -1016" : "=r"(c));
+    return c;
+#endif
+}
+
+static void init_inputs(void) {
+    for (uint32_t xb = 0; xb < VGA_WIDTH_BYTES; ++xb) {
+        row_r[xb] = vga_pack_two_pixels_fast((uint8_t)xb, (uint8_t)(xb + 1u));
+        row_g[xb] = vga_pack_two_pixels_fast((uint8_t)(xb >> 2), (uint8_t)(xb >> 3));
+        row_b[xb] = (uint8_t)(0xFFu - xb);
+    }
+    for (uint32_t y = 0; y < VGA_HEIGHT; ++y) {
+        col_r[y] = (uint8_t)(y * 3u);
+        col_g[y] = (uint8_t)(y ^ 0x5Au);
+        col_b[y] = (uint8_t)(0xFFu - y);
+    }
+    for (uint32_t i = 0; i < 64u; ++i) {
+        block_8[i].r = (uint8_t)(i & 0x0Fu);
+        block_8[i].g = (uint8_t)((i >> 2) & 0x0Fu);
+        block_8[i].b = (uint8_t)(0x0Fu - (i & 0x0Fu));
+        if (i < 16u) {
+            block_4[i] = block_8[i];
+        }
+    }
+}
+
+static uint32_t measure_counter_overhead(void) {
+    uint32_t best = 0xFFFFFFFFu;
+    for (uint32_t i = 0; i < BENCH_REPS; ++i) {
+        uint32_t t0 = read_cycles();
+        uint32_t t1 = read_cycles();
+        if ((t1 - t0) < best) {
+            best = t1 - t0;
+        }
+    }
+    return best;
+}
+
+/*
+ * Run STMT BENCH_REPS times, timing each call separately and counting its
+ * MMIO stores and bytes, then record the result under ID. `rep` is visible
+ * to STMT for varying the target.
+ */
+#define BENCH(id, stmt) \
+    do { \
+        uint32_t _samples[BENCH_REPS]; \
+        uint32_t _stores = 0u; \
+        uint32_t _bytes = 0u; \
+        bench_marker = (id); \
+        for (uint32_t rep = 0; rep < BENCH_REPS; ++rep) { \
+            uint32_t _s0 = read_mmio_stores(); \
+            uint32_t _b0 = read_mmio_bytes(); \
+            uint32_t _t0 = read_cycles(); \
+            stmt; \
+            vga_dma_wait(); \
+            _samples[rep] = read_cycles() - _t0; \
+            _s0 = read_mmio_stores() - _s0; \
+            _b0 = read_mmio_bytes() - _b0; \
+            _stores = (_s0 > _stores) ? _s0 : _stores; \
+            _bytes = (_b0 > _bytes) ? _b0 : _bytes; \
+        } \
+        bench_marker = (id) | BENCH_MARKER_END; \
+        bench_table_add((id), #id, _samples, BENCH_REPS, _stores, _bytes); \
+    } while (0)
+
+// Compositor: fill background plus a 2x2-glyph text overlay per call
+static const uint8_t bench_font[16] = {
+    0x3Cu, 0x42u, 0x81u, 0x81u, 0xFFu, 0x81u, 0x81u, 0x81u,
+    0x7Fu, 0x81u, 0x81u, 0x7Fu, 0x81u, 0x81u, 0x81u, 0x7Fu,
+};
+static const char bench_text[4] = { 'A', 'B', 'B', 'A' };
+static const vga_fill_layer_t bench_fill = { { 0x1u, 0x2u, 0x3u } };
+static vga_text_layer_t bench_overlay = {
+    bench_text, bench_font, 'A', 2u, 2u, 2u, 0u, 0u, { 0xFu, 0xFu, 0xFu }
+};
+static const vga_layer_t bench_layers[2] = {
+    { vga_fill_layer, &bench_fill, 0u, VGA_HEIGHT },
+    { vga_text_layer, &bench_overlay, 0u, VGA_HEIGHT },
+};
+
+static void compose_frame(uint32_t rep) {
+    bench_overlay.x_word = (uint8_t)rep;
+    bench_overlay.y = (uint8_t)(rep * 8u);
+    vga_compose_frame(bench_layers, 2u);
+}
+
+static const Color grad_c0 = { 0x0u, 0x4u, 0xFu };
+static const Color grad_c1 = { 0xFu, 0x8u, 0x0u };
+static const Color grad_c2 = { 0x3u, 0xFu, 0x3u };
+static const Color grad_c3 = { 0x0u, 0x0u, 0x0u };
+
+// Two 40x24 masks (2 words per row) that only touch in their last row,
+// so the overlap test walks every shared row before it hits
+#define BENCH_MASK_W    40u
+#define BENCH_MASK_H    24u
+static uint32_t mask_a_bits[BENCH_MASK_H * VGA_MASK_WORDS_PER_ROW(BENCH_MASK_W)];
+static uint32_t mask_b_bits[BENCH_MASK_H * VGA_MASK_WORDS_PER_ROW(BENCH_MASK_W)];
+static const vga_mask_t mask_a = { mask_a_bits, BENCH_MASK_W, BENCH_MASK_H, VGA_MASK_WORDS_PER_ROW(BENCH_MASK_W) };
+static const vga_mask_t mask_b = { mask_b_bits, BENCH_MASK_W, BENCH_MASK_H, VGA_MASK_WORDS_PER_ROW(BENCH_MASK_W) };
+
+static void init_masks(void) {
+    vga_mask_fill_rect(mask_a_bits, VGA_MASK_WORDS_PER_ROW(BENCH_MASK_W), 0u, 0u, 20u, BENCH_MASK_H - 1u);
+    vga_mask_fill_rect(mask_a_bits, VGA_MASK_WORDS_PER_ROW(BENCH_MASK_W), 0u, BENCH_MASK_H - 1u, BENCH_MASK_W, 1u);
+    vga_mask_fill_rect(mask_b_bits, VGA_MASK_WORDS_PER_ROW(BENCH_MASK_W), 20u, 0u, 20u, BENCH_MASK_H);
+}
+
+// Column strip: 8 bars of different heights, flushed as one 8-pixel-wide strip
+static vga_strip_t bench_strip;
+
+static void init_strip(void) {
+    vga_strip_clear(&bench_strip, grad_c3);
+    for (uint32_t c = 0; c < VGA_STRIP_COLUMNS; ++c) {
+        vga_strip_vline(&bench_strip, c, c * 12u, VGA_HEIGHT, grad_c1);
+    }
+}
+
+// Row cache: a full frame of two alternating stripe rows, both cached, so
+// every call is hits plus row writes
+static void gen_stripe_row(const void *ctx, uint32_t phase, uint8_t *red_row, uint8_t *green_row,
+                           uint8_t *blue_row) {
+    (void)ctx;
+    for (uint32_t xb = 0; xb < VGA_WIDTH_BYTES; ++xb) {
+        uint8_t on = (uint8_t)((((xb >> 2) ^ phase) & 1u) ? 0xFFu : 0x00u);
+        red_row[xb] = on;
+        green_row[xb] = (uint8_t)(on & 0x77u);
+        blue_row[xb] = (uint8_t)~on;
+    }
+}
+
+static const vga_row_gen_t bench_row_gens[1] = { { gen_stripe_row, NULL } };
+static vga_rowcache_slot_t bench_row_arena[2];
+static vga_rowcache_t bench_rows;
+
+static void rowcache_frame(void) {
+    for (uint32_t y = 0; y < VGA_HEIGHT; ++y) {
+        vga_rowcache_write(&bench_rows, y, 0u, y & 1u);
+    }
+}
+
+// 1-bpp icon: 64x16 pixels, 8 bytes per row
+#define BENCH_ICON_BYTES    8u
+#define BENCH_ICON_H        16u
+static uint8_t bench_icon[BENCH_ICON_H * BENCH_ICON_BYTES];
+static vga_bitmap_lut_t bench_icon_lut;
+
+static void init_icon(void) {
+    for (uint32_t i = 0; i < BENCH_ICON_H * BENCH_ICON_BYTES; ++i) {
+        bench_icon[i] = bench_font[i & 15u];
+    }
+    vga_bitmap_lut_build(&bench_icon_lut, grad_c1, grad_c0);
+}
+
+static void full_frame_fill(uint8_t value) {
+    for (uint32_t y = 0; y < VGA_HEIGHT; ++y) {
+        fill_rgb_row_constant(y, value, value, value, VGA_WIDTH_BYTES);
+    }
+}
+
+static void run_benchmarks(void) {
+    BENCH(BENCH_COLOR_ADDR, bench_sink = color_addr(VGA_GREEN_BASE, rep, rep));
+    BENCH(BENCH_PACK_TWO_PIXELS, bench_sink = pack_two_pixels((uint8_t)rep, (uint8_t)(rep + 1u)));
+    BENCH(BENCH_WRITE_SINGLE_PIXEL_BYTE, write_single_pixel_byte(block_4, rep, rep));
+    BENCH(BENCH_WRITE_RGB_BYTE, write_rgb_byte(rep, rep, 0x12u, 0x34u, 0x56u));
+    BENCH(BENCH_WRITE_QUAD_4_PIXELS, write_quad_4_pixels(block_4, rep * 4u, rep * 2u));
+    BENCH(BENCH_WRITE_QUAD_8_PIXELS, write_quad_8_pixels(block_8, rep * 8u, rep * 4u));
+    BENCH(BENCH_WRITE_RGB_ROW_BYTES, write_rgb_row_bytes(rep, row_r, row_g, row_b, VGA_WIDTH_BYTES));
+    BENCH(BENCH_FILL_RGB_ROW_CONSTANT, fill_rgb_row_constant(rep, 0x11u, 0x22u, 0x33u, VGA_WIDTH_BYTES));
+    BENCH(BENCH_WRITE_RGB_ROW_R_CONST_GB, write_rgb_row_r_const_gb(rep, row_r, 0x22u, 0x33u, VGA_WIDTH_BYTES));
+    BENCH(BENCH_WRITE_RGB_ROW_RB_CONST_G, write_rgb_row_rb_const_g(rep, row_r, row_b, 0x22u, VGA_WIDTH_BYTES));
+    BENCH(BENCH_WRITE_RGB_COLUMN_BYTES, write_rgb_column_bytes(0u, rep, col_r, col_g, col_b, VGA_HEIGHT));
+    BENCH(BENCH_FILL_RGB_COLUMN_CONSTANT, fill_rgb_column_constant(0u, rep, 0x11u, 0x22u, 0x33u, VGA_HEIGHT));
+    BENCH(BENCH_WRITE_RGB_COLUMN_R_CONST_GB, write_rgb_column_r_const_gb(0u, rep, col_r, 0x22u, 0x33u, VGA_HEIGHT));
+    BENCH(BENCH_WRITE_RGB_COLUMN_RB_CONST_G, write_rgb_column_rb_const_g(0u, rep, col_r, col_b, 0x22u, VGA_HEIGHT));
+    BENCH(BENCH_FULL_FRAME_FILL, full_frame_fill((uint8_t)(rep * 0x11u)));
+    BENCH(BENCH_SWAP_FRAME, swap_frame());
+    BENCH(BENCH_COMPOSE_FRAME, compose_frame(rep));
+    BENCH(BENCH_GRADIENT_ROW, vga_gradient_row(rep, 0u, VGA_WIDTH_BYTES, grad_c0, grad_c1));
+    BENCH(BENCH_GRADIENT_COLUMN, vga_gradient_column(0u, rep, VGA_HEIGHT, grad_c0, grad_c1));
+    BENCH(BENCH_GRADIENT_RECT_FULL,
+          vga_gradient_rect(0u, 0u, VGA_WIDTH_BYTES, VGA_HEIGHT, grad_c0, grad_c1, grad_c2, grad_c3));
+    BENCH(BENCH_MASK_OVERLAP,
+          bench_sink = (uint32_t)vga_mask_overlap(&mask_a, 8, (int32_t)rep, &mask_b, 8, (int32_t)rep));
+    BENCH(BENCH_STRIP_FLUSH, vga_strip_flush(&bench_strip, rep));
+    BENCH(BENCH_FILL_RGB_RECT_FULL,
+          fill_rgb_rect_constant(0u, 0u, VGA_WIDTH_BYTES, VGA_HEIGHT, (uint8_t)rep, 0x5Au, 0xA5u));
+    BENCH(BENCH_ROWCACHE_FRAME, rowcache_frame());
+    BENCH(BENCH_BITMAP_LUT_BUILD, vga_bitmap_lut_build(&bench_icon_lut, grad_c1, grad_c0));
+    BENCH(BENCH_BITMAP_DRAW,
+          vga_bitmap_draw(&bench_icon_lut, bench_icon, BENCH_ICON_BYTES, BENCH_ICON_H, BENCH_ICON_BYTES, rep, rep));
+}
+
+int main(void) {
+    bench_done = 0;
+    bench_marker = 0;
+
+    init_inputs();
+    init_masks();
+    init_strip();
+    init_icon();
+    vga_rowcache_init(&bench_rows, bench_row_arena, sizeof(bench_row_arena), bench_row_gens, 1u);
+    bench_table_begin(BENCH_CYCLE_SOURCE, measure_counter_overhead(), 0u);
+    run_benchmarks();
+    bench_table_end();
+
+    bench_done = 1;
+    for (;;) {
+    }
+}
@@ -5,24 +5,77 @@
 // - clk/reset
 // - memAddr/writeData/ctrlMEM
 // - readData (the mem block's o_readData)
+// - funct3 of the load/store being logged (optional; the access size is
+//   funct3[1:0]: 0 byte, 1 half, 2 word, the default when unconnected)
 //
 // It writes human-readable lines to a log file (default: mem.log).
+//
+// DPI mode (compile with +define+MEMLOG_DPI and link tools/memlog_dpi.c):
+// each access is handed to memlog_dpi_access() instead of $fdisplay. The C
+// side queues it to a background writer thread (CSV or compact binary trace,
+// address/op filtering, per-region counts) and can shadow main RAM to flag
+// corrupt reads at the cycle they happen. DPI_OPTIONS is passed through,
+// e.g. "golden=1,image=test_mem_hammer.mem,format=bin". See the comment at
+// the top of tools/memlog_dpi.c for the option list.
+//
+// Triggered capture (TRIG_ENABLE=1): nothing is logged until a start
+// condition fires, and logging ends on a stop condition. Conditions:
+// - a write to START_ADDR (START_ON_ADDR), and/or a write whose data
+//   matches START_DATA under START_DATA_MASK (START_ON_DATA; START_DATA_NE
+//   inverts the match). When both are enabled the same write must match both.
+// - START_AFTER accesses seen (0 = off), OR-ed with the write conditions.
+// - STOP_ON_ADDR/STOP_ADDR, STOP_ON_DATA/STOP_DATA/STOP_DATA_MASK likewise,
+//   or STOP_AFTER accesses logged since the start (0 = off).
+// The last PRE_TRIGGER accesses before the start are kept in a circular
+// buffer and dumped when the trigger fires. REARM=1 re-arms after a stop.
+// Each window is bracketed by "# trigger ..." comment lines in the CSV log
+// (also in DPI mode), and by marker records in the DPI binary trace.
+//
+// Example: capture the failure in test_mem_hammer. main() sets fail_index
+// to 0xFFFFFFFF (no failure) at start-up and a failing check writes the
+// index it failed at, so trigger on the first other write to it; phase 0
+// (the initial guard check) reports index 0..7 and is caught too (address
+// from `make PROGRAM=test_mem_hammer symaddr SYM=fail_index`):
+//   .TRIG_ENABLE(1), .START_ON_ADDR(1), .START_ADDR(32'h<fail_index>),
+//   .START_ON_DATA(1), .START_DATA(32'hFFFF_FFFF), .START_DATA_NE(1),
+//   .PRE_TRIGGER(256), .STOP_AFTER(64)
 
 // Implemetation
 
 // mem_memlog # (
-//          .LOG_FILENAME("mem.log")
+//          .LOG_FILENAME("mem.log"),
+//          .DPI_OPTIONS(""),         // only used with +define+MEMLOG_DPI
+//          .TRIG_ENABLE(0)           // see "Triggered capture" above
 //          ) mm (
 //         .i_clk      (i_clk),
 //         .i_reset_n  (i_reset_n),
 //         .i_memAddr  (i_memAddr),
 //         .i_writeData(i_writeData),
 //         .i_ctrlMEM  (i_ctrlMEM),
-//         .i_readData (o_readData)
+//         .i_readData (o_readData),
+//         .i_funct3   (funct3)      // optional, see above
 //     );
 
 module mem_memlog #(
-    parameter string LOG_FILENAME = "mem.log"
+    parameter string LOG_FILENAME = "mem.log",
+    parameter string DPI_OPTIONS = "",
+
+    parameter bit          TRIG_ENABLE     = 1'b0,
+    parameter bit          START_ON_ADDR   = 1'b0,
+    parameter logic [31:0] START_ADDR      = 32'h0,
+    parameter bit          START_ON_DATA   = 1'b0,
+    parameter logic [31:0] START_DATA      = 32'h0,
+    parameter logic [31:0] START_DATA_MASK = 32'hFFFF_FFFF,
+    parameter bit          START_DATA_NE   = 1'b0,
+    parameter longint      START_AFTER     = 0,
+    parameter bit          STOP_ON_ADDR    = 1'b0,
+    parameter logic [31:0] STOP_ADDR       = 32'h0,
+    parameter bit          STOP_ON_DATA    = 1'b0,
+    parameter logic [31:0] STOP_DATA       = 32'h0,
+    parameter logic [31:0] STOP_DATA_MASK  = 32'hFFFF_FFFF,
+    parameter longint      STOP_AFTER      = 0,
+    parameter int          PRE_TRIGGER     = 0,
+    parameter bit          REARM           = 1'b0
 ) (
     input  logic        i_clk,
     input  logic        en_MEM,
@@ -30,8 +83,36 @@ module mem_memlog #(
     input  logic [31:0] i_memAddr,
     input  logic [31:0] i_writeData,
     input  mem_ctrl_t  i_ctrlMEM,   // [1]=read, [0]=write
-    input  logic [31:0] i_readData
+    input  logic [31:0] i_readData,
+    input  logic [2:0]  i_funct3 = 3'b010  // S/L-type funct3, [1:0] = size
 );
+    localparam int PRE_DEPTH = (PRE_TRIGGER > 0) ? PRE_TRIGGER : 1;
+
+`ifdef MEMLOG_DPI
+    // flags: bit0 = run the golden check on this access, bit1 = trace it.
+    import "DPI-C" function int memlog_dpi_open(input string filename, input string options);
+    import "DPI-C" function int memlog_dpi_access(input int handle, input longint unsigned t,
+                                                  input int is_write, input int size,
+                                                  input int unsigned addr, input int unsigned data,
+                                                  input int flags);
+    import "DPI-C" function void memlog_dpi_note(input int handle, input longint unsigned t,
+                                                 input int start);
+    import "DPI-C" function int unsigned memlog_dpi_expected(input int handle);
+    import "DPI-C" function void memlog_dpi_close(input int handle);
+
+    int dpi_h;
+
+    initial begin
+        dpi_h = memlog_dpi_open(LOG_FILENAME, DPI_OPTIONS);
+        if (dpi_h < 0) begin
+            $fatal(1, "mem_memlog: failed to open DPI log '%s'", LOG_FILENAME);
+        end
+    end
+
+    final begin
+        memlog_dpi_close(dpi_h);
+    end
+`else
     integer fd;
 
     initial begin
@@ -49,23 +130,124 @@ module mem_memlog #(
             $fclose(fd);
         end
     end
+`endif
 
-    // Log writes on falling edge (matches sim-stage timing in this design).
-    always @(negedge i_clk) begin
-        if (i_ctrlMEM[0] & en_MEM) begin
-            $fdisplay(fd, "%0t,WRITE,0x%08h,%0d,0x%08h",
-                      $time, i_memAddr, i_memAddr[14:2], i_writeData);
-            $fflush(fd);
+    // Write one record to the log.
+    task automatic emit(input longint unsigned t, input bit is_write, input int size,
+                        input logic [31:0] addr, input logic [31:0] data);
+`ifdef MEMLOG_DPI
+        void'(memlog_dpi_access(dpi_h, t, int'(is_write), size, addr, data, 2));
+`else
+        $fdisplay(fd, "%0t,%s,0x%08h,%0d,0x%08h",
+                  t, is_write ? "WRITE" : "READ", addr, addr[14:2], data);
+        $fflush(fd);
+`endif
+    endtask
+
+    // Mark the start or end of a capture window.
+    task automatic note(input bit is_start);
+`ifdef MEMLOG_DPI
+        memlog_dpi_note(dpi_h, $time, int'(is_start));
+`else
+        $fdisplay(fd, "# trigger %s at %0t", is_start ? "start" : "stop", $time);
+        $fflush(fd);
+`endif
+    endtask
+
+    // Trigger state and the pre-trigger circular buffer.
+    bit              armed = 1'b1;
+    bit              active = !TRIG_ENABLE;
+    longint          seen = 0;
+    longint          logged = 0;
+    longint unsigned pre_time [PRE_DEPTH];
+    bit              pre_write[PRE_DEPTH];
+    int              pre_size [PRE_DEPTH];
+    logic [31:0]     pre_addr [PRE_DEPTH];
+    logic [31:0]     pre_data [PRE_DEPTH];
+    int              pre_head = 0;
+    int              pre_count = 0;
+
+    function automatic bit start_hit(input bit is_write, input logic [31:0] addr,
+                                     input logic [31:0] data);
+        bit wr_cond = (START_ON_ADDR || START_ON_DATA) && is_write;
+        if (START_ON_ADDR && addr != START_ADDR) begin
+            wr_cond = 1'b0;
         end
-    end
+        if (START_ON_DATA &&
+            (((data & START_DATA_MASK) == (START_DATA & START_DATA_MASK)) == START_DATA_NE)) begin
+            wr_cond = 1'b0;
+        end
+        return wr_cond || (START_AFTER > 0 && seen >= START_AFTER);
+    endfunction
+
+    function automatic bit stop_hit(input bit is_write, input logic [31:0] addr,
+                                    input logic [31:0] data);
+        bit wr_cond = (STOP_ON_ADDR || STOP_ON_DATA) && is_write;
+        if (STOP_ON_ADDR && addr != STOP_ADDR) begin
+            wr_cond = 1'b0;
+        end
+        if (STOP_ON_DATA && (data & STOP_DATA_MASK) != (STOP_DATA & STOP_DATA_MASK)) begin
+            wr_cond = 1'b0;
+        end
+        return wr_cond || (STOP_AFTER > 0 && logged >= STOP_AFTER);
+    endfunction
+
+    task automatic log_access(input bit is_write, input int size,
+                              input logic [31:0] addr, input logic [31:0] data);
+        longint unsigned t = $time;
+        seen++;
 
-    // Log reads on falling edge.
+        if (!active && armed && start_hit(is_write, addr, data)) begin
+            note(1'b1);
+            for (int i = 0; i < pre_count; i++) begin
+                int k = (pre_head - pre_count + i + PRE_DEPTH) % PRE_DEPTH;
+                emit(pre_time[k], pre_write[k], pre_size[k], pre_addr[k], pre_data[k]);
+            end
+            pre_count = 0;
+            active = 1'b1;
+            logged = 0;
+        end
+
+        if (active) begin
+            emit(t, is_write, size, addr, data);
+            logged++;
+            if (TRIG_ENABLE && stop_hit(is_write, addr, data)) begin
+                note(1'b0);
+                active = 1'b0;
+                armed = REARM;
+            end
+        end else if (PRE_TRIGGER > 0 && armed) begin
+            pre_time[pre_head]  = t;
+            pre_write[pre_head] = is_write;
+            pre_size[pre_head]  = size;
+            pre_addr[pre_head]  = addr;
+            pre_data[pre_head]  = data;
+            pre_head = (pre_head + 1) % PRE_DEPTH;
+            if (pre_count < PRE_DEPTH) begin
+                pre_count++;
+            end
+        end
+    endtask
+
+    // Log writes and reads on the falling edge (matches sim-stage timing in
+    // this design). size is funct3[1:0] (0 byte, 1 half, 2 word).
     always @(negedge i_clk) begin
+        if (i_ctrlMEM[0] & en_MEM) begin
+`ifdef MEMLOG_DPI
+            void'(memlog_dpi_access(dpi_h, $time, 1, int'(i_funct3[1:0]),
+                                    i_memAddr, i_writeData, 1));
+`endif
+            log_access(1'b1, int'(i_funct3[1:0]), i_memAddr, i_writeData);
+        end
         if (i_ctrlMEM[1] & en_WB) begin
-            $fdisplay(fd, "%0t,READ,0x%08h,%0d,0x%08h",
-                      $time, i_memAddr, i_memAddr[14:2], i_readData);
-            $fflush(fd);
+`ifdef MEMLOG_DPI
+            if (memlog_dpi_access(dpi_h, $time, 0, int'(i_funct3[1:0]),
+                                  i_memAddr, i_readData, 1) != 0) begin
+                $error("mem_memlog: corrupt read at 0x%08h: got 0x%08h, golden 0x%08h",
+                       i_memAddr, i_readData, memlog_dpi_expected(dpi_h));
+            end
+`endif
+            log_access(1'b0, int'(i_funct3[1:0]), i_memAddr, i_readData);
         end
     end
 endmodule
-
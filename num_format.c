@@ -0,0 +1,105 @@
+#include "num_format.h"
+
+/*
+ * Division-free number formatting: see num_format.h.
+ */
+
+static const char hex_digits[16] = {
+    '0', '1', '2', '3', '4', '5', '6', '7', '8', '9', 'a', 'b', 'c', 'd', 'e', 'f'
+};
+
+// v / 10 for 64-bit v. The shift-add estimate can be a few low, so the
+// correction loops; once v fits in 32 bits callers switch to num_divu10.
+static uint64_t divu10_64(uint64_t v, uint32_t *rem) {
+    uint64_t q = (v >> 1) + (v >> 2);
+    uint64_t r;
+
+    q += q >> 4;
+    q += q >> 8;
+    q += q >> 16;
+    q += q >> 32;
+    q >>= 3;
+    r = v - ((q << 3) + (q << 1));
+    while (r > 9u) {
+        q++;
+        r -= 10u;
+    }
+    *rem = (uint32_t)r;
+    return q;
+}
+
+// Copy the count digits in tmp (least significant first) to buf after
+// sign and padding
+static uint32_t emit(char *buf, const char *tmp, uint32_t count, char sign, uint32_t width, char pad) {
+    uint32_t len = 0;
+    uint32_t used = count + (sign != 0);
+
+    // A zero-padded sign goes before the zeros, a space-padded one after the spaces
+    if (sign != 0 && pad == '0') {
+        buf[len++] = sign;
+        sign = 0;
+    }
+    for (; used < width; ++used) {
+        buf[len++] = pad;
+    }
+    if (sign != 0) {
+        buf[len++] = sign;
+    }
+    while (count != 0u) {
+        buf[len++] = tmp[--count];
+    }
+    buf[len] = '\0';
+    return len;
+}
+
+static uint32_t digits_u32(char *tmp, uint32_t v) {
+    uint32_t n = 0;
+
+    do {
+        uint32_t d;
+        v = num_divu10(v, &d);
+        tmp[n++] = (char)('0' + d);
+    } while (v != 0u);
+    return n;
+}
+
+uint32_t num_format_u32(char *buf, uint32_t v, uint32_t width, char pad) {
+    char tmp[NUM_FORMAT_U32_MAX];
+
+    return emit(buf, tmp, digits_u32(tmp, v), 0, width, pad);
+}
+
+uint32_t num_format_i32(char *buf, int32_t v, uint32_t width, char pad) {
+    char tmp[NUM_FORMAT_U32_MAX];
+    // Negate in unsigned so INT32_MIN works
+    uint32_t mag = (v < 0) ? 0u - (uint32_t)v : (uint32_t)v;
+
+    return emit(buf, tmp, digits_u32(tmp, mag), (v < 0) ? '-' : 0, width, pad);
+}
+
+uint32_t num_format_u64(char *buf, uint64_t v, uint32_t width, char pad) {
+    char tmp[NUM_FORMAT_U64_MAX];
+    uint32_t n = 0;
+
+    while ((v >> 32) != 0u) {
+        uint32_t d;
+        v = divu10_64(v, &d);
+        tmp[n++] = (char)('0' + d);
+    }
+    n += digits_u32(tmp + n, (uint32_t)v);
+    return emit(buf, tmp, n, 0, width, pad);
+}
+
+uint32_t num_format_hex32(char *buf, uint32_t v, uint32_t digits) {
+    if (digits == 0u) {
+        digits = 1u;
+    } else if (digits > 8u) {
+        digits = 8u;
+    }
+    for (uint32_t i = digits; i != 0u; --i) {
+        buf[i - 1u] = hex_digits[v & 0xFu];
+        v >>= 4;
+    }
+    buf[digits] = '\0';
+    return digits;
+}
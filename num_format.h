@@ -0,0 +1,52 @@
+#ifndef NUM_FORMAT_H
+#define NUM_FORMAT_H
+
+#include <stdint.h>
+
+/*
+ * Division-free number formatting for status output (test counters, cycle
+ * counts, failing values on the screen or in a RAM log).
+ *
+ * RV32I has no divide or multiply, so "v / 10" and "v % 10" are libgcc
+ * calls (__udivsi3, __umodsi3) that loop over the bits: a few hundred
+ * cycles per digit, twice. Here decimal digits come from num_divu10, a
+ * shift-and-add reciprocal of 10 with a one-step correction (about 20
+ * instructions, no multiply either), and hex is nibble shifts and a table.
+ *
+ * Output goes into caller buffers, NUL-terminated; the return value is the
+ * length without the NUL. A width pads on the left with pad ('0' or ' ')
+ * to at least that many characters (the sign included); longer numbers
+ * are never cut, so size buffers for NUM_FORMAT_*_MAX or the width, + 1.
+ */
+
+#define NUM_FORMAT_U32_MAX  10u     /* 4294967295 */
+#define NUM_FORMAT_I32_MAX  11u     /* -2147483648 */
+#define NUM_FORMAT_U64_MAX  20u     /* 18446744073709551615 */
+
+// v / 10, remainder in *rem
+static inline uint32_t num_divu10(uint32_t v, uint32_t *rem) {
+    uint32_t q = (v >> 1) + (v >> 2);
+    uint32_t r;
+
+    q += q >> 4;
+    q += q >> 8;
+    q += q >> 16;
+    q >>= 3;
+    r = v - ((q << 3) + (q << 1));
+    // The estimate is at most one low
+    if (r > 9u) {
+        q++;
+        r -= 10u;
+    }
+    *rem = r;
+    return q;
+}
+
+uint32_t num_format_u32(char *buf, uint32_t v, uint32_t width, char pad);
+uint32_t num_format_i32(char *buf, int32_t v, uint32_t width, char pad);
+uint32_t num_format_u64(char *buf, uint64_t v, uint32_t width, char pad);
+
+// Exactly digits (1..8) lowercase hex digits of the low bits of v, no prefix
+uint32_t num_format_hex32(char *buf, uint32_t v, uint32_t digits);
+
+#endif
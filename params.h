@@ -0,0 +1,47 @@
+#ifndef PARAMS_H
+#define PARAMS_H
+
+/*
+ * Load-time program parameters.
+ *
+ * A program declares one parameter block with PARAMS_SECTION. link.ld puts
+ * it at PARAMS_ADDR, right after the startup code, so the values can be
+ * changed in $(PROGRAM).mem / .bin without recompiling: tools/params_patch
+ * rewrites the image, tools/rvsim --param and tools/param_sweep patch RAM
+ * after loading. Every entry carries its name, so the tools need no ELF.
+ *
+ *   static volatile struct {
+ *       params_header_t hdr;
+ *       param_t words;
+ *       param_t seed;
+ *   } my_params PARAMS_SECTION = {
+ *       PARAMS_HEADER(2u),
+ *       PARAM("words", 512u),
+ *       PARAM("seed", 0x1BADF00Du),
+ *   };
+ *
+ * The block must be volatile (or read through a volatile pointer) so the
+ * compiler does not fold the default values into the code.
+ */
+
+#include <stdint.h>
+
+#define PARAMS_ADDR         0x40u           /* link.ld: ORIGIN(RAM) + 0x40 */
+#define PARAMS_MAGIC        0x4D524150u     /* "PARM" */
+#define PARAMS_NAME_LEN     8u              /* NUL-padded, no NUL at full length */
+
+typedef struct {
+    uint32_t magic;
+    uint32_t count;             /* entries that follow */
+} params_header_t;
+
+typedef struct {
+    char name[PARAMS_NAME_LEN];
+    uint32_t value;
+} param_t;
+
+#define PARAMS_SECTION          __attribute__((section(".params"), used, aligned(4)))
+#define PARAMS_HEADER(count)    { PARAMS_MAGIC, (count) }
+#define PARAM(name, value)      { name, (value) }
+
+#endif
@@ -0,0 +1,28 @@
+#ifndef PGO_H
+#define PGO_H
+
+/*
+ * Per-function optimization from a profile (make PGO=1).
+ *
+ * Put PGO_FN(name) in front of a function definition to let the profile
+ * decide how it is compiled. In a normal build it expands to nothing. The
+ * profiling pass (PGO_PASS1) keeps marked functions out of line so their
+ * cycles are not folded into the caller. In the second pass the Makefile
+ * force-includes $(PROGRAM).pgo.h, in which tools/pgo_gen defines
+ * PGO_FN_<name> for every marked function: PGO_HOT for the functions that
+ * account for most of the simulated cycles, PGO_COLD for init and failure
+ * paths that ran at most once.
+ */
+
+#define PGO_HOT  __attribute__((hot, optimize("O3", "unroll-loops")))
+#define PGO_COLD __attribute__((cold, optimize("Os")))
+
+#if defined(PGO_PROFILE_LOADED)
+#define PGO_FN(name) PGO_FN_##name
+#elif defined(PGO_PASS1)
+#define PGO_FN(name) __attribute__((noinline))
+#else
+#define PGO_FN(name)
+#endif
+
+#endif
@@ -0,0 +1,96 @@
+// rv32i_cosim.sv
+// Lock-step co-simulation checker (non-synthesizable).
+//
+// Instantiate this module in the Wizard Core testbench and wire it to the
+// core's retirement point: one i_retire pulse per instruction that leaves
+// write-back, with its PC, instruction word, register write and memory
+// access. Each retirement is handed to the RV32I reference model in
+// tools/rv32i_dpi.c (link tools/librv32i_dpi.so), which executes the same
+// instruction and compares PC, instruction word, rd/value and the memory
+// address/data. A mismatch is reported with $error at the cycle it happens;
+// after MAX_ERRORS of them (OPTIONS max_errors=, default 10) the simulation
+// stops with $fatal.
+//
+// i_mem_data is the load data the core received (or the store data it
+// sent). By default it is the value in the low bits (RISC-V semantics);
+// with OPTIONS "ldata=laned" it is the raw bus word with bytes in their
+// address lanes, as on i_readData of mem_memlog.sv. MMIO loads always use
+// this data. With "mem=rtl" (default when no image= is given) RAM loads and
+// instruction words come from the RTL too. With image=$(PROGRAM).mem the
+// model runs its own copy of RAM and cross-checks them.
+//
+// OPTIONS is passed through; see the comment at the top of
+// tools/rv32i_dpi.c for the option list. The library also has
+// rv32i_dpi_step/_write_mem/_get_reg/_set_reg/_get_pc/_set_pc for
+// testbenches that need to fast-forward the model or mirror memory
+// written behind the core's back.
+
+// Instantiation
+
+// rv32i_cosim # (
+//          .OPTIONS("image=test_isa_vga.mem")
+//          ) cosim (
+//         .i_clk      (i_clk),
+//         .i_retire   (wb_valid),
+//         .i_pc       (wb_pc),
+//         .i_insn     (wb_insn),
+//         .i_rd_we    (wb_rd_we),
+//         .i_rd       (wb_rd),
+//         .i_rd_value (wb_rd_value),
+//         .i_mem_valid(wb_mem_valid),
+//         .i_mem_addr (wb_mem_addr),
+//         .i_mem_data (wb_mem_data)
+//     );
+
+module rv32i_cosim #(
+    parameter string OPTIONS = ""
+) (
+    input  logic        i_clk,
+    input  logic        i_retire,
+    input  logic [31:0] i_pc,
+    input  logic [31:0] i_insn,
+    input  logic        i_rd_we,
+    input  logic [4:0]  i_rd,
+    input  logic [31:0] i_rd_value,
+    input  logic        i_mem_valid,
+    input  logic [31:0] i_mem_addr,
+    input  logic [31:0] i_mem_data
+);
+    import "DPI-C" function int rv32i_dpi_open(input string options);
+    import "DPI-C" function int rv32i_dpi_retire(input int handle, input longint unsigned t,
+                                                 input int unsigned pc, input int unsigned insn,
+                                                 input int rd, input int unsigned rd_value,
+                                                 input int unsigned mem_addr,
+                                                 input int unsigned mem_data);
+    import "DPI-C" function int rv32i_dpi_close(input int handle);
+
+    int h;
+    int rc;
+
+    initial begin
+        h = rv32i_dpi_open(OPTIONS);
+        if (h < 0) begin
+            $fatal(1, "rv32i_cosim: failed to open model with options '%s'", OPTIONS);
+        end
+    end
+
+    final begin
+        if (rv32i_dpi_close(h) != 0) begin
+            $error("rv32i_cosim: RTL diverged from the reference model");
+        end
+    end
+
+    always @(negedge i_clk) begin
+        if (i_retire) begin
+            rc = rv32i_dpi_retire(h, $time, i_pc, i_insn,
+                                  (i_rd_we && i_rd != 5'd0) ? int'(i_rd) : 0, i_rd_value,
+                                  i_mem_valid ? i_mem_addr : 32'h0,
+                                  i_mem_valid ? i_mem_data : 32'h0);
+            if (rc == 1) begin
+                $error("rv32i_cosim: mismatch at pc 0x%08h (insn 0x%08h)", i_pc, i_insn);
+            end else if (rc == 2) begin
+                $fatal(1, "rv32i_cosim: too many mismatches, last at pc 0x%08h", i_pc);
+            end
+        end
+    end
+endmodule
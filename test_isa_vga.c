@@ -12,6 +12,7 @@
 
 #include <stdint.h>
 #include "vga_driver.h"
+#include "pgo.h"
 
 volatile uint32_t test_result = 0;
 volatile uint32_t test_passed = 0;
@@ -302,7 +303,9 @@ static uint8_t frame_b_red_row_odd[VGA_WIDTH_BYTES];
 static uint8_t frame_b_blue_row_even[VGA_WIDTH_BYTES];
 static uint8_t frame_b_blue_row_odd[VGA_WIDTH_BYTES];
 
-static void init_vga_rows(void) {
+// Kept out of line so the symbol survives -O2: it is the sim-watch
+// snapshot point (make sim-watch SIM_SNAPSHOT=init_vga_rows)
+PGO_FN(init_vga_rows) static void __attribute__((noinline)) init_vga_rows(void) {
     for (uint32_t xb = 0; xb < VGA_WIDTH_BYTES; ++xb) {
         uint8_t x0 = (uint8_t)(xb << 1);
         uint8_t x1 = (uint8_t)(x0 + 1u);
@@ -322,7 +325,7 @@ static void init_vga_rows(void) {
     }
 }
 
-static void draw_frame_a(void) {
+PGO_FN(draw_frame_a) static void draw_frame_a(void) {
     uint8_t blue_byte = vga_pack_two_pixels_fast(0x2u, 0x2u);
 
     for (uint32_t y = 0; y < VGA_HEIGHT; y++) {
@@ -331,7 +334,7 @@ static void draw_frame_a(void) {
     }
 }
 
-static void draw_frame_b(void) {
+PGO_FN(draw_frame_b) static void draw_frame_b(void) {
     uint8_t green_byte = vga_pack_two_pixels_fast(0x0u, 0x0u);
     for (uint32_t y = 0; y < VGA_HEIGHT; y++) {
         const uint8_t *red_row = ((y & 1u) == 0u) ? frame_b_red_row_even : frame_b_red_row_odd;
@@ -340,7 +343,7 @@ static void draw_frame_b(void) {
     }
 }
 
-static void draw_fail_screen_red(void) {
+PGO_FN(draw_fail_screen_red) static void draw_fail_screen_red(void) {
     uint8_t red = vga_pack_two_pixels_fast(0xFu, 0xFu);
     uint8_t zero = vga_pack_two_pixels_fast(0x0u, 0x0u);
     for (uint32_t y = 0; y < VGA_HEIGHT; y++) {
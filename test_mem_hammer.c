@@ -5,19 +5,42 @@
  *  - Detect wrong-address writes and read/write corruption
  *  - Exercise word/halfword/byte paths
  *  - Hammer memory with repeated randomized traffic
+ *
+ * Region size, hammer iterations, seed, data pattern and the set of phases
+ * come from the parameter block (params.h), so they can be changed in the
+ * .mem/.bin without a rebuild, e.g. tools/params_patch --set seed=7 or a
+ * tools/param_sweep run:
+ *  - words:   region size in words, 1..MEM_WORDS_MAX (0 or larger = max)
+ *  - iters:   randomized hammer iterations
+ *  - seed:    xorshift32 seed (0 = the default, xorshift32 sticks at 0)
+ *  - pattern: XOR-ed into every data value (march uses pattern / ~pattern)
+ *  - phases:  PHASE_* mask
+ *
+ * At the end, status_text holds a one-line summary for a RAM dump or the
+ * simulator, e.g. "FAIL phase 30 index 117 expected 0x1badf00d actual
+ * 0x1badf00c passed 5231", formatted without soft division (num_format.h).
  */
 
 #include <stdint.h>
+#include "num_format.h"
+#include "params.h"
 
 volatile uint32_t test_result = 0;
 volatile uint32_t test_passed = 0;
 volatile uint32_t test_failed = 0;
 
+// fail_index stays FAIL_INDEX_NONE until a check fails (every phase,
+// including 0, writes a real index), e.g. for a mem_memlog capture trigger
+#define FAIL_INDEX_NONE 0xFFFFFFFFu
+
 volatile uint32_t fail_phase = 0;
-volatile uint32_t fail_index = 0;
+volatile uint32_t fail_index = FAIL_INDEX_NONE;
 volatile uint32_t fail_expected = 0;
 volatile uint32_t fail_actual = 0;
 
+#define STATUS_TEXT_LEN 96u
+volatile char status_text[STATUS_TEXT_LEN];
+
 #define ASSERT_EQ(actual, expected, phase_id, index_id) \
     do { \
         uint32_t _a = (uint32_t)(actual); \
@@ -35,21 +58,56 @@ volatile uint32_t fail_actual = 0;
         } \
     } while (0)
 
-#define MEM_WORDS 512u
+/*
+ * Largest region the words parameter can select. The region and its
+ * shadow cost 8 bytes of RAM per word (8 KB + guards here, against 4 KB for
+ * the 512-word default), so the ceiling covers the sweeps in the Makefile
+ * and README rather than the whole RAM; rebuild with
+ * EXTRA_CFLAGS=-DMEM_WORDS_MAX=2048 for more.
+ */
+#ifndef MEM_WORDS_MAX
+#define MEM_WORDS_MAX 1024u
+#endif
 #define GUARD_WORDS 8u
-#define MEM_MASK (MEM_WORDS - 1u)
+#define DEFAULT_SEED 0x1BADF00Du
+
+#define PHASE_PATTERNS  0x1u
+#define PHASE_MARCH     0x2u
+#define PHASE_ALIAS     0x4u
+#define PHASE_HAMMER    0x8u
 
 #define GUARD_LO_PATTERN 0xCAFEBABEu
 #define GUARD_HI_PATTERN 0xDEADC0DEu
 
+static volatile struct {
+    params_header_t hdr;
+    param_t words;
+    param_t iters;
+    param_t seed;
+    param_t pattern;
+    param_t phases;
+} hammer_params PARAMS_SECTION = {
+    PARAMS_HEADER(5u),
+    PARAM("words", 512u),
+    PARAM("iters", 300000u),
+    PARAM("seed", DEFAULT_SEED),
+    PARAM("pattern", 0u),
+    PARAM("phases", PHASE_PATTERNS | PHASE_MARCH | PHASE_ALIAS | PHASE_HAMMER),
+};
+
+/* guard_lo, mem[mem_words], guard_hi; the high guard follows the active size */
 typedef struct {
-    volatile uint32_t guard_lo[GUARD_WORDS];
-    volatile uint32_t mem[MEM_WORDS];
-    volatile uint32_t guard_hi[GUARD_WORDS];
+    volatile uint32_t *guard_lo;
+    volatile uint32_t *mem;
+    volatile uint32_t *guard_hi;
 } mem_region_t;
 
+static volatile uint32_t region_words[GUARD_WORDS + MEM_WORDS_MAX + GUARD_WORDS];
 static mem_region_t region;
-static uint32_t shadow[MEM_WORDS];
+static uint32_t shadow[MEM_WORDS_MAX];
+static uint32_t mem_words;
+static uint32_t mem_mask;           /* next power of two above mem_words, minus 1 */
+static uint32_t data_pattern;
 
 static uint32_t xorshift32(uint32_t state) {
     state ^= state << 13;
@@ -66,6 +124,31 @@ static uint32_t rol32(uint32_t v, uint32_t sh) {
     return (v << sh) | (v >> (32u - sh));
 }
 
+static void load_params(void) {
+    uint32_t words = hammer_params.words.value;
+
+    if (words == 0u || words > MEM_WORDS_MAX) {
+        words = MEM_WORDS_MAX;
+    }
+    mem_words = words;
+    mem_mask = 1u;
+    while (mem_mask < words) {
+        mem_mask <<= 1;
+    }
+    mem_mask -= 1u;
+    data_pattern = hammer_params.pattern.value;
+
+    region.guard_lo = &region_words[0];
+    region.mem = &region_words[GUARD_WORDS];
+    region.guard_hi = &region_words[GUARD_WORDS + words];
+}
+
+/* Uniform enough over [0, mem_words): mem_mask < 2 * mem_words. */
+static uint32_t random_index(uint32_t state) {
+    uint32_t idx = state & mem_mask;
+    return (idx >= mem_words) ? idx - mem_words : idx;
+}
+
 static void init_guards(void) {
     uint32_t i;
     for (i = 0; i < GUARD_WORDS; i++) {
@@ -87,7 +170,7 @@ static void fill_and_check_patterns(void) {
     uint32_t pass;
     uint32_t p;
 
-    for (i = 0; i < MEM_WORDS; i++) {
+    for (i = 0; i < mem_words; i++) {
         region.mem[i] = 0u;
         shadow[i] = 0u;
     }
@@ -95,12 +178,12 @@ static void fill_and_check_patterns(void) {
     check_guards(1u);
 
     for (pass = 0; pass < 16u; pass++) {
-        for (i = 0; i < MEM_WORDS; i++) {
-            p = (0xA5A50000u | pass) ^ (i << (pass & 7u)) ^ rol32(i, pass & 31u);
+        for (i = 0; i < mem_words; i++) {
+            p = (0xA5A50000u | pass) ^ (i << (pass & 7u)) ^ rol32(i, pass & 31u) ^ data_pattern;
             region.mem[i] = p;
             shadow[i] = p;
         }
-        for (i = 0; i < MEM_WORDS; i++) {
+        for (i = 0; i < mem_words; i++) {
             ASSERT_EQ(region.mem[i], shadow[i], 2u, i);
         }
         check_guards(3u);
@@ -109,35 +192,36 @@ static void fill_and_check_patterns(void) {
 
 static void march_like_test(void) {
     uint32_t i;
+    uint32_t bg = data_pattern;
 
-    for (i = 0; i < MEM_WORDS; i++) {
-        region.mem[i] = 0u;
+    for (i = 0; i < mem_words; i++) {
+        region.mem[i] = bg;
     }
 
-    for (i = 0; i < MEM_WORDS; i++) {
-        ASSERT_EQ(region.mem[i], 0u, 10u, i);
-        region.mem[i] = 0xFFFFFFFFu;
+    for (i = 0; i < mem_words; i++) {
+        ASSERT_EQ(region.mem[i], bg, 10u, i);
+        region.mem[i] = ~bg;
     }
 
-    for (i = 0; i < MEM_WORDS; i++) {
-        ASSERT_EQ(region.mem[i], 0xFFFFFFFFu, 11u, i);
-        region.mem[i] = 0u;
+    for (i = 0; i < mem_words; i++) {
+        ASSERT_EQ(region.mem[i], ~bg, 11u, i);
+        region.mem[i] = bg;
     }
 
-    for (i = MEM_WORDS; i > 0u; i--) {
+    for (i = mem_words; i > 0u; i--) {
         uint32_t idx = i - 1u;
-        ASSERT_EQ(region.mem[idx], 0u, 12u, idx);
-        region.mem[idx] = 0xFFFFFFFFu;
+        ASSERT_EQ(region.mem[idx], bg, 12u, idx);
+        region.mem[idx] = ~bg;
     }
 
-    for (i = MEM_WORDS; i > 0u; i--) {
+    for (i = mem_words; i > 0u; i--) {
         uint32_t idx = i - 1u;
-        ASSERT_EQ(region.mem[idx], 0xFFFFFFFFu, 13u, idx);
-        region.mem[idx] = 0u;
+        ASSERT_EQ(region.mem[idx], ~bg, 13u, idx);
+        region.mem[idx] = bg;
     }
 
-    for (i = 0; i < MEM_WORDS; i++) {
-        ASSERT_EQ(region.mem[i], 0u, 14u, i);
+    for (i = 0; i < mem_words; i++) {
+        ASSERT_EQ(region.mem[i], bg, 14u, i);
     }
 
     check_guards(15u);
@@ -149,15 +233,15 @@ static void byte_halfword_alias_test(void) {
     uint32_t i;
     uint32_t expected;
 
-    for (i = 0; i < MEM_WORDS; i++) {
+    for (i = 0; i < mem_words; i++) {
         region.mem[i] = 0u;
     }
 
-    for (i = 0; i < MEM_WORDS * 4u; i++) {
-        b[i] = (uint8_t)((i * 37u) ^ 0x5Au);
+    for (i = 0; i < mem_words * 4u; i++) {
+        b[i] = (uint8_t)((i * 37u) ^ 0x5Au ^ (data_pattern >> (8u * (i & 3u))));
     }
 
-    for (i = 0; i < MEM_WORDS; i++) {
+    for (i = 0; i < mem_words; i++) {
         uint32_t base = i * 4u;
         expected =
             (uint32_t)b[base] |
@@ -167,11 +251,11 @@ static void byte_halfword_alias_test(void) {
         ASSERT_EQ(region.mem[i], expected, 20u, i);
     }
 
-    for (i = 0; i < MEM_WORDS * 2u; i++) {
-        h[i] = (uint16_t)((i * 149u) ^ 0xA55Au);
+    for (i = 0; i < mem_words * 2u; i++) {
+        h[i] = (uint16_t)((i * 149u) ^ 0xA55Au ^ (data_pattern >> (16u * (i & 1u))));
     }
 
-    for (i = 0; i < MEM_WORDS; i++) {
+    for (i = 0; i < mem_words; i++) {
         uint32_t lo = (uint32_t)h[i * 2u];
         uint32_t hi = (uint32_t)h[i * 2u + 1u];
         expected = lo | (hi << 16);
@@ -184,22 +268,26 @@ static void byte_halfword_alias_test(void) {
 static void randomized_hammer_test(void) {
     uint32_t i;
     uint32_t iter;
-    uint32_t state = 0x1BADF00Du;
+    uint32_t iters = hammer_params.iters.value;
+    uint32_t state = hammer_params.seed.value;
 
-    for (i = 0; i < MEM_WORDS; i++) {
-        uint32_t v = 0x13579BDFu ^ rol32(i, i & 31u);
+    if (state == 0u) {
+        state = DEFAULT_SEED;
+    }
+    for (i = 0; i < mem_words; i++) {
+        uint32_t v = 0x13579BDFu ^ rol32(i, i & 31u) ^ data_pattern;
         region.mem[i] = v;
         shadow[i] = v;
     }
 
-    for (iter = 0; iter < 300000u; iter++) {
+    for (iter = 0; iter < iters; iter++) {
         uint32_t idx;
         uint32_t value;
         uint32_t v_idx;
 
         state = xorshift32(state);
-        idx = state & MEM_MASK;
-        value = state ^ rol32(idx, (state >> 27u) & 31u) ^ 0x9E3779B9u;
+        idx = random_index(state);
+        value = state ^ rol32(idx, (state >> 27u) & 31u) ^ 0x9E3779B9u ^ data_pattern;
 
         region.mem[idx] = value;
         shadow[idx] = value;
@@ -207,40 +295,92 @@ static void randomized_hammer_test(void) {
         ASSERT_EQ(region.mem[idx], shadow[idx], 30u, idx);
 
         state = xorshift32(state);
-        v_idx = state & MEM_MASK;
+        v_idx = random_index(state);
         ASSERT_EQ(region.mem[v_idx], shadow[v_idx], 31u, v_idx);
 
         if ((iter & 0x7FFu) == 0u) {
-            for (i = 0; i < MEM_WORDS; i++) {
+            for (i = 0; i < mem_words; i++) {
                 ASSERT_EQ(region.mem[i], shadow[i], 32u, i);
             }
             check_guards(33u);
         }
     }
 
-    for (i = 0; i < MEM_WORDS; i++) {
+    for (i = 0; i < mem_words; i++) {
         ASSERT_EQ(region.mem[i], shadow[i], 34u, i);
     }
 
     check_guards(35u);
 }
 
+static uint32_t status_put(uint32_t pos, const char *s) {
+    while (*s != '\0' && pos < STATUS_TEXT_LEN - 1u) {
+        status_text[pos++] = *s++;
+    }
+    status_text[pos] = '\0';
+    return pos;
+}
+
+static uint32_t status_put_u32(uint32_t pos, const char *label, uint32_t v) {
+    char buf[NUM_FORMAT_U32_MAX + 1u];
+
+    num_format_u32(buf, v, 0u, '0');
+    pos = status_put(pos, label);
+    return status_put(pos, buf);
+}
+
+static uint32_t status_put_hex(uint32_t pos, const char *label, uint32_t v) {
+    char buf[9];
+
+    num_format_hex32(buf, v, 8u);
+    pos = status_put(pos, label);
+    return status_put(pos, buf);
+}
+
+static void write_status(void) {
+    uint32_t pos;
+
+    if (test_result == 0u) {
+        pos = status_put(0u, "PASS");
+    } else {
+        pos = status_put(0u, "FAIL");
+        pos = status_put_u32(pos, " phase ", fail_phase);
+        pos = status_put_u32(pos, " index ", fail_index);
+        pos = status_put_hex(pos, " expected 0x", fail_expected);
+        pos = status_put_hex(pos, " actual 0x", fail_actual);
+    }
+    (void)status_put_u32(pos, " passed ", test_passed);
+}
+
 int main(void) {
+    uint32_t phases;
+
     test_result = 0;
     test_passed = 0;
     test_failed = 0;
     fail_phase = 0;
-    fail_index = 0;
+    fail_index = FAIL_INDEX_NONE;
     fail_expected = 0;
     fail_actual = 0;
 
+    load_params();
+    phases = hammer_params.phases.value;
     init_guards();
     check_guards(0u);
 
-    fill_and_check_patterns();
-    march_like_test();
-    byte_halfword_alias_test();
-    randomized_hammer_test();
+    if (phases & PHASE_PATTERNS) {
+        fill_and_check_patterns();
+    }
+    if (phases & PHASE_MARCH) {
+        march_like_test();
+    }
+    if (phases & PHASE_ALIAS) {
+        byte_halfword_alias_test();
+    }
+    if (phases & PHASE_HAMMER) {
+        randomized_hammer_test();
+    }
 
+    write_status();
     return (int)test_result;
 }
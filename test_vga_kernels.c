@@ -0,0 +1,681 @@
+#include <stddef.h>
+#include <stdint.h>
+#include "vga_driver.h"
+#include "vga_bitmap.h"
+#include "vga_compositor.h"
+#include "vga_gradient.h"
+#include "vga_rowcache.h"
+#include "vga_sprite.h"
+#include "vga_strip.h"
+
+/*
+ * Self-checking tests for the VGA drawing kernels.
+ *
+ * Each test draws into the frame buffer with one kernel, reads the planes
+ * back and compares every pixel with a naive per-pixel reference. Reading
+ * VGA memory needs tools/rvsim's VGA model (loads return the buffer being
+ * drawn), so run the program there:
+ *   make PROGRAM=test_vga_kernels sim SIM_FLAGS="--print test_result --print fail_check"
+ * Built with -DVGA_DMA (and run with --dma) the fill and copy tests go
+ * through the blit/fill engine instead of CPU stores.
+ *
+ * test_result is 0 when every check passed. fail_check holds the CHECK_*
+ * id of the first failing check and fail_count the value it got (the
+ * number of wrong pixels for a readback check). Nothing calls swap_frame,
+ * so all drawing and reading stays in one buffer.
+ */
+
+volatile uint32_t test_result = 0;
+volatile uint32_t test_passed = 0;
+volatile uint32_t test_failed = 0;
+volatile uint32_t fail_check = 0;
+volatile uint32_t fail_count = 0;
+
+// Check ids, reported in fail_check (append only)
+enum {
+    CHECK_NONE,
+    CHECK_COMPOSE_TILEMAP,
+    CHECK_COMPOSE_TILEMAP_ALIGNED,
+    CHECK_COMPOSE_UNCOVERED_ROWS,
+    CHECK_GRADIENT_ROW,
+    CHECK_GRADIENT_COLUMN,
+    CHECK_GRADIENT_RECT_CORNERS,
+    CHECK_GRADIENT_ROW_CLIPPED,
+    CHECK_GRADIENT_COLUMN_CLIPPED,
+    CHECK_GRADIENT_RECT_CLIPPED,
+    CHECK_MASK_OVERLAP,
+    CHECK_MASK_TEST_POINT,
+    CHECK_STRIP_FLUSH,
+    CHECK_STRIP_NEIGHBOURS,
+    CHECK_FILL_RECT,
+    CHECK_FILL_RECT_SMALL,
+    CHECK_COPY_ROW,
+    CHECK_ROWCACHE_ROWS,
+    CHECK_ROWCACHE_HITS,
+    CHECK_ROWCACHE_MISSES,
+    CHECK_ROWCACHE_EVICTIONS,
+    CHECK_ROWCACHE_GEN_CALLS,
+    CHECK_BITMAP_LUT,
+    CHECK_BITMAP_EXPAND_ROW,
+    CHECK_BITMAP_DRAW,
+    CHECK_COMPOSE_EMPTY_TILEMAP,
+};
+
+#define ASSERT_EQ(actual, expected, check_id) \
+    do { \
+        uint32_t _a = (uint32_t)(actual); \
+        uint32_t _e = (uint32_t)(expected); \
+        if (_a == _e) { \
+            test_passed++; \
+        } else { \
+            test_failed++; \
+            if (test_result == 0u) { \
+                fail_check = (check_id); \
+                fail_count = _a; \
+            } \
+            test_result = 1; \
+        } \
+    } while (0)
+
+static const uint32_t plane_base[3] = { VGA_RED_BASE, VGA_GREEN_BASE, VGA_BLUE_BASE };
+
+// Reference pixel value of one plane at (x, y)
+typedef uint8_t (*ref_pixel_fn)(const void *ctx, uint32_t plane, uint32_t x, uint32_t y);
+
+static uint8_t read_pixel(uint32_t plane, uint32_t x, uint32_t y) {
+    uint8_t byte = *(volatile uint8_t *)vga_color_addr_fast(plane_base[plane], y, x >> 1);
+    return (x & 1u) ? (uint8_t)(byte >> 4) : (uint8_t)(byte & 0x0Fu);
+}
+
+// Pixels in [x0, x1) x [y0, y1) that differ from the reference, all planes
+static uint32_t count_mismatches(uint32_t x0, uint32_t x1, uint32_t y0, uint32_t y1, ref_pixel_fn ref,
+                                 const void *ctx) {
+    uint32_t bad = 0;
+
+    for (uint32_t y = y0; y < y1; ++y) {
+        for (uint32_t x = x0; x < x1; ++x) {
+            for (uint32_t plane = 0; plane < 3u; ++plane) {
+                bad += read_pixel(plane, x, y) != ref(ctx, plane, x, y);
+            }
+        }
+    }
+    return bad;
+}
+
+// Pixels of the w x h block at (xa, ya) that differ from the block at (xb, yb)
+static uint32_t count_block_diff(uint32_t xa, uint32_t ya, uint32_t xb, uint32_t yb, uint32_t w, uint32_t h) {
+    uint32_t bad = 0;
+
+    for (uint32_t y = 0; y < h; ++y) {
+        for (uint32_t x = 0; x < w; ++x) {
+            for (uint32_t plane = 0; plane < 3u; ++plane) {
+                bad += read_pixel(plane, xa + x, ya + y) != read_pixel(plane, xb + x, yb + y);
+            }
+        }
+    }
+    return bad;
+}
+
+static uint8_t ref_constant(const void *ctx, uint32_t plane, uint32_t x, uint32_t y) {
+    const Color *c = (const Color *)ctx;
+    (void)x;
+    (void)y;
+    return (plane == 0u) ? c->r : (plane == 1u) ? c->g : c->b;
+}
+
+static void clear_frame(uint8_t value) {
+    for (uint32_t y = 0; y < VGA_HEIGHT; ++y) {
+        vga_fill_rgb_row_constant_fast(y, value, value, value, VGA_WIDTH_BYTES);
+    }
+}
+
+////////////////////////////////////////////////////////////
+// Compositor: tilemap layer with wrapping and fine scroll
+////////////////////////////////////////////////////////////
+
+#define TEST_MAP_W      5u
+#define TEST_MAP_H      3u
+#define TEST_TILES      4u
+
+static vga_tile_t test_tiles[TEST_TILES];
+static uint8_t test_map[TEST_MAP_W * TEST_MAP_H];
+static vga_tilemap_layer_t test_tilemap = { test_tiles, test_map, TEST_MAP_W, TEST_MAP_H, 0u, 0u };
+
+static uint8_t tile_nibble(uint32_t tile, uint32_t row, uint32_t plane, uint32_t x) {
+    return (uint8_t)((tile * 5u + row * 3u + plane * 7u + x) & 0x0Fu);
+}
+
+static void init_tiles(void) {
+    for (uint32_t t = 0; t < TEST_TILES; ++t) {
+        for (uint32_t row = 0; row < 8u; ++row) {
+            for (uint32_t plane = 0; plane < 3u; ++plane) {
+                uint32_t w = 0;
+                for (uint32_t x = 0; x < 8u; ++x) {
+                    w |= (uint32_t)tile_nibble(t, row, plane, x) << (x * 4u);
+                }
+                test_tiles[t].row[row][plane] = w;
+            }
+        }
+    }
+    for (uint32_t i = 0; i < TEST_MAP_W * TEST_MAP_H; ++i) {
+        test_map[i] = (uint8_t)((i * 7u + 1u) % TEST_TILES);
+    }
+}
+
+static uint8_t ref_tilemap(const void *ctx, uint32_t plane, uint32_t x, uint32_t y) {
+    const vga_tilemap_layer_t *tm = (const vga_tilemap_layer_t *)ctx;
+    uint32_t px = (x + tm->scroll_x) % (tm->map_w * 8u);
+    uint32_t py = (y + tm->scroll_y) % (tm->map_h * 8u);
+    uint32_t tile = tm->map[(py / 8u) * tm->map_w + px / 8u];
+
+    return tile_nibble(tile, py % 8u, plane, px % 8u);
+}
+
+static void test_compose_tilemap(void) {
+    static const Color black = { 0u, 0u, 0u };
+    static const vga_tilemap_layer_t empty_map = { test_tiles, test_map, 0u, TEST_MAP_H, 0u, 0u };
+    static const vga_layer_t layers[1] = {
+        { vga_tilemap_layer, &test_tilemap, 8u, 40u },
+    };
+    static const vga_layer_t empty_layers[1] = {
+        { vga_tilemap_layer, &empty_map, 8u, 40u },
+    };
+
+    init_tiles();
+    clear_frame(0xFFu);
+
+    // Fine scroll past both map edges: the funnel-shift path
+    test_tilemap.scroll_x = 1003u;
+    test_tilemap.scroll_y = 70u;
+    vga_compose_rows(layers, 1u, 0u, 48u);
+    ASSERT_EQ(count_mismatches(0u, VGA_WIDTH_PIXELS, 8u, 40u, ref_tilemap, &test_tilemap), 0u,
+              CHECK_COMPOSE_TILEMAP);
+    // Rows the first layer does not cover come out black
+    ASSERT_EQ(count_mismatches(0u, VGA_WIDTH_PIXELS, 0u, 8u, ref_constant, &black) +
+                  count_mismatches(0u, VGA_WIDTH_PIXELS, 40u, 48u, ref_constant, &black),
+              0u, CHECK_COMPOSE_UNCOVERED_ROWS);
+
+    // Whole-tile scroll: the word copy path
+    test_tilemap.scroll_x = 16u;
+    test_tilemap.scroll_y = 3u;
+    vga_compose_rows(layers, 1u, 8u, 40u);
+    ASSERT_EQ(count_mismatches(0u, VGA_WIDTH_PIXELS, 8u, 40u, ref_tilemap, &test_tilemap), 0u,
+              CHECK_COMPOSE_TILEMAP_ALIGNED);
+
+    // An empty map as the first layer draws black, not the last row again
+    vga_compose_rows(empty_layers, 1u, 8u, 40u);
+    ASSERT_EQ(count_mismatches(0u, VGA_WIDTH_PIXELS, 8u, 40u, ref_constant, &black), 0u,
+              CHECK_COMPOSE_EMPTY_TILEMAP);
+}
+
+////////////////////////////////////////////////////////////
+// Gradients: endpoints, linearity, clipping
+////////////////////////////////////////////////////////////
+
+static const Color grad_a = { 0x0u, 0x4u, 0xFu };
+static const Color grad_b = { 0xFu, 0x9u, 0x1u };
+static const Color grad_c = { 0x3u, 0xFu, 0x3u };
+static const Color grad_d = { 0x8u, 0x0u, 0xCu };
+
+static uint8_t channel(Color c, uint32_t plane) {
+    return (plane == 0u) ? c.r : (plane == 1u) ? c.g : c.b;
+}
+
+// Pixels of an n-pixel run from (x, y), stepping (dx, dy), that are not
+// within one level of the straight line from c0 to c1 or that miss an
+// endpoint: p * (n - 1) must be within n - 1 of c0 * (n - 1) + (c1 - c0) * i
+static uint32_t count_gradient_errors(uint32_t x, uint32_t y, uint32_t dx, uint32_t dy, uint32_t n, Color c0,
+                                      Color c1) {
+    uint32_t bad = 0;
+
+    for (uint32_t plane = 0; plane < 3u; ++plane) {
+        int32_t v0 = channel(c0, plane);
+        int32_t v1 = channel(c1, plane);
+        int32_t span = (int32_t)n - 1;
+        for (uint32_t i = 0; i < n; ++i) {
+            int32_t p = read_pixel(plane, x + i * dx, y + i * dy);
+            int32_t err = p * span - (v0 * span + (v1 - v0) * (int32_t)i);
+            if (err <= -span || err >= span) {
+                bad++;
+            }
+        }
+        bad += read_pixel(plane, x, y) != (uint8_t)v0;
+        bad += read_pixel(plane, x + (n - 1u) * dx, y + (n - 1u) * dy) != (uint8_t)v1;
+    }
+    return bad;
+}
+
+static uint32_t count_corner_errors(uint32_t x0, uint32_t y0, uint32_t x1, uint32_t y1, Color tl, Color tr,
+                                    Color bl, Color br) {
+    uint32_t bad = 0;
+
+    for (uint32_t plane = 0; plane < 3u; ++plane) {
+        bad += read_pixel(plane, x0, y0) != channel(tl, plane);
+        bad += read_pixel(plane, x1, y0) != channel(tr, plane);
+        bad += read_pixel(plane, x0, y1) != channel(bl, plane);
+        bad += read_pixel(plane, x1, y1) != channel(br, plane);
+    }
+    return bad;
+}
+
+static void test_gradients(void) {
+    // Odd start byte: leading bytes, word body and trailing bytes
+    clear_frame(0x00u);
+    vga_gradient_row(50u, 3u, 73u, grad_a, grad_b);
+    ASSERT_EQ(count_gradient_errors(6u, 50u, 1u, 0u, 146u, grad_a, grad_b), 0u, CHECK_GRADIENT_ROW);
+
+    // Both pixels of the column byte, top to bottom
+    vga_gradient_column(10u, 70u, 100u, grad_b, grad_c);
+    ASSERT_EQ(count_gradient_errors(140u, 10u, 0u, 1u, 100u, grad_b, grad_c) +
+                  count_gradient_errors(141u, 10u, 0u, 1u, 100u, grad_b, grad_c),
+              0u, CHECK_GRADIENT_COLUMN);
+
+    vga_gradient_rect(20u, 10u, 30u, 40u, grad_a, grad_b, grad_c, grad_d);
+    ASSERT_EQ(count_corner_errors(20u, 20u, 79u, 59u, grad_a, grad_b, grad_c, grad_d), 0u,
+              CHECK_GRADIENT_RECT_CORNERS);
+
+    // Clipped spans keep the steps of the requested extent: the visible part
+    // matches the same gradient drawn fully on screen
+    clear_frame(0x00u);
+    vga_gradient_row(0u, 60u, 40u, grad_a, grad_b);
+    vga_gradient_row(1u, 0u, 40u, grad_a, grad_b);
+    ASSERT_EQ(count_block_diff(120u, 0u, 0u, 1u, 40u, 1u), 0u, CHECK_GRADIENT_ROW_CLIPPED);
+
+    vga_gradient_column(100u, 5u, 40u, grad_b, grad_c);
+    vga_gradient_column(0u, 6u, 40u, grad_b, grad_c);
+    ASSERT_EQ(count_block_diff(10u, 100u, 12u, 0u, 2u, 20u), 0u, CHECK_GRADIENT_COLUMN_CLIPPED);
+
+    // Off the bottom and off the right edge
+    clear_frame(0x00u);
+    vga_gradient_rect(100u, 60u, 40u, 40u, grad_a, grad_b, grad_c, grad_d);
+    vga_gradient_rect(0u, 0u, 40u, 40u, grad_a, grad_b, grad_c, grad_d);
+    ASSERT_EQ(count_block_diff(120u, 100u, 0u, 0u, 40u, 20u), 0u, CHECK_GRADIENT_RECT_CLIPPED);
+}
+
+////////////////////////////////////////////////////////////
+// Sprite masks: SWAR overlap against a per-pixel search
+////////////////////////////////////////////////////////////
+
+#define TEST_MASK_A_W   40u
+#define TEST_MASK_A_H   13u
+#define TEST_MASK_B_W   70u
+#define TEST_MASK_B_H   9u
+
+static uint32_t test_mask_a_bits[TEST_MASK_A_H * VGA_MASK_WORDS_PER_ROW(TEST_MASK_A_W)];
+static uint32_t test_mask_b_bits[TEST_MASK_B_H * VGA_MASK_WORDS_PER_ROW(TEST_MASK_B_W)];
+static const vga_mask_t test_mask_a = {
+    test_mask_a_bits, TEST_MASK_A_W, TEST_MASK_A_H, VGA_MASK_WORDS_PER_ROW(TEST_MASK_A_W)
+};
+static const vga_mask_t test_mask_b = {
+    test_mask_b_bits, TEST_MASK_B_W, TEST_MASK_B_H, VGA_MASK_WORDS_PER_ROW(TEST_MASK_B_W)
+};
+
+static uint32_t xorshift32(uint32_t *state) {
+    uint32_t x = *state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    *state = x;
+    return x;
+}
+
+// About one pixel in 32 set, so placements both hit and miss
+static void fill_sparse_mask(uint32_t *bits, uint32_t width, uint32_t height, uint32_t *seed) {
+    for (uint32_t y = 0; y < height; ++y) {
+        for (uint32_t x = 0; x < width; ++x) {
+            if ((xorshift32(seed) & 31u) == 0u) {
+                vga_mask_fill_rect(bits, VGA_MASK_WORDS_PER_ROW(width), x, y, 1u, 1u);
+            }
+        }
+    }
+}
+
+static int mask_bit(const vga_mask_t *m, int32_t x, int32_t y) {
+    if (x < 0 || y < 0 || x >= (int32_t)m->width || y >= (int32_t)m->height) {
+        return 0;
+    }
+    return (int)((m->bits[(uint32_t)y * m->words_per_row + ((uint32_t)x >> 5)] >> ((uint32_t)x & 31u)) & 1u);
+}
+
+static int naive_overlap(const vga_mask_t *a, const vga_mask_t *b, int32_t dx, int32_t dy) {
+    for (int32_t y = 0; y < (int32_t)a->height; ++y) {
+        for (int32_t x = 0; x < (int32_t)a->width; ++x) {
+            if (mask_bit(a, x, y) && mask_bit(b, x - dx, y - dy)) {
+                return 1;
+            }
+        }
+    }
+    return 0;
+}
+
+static void test_mask_overlap(void) {
+    uint32_t seed = 0x2545F491u;
+    uint32_t overlap_bad = 0;
+    uint32_t point_bad = 0;
+
+    fill_sparse_mask(test_mask_a_bits, TEST_MASK_A_W, TEST_MASK_A_H, &seed);
+    fill_sparse_mask(test_mask_b_bits, TEST_MASK_B_W, TEST_MASK_B_H, &seed);
+
+    // b at every third X offset across and past a (word splits on both
+    // sides, negative offsets) and every row offset; a is not at the origin
+    for (int32_t dy = -(int32_t)TEST_MASK_B_H; dy <= (int32_t)TEST_MASK_A_H; ++dy) {
+        for (int32_t dx = -(int32_t)TEST_MASK_B_W - 1; dx <= (int32_t)TEST_MASK_A_W + 1; dx += 3) {
+            int got = vga_mask_overlap(&test_mask_a, 5, -3, &test_mask_b, 5 + dx, -3 + dy);
+            overlap_bad += (got != 0) != naive_overlap(&test_mask_a, &test_mask_b, dx, dy);
+        }
+    }
+    ASSERT_EQ(overlap_bad, 0u, CHECK_MASK_OVERLAP);
+
+    for (int32_t y = -2; y < (int32_t)TEST_MASK_B_H + 2; ++y) {
+        for (int32_t x = -2; x < (int32_t)TEST_MASK_B_W + 2; ++x) {
+            int got = vga_mask_test_point(&test_mask_b, 7, 3, x + 7, y + 3);
+            point_bad += (got != 0) != mask_bit(&test_mask_b, x, y);
+        }
+    }
+    ASSERT_EQ(point_bad, 0u, CHECK_MASK_TEST_POINT);
+}
+
+////////////////////////////////////////////////////////////
+// Column strip: nibble transpose on flush
+////////////////////////////////////////////////////////////
+
+#define TEST_STRIP_X_WORD   7u
+#define TEST_VLINE_COL      3u
+#define TEST_VLINE_Y0       17u
+#define TEST_VLINE_Y1       90u
+#define TEST_COLUMN_COL     6u
+#define TEST_COLUMN_Y0      5u
+#define TEST_COLUMN_LEN     50u
+
+static vga_strip_t test_strip;
+static const Color test_vline_color = { 0xAu, 0x3u, 0xEu };
+
+static uint8_t strip_pattern(uint32_t col, uint32_t y, uint32_t plane) {
+    return (uint8_t)((col * 11u + y * 7u + plane * 5u + (y >> 3)) & 0x0Fu);
+}
+
+static uint8_t column_pattern(uint32_t i, uint32_t plane) {
+    return (uint8_t)((i * 3u + plane * 4u + 1u) & 0x0Fu);
+}
+
+// ctx: the vline color
+static uint8_t ref_strip(const void *ctx, uint32_t plane, uint32_t x, uint32_t y) {
+    uint32_t col = x - TEST_STRIP_X_WORD * 8u;
+
+    if (col == TEST_COLUMN_COL && y >= TEST_COLUMN_Y0 && y < TEST_COLUMN_Y0 + TEST_COLUMN_LEN) {
+        return column_pattern(y - TEST_COLUMN_Y0, plane);
+    }
+    if (col == TEST_VLINE_COL && y >= TEST_VLINE_Y0 && y < TEST_VLINE_Y1) {
+        return channel(*(const Color *)ctx, plane);
+    }
+    return strip_pattern(col, y, plane);
+}
+
+static void test_strip_flush(void) {
+    static const Color black = { 0u, 0u, 0u };
+    uint8_t col_r[TEST_COLUMN_LEN];
+    uint8_t col_g[TEST_COLUMN_LEN];
+    uint8_t col_b[TEST_COLUMN_LEN];
+
+    for (uint32_t col = 0; col < VGA_STRIP_COLUMNS; ++col) {
+        for (uint32_t y = 0; y < VGA_HEIGHT; ++y) {
+            Color c = { strip_pattern(col, y, 0u), strip_pattern(col, y, 1u), strip_pattern(col, y, 2u) };
+            vga_strip_put(&test_strip, col, y, c);
+        }
+    }
+    vga_strip_vline(&test_strip, TEST_VLINE_COL, TEST_VLINE_Y0, TEST_VLINE_Y1, test_vline_color);
+    for (uint32_t i = 0; i < TEST_COLUMN_LEN; ++i) {
+        col_r[i] = column_pattern(i, 0u);
+        col_g[i] = column_pattern(i, 1u);
+        col_b[i] = column_pattern(i, 2u);
+    }
+    vga_strip_column(&test_strip, TEST_COLUMN_COL, TEST_COLUMN_Y0, col_r, col_g, col_b, TEST_COLUMN_LEN);
+
+    clear_frame(0x00u);
+    vga_strip_flush(&test_strip, TEST_STRIP_X_WORD);
+    ASSERT_EQ(count_mismatches(TEST_STRIP_X_WORD * 8u, TEST_STRIP_X_WORD * 8u + 8u, 0u, VGA_HEIGHT, ref_strip,
+                               &test_vline_color),
+              0u, CHECK_STRIP_FLUSH);
+    ASSERT_EQ(count_mismatches(0u, TEST_STRIP_X_WORD * 8u, 0u, VGA_HEIGHT, ref_constant, &black) +
+                  count_mismatches(TEST_STRIP_X_WORD * 8u + 8u, VGA_WIDTH_PIXELS, 0u, VGA_HEIGHT, ref_constant,
+                                   &black),
+              0u, CHECK_STRIP_NEIGHBOURS);
+}
+
+////////////////////////////////////////////////////////////
+// Rect fill and row copy (the blit/fill engine under VGA_DMA)
+////////////////////////////////////////////////////////////
+
+typedef struct {
+    uint32_t x_byte;
+    uint32_t y;
+    uint32_t width;         // bytes
+    uint32_t height;
+    uint8_t bytes[3];       // per plane inside the rect
+    uint8_t outside;        // every byte outside it
+} test_rect_t;
+
+static uint8_t ref_rect(const void *ctx, uint32_t plane, uint32_t x, uint32_t y) {
+    const test_rect_t *rect = (const test_rect_t *)ctx;
+    uint32_t xb = x >> 1;
+    uint8_t byte = rect->outside;
+
+    if (xb >= rect->x_byte && xb < rect->x_byte + rect->width && y >= rect->y && y < rect->y + rect->height) {
+        byte = rect->bytes[plane];
+    }
+    return (x & 1u) ? (uint8_t)(byte >> 4) : (uint8_t)(byte & 0x0Fu);
+}
+
+static uint8_t copy_row_byte(uint32_t xb, uint32_t plane) {
+    return (uint8_t)(xb * 13u + plane * 0x55u + 7u);
+}
+
+static uint8_t ref_copy_row(const void *ctx, uint32_t plane, uint32_t x, uint32_t y) {
+    uint8_t byte = copy_row_byte(x >> 1, plane);
+    (void)ctx;
+    (void)y;
+    return (x & 1u) ? (uint8_t)(byte >> 4) : (uint8_t)(byte & 0x0Fu);
+}
+
+static void test_fill_and_copy(void) {
+    static const test_rect_t big = { 13u, 30u, 37u, 21u, { 0x5Au, 0xC3u, 0x0Fu }, 0x77u };
+    static const test_rect_t small = { 70u, 100u, 3u, 2u, { 0x12u, 0x34u, 0x56u }, 0x77u };
+    uint8_t row_r[VGA_WIDTH_BYTES];
+    uint8_t row_g[VGA_WIDTH_BYTES];
+    uint8_t row_b[VGA_WIDTH_BYTES];
+
+    // The whole frame, so stray engine rows outside the rect show up too
+    clear_frame(big.outside);
+    fill_rgb_rect_constant(big.y, big.x_byte, big.width, big.height, big.bytes[0], big.bytes[1], big.bytes[2]);
+    vga_dma_wait();
+    ASSERT_EQ(count_mismatches(0u, VGA_WIDTH_PIXELS, 0u, VGA_HEIGHT, ref_rect, &big), 0u, CHECK_FILL_RECT);
+
+    // 3x2 = 6 bytes per plane, below VGA_DMA_MIN_BYTES: CPU stores in either build
+    clear_frame(small.outside);
+    fill_rgb_rect_constant(small.y, small.x_byte, small.width, small.height, small.bytes[0], small.bytes[1],
+                           small.bytes[2]);
+    ASSERT_EQ(count_mismatches(0u, VGA_WIDTH_PIXELS, 96u, 106u, ref_rect, &small), 0u, CHECK_FILL_RECT_SMALL);
+
+    for (uint32_t xb = 0; xb < VGA_WIDTH_BYTES; ++xb) {
+        row_r[xb] = copy_row_byte(xb, 0u);
+        row_g[xb] = copy_row_byte(xb, 1u);
+        row_b[xb] = copy_row_byte(xb, 2u);
+    }
+    write_rgb_row_bytes(77u, row_r, row_g, row_b, VGA_WIDTH_BYTES);
+    // Engine copies complete in the background
+    vga_dma_wait();
+    ASSERT_EQ(count_mismatches(0u, VGA_WIDTH_PIXELS, 77u, 78u, ref_copy_row, NULL), 0u, CHECK_COPY_ROW);
+}
+
+////////////////////////////////////////////////////////////
+// Row cache: rows written from cached slots, LRU bookkeeping
+////////////////////////////////////////////////////////////
+
+#define TEST_ROWCACHE_Y     60u
+
+typedef struct {
+    uint8_t gen;
+    uint8_t param;
+} test_row_key_t;
+
+static uint32_t test_gen_calls;
+
+static uint8_t cached_row_byte(uint32_t gen, uint32_t param, uint32_t xb, uint32_t plane) {
+    return (uint8_t)(xb * (3u + gen) + param * 0x29u + plane * 0x47u);
+}
+
+static void gen_test_row(const void *ctx, uint32_t param, uint8_t *red, uint8_t *green, uint8_t *blue) {
+    uint32_t gen = *(const uint8_t *)ctx;
+
+    test_gen_calls++;
+    for (uint32_t xb = 0; xb < VGA_WIDTH_BYTES; ++xb) {
+        red[xb] = cached_row_byte(gen, param, xb, 0u);
+        green[xb] = cached_row_byte(gen, param, xb, 1u);
+        blue[xb] = cached_row_byte(gen, param, xb, 2u);
+    }
+}
+
+static uint8_t ref_cached_row(const void *ctx, uint32_t plane, uint32_t x, uint32_t y) {
+    const test_row_key_t *key = (const test_row_key_t *)ctx;
+    uint8_t byte = cached_row_byte(key->gen, key->param, x >> 1, plane);
+    (void)y;
+    return (x & 1u) ? (uint8_t)(byte >> 4) : (uint8_t)(byte & 0x0Fu);
+}
+
+static const uint8_t test_gen_ids[2] = { 0u, 1u };
+static const vga_row_gen_t test_row_gens[2] = {
+    { gen_test_row, &test_gen_ids[0] },
+    { gen_test_row, &test_gen_ids[1] },
+};
+static vga_rowcache_slot_t test_row_arena[2];
+static vga_rowcache_t test_rows;
+
+static void test_rowcache(void) {
+    // With two slots: miss, miss, hit, miss (evicts 0/1), hit, hit,
+    // miss (evicts 1/0), miss (evicts 0/0)
+    static const test_row_key_t keys[8] = {
+        { 0u, 0u }, { 0u, 1u }, { 0u, 0u }, { 1u, 0u }, { 1u, 0u }, { 0u, 0u }, { 0u, 1u }, { 1u, 0u },
+    };
+    uint32_t bad = 0;
+
+    vga_rowcache_init(&test_rows, test_row_arena, sizeof(test_row_arena), test_row_gens, 2u);
+    test_gen_calls = 0u;
+    for (uint32_t i = 0; i < 8u; ++i) {
+        vga_rowcache_write(&test_rows, TEST_ROWCACHE_Y + i, keys[i].gen, keys[i].param);
+    }
+    // Dropping generator 1 frees its slot: the next (1, 0) misses without an eviction
+    vga_rowcache_invalidate(&test_rows, 1u);
+    vga_rowcache_write(&test_rows, TEST_ROWCACHE_Y + 8u, 1u, 0u);
+    vga_rowcache_write(&test_rows, TEST_ROWCACHE_Y + 9u, 0u, 1u);
+
+    for (uint32_t i = 0; i < 8u; ++i) {
+        bad += count_mismatches(0u, VGA_WIDTH_PIXELS, TEST_ROWCACHE_Y + i, TEST_ROWCACHE_Y + i + 1u, ref_cached_row,
+                                &keys[i]);
+    }
+    bad += count_mismatches(0u, VGA_WIDTH_PIXELS, TEST_ROWCACHE_Y + 8u, TEST_ROWCACHE_Y + 9u, ref_cached_row,
+                            &keys[3]);
+    bad += count_mismatches(0u, VGA_WIDTH_PIXELS, TEST_ROWCACHE_Y + 9u, TEST_ROWCACHE_Y + 10u, ref_cached_row,
+                            &keys[1]);
+    ASSERT_EQ(bad, 0u, CHECK_ROWCACHE_ROWS);
+    ASSERT_EQ(test_rows.hits, 4u, CHECK_ROWCACHE_HITS);
+    ASSERT_EQ(test_rows.misses, 6u, CHECK_ROWCACHE_MISSES);
+    ASSERT_EQ(test_rows.evictions, 3u, CHECK_ROWCACHE_EVICTIONS);
+    ASSERT_EQ(test_gen_calls, test_rows.misses, CHECK_ROWCACHE_GEN_CALLS);
+}
+
+////////////////////////////////////////////////////////////
+// 1-bpp bitmaps: lookup table, row expansion, draw
+////////////////////////////////////////////////////////////
+
+#define TEST_ICON_BYTES     3u
+#define TEST_ICON_STRIDE    5u
+#define TEST_ICON_H         11u
+#define TEST_ICON_Y         90u
+#define TEST_ICON_X_WORD    17u
+
+static vga_bitmap_lut_t test_lut;
+static uint8_t test_icon[TEST_ICON_H * TEST_ICON_STRIDE];
+static const Color test_fg = { 0xEu, 0x2u, 0x9u };
+static const Color test_bg = { 0x1u, 0xBu, 0x6u };
+
+// Bit i of a source byte in plane nibble i of the packed word
+static uint32_t count_expand_errors(uint32_t word, uint32_t byte, uint32_t plane) {
+    uint32_t bad = 0;
+
+    for (uint32_t i = 0; i < 8u; ++i) {
+        uint8_t want = channel(((byte >> i) & 1u) ? test_fg : test_bg, plane);
+        bad += ((word >> (i * 4u)) & 0x0Fu) != want;
+    }
+    return bad;
+}
+
+// ctx: the frame-buffer value outside the icon
+static uint8_t ref_icon(const void *ctx, uint32_t plane, uint32_t x, uint32_t y) {
+    uint32_t dx = x - TEST_ICON_X_WORD * 8u;
+    uint32_t dy = y - TEST_ICON_Y;
+    uint8_t byte;
+
+    if (dx >= TEST_ICON_BYTES * 8u || dy >= TEST_ICON_H) {
+        return *(const uint8_t *)ctx;
+    }
+    byte = test_icon[dy * TEST_ICON_STRIDE + (dx >> 3)];
+    return channel(((byte >> (dx & 7u)) & 1u) ? test_fg : test_bg, plane);
+}
+
+static void test_bitmap(void) {
+    static const uint8_t outside = 0x7u;
+    uint32_t red[TEST_ICON_BYTES];
+    uint32_t green[TEST_ICON_BYTES];
+    uint32_t blue[TEST_ICON_BYTES];
+    uint32_t lut_bad = 0;
+    uint32_t row_bad = 0;
+    uint32_t seed = 0x9E3779B9u;
+
+    vga_bitmap_lut_build(&test_lut, test_fg, test_bg);
+    for (uint32_t v = 0; v < 256u; ++v) {
+        lut_bad += count_expand_errors(test_lut.r[v], v, 0u);
+        lut_bad += count_expand_errors(test_lut.g[v], v, 1u);
+        lut_bad += count_expand_errors(test_lut.b[v], v, 2u);
+    }
+    ASSERT_EQ(lut_bad, 0u, CHECK_BITMAP_LUT);
+
+    for (uint32_t i = 0; i < TEST_ICON_H * TEST_ICON_STRIDE; ++i) {
+        test_icon[i] = (uint8_t)xorshift32(&seed);
+    }
+    for (uint32_t y = 0; y < TEST_ICON_H; ++y) {
+        const uint8_t *bits = &test_icon[y * TEST_ICON_STRIDE];
+        vga_bitmap_expand_row(&test_lut, bits, TEST_ICON_BYTES, red, green, blue);
+        for (uint32_t i = 0; i < TEST_ICON_BYTES; ++i) {
+            row_bad += count_expand_errors(red[i], bits[i], 0u);
+            row_bad += count_expand_errors(green[i], bits[i], 1u);
+            row_bad += count_expand_errors(blue[i], bits[i], 2u);
+        }
+    }
+    ASSERT_EQ(row_bad, 0u, CHECK_BITMAP_EXPAND_ROW);
+
+    // At the right edge, rows stride bytes apart; the pixels around it stay
+    clear_frame((uint8_t)(outside | (outside << 4)));
+    vga_bitmap_draw(&test_lut, test_icon, TEST_ICON_BYTES, TEST_ICON_H, TEST_ICON_STRIDE, TEST_ICON_Y,
+                    TEST_ICON_X_WORD);
+    ASSERT_EQ(count_mismatches(0u, VGA_WIDTH_PIXELS, TEST_ICON_Y - 2u, TEST_ICON_Y + TEST_ICON_H + 2u, ref_icon,
+                               &outside),
+              0u, CHECK_BITMAP_DRAW);
+}
+
+int main(void) {
+    test_result = 0;
+    test_passed = 0;
+    test_failed = 0;
+    fail_check = CHECK_NONE;
+    fail_count = 0;
+
+    test_compose_tilemap();
+    test_gradients();
+    test_mask_overlap();
+    test_strip_flush();
+    test_fill_and_copy();
+    test_rowcache();
+    test_bitmap();
+
+    return (int)test_result;
+}
@@ -0,0 +1,168 @@
+/*
+ * Compare two benchmark result sets (bench_table.h) and flag regressions.
+ *
+ * Each input is a CSV written by tools/rvsim --bench-out (or by this tool
+ * with one input), or a RAM dump (.bin / .mem of the whole RAM) taken after
+ * the program set bench_table.done. Records are matched by id.
+ *
+ * Cycles are compared on the median. A change counts only when it is
+ * larger than all of:
+ *   --rel PCT       percent of the base median (default 3)
+ *   --noise K       K times the larger half-spread (max - min) / 2 of the
+ *                   two runs (default 1.0), so jittery benchmarks need a
+ *                   bigger move than steady ones
+ *   --min-cycles N  absolute floor (default 2)
+ * MMIO store and byte counts are measured per call (the most of any call)
+ * and do not jitter, so any increase is a regression.
+ *
+ * Usage:
+ *   tools/bench_compare [options] base new     compare, exit 1 on a regression
+ *   tools/bench_compare [--ram-base A] input   print the set as CSV
+ *     --all                 list unchanged records too
+ *     --ram-base A          RAM base of dumps (default 0x0)
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "bench_results.h"
+
+typedef enum { V_SAME, V_FASTER, V_SLOWER, V_MISSING, V_ADDED } verdict_t;
+
+static const bench_row_t *find_row(const bench_results_t *r, uint32_t id) {
+    for (uint32_t i = 0; i < r->count; ++i) {
+        if (r->rows[i].id == id) {
+            return &r->rows[i];
+        }
+    }
+    return NULL;
+}
+
+static double cycle_limit(const bench_row_t *a, const bench_row_t *b, double rel, double noise_k,
+                          double min_cycles) {
+    double spread_a = (double)(a->cycles_max - a->cycles_min) / 2.0;
+    double spread_b = (double)(b->cycles_max - b->cycles_min) / 2.0;
+    double limit = (double)a->cycles_median * rel / 100.0;
+
+    if (noise_k * (spread_a > spread_b ? spread_a : spread_b) > limit) {
+        limit = noise_k * (spread_a > spread_b ? spread_a : spread_b);
+    }
+    return limit > min_cycles ? limit : min_cycles;
+}
+
+static void usage(const char *argv0) {
+    fprintf(stderr,
+            "usage: %s [--rel PCT] [--noise K] [--min-cycles N] [--all] [--ram-base A] base new\n"
+            "       %s [--ram-base A] input\n",
+            argv0, argv0);
+}
+
+int main(int argc, char **argv) {
+    const char *paths[2] = { NULL, NULL };
+    unsigned path_count = 0;
+    double rel = 3.0;
+    double noise_k = 1.0;
+    double min_cycles = 2.0;
+    uint32_t ram_base = 0x0u;
+    int all = 0;
+    static bench_results_t sets[2];
+    unsigned counts[5] = { 0 };
+    unsigned store_regressions = 0;
+    int cycles_valid;
+
+    for (int i = 1; i < argc; ++i) {
+        if (strcmp(argv[i], "--rel") == 0 && i + 1 < argc) {
+            rel = strtod(argv[++i], NULL);
+        } else if (strcmp(argv[i], "--noise") == 0 && i + 1 < argc) {
+            noise_k = strtod(argv[++i], NULL);
+        } else if (strcmp(argv[i], "--min-cycles") == 0 && i + 1 < argc) {
+            min_cycles = strtod(argv[++i], NULL);
+        } else if (strcmp(argv[i], "--ram-base") == 0 && i + 1 < argc) {
+            ram_base = (uint32_t)strtoul(argv[++i], NULL, 0);
+        } else if (strcmp(argv[i], "--all") == 0) {
+            all = 1;
+        } else if (argv[i][0] != '-' && path_count < 2u) {
+            paths[path_count++] = argv[i];
+        } else {
+            usage(argv[0]);
+            return 2;
+        }
+    }
+    if (path_count == 0u) {
+        usage(argv[0]);
+        return 2;
+    }
+    for (unsigned k = 0; k < path_count; ++k) {
+        if (bench_results_load(paths[k], ram_base, &sets[k]) != 0) {
+            return 2;
+        }
+        if (!sets[k].done) {
+            fprintf(stderr, "bench_compare: warning: %s: table not marked done (run cut short?)\n", paths[k]);
+        }
+    }
+    if (path_count == 1u) {
+        return bench_results_write_csv(&sets[0], stdout) == 0 ? 0 : 1;
+    }
+
+    cycles_valid = sets[0].cycle_source == BENCH_SOURCE_CYCLE_CSR &&
+                   sets[1].cycle_source == BENCH_SOURCE_CYCLE_CSR;
+    printf("bench_compare: %s -> %s\n", paths[0], paths[1]);
+    if (!cycles_valid) {
+        printf("  cycles not compared: a run has no cycle counter (source=none)\n");
+    }
+    printf("  %4s  %-34s %10s %10s %9s %8s  %s\n", "id", "name", "base", "new", "delta", "limit", "verdict");
+
+    for (uint32_t i = 0; i < sets[0].count; ++i) {
+        const bench_row_t *a = &sets[0].rows[i];
+        const bench_row_t *b = find_row(&sets[1], a->id);
+        verdict_t v = V_SAME;
+        double delta = 0.0;
+        double limit = 0.0;
+        int stores_up = 0;
+        int stores_changed = 0;
+
+        if (b == NULL) {
+            v = V_MISSING;
+        } else {
+            stores_changed = a->mmio_stores != b->mmio_stores || a->mmio_bytes != b->mmio_bytes;
+            stores_up = b->mmio_stores > a->mmio_stores || b->mmio_bytes > a->mmio_bytes;
+            if (cycles_valid) {
+                delta = (double)b->cycles_median - (double)a->cycles_median;
+                limit = cycle_limit(a, b, rel, noise_k, min_cycles);
+                v = (delta > limit) ? V_SLOWER : (-delta > limit) ? V_FASTER : V_SAME;
+            }
+        }
+        counts[v]++;
+        store_regressions += (unsigned)stores_up;
+        if (v == V_SAME && !stores_changed && !all) {
+            continue;
+        }
+        if (v == V_MISSING) {
+            printf("  %4u  %-34s %10u %10s %9s %8s  missing\n", a->id, a->name, a->cycles_median, "-", "-", "-");
+            continue;
+        }
+        printf("  %4u  %-34s %10u %10u %+8.1f%% %8.1f  %s", a->id, a->name, a->cycles_median, b->cycles_median,
+               a->cycles_median ? 100.0 * delta / (double)a->cycles_median : 0.0, limit,
+               v == V_SLOWER ? "REGRESSED" : v == V_FASTER ? "improved" : "same");
+        if (stores_changed) {
+            printf("  stores %u->%u, bytes %u->%u%s", a->mmio_stores, b->mmio_stores, a->mmio_bytes,
+                   b->mmio_bytes, stores_up ? " (REGRESSED)" : "");
+        }
+        printf("\n");
+    }
+    for (uint32_t i = 0; i < sets[1].count; ++i) {
+        const bench_row_t *b = &sets[1].rows[i];
+        if (find_row(&sets[0], b->id) == NULL) {
+            counts[V_ADDED]++;
+            printf("  %4u  %-34s %10s %10u %9s %8s  added\n", b->id, b->name, "-", b->cycles_median, "-", "-");
+        }
+    }
+    printf("  %u compared: %u regressed, %u improved, %u store-count regressions, %u missing, %u added\n",
+           counts[V_SAME] + counts[V_FASTER] + counts[V_SLOWER], counts[V_SLOWER], counts[V_FASTER],
+           store_regressions, counts[V_MISSING], counts[V_ADDED]);
+    return (counts[V_SLOWER] != 0u || store_regressions != 0u) ? 1 : 0;
+}
@@ -0,0 +1,190 @@
+/*
+ * Benchmark result tables, host side. See bench_results.h.
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "bench_results.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "params_image.h"
+
+#define HEADER_WORDS 8u
+#define RECORD_WORDS 8u
+
+static uint32_t get32(const uint8_t *p) {
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+const char *bench_source_name(uint32_t source) {
+    return (source == BENCH_SOURCE_CYCLE_CSR) ? "cycle" : (source == BENCH_SOURCE_NONE) ? "none" : "?";
+}
+
+static void ram_string(char *dst, size_t len, const uint8_t *ram, uint32_t ram_base, uint32_t ram_size,
+                       uint32_t addr, uint32_t id) {
+    uint32_t off = addr - ram_base;
+    size_t n = 0;
+
+    while (off + n < ram_size && n + 1u < len && ram[off + n] >= 0x20u && ram[off + n] < 0x7Fu &&
+           ram[off + n] != ',') {
+        dst[n] = (char)ram[off + n];
+        ++n;
+    }
+    if (addr < ram_base || off + n >= ram_size || n == 0u || n + 1u == len || ram[off + n] != 0u) {
+        snprintf(dst, len, "id%u", id);
+        return;
+    }
+    dst[n] = '\0';
+}
+
+int bench_results_from_ram(bench_results_t *out, const uint8_t *ram, uint32_t ram_base, uint32_t ram_size) {
+    uint32_t off = BENCH_TABLE_ADDR - ram_base;
+    const uint8_t *t;
+
+    if (BENCH_TABLE_ADDR < ram_base || off > ram_size ||
+        ram_size - off < 4u * (HEADER_WORDS + RECORD_WORDS * BENCH_TABLE_MAX)) {
+        return -1;
+    }
+    t = ram + off;
+    if (get32(t) != BENCH_TABLE_MAGIC || get32(t + 4u) != BENCH_TABLE_VERSION ||
+        get32(t + 8u) > BENCH_TABLE_MAX) {
+        return -1;
+    }
+    memset(out, 0, sizeof(*out));
+    out->version = get32(t + 4u);
+    out->count = get32(t + 8u);
+    out->done = get32(t + 16u);
+    out->cycle_source = get32(t + 20u);
+    out->counter_overhead = get32(t + 24u);
+    out->run_id = get32(t + 28u);
+    for (uint32_t i = 0; i < out->count; ++i) {
+        const uint8_t *r = t + 4u * (HEADER_WORDS + RECORD_WORDS * i);
+        bench_row_t *row = &out->rows[i];
+        row->id = get32(r);
+        ram_string(row->name, sizeof(row->name), ram, ram_base, ram_size, get32(r + 4u), row->id);
+        row->iterations = get32(r + 8u);
+        row->cycles_min = get32(r + 12u);
+        row->cycles_median = get32(r + 16u);
+        row->cycles_max = get32(r + 20u);
+        row->mmio_stores = get32(r + 24u);
+        row->mmio_bytes = get32(r + 28u);
+    }
+    return 0;
+}
+
+int bench_results_write_csv(const bench_results_t *r, FILE *fp) {
+    fprintf(fp, "# bench_table v%u source=%s overhead=%u run_id=%u done=%u\n", r->version,
+            bench_source_name(r->cycle_source), r->counter_overhead, r->run_id, r->done);
+    fprintf(fp, "id,name,iterations,cycles_min,cycles_median,cycles_max,mmio_stores,mmio_bytes\n");
+    for (uint32_t i = 0; i < r->count; ++i) {
+        const bench_row_t *row = &r->rows[i];
+        fprintf(fp, "%u,%s,%u,%u,%u,%u,%u,%u\n", row->id, row->name, row->iterations, row->cycles_min,
+                row->cycles_median, row->cycles_max, row->mmio_stores, row->mmio_bytes);
+    }
+    return ferror(fp) ? -1 : 0;
+}
+
+static int parse_header(const char *line, bench_results_t *out) {
+    char source[16];
+
+    if (sscanf(line, "# bench_table v%u source=%15s overhead=%u run_id=%u done=%u", &out->version, source,
+               &out->counter_overhead, &out->run_id, &out->done) != 5) {
+        return -1;
+    }
+    out->cycle_source = (strcmp(source, "cycle") == 0) ? BENCH_SOURCE_CYCLE_CSR : BENCH_SOURCE_NONE;
+    return 0;
+}
+
+static int parse_row(char *line, bench_row_t *row) {
+    uint32_t *fields[] = {
+        &row->iterations, &row->cycles_min, &row->cycles_median, &row->cycles_max,
+        &row->mmio_stores, &row->mmio_bytes,
+    };
+    char *p = line;
+    char *end;
+    char *comma;
+
+    row->id = (uint32_t)strtoul(p, &end, 0);
+    if (end == p || *end != ',') {
+        return -1;
+    }
+    p = end + 1;
+    comma = strchr(p, ',');
+    if (comma == NULL || (size_t)(comma - p) >= sizeof(row->name)) {
+        return -1;
+    }
+    memcpy(row->name, p, (size_t)(comma - p));
+    row->name[comma - p] = '\0';
+    p = comma + 1;
+    for (size_t k = 0; k < sizeof(fields) / sizeof(fields[0]); ++k) {
+        *fields[k] = (uint32_t)strtoul(p, &end, 0);
+        if (end == p || (*end != ',' && k + 1u < sizeof(fields) / sizeof(fields[0]))) {
+            return -1;
+        }
+        p = end + 1;
+    }
+    return 0;
+}
+
+static int load_csv(const char *path, FILE *fp, bench_results_t *out) {
+    char line[256];
+    unsigned lineno = 0;
+    int have_header = 0;
+
+    while (fgets(line, sizeof(line), fp) != NULL) {
+        ++lineno;
+        line[strcspn(line, "\r\n")] = '\0';
+        if (line[0] == '#') {
+            have_header |= parse_header(line, out) == 0;
+            continue;
+        }
+        if (line[0] == '\0' || strncmp(line, "id,", 3) == 0) {
+            continue;
+        }
+        if (out->count >= BENCH_TABLE_MAX || parse_row(line, &out->rows[out->count]) != 0) {
+            fprintf(stderr, "%s:%u: bad result row\n", path, lineno);
+            return -1;
+        }
+        out->count++;
+    }
+    if (!have_header) {
+        fprintf(stderr, "%s: no '# bench_table' header line\n", path);
+        return -1;
+    }
+    return 0;
+}
+
+int bench_results_load(const char *path, uint32_t ram_base, bench_results_t *out) {
+    FILE *fp = fopen(path, "rb");
+    char first[16] = { 0 };
+    uint8_t *img;
+    uint32_t size;
+    int is_mem;
+    int rc;
+
+    if (fp == NULL) {
+        perror(path);
+        return -1;
+    }
+    memset(out, 0, sizeof(*out));
+    if (fgets(first, sizeof(first), fp) != NULL && strncmp(first, "# bench_table", 13) == 0) {
+        rewind(fp);
+        rc = load_csv(path, fp, out);
+        fclose(fp);
+        return rc;
+    }
+    fclose(fp);
+
+    if (params_image_read(path, &img, &size, &is_mem) != 0) {
+        return -1;
+    }
+    rc = bench_results_from_ram(out, img, ram_base, size);
+    free(img);
+    if (rc != 0) {
+        fprintf(stderr, "%s: no benchmark table at 0x%x (not a full RAM dump, or the program never "
+                        "called bench_table_begin)\n", path, BENCH_TABLE_ADDR);
+    }
+    return rc;
+}
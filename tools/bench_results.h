@@ -0,0 +1,68 @@
+/*
+ * Benchmark result tables (bench_table.h), host side.
+ *
+ * Extracts the table a program leaves at BENCH_TABLE_ADDR from simulated
+ * RAM or a RAM dump, and reads / writes it as CSV:
+ *
+ *   # bench_table v1 source=cycle overhead=N run_id=N done=1
+ *   id,name,iterations,cycles_min,cycles_median,cycles_max,mmio_stores,mmio_bytes
+ *   0,BENCH_COLOR_ADDR,8,7,7,9,0,0
+ *   ...
+ */
+
+#ifndef BENCH_RESULTS_H
+#define BENCH_RESULTS_H
+
+#include <stdint.h>
+#include <stdio.h>
+
+/* Must match bench_table.h and link.ld */
+#define BENCH_TABLE_ADDR        0x7C00u
+#define BENCH_TABLE_MAGIC       0x48434E42u
+#define BENCH_TABLE_VERSION     1u
+#define BENCH_TABLE_MAX         31u
+#define BENCH_SOURCE_CYCLE_CSR  0u
+#define BENCH_SOURCE_NONE       1u
+
+#define BENCH_NAME_LEN          48u
+
+typedef struct {
+    uint32_t id;
+    char name[BENCH_NAME_LEN];
+    uint32_t iterations;
+    uint32_t cycles_min;
+    uint32_t cycles_median;
+    uint32_t cycles_max;
+    uint32_t mmio_stores;
+    uint32_t mmio_bytes;
+} bench_row_t;
+
+typedef struct {
+    uint32_t version;
+    uint32_t cycle_source;
+    uint32_t counter_overhead;
+    uint32_t run_id;
+    uint32_t done;
+    uint32_t count;
+    bench_row_t rows[BENCH_TABLE_MAX];
+} bench_results_t;
+
+/*
+ * Decode the table from RAM bytes (ram[0] is ram_base). Names are read from
+ * RAM when their pointer is inside it, else "id<N>". Returns 0 on success,
+ * -1 if there is no valid table.
+ */
+int bench_results_from_ram(bench_results_t *out, const uint8_t *ram, uint32_t ram_base, uint32_t ram_size);
+
+int bench_results_write_csv(const bench_results_t *r, FILE *fp);
+
+/*
+ * Load a result set from a CSV written above, or from a RAM dump (.bin of
+ * the whole RAM, or .mem with one word per line) starting at ram_base.
+ * Returns 0 on success, else prints why and returns -1.
+ */
+int bench_results_load(const char *path, uint32_t ram_base, bench_results_t *out);
+
+const char *bench_source_name(uint32_t source);
+
+#endif
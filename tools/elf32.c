@@ -0,0 +1,215 @@
+/*
+ * Minimal ELF32 reader: see elf32.h.
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "elf32.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define EM_RISCV    243u
+#define PT_LOAD     1u
+#define SHT_SYMTAB  2u
+#define SHT_NOBITS  8u
+#define SHF_ALLOC   2u
+
+static uint16_t rd16(const uint8_t *p) {
+    return (uint16_t)(p[0] | (p[1] << 8));
+}
+
+static uint32_t rd32(const uint8_t *p) {
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static int in_file(const elf32_file_t *f, uint32_t off, uint32_t len) {
+    return off <= f->size && len <= f->size - off;
+}
+
+int elf32_open(elf32_file_t *f, const char *path) {
+    FILE *fp = fopen(path, "rb");
+    const uint8_t *h;
+    long len;
+
+    memset(f, 0, sizeof(*f));
+    if (fp == NULL) {
+        perror(path);
+        return -1;
+    }
+    if (fseek(fp, 0, SEEK_END) != 0 || (len = ftell(fp)) < 52 || fseek(fp, 0, SEEK_SET) != 0) {
+        fprintf(stderr, "%s: not an ELF file\n", path);
+        fclose(fp);
+        return -1;
+    }
+    f->size = (size_t)len;
+    f->data = malloc(f->size);
+    if (f->data == NULL || fread(f->data, 1, f->size, fp) != f->size) {
+        fprintf(stderr, "%s: read failed\n", path);
+        fclose(fp);
+        elf32_close(f);
+        return -1;
+    }
+    fclose(fp);
+
+    h = f->data;
+    if (memcmp(h, "\177ELF", 4) != 0 || h[4] != 1u || h[5] != 1u) {
+        fprintf(stderr, "%s: not a little-endian ELF32 file\n", path);
+        elf32_close(f);
+        return -1;
+    }
+    if (rd16(h + 18) != EM_RISCV) {
+        fprintf(stderr, "%s: not a RISC-V ELF (e_machine %u)\n", path, rd16(h + 18));
+        elf32_close(f);
+        return -1;
+    }
+    f->entry = rd32(h + 24);
+    f->shentsize = rd16(h + 46);
+    f->shnum = rd16(h + 48);
+    if (f->shnum != 0u && f->shentsize >= 40u && in_file(f, rd32(h + 32), f->shnum * f->shentsize)) {
+        uint32_t shstrndx = rd16(h + 50);
+        f->shdrs = f->data + rd32(h + 32);
+        if (shstrndx < f->shnum) {
+            const uint8_t *s = f->shdrs + shstrndx * f->shentsize;
+            if (in_file(f, rd32(s + 16), rd32(s + 20))) {
+                f->shstrtab = (const char *)f->data + rd32(s + 16);
+            }
+        }
+        for (uint32_t i = 0; i < f->shnum; ++i) {
+            const uint8_t *s = f->shdrs + i * f->shentsize;
+            uint32_t link = rd32(s + 24);
+            if (rd32(s + 4) != SHT_SYMTAB || link >= f->shnum) {
+                continue;
+            }
+            if (in_file(f, rd32(s + 16), rd32(s + 20))) {
+                const uint8_t *l = f->shdrs + link * f->shentsize;
+                if (in_file(f, rd32(l + 16), rd32(l + 20))) {
+                    f->symtab = f->data + rd32(s + 16);
+                    f->symcount = rd32(s + 20) / 16u;
+                    f->strtab = (const char *)f->data + rd32(l + 16);
+                }
+            }
+            break;
+        }
+    }
+    return 0;
+}
+
+void elf32_close(elf32_file_t *f) {
+    free(f->data);
+    memset(f, 0, sizeof(*f));
+}
+
+int elf32_load(const elf32_file_t *f, uint8_t *ram, uint32_t ram_base, uint32_t ram_size) {
+    const uint8_t *h = f->data;
+    uint32_t phoff = rd32(h + 28);
+    uint32_t phentsize = rd16(h + 42);
+    uint32_t phnum = rd16(h + 44);
+
+    if (phentsize < 32u || !in_file(f, phoff, phnum * phentsize)) {
+        fprintf(stderr, "elf32: bad program header table\n");
+        return -1;
+    }
+    for (uint32_t i = 0; i < phnum; ++i) {
+        const uint8_t *p = h + phoff + i * phentsize;
+        uint32_t offset = rd32(p + 4);
+        uint32_t paddr = rd32(p + 12);
+        uint32_t filesz = rd32(p + 16);
+        uint32_t memsz = rd32(p + 20);
+        uint32_t off;
+
+        if (rd32(p) != PT_LOAD || memsz == 0u) {
+            continue;
+        }
+        off = paddr - ram_base;
+        if (paddr < ram_base || off > ram_size || memsz > ram_size - off || filesz > memsz ||
+            !in_file(f, offset, filesz)) {
+            fprintf(stderr, "elf32: segment 0x%08x+0x%x does not fit RAM 0x%08x+0x%x\n",
+                    paddr, memsz, ram_base, ram_size);
+            return -1;
+        }
+        memcpy(ram + off, h + offset, filesz);
+        memset(ram + off + filesz, 0, memsz - filesz);
+    }
+    return 0;
+}
+
+int elf32_symbol_at_index(const elf32_file_t *f, uint32_t i, elf32_sym_t *out) {
+    const uint8_t *s;
+
+    if (f->symtab == NULL || i >= f->symcount) {
+        return -1;
+    }
+    s = f->symtab + 16u * i;
+    out->name = f->strtab + rd32(s);
+    out->value = rd32(s + 4);
+    out->size = rd32(s + 8);
+    out->type = s[12] & 0x0Fu;
+    out->bind = s[12] >> 4;
+    out->shndx = rd16(s + 14);
+    return 0;
+}
+
+int elf32_symbol(const elf32_file_t *f, const char *name, elf32_sym_t *out) {
+    elf32_sym_t s;
+    int found = 0;
+
+    for (uint32_t i = 1; elf32_symbol_at_index(f, i, &s) == 0; ++i) {
+        if (strcmp(s.name, name) == 0) {
+            *out = s;
+            found = 1;
+            if (s.bind != 0u) {
+                break;      /* prefer a global over a same-named local */
+            }
+        }
+    }
+    return found ? 0 : -1;
+}
+
+int elf32_function_at(const elf32_file_t *f, uint32_t addr, elf32_sym_t *out) {
+    elf32_sym_t s;
+
+    for (uint32_t i = 1; elf32_symbol_at_index(f, i, &s) == 0; ++i) {
+        if (s.type == ELF32_STT_FUNC && addr >= s.value && addr - s.value < (s.size ? s.size : 1u)) {
+            *out = s;
+            return 0;
+        }
+    }
+    return -1;
+}
+
+int elf32_section(const elf32_file_t *f, const char *name, uint32_t *addr, uint32_t *size,
+                  const uint8_t **bytes) {
+    if (f->shdrs == NULL || f->shstrtab == NULL) {
+        return -1;
+    }
+    for (uint32_t i = 0; i < f->shnum; ++i) {
+        const uint8_t *s = f->shdrs + i * f->shentsize;
+        if (strcmp(f->shstrtab + rd32(s), name) != 0) {
+            continue;
+        }
+        *addr = rd32(s + 12);
+        *size = rd32(s + 20);
+        if (bytes != NULL) {
+            *bytes = (rd32(s + 4) == SHT_NOBITS || !in_file(f, rd32(s + 16), *size)) ?
+                     NULL : f->data + rd32(s + 16);
+        }
+        return 0;
+    }
+    return -1;
+}
+
+int elf32_section_at(const elf32_file_t *f, uint32_t addr, const char **name) {
+    if (f->shdrs == NULL || f->shstrtab == NULL) {
+        return -1;
+    }
+    for (uint32_t i = 0; i < f->shnum; ++i) {
+        const uint8_t *s = f->shdrs + i * f->shentsize;
+        if ((rd32(s + 8) & SHF_ALLOC) != 0u && addr - rd32(s + 12) < rd32(s + 20)) {
+            *name = f->shstrtab + rd32(s);
+            return 0;
+        }
+    }
+    return -1;
+}
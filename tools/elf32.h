@@ -0,0 +1,66 @@
+/*
+ * Minimal ELF32 (little-endian, RISC-V) reader for the host tools.
+ *
+ * Reads the whole file into memory; gives access to PT_LOAD segments,
+ * sections and the symbol table. Enough for loading $(PROGRAM).elf into
+ * the reference model and mapping addresses back to functions.
+ */
+
+#ifndef ELF32_H
+#define ELF32_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+typedef struct {
+    uint8_t *data;
+    size_t size;
+    uint32_t entry;
+    const uint8_t *shdrs;       /* section header table */
+    uint32_t shnum;
+    uint32_t shentsize;
+    const char *shstrtab;
+    const uint8_t *symtab;      /* .symtab entries, 16 bytes each */
+    uint32_t symcount;
+    const char *strtab;
+} elf32_file_t;
+
+typedef struct {
+    const char *name;
+    uint32_t value;
+    uint32_t size;
+    uint8_t type;               /* STT_* (0 notype, 1 object, 2 func) */
+    uint8_t bind;               /* STB_* (0 local, 1 global, 2 weak) */
+    uint16_t shndx;
+} elf32_sym_t;
+
+#define ELF32_STT_OBJECT 1u
+#define ELF32_STT_FUNC   2u
+
+/* Read and validate path. Returns 0 on success, else prints why and returns -1. */
+int elf32_open(elf32_file_t *f, const char *path);
+void elf32_close(elf32_file_t *f);
+
+/*
+ * Copy every PT_LOAD segment into ram (mapped at ram_base) and zero the
+ * .bss part. Returns -1 if a segment does not fit.
+ */
+int elf32_load(const elf32_file_t *f, uint8_t *ram, uint32_t ram_base, uint32_t ram_size);
+
+/* Look up a symbol by name; returns 0 and fills *out when found. */
+int elf32_symbol(const elf32_file_t *f, const char *name, elf32_sym_t *out);
+
+/* Symbol i (0 <= i < symcount). Returns 0 if the entry is valid. */
+int elf32_symbol_at_index(const elf32_file_t *f, uint32_t i, elf32_sym_t *out);
+
+/* The function symbol that contains addr, if any. */
+int elf32_function_at(const elf32_file_t *f, uint32_t addr, elf32_sym_t *out);
+
+/* Section by name: address, size and a pointer to its file bytes (NULL for NOBITS). */
+int elf32_section(const elf32_file_t *f, const char *name, uint32_t *addr, uint32_t *size,
+                  const uint8_t **bytes);
+
+/* Name of the allocated section that contains addr. Returns 0 when found. */
+int elf32_section_at(const elf32_file_t *f, uint32_t addr, const char **name);
+
+#endif
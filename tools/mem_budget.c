@@ -0,0 +1,600 @@
+/*
+ * Memory budget report for the 32 KB image, from the GNU ld map file.
+ *
+ * Reads $(PROGRAM).map (the "Linker script and memory map" part) and
+ * reports:
+ *   - .text/.rodata/.data/.bss sizes and alignment padding, the stack
+ *     reservation (_stack_start.._stack_end from link.ld) and the heap left
+ *     between _heap_start and _heap_end
+ *   - bytes per object file, split by section
+ *   - bytes per symbol, largest first. With -ffunction-sections /
+ *     -fdata-sections every function and variable has its own input
+ *     section, so statics are named too; other input sections are split at
+ *     the global symbols the map lists, or shown as "(section)"
+ *
+ * Budgets (--budget KEY=BYTES, repeatable) make the exit status 1 when
+ * any is exceeded, so the Makefile can fail the build:
+ *   text, rodata, data, bss   section sizes
+ *   image                     text + rodata + data (the loaded image)
+ *   ram                       everything below _heap_start (image + bss + stack)
+ *   heap-min                  minimum heap left (a floor, not a ceiling)
+ *   sym:NAME                  one symbol
+ *   obj:NAME                  one object file (e.g. obj:vga_driver.o)
+ * A sym:/obj: key that matches nothing is an error (exit 2), so a renamed
+ * symbol cannot silently turn its budget off.
+ *
+ * Usage:
+ *   tools/mem_budget [options] program.map
+ *     --budget KEY=BYTES    see above (repeatable)
+ *     --top N               symbols to list (default 20, 0 = all)
+ *     --summary             one line plus budget results
+ *     --csv FILE            every symbol as CSV
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define MAX_BUDGETS     32
+#define MAX_SYMS        64
+
+typedef enum { CAT_TEXT, CAT_RODATA, CAT_DATA, CAT_BSS, CAT_OTHER, CAT_COUNT } cat_t;
+
+static const char *const cat_names[CAT_COUNT] = { ".text", ".rodata", ".data", ".bss", "other" };
+
+typedef struct {
+    char name[96];
+    char object[64];
+    cat_t cat;
+    uint32_t addr;
+    uint32_t size;
+} item_t;
+
+typedef struct {
+    char object[64];
+    uint32_t bytes[CAT_COUNT];
+    uint32_t total;
+} obj_t;
+
+typedef struct {
+    char key[96];
+    unsigned long limit;
+} budget_t;
+
+typedef struct {
+    uint32_t ram_origin, ram_length;
+    uint32_t cat_addr[CAT_COUNT];
+    uint32_t cat_size[CAT_COUNT];
+    uint32_t cat_fill[CAT_COUNT];
+    uint32_t stack_start, stack_end, heap_start, heap_end;
+    unsigned have;                  /* bit per linker symbol above */
+
+    item_t *items;
+    size_t item_count, item_cap;
+    obj_t *objs;
+    size_t obj_count, obj_cap;
+} map_t;
+
+/* Input section being read, with the global symbols listed under it */
+typedef struct {
+    int open;
+    char name[96];
+    char object[64];
+    cat_t cat;
+    uint32_t addr, size;
+    uint32_t sym_addr[MAX_SYMS];
+    char sym_name[MAX_SYMS][96];
+    unsigned sym_count;
+} insec_t;
+
+static int item_add(map_t *m, const char *name, const char *object, cat_t cat, uint32_t addr, uint32_t size) {
+    item_t *it;
+
+    if (size == 0u) {
+        return 0;
+    }
+    if (m->item_count == m->item_cap) {
+        size_t cap = m->item_cap ? m->item_cap * 2u : 256u;
+        item_t *n = realloc(m->items, cap * sizeof(*n));
+        if (n == NULL) {
+            return -1;
+        }
+        m->items = n;
+        m->item_cap = cap;
+    }
+    it = &m->items[m->item_count++];
+    snprintf(it->name, sizeof(it->name), "%s", name);
+    snprintf(it->object, sizeof(it->object), "%s", object);
+    it->cat = cat;
+    it->addr = addr;
+    it->size = size;
+    return 0;
+}
+
+static cat_t out_category(const char *name) {
+    if (strcmp(name, ".text") == 0) {
+        return CAT_TEXT;
+    } else if (strcmp(name, ".rodata") == 0) {
+        return CAT_RODATA;
+    } else if (strcmp(name, ".data") == 0) {
+        return CAT_DATA;
+    } else if (strcmp(name, ".bss") == 0) {
+        return CAT_BSS;
+    }
+    return CAT_OTHER;
+}
+
+/* Sections that are not loaded into RAM */
+static int non_alloc(const char *name) {
+    static const char *const prefixes[] = { ".debug", ".comment", ".riscv.attributes", ".note", ".stab",
+                                            ".bench_table" };
+    for (size_t i = 0; i < sizeof(prefixes) / sizeof(prefixes[0]); ++i) {
+        if (strncmp(name, prefixes[i], strlen(prefixes[i])) == 0) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+/* Function / variable name from a -ffunction-sections / -fdata-sections input section */
+static const char *section_symbol(const char *sec) {
+    static const char *const prefixes[] = {
+        ".text.startup.", ".text.unlikely.", ".text.hot.", ".text.", ".srodata.", ".rodata.",
+        ".sdata.", ".data.", ".sbss.", ".bss.",
+    };
+    for (size_t i = 0; i < sizeof(prefixes) / sizeof(prefixes[0]); ++i) {
+        size_t n = strlen(prefixes[i]);
+        if (strncmp(sec, prefixes[i], n) == 0 && sec[n] != '\0' && strncmp(sec + n, "str1.", 5) != 0 &&
+            strncmp(sec + n, "cst", 3) != 0) {
+            return sec + n;
+        }
+    }
+    return NULL;
+}
+
+static int insec_close(map_t *m, insec_t *in) {
+    const char *sym;
+    char label[112];
+    uint32_t end = in->addr + in->size;
+    uint32_t at = in->addr;
+
+    if (!in->open) {
+        return 0;
+    }
+    in->open = 0;
+    sym = section_symbol(in->name);
+    if (sym != NULL) {
+        return item_add(m, sym, in->object, in->cat, in->addr, in->size);
+    }
+    snprintf(label, sizeof(label), "(%s)", in->name);
+    for (unsigned i = 0; i < in->sym_count; ++i) {
+        uint32_t a = in->sym_addr[i];
+        uint32_t next = (i + 1u < in->sym_count) ? in->sym_addr[i + 1u] : end;
+        if (a < at || a > end || next < a) {
+            continue;
+        }
+        if (item_add(m, label, in->object, in->cat, at, a - at) != 0 ||
+            item_add(m, in->sym_name[i], in->object, in->cat, a, (next > end ? end : next) - a) != 0) {
+            return -1;
+        }
+        at = next > end ? end : next;
+    }
+    return item_add(m, label, in->object, in->cat, at, end - at);
+}
+
+static const char *base_name(const char *path) {
+    const char *paren = strchr(path, '(');
+    const char *slash = NULL;
+
+    // Archive members: keep "libgcc.a(div.o)"
+    for (const char *p = path; *p != '\0' && (paren == NULL || p < paren); ++p) {
+        if (*p == '/') {
+            slash = p;
+        }
+    }
+    return slash != NULL ? slash + 1 : path;
+}
+
+static int is_hex(const char *s) {
+    return s[0] == '0' && s[1] == 'x';
+}
+
+static int load_map(const char *path, map_t *m) {
+    FILE *f = fopen(path, "r");
+    char line[1024];
+    int in_map = 0;
+    int in_memcfg = 0;
+    char pending_out[96] = "";
+    char pending_in[96] = "";
+    cat_t cur_cat = CAT_OTHER;
+    int cur_skip = 1;
+    static insec_t in;
+
+    if (f == NULL) {
+        perror(path);
+        return -1;
+    }
+    memset(&in, 0, sizeof(in));
+    while (fgets(line, sizeof(line), f) != NULL) {
+        char tok[4][256];
+        int n;
+
+        line[strcspn(line, "\r\n")] = '\0';
+        if (!in_map) {
+            unsigned long o, l;
+            if (strncmp(line, "Memory Configuration", 20) == 0) {
+                in_memcfg = 1;
+            } else if (strncmp(line, "Linker script and memory map", 28) == 0) {
+                in_map = 1;
+            } else if (in_memcfg && m->ram_length == 0u && line[0] != '*' &&
+                       sscanf(line, "%255s 0x%lx 0x%lx", tok[0], &o, &l) == 3) {
+                m->ram_origin = (uint32_t)o;
+                m->ram_length = (uint32_t)l;
+            }
+            continue;
+        }
+        if (strstr(line, "(size before relaxing)") != NULL || strncmp(line, "LOAD ", 5) == 0 ||
+            strncmp(line, "OUTPUT(", 7) == 0) {
+            continue;
+        }
+        n = sscanf(line, "%255s %255s %255s %255s", tok[0], tok[1], tok[2], tok[3]);
+        if (n <= 0) {
+            continue;
+        }
+
+        // Output section: name in column 0, address/size on the same or next line
+        if (line[0] == '.' || pending_out[0] != '\0') {
+            const char *name = pending_out[0] != '\0' ? pending_out : tok[0];
+            int off = pending_out[0] != '\0' ? 0 : 1;
+            if (n < off + 2) {
+                snprintf(pending_out, sizeof(pending_out), "%.95s", tok[0]);
+                continue;
+            }
+            if (insec_close(m, &in) != 0) {
+                break;
+            }
+            cur_cat = out_category(name);
+            cur_skip = non_alloc(name);
+            if (!cur_skip) {
+                uint32_t a = (uint32_t)strtoul(tok[off], NULL, 16);
+                uint32_t s = (uint32_t)strtoul(tok[off + 1], NULL, 16);
+                if (cur_cat == CAT_OTHER && s != 0u) {
+                    fprintf(stderr, "mem_budget: counting output section %s as other\n", name);
+                }
+                if (m->cat_size[cur_cat] == 0u) {
+                    m->cat_addr[cur_cat] = a;
+                }
+                m->cat_size[cur_cat] += s;
+            }
+            pending_out[0] = '\0';
+            continue;
+        }
+
+        // Padding between input sections
+        if (strcmp(tok[0], "*fill*") == 0) {
+            if (!cur_skip && n >= 3) {
+                m->cat_fill[cur_cat] += (uint32_t)strtoul(tok[2], NULL, 16);
+            }
+            continue;
+        }
+        if (tok[0][0] == '*') {
+            continue;               /* input section pattern from link.ld */
+        }
+
+        // Input section: one leading space, address/size/object on the same or next line
+        if ((line[0] == ' ' && line[1] != ' ') || pending_in[0] != '\0') {
+            const char *name = pending_in[0] != '\0' ? pending_in : tok[0];
+            int off = pending_in[0] != '\0' ? 0 : 1;
+            if (pending_in[0] == '\0' && n == 1) {
+                snprintf(pending_in, sizeof(pending_in), "%.95s", tok[0]);
+                continue;
+            }
+            if (insec_close(m, &in) != 0) {
+                break;
+            }
+            if (!cur_skip && n >= off + 3 && is_hex(tok[off]) && is_hex(tok[off + 1])) {
+                in.open = 1;
+                snprintf(in.name, sizeof(in.name), "%.95s", name);
+                snprintf(in.object, sizeof(in.object), "%.63s", base_name(tok[off + 2]));
+                in.cat = cur_cat;
+                in.addr = (uint32_t)strtoul(tok[off], NULL, 16);
+                in.size = (uint32_t)strtoul(tok[off + 1], NULL, 16);
+                in.sym_count = 0;
+            }
+            pending_in[0] = '\0';
+            continue;
+        }
+
+        // Symbol or assignment: "0xADDR name" / "0xADDR name = expr"
+        if (n >= 2 && is_hex(tok[0])) {
+            uint32_t a = (uint32_t)strtoul(tok[0], NULL, 16);
+            if (n >= 3 && strcmp(tok[2], "=") == 0) {
+                static const char *const syms[] = { "_stack_start", "_stack_end", "_heap_start", "_heap_end" };
+                uint32_t *dst[] = { &m->stack_start, &m->stack_end, &m->heap_start, &m->heap_end };
+                for (unsigned k = 0; k < 4u; ++k) {
+                    if (strcmp(tok[1], syms[k]) == 0) {
+                        *dst[k] = a;
+                        m->have |= 1u << k;
+                    }
+                }
+            } else if (n == 2 && in.open && in.sym_count < MAX_SYMS && strchr(tok[1], '(') == NULL) {
+                in.sym_addr[in.sym_count] = a;
+                snprintf(in.sym_name[in.sym_count], sizeof(in.sym_name[0]), "%.95s", tok[1]);
+                in.sym_count++;
+            }
+        }
+    }
+    fclose(f);
+    if (insec_close(m, &in) != 0) {
+        fprintf(stderr, "mem_budget: out of memory\n");
+        return -1;
+    }
+    if (!in_map) {
+        fprintf(stderr, "%s: no \"Linker script and memory map\" section (not a GNU ld map?)\n", path);
+        return -1;
+    }
+    if (m->ram_length == 0u) {
+        m->ram_length = 0x8000u;
+    }
+    return 0;
+}
+
+static int obj_build(map_t *m) {
+    for (size_t i = 0; i < m->item_count; ++i) {
+        const item_t *it = &m->items[i];
+        obj_t *o = NULL;
+        for (size_t k = 0; k < m->obj_count; ++k) {
+            if (strcmp(m->objs[k].object, it->object) == 0) {
+                o = &m->objs[k];
+                break;
+            }
+        }
+        if (o == NULL) {
+            if (m->obj_count == m->obj_cap) {
+                size_t cap = m->obj_cap ? m->obj_cap * 2u : 32u;
+                obj_t *n = realloc(m->objs, cap * sizeof(*n));
+                if (n == NULL) {
+                    return -1;
+                }
+                m->objs = n;
+                m->obj_cap = cap;
+            }
+            o = &m->objs[m->obj_count++];
+            memset(o, 0, sizeof(*o));
+            snprintf(o->object, sizeof(o->object), "%s", it->object);
+        }
+        o->bytes[it->cat] += it->size;
+        o->total += it->size;
+    }
+    return 0;
+}
+
+static int by_size_item(const void *a, const void *b) {
+    const item_t *x = a, *y = b;
+    if (x->size != y->size) {
+        return x->size < y->size ? 1 : -1;
+    }
+    return strcmp(x->name, y->name);
+}
+
+static int by_size_obj(const void *a, const void *b) {
+    const obj_t *x = a, *y = b;
+    if (x->total != y->total) {
+        return x->total < y->total ? 1 : -1;
+    }
+    return strcmp(x->object, y->object);
+}
+
+static uint32_t image_bytes(const map_t *m) {
+    return m->cat_size[CAT_TEXT] + m->cat_size[CAT_RODATA] + m->cat_size[CAT_DATA] + m->cat_size[CAT_OTHER];
+}
+
+static uint32_t static_bytes(const map_t *m) {
+    if (m->have & 4u) {
+        return m->heap_start - m->ram_origin;
+    }
+    return image_bytes(m) + m->cat_size[CAT_BSS] + (m->stack_end - m->stack_start);
+}
+
+static uint32_t heap_bytes(const map_t *m) {
+    return ((m->have & 12u) == 12u && m->heap_end > m->heap_start) ? m->heap_end - m->heap_start : 0u;
+}
+
+static double pct(uint32_t part, uint32_t whole) {
+    return whole != 0u ? 100.0 * (double)part / (double)whole : 0.0;
+}
+
+static void report(const map_t *m, const char *path, unsigned top) {
+    uint32_t stack = (m->have & 3u) == 3u ? m->stack_end - m->stack_start : 0u;
+
+    printf("mem_budget: %s (RAM 0x%08x, %u bytes)\n", path, m->ram_origin, m->ram_length);
+    printf("  %-10s %10s %8s %8s %7s\n", "region", "start", "bytes", "padding", "of RAM");
+    for (unsigned c = 0; c < CAT_COUNT; ++c) {
+        if (c == CAT_OTHER && m->cat_size[c] == 0u) {
+            continue;
+        }
+        printf("  %-10s 0x%08x %8u %8u %6.1f%%\n", cat_names[c], m->cat_addr[c], m->cat_size[c], m->cat_fill[c],
+               pct(m->cat_size[c], m->ram_length));
+    }
+    if ((m->have & 3u) == 3u) {
+        printf("  %-10s 0x%08x %8u %8s %6.1f%%  (link.ld reservation)\n", "stack", m->stack_start, stack, "",
+               pct(stack, m->ram_length));
+    }
+    if ((m->have & 12u) == 12u) {
+        printf("  %-10s 0x%08x %8u %8s %6.1f%%  (_heap_start.._heap_end, free)\n", "heap", m->heap_start,
+               heap_bytes(m), "", pct(heap_bytes(m), m->ram_length));
+    }
+    printf("  image %u bytes, static RAM %u bytes (%.1f%%), heap left %u bytes\n", image_bytes(m),
+           static_bytes(m), pct(static_bytes(m), m->ram_length), heap_bytes(m));
+
+    printf("\n== Per object ==\n");
+    printf("  %-32s %8s %8s %8s %8s %8s\n", "object", ".text", ".rodata", ".data", ".bss", "total");
+    for (size_t i = 0; i < m->obj_count; ++i) {
+        const obj_t *o = &m->objs[i];
+        printf("  %-32s %8u %8u %8u %8u %8u\n", o->object, o->bytes[CAT_TEXT], o->bytes[CAT_RODATA],
+               o->bytes[CAT_DATA], o->bytes[CAT_BSS] + o->bytes[CAT_OTHER], o->total);
+    }
+
+    printf("\n== Per symbol (%s) ==\n", top ? "largest first" : "all");
+    printf("  %-36s %-8s %-24s %10s %8s\n", "symbol", "section", "object", "address", "bytes");
+    for (size_t i = 0; i < m->item_count && (top == 0u || i < top); ++i) {
+        const item_t *it = &m->items[i];
+        printf("  %-36s %-8s %-24s 0x%08x %8u\n", it->name, cat_names[it->cat], it->object, it->addr, it->size);
+    }
+    if (top != 0u && m->item_count > top) {
+        printf("  ... %zu more (--top 0 lists all)\n", m->item_count - top);
+    }
+}
+
+static int write_csv(const map_t *m, const char *path) {
+    FILE *fp = fopen(path, "w");
+
+    if (fp == NULL) {
+        perror(path);
+        return -1;
+    }
+    fprintf(fp, "symbol,section,object,address,bytes\n");
+    for (size_t i = 0; i < m->item_count; ++i) {
+        const item_t *it = &m->items[i];
+        fprintf(fp, "%s,%s,%s,0x%08x,%u\n", it->name, cat_names[it->cat], it->object, it->addr, it->size);
+    }
+    return fclose(fp);
+}
+
+/* Returns 1 if over budget, 0 if within, -1 for an unknown key */
+static int check_budget(const map_t *m, const budget_t *b) {
+    unsigned long used = 0;
+    int floor = 0;
+    int found = 1;
+
+    if (strcmp(b->key, "text") == 0) {
+        used = m->cat_size[CAT_TEXT];
+    } else if (strcmp(b->key, "rodata") == 0) {
+        used = m->cat_size[CAT_RODATA];
+    } else if (strcmp(b->key, "data") == 0) {
+        used = m->cat_size[CAT_DATA];
+    } else if (strcmp(b->key, "bss") == 0) {
+        used = m->cat_size[CAT_BSS];
+    } else if (strcmp(b->key, "image") == 0) {
+        used = image_bytes(m);
+    } else if (strcmp(b->key, "ram") == 0) {
+        used = static_bytes(m);
+    } else if (strcmp(b->key, "heap-min") == 0) {
+        used = heap_bytes(m);
+        floor = 1;
+    } else if (strncmp(b->key, "sym:", 4) == 0) {
+        found = 0;
+        for (size_t i = 0; i < m->item_count; ++i) {
+            if (strcmp(m->items[i].name, b->key + 4) == 0) {
+                used += m->items[i].size;
+                found = 1;
+            }
+        }
+    } else if (strncmp(b->key, "obj:", 4) == 0) {
+        found = 0;
+        for (size_t i = 0; i < m->obj_count; ++i) {
+            if (strcmp(m->objs[i].object, b->key + 4) == 0) {
+                used = m->objs[i].total;
+                found = 1;
+            }
+        }
+    } else {
+        fprintf(stderr, "mem_budget: unknown budget key '%s'\n", b->key);
+        return -1;
+    }
+
+    if (!found) {
+        /* Most likely a typo or a renamed symbol: a budget that checks nothing is an error */
+        fprintf(stderr, "mem_budget: budget key '%s' matches nothing in the map\n", b->key);
+        return -1;
+    }
+    if (floor ? used < b->limit : used > b->limit) {
+        printf("  budget %-24s %8lu %s %lu  OVER BUDGET\n", b->key, used, floor ? "<" : ">", b->limit);
+        return 1;
+    }
+    printf("  budget %-24s %8lu of %lu%s\n", b->key, used, b->limit, floor ? " (minimum)" : "");
+    return 0;
+}
+
+static void usage(const char *argv0) {
+    fprintf(stderr, "usage: %s [--budget KEY=BYTES]... [--top N] [--summary] [--csv FILE] program.map\n", argv0);
+}
+
+int main(int argc, char **argv) {
+    const char *path = NULL;
+    const char *csv_path = NULL;
+    budget_t budgets[MAX_BUDGETS];
+    unsigned budget_count = 0;
+    unsigned top = 20;
+    int summary = 0;
+    int over = 0;
+    static map_t m;
+
+    for (int i = 1; i < argc; ++i) {
+        if (strcmp(argv[i], "--budget") == 0 && i + 1 < argc && budget_count < MAX_BUDGETS) {
+            const char *spec = argv[++i];
+            const char *eq = strrchr(spec, '=');
+            char *end;
+            if (eq == NULL || eq == spec || (size_t)(eq - spec) >= sizeof(budgets[0].key)) {
+                fprintf(stderr, "mem_budget: bad budget '%s' (want KEY=BYTES)\n", spec);
+                return 2;
+            }
+            memcpy(budgets[budget_count].key, spec, (size_t)(eq - spec));
+            budgets[budget_count].key[eq - spec] = '\0';
+            budgets[budget_count].limit = strtoul(eq + 1, &end, 0);
+            if (end == eq + 1 || *end != '\0') {
+                fprintf(stderr, "mem_budget: bad budget '%s' (want KEY=BYTES)\n", spec);
+                return 2;
+            }
+            budget_count++;
+        } else if (strcmp(argv[i], "--top") == 0 && i + 1 < argc) {
+            top = (unsigned)strtoul(argv[++i], NULL, 0);
+        } else if (strcmp(argv[i], "--summary") == 0) {
+            summary = 1;
+        } else if (strcmp(argv[i], "--csv") == 0 && i + 1 < argc) {
+            csv_path = argv[++i];
+        } else if (argv[i][0] != '-' && path == NULL) {
+            path = argv[i];
+        } else {
+            usage(argv[0]);
+            return 2;
+        }
+    }
+    if (path == NULL) {
+        usage(argv[0]);
+        return 2;
+    }
+    if (load_map(path, &m) != 0 || obj_build(&m) != 0) {
+        return 2;
+    }
+    qsort(m.items, m.item_count, sizeof(m.items[0]), by_size_item);
+    qsort(m.objs, m.obj_count, sizeof(m.objs[0]), by_size_obj);
+
+    if (summary) {
+        printf("mem_budget: %s: text %u rodata %u data %u bss %u stack %u, static RAM %u of %u (%.1f%%), heap left %u\n",
+               path, m.cat_size[CAT_TEXT], m.cat_size[CAT_RODATA], m.cat_size[CAT_DATA], m.cat_size[CAT_BSS],
+               (m.have & 3u) == 3u ? m.stack_end - m.stack_start : 0u, static_bytes(&m), m.ram_length,
+               pct(static_bytes(&m), m.ram_length), heap_bytes(&m));
+    } else {
+        report(&m, path, top);
+    }
+    if (budget_count != 0u && !summary) {
+        printf("\n== Budgets ==\n");
+    }
+    for (unsigned i = 0; i < budget_count; ++i) {
+        int rc = check_budget(&m, &budgets[i]);
+        if (rc < 0) {
+            return 2;
+        }
+        over |= rc;
+    }
+    if (csv_path != NULL && write_csv(&m, csv_path) != 0) {
+        return 2;
+    }
+    free(m.items);
+    free(m.objs);
+    return over;
+}
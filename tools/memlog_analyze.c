@@ -0,0 +1,651 @@
+/*
+ * Streaming access-pattern analyzer for mem_memlog traces.
+ *
+ * Reads the CSV written by mem_memlog.sv:
+ *   time,op,addr_hex,word_index,data_hex
+ * (or the MLOGBIN1 binary trace from the DPI-C backend, detected by magic)
+ * Trigger markers from a triggered capture are counted as windows and
+ * otherwise skipped.
+ * one record at a time (constant memory, any trace length) and reports:
+ *   - per-region traffic split (text/rodata/data/bss/stack/heap/VGA/...)
+ *   - per-region stride distributions (byte distance between consecutive
+ *     accesses of the same kind inside the region)
+ *   - reuse-distance histogram for main-RAM words (distinct words touched
+ *     between two accesses to the same word)
+ *   - hot-word heatmap over word_index 0..8191
+ *   - redundant stores: write-after-write with the same value, and silent
+ *     stores (value equals the last value seen at that address)
+ *
+ * Region boundaries come from the linker map ($(PROGRAM).map) when given,
+ * so the stack/.bss/.data split follows link.ld exactly.
+ *
+ * Usage:
+ *   tools/memlog_analyze [--map test_isa_vga.map] [--range name=lo:hi]...
+ *                        [--top N] [--heatmap-csv FILE] [mem.log | -]
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <inttypes.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "memlog_format.h"
+
+#define RAM_WORDS       8192u
+#define RAM_BYTES       (RAM_WORDS * 4u)
+
+#define VGA_PLANES_LO   0x10000000u
+#define VGA_PLANES_HI   0x1002FFFFu
+#define VGA_SWAP_LO     0x10030000u
+#define VGA_SWAP_HI     0x10030003u
+
+#define MAX_REGIONS     24
+#define STRIDE_SLOTS    64
+#define REUSE_BUCKETS   15  /* log2 buckets: 0, 1, 2-3, ..., 8192-16383 */
+#define REUSE_SLOTS     (2u * RAM_WORDS)
+#define SHADOW_SLOTS    (1u << 20)
+
+enum { OP_READ = 0, OP_WRITE = 1 };
+
+typedef struct {
+    int32_t stride;
+    uint64_t count;
+} stride_bin_t;
+
+typedef struct {
+    char name[32];
+    uint32_t lo;
+    uint32_t hi;
+    uint64_t accesses[2];
+    uint64_t waw_same;
+    uint64_t silent;
+    uint32_t last_addr[2];
+    int have_last[2];
+    stride_bin_t strides[2][STRIDE_SLOTS];
+    uint64_t stride_other[2];
+} region_t;
+
+typedef struct {
+    uint32_t addr;
+    uint32_t value;
+    uint8_t used;
+    uint8_t last_op;
+} shadow_t;
+
+static region_t regions[MAX_REGIONS];
+static int region_count;
+
+static uint64_t word_hits[RAM_WORDS];
+
+/* Reuse distance: each RAM word occupies the Fenwick slot of its most
+ * recent access; the distance is the number of occupied slots after it. */
+static int32_t reuse_slot_of[RAM_WORDS];
+static int32_t reuse_tree[REUSE_SLOTS + 1];
+static uint32_t reuse_next_slot;
+static uint64_t reuse_hist[REUSE_BUCKETS];
+static uint64_t reuse_cold;
+
+static shadow_t *shadow;
+static uint64_t shadow_full_drops;
+
+static uint64_t total_records;
+static uint64_t bad_records;
+static uint64_t trigger_windows;    /* "# trigger start" lines or start markers */
+
+static void region_add(const char *name, uint32_t lo, uint32_t hi) {
+    region_t *r;
+    if (region_count >= MAX_REGIONS || hi < lo) {
+        return;
+    }
+    r = &regions[region_count++];
+    memset(r, 0, sizeof(*r));
+    snprintf(r->name, sizeof(r->name), "%s", name);
+    r->lo = lo;
+    r->hi = hi;
+}
+
+static region_t *region_find(uint32_t addr) {
+    int i;
+    for (i = 0; i < region_count; i++) {
+        if (addr >= regions[i].lo && addr <= regions[i].hi) {
+            return &regions[i];
+        }
+    }
+    return NULL;
+}
+
+static void stride_record(region_t *r, int op, int32_t stride) {
+    stride_bin_t *bins = r->strides[op];
+    uint32_t h = ((uint32_t)stride * 2654435761u) % STRIDE_SLOTS;
+    uint32_t probe;
+
+    for (probe = 0; probe < STRIDE_SLOTS; probe++) {
+        stride_bin_t *b = &bins[(h + probe) % STRIDE_SLOTS];
+        if (b->count == 0u) {
+            b->stride = stride;
+            b->count = 1u;
+            return;
+        }
+        if (b->stride == stride) {
+            b->count++;
+            return;
+        }
+    }
+    r->stride_other[op]++;
+}
+
+static void reuse_tree_add(uint32_t slot, int32_t delta) {
+    for (uint32_t i = slot + 1u; i <= REUSE_SLOTS; i += i & (0u - i)) {
+        reuse_tree[i] += delta;
+    }
+}
+
+static int32_t reuse_tree_prefix(uint32_t slot_count) {
+    int32_t sum = 0;
+    for (uint32_t i = slot_count; i > 0u; i -= i & (0u - i)) {
+        sum += reuse_tree[i];
+    }
+    return sum;
+}
+
+static int compare_slot(const void *a, const void *b) {
+    int32_t sa = reuse_slot_of[*(const uint32_t *)a];
+    int32_t sb = reuse_slot_of[*(const uint32_t *)b];
+    return (sa > sb) - (sa < sb);
+}
+
+static void reuse_compact(void) {
+    static uint32_t live[RAM_WORDS];
+    uint32_t n = 0;
+    uint32_t w;
+
+    for (w = 0; w < RAM_WORDS; w++) {
+        if (reuse_slot_of[w] >= 0) {
+            live[n++] = w;
+        }
+    }
+    qsort(live, n, sizeof(live[0]), compare_slot);
+    memset(reuse_tree, 0, sizeof(reuse_tree));
+    for (w = 0; w < n; w++) {
+        reuse_slot_of[live[w]] = (int32_t)w;
+        reuse_tree_add(w, 1);
+    }
+    reuse_next_slot = n;
+}
+
+static void reuse_record(uint32_t word) {
+    int32_t slot = reuse_slot_of[word];
+
+    if (slot < 0) {
+        reuse_cold++;
+    } else {
+        uint32_t dist = (uint32_t)(reuse_tree_prefix(reuse_next_slot) -
+                                   reuse_tree_prefix((uint32_t)slot + 1u));
+        uint32_t bucket = 0;
+        while (bucket + 1u < REUSE_BUCKETS && (dist >> bucket) != 0u) {
+            bucket++;
+        }
+        reuse_hist[bucket]++;
+        reuse_tree_add((uint32_t)slot, -1);
+    }
+
+    if (reuse_next_slot == REUSE_SLOTS) {
+        reuse_slot_of[word] = -1;
+        reuse_compact();
+    }
+    reuse_slot_of[word] = (int32_t)reuse_next_slot;
+    reuse_tree_add(reuse_next_slot, 1);
+    reuse_next_slot++;
+}
+
+static shadow_t *shadow_lookup(uint32_t addr) {
+    uint32_t h = (addr * 2654435761u) >> 12;
+    uint32_t probe;
+
+    for (probe = 0; probe < 64u; probe++) {
+        shadow_t *s = &shadow[(h + probe) & (SHADOW_SLOTS - 1u)];
+        if (!s->used || s->addr == addr) {
+            return s;
+        }
+    }
+    shadow_full_drops++;
+    return NULL;
+}
+
+static void account(int op, uint32_t addr, uint32_t data) {
+    region_t *r = region_find(addr);
+    shadow_t *s;
+
+    total_records++;
+
+    if (r != NULL) {
+        r->accesses[op]++;
+        if (r->have_last[op]) {
+            stride_record(r, op, (int32_t)(addr - r->last_addr[op]));
+        }
+        r->last_addr[op] = addr;
+        r->have_last[op] = 1;
+    }
+
+    if (addr < RAM_BYTES) {
+        uint32_t word = (addr >> 2) & (RAM_WORDS - 1u);
+        word_hits[word]++;
+        reuse_record(word);
+    }
+
+    s = shadow_lookup(addr);
+    if (s == NULL) {
+        return;
+    }
+    if (op == OP_WRITE && s->used && r != NULL) {
+        if (s->value == data) {
+            r->silent++;
+            if (s->last_op == OP_WRITE) {
+                r->waw_same++;
+            }
+        }
+    }
+    s->used = 1;
+    s->addr = addr;
+    s->value = data;
+    s->last_op = (uint8_t)op;
+}
+
+/* Parse one "time,op,addr_hex,word_index,data_hex" record. */
+static int parse_record(const char *line, int *op, uint32_t *addr, uint32_t *data) {
+    const char *p = strchr(line, ',');
+    char *end;
+
+    if (p == NULL) {
+        return 0;
+    }
+    p++;
+    if (strncmp(p, "WRITE,", 6) == 0) {
+        *op = OP_WRITE;
+        p += 6;
+    } else if (strncmp(p, "READ,", 5) == 0) {
+        *op = OP_READ;
+        p += 5;
+    } else {
+        return 0;
+    }
+    *addr = (uint32_t)strtoul(p, &end, 16);
+    if (end == p || *end != ',') {
+        return 0;
+    }
+    p = strchr(end + 1, ',');
+    if (p == NULL) {
+        return 0;
+    }
+    *data = (uint32_t)strtoul(p + 1, &end, 16);
+    return end != p + 1;
+}
+
+/* Pull section and symbol addresses out of a GNU ld map file. */
+static int load_map(const char *path) {
+    FILE *f = fopen(path, "r");
+    char line[512];
+    uint32_t text = 0, rodata = 0, data = 0, bss = 0;
+    uint32_t text_sz = 0, rodata_sz = 0, data_sz = 0, bss_sz = 0;
+    uint32_t stack_lo = 0, stack_hi = 0, heap_lo = 0, heap_hi = 0;
+    int have_stack = 0, have_heap = 0;
+
+    if (f == NULL) {
+        perror(path);
+        return -1;
+    }
+    while (fgets(line, sizeof(line), f) != NULL) {
+        char name[128];
+        unsigned long a, b;
+
+        if (line[0] == '.' && sscanf(line, "%127s 0x%lx 0x%lx", name, &a, &b) == 3) {
+            if (strcmp(name, ".text") == 0) { text = (uint32_t)a; text_sz = (uint32_t)b; }
+            else if (strcmp(name, ".rodata") == 0) { rodata = (uint32_t)a; rodata_sz = (uint32_t)b; }
+            else if (strcmp(name, ".data") == 0) { data = (uint32_t)a; data_sz = (uint32_t)b; }
+            else if (strcmp(name, ".bss") == 0) { bss = (uint32_t)a; bss_sz = (uint32_t)b; }
+            continue;
+        }
+        if (sscanf(line, " 0x%lx %127s =", &a, name) == 2) {
+            if (strcmp(name, "_stack_start") == 0) { stack_lo = (uint32_t)a; have_stack |= 1; }
+            else if (strcmp(name, "_stack_end") == 0) { stack_hi = (uint32_t)a; have_stack |= 2; }
+            else if (strcmp(name, "_heap_start") == 0) { heap_lo = (uint32_t)a; have_heap |= 1; }
+            else if (strcmp(name, "_heap_end") == 0) { heap_hi = (uint32_t)a; have_heap |= 2; }
+        }
+    }
+    fclose(f);
+
+    if (text_sz) { region_add(".text", text, text + text_sz - 1u); }
+    if (rodata_sz) { region_add(".rodata", rodata, rodata + rodata_sz - 1u); }
+    if (data_sz) { region_add(".data", data, data + data_sz - 1u); }
+    if (bss_sz) { region_add(".bss", bss, bss + bss_sz - 1u); }
+    if (have_stack == 3 && stack_hi > stack_lo) { region_add("stack", stack_lo, stack_hi - 1u); }
+    if (have_heap == 3 && heap_hi > heap_lo) { region_add("heap", heap_lo, heap_hi - 1u); }
+    return 0;
+}
+
+static int parse_range(const char *spec) {
+    char name[32];
+    const char *eq = strchr(spec, '=');
+    char *end;
+    unsigned long lo, hi;
+    size_t len;
+
+    if (eq == NULL) {
+        return -1;
+    }
+    len = (size_t)(eq - spec);
+    if (len == 0 || len >= sizeof(name)) {
+        return -1;
+    }
+    memcpy(name, spec, len);
+    name[len] = '\0';
+    lo = strtoul(eq + 1, &end, 0);
+    if (*end != ':') {
+        return -1;
+    }
+    hi = strtoul(end + 1, &end, 0);
+    if (*end != '\0' || hi < lo) {
+        return -1;
+    }
+    region_add(name, (uint32_t)lo, (uint32_t)hi);
+    return 0;
+}
+
+static double pct(uint64_t part, uint64_t whole) {
+    return whole ? (100.0 * (double)part / (double)whole) : 0.0;
+}
+
+static int compare_bins(const void *a, const void *b) {
+    uint64_t ca = ((const stride_bin_t *)a)->count;
+    uint64_t cb = ((const stride_bin_t *)b)->count;
+    return (ca < cb) - (ca > cb);
+}
+
+static void report_regions(unsigned top) {
+    static const char *op_name[2] = { "read", "write" };
+    int i, op;
+
+    printf("== Traffic by region ==\n");
+    printf("%-10s %-23s %12s %12s %7s %10s %10s\n",
+           "region", "range", "reads", "writes", "share", "waw_same", "silent");
+    for (i = 0; i < region_count; i++) {
+        region_t *r = &regions[i];
+        uint64_t n = r->accesses[0] + r->accesses[1];
+        if (n == 0u) {
+            continue;
+        }
+        printf("%-10s 0x%08" PRIx32 "-0x%08" PRIx32 " %12" PRIu64 " %12" PRIu64 " %6.2f%% %10" PRIu64 " %10" PRIu64 "\n",
+               r->name, r->lo, r->hi, r->accesses[0], r->accesses[1],
+               pct(n, total_records), r->waw_same, r->silent);
+    }
+
+    printf("\n== Stride distribution (bytes between consecutive same-op accesses) ==\n");
+    for (i = 0; i < region_count; i++) {
+        region_t *r = &regions[i];
+        for (op = 0; op < 2; op++) {
+            stride_bin_t sorted[STRIDE_SLOTS];
+            uint64_t n = r->accesses[op] > 0u ? r->accesses[op] - 1u : 0u;
+            unsigned k;
+            if (n == 0u) {
+                continue;
+            }
+            memcpy(sorted, r->strides[op], sizeof(sorted));
+            qsort(sorted, STRIDE_SLOTS, sizeof(sorted[0]), compare_bins);
+            printf("%-10s %-5s:", r->name, op_name[op]);
+            for (k = 0; k < top && k < STRIDE_SLOTS && sorted[k].count; k++) {
+                printf(" %+d:%.1f%%", sorted[k].stride, pct(sorted[k].count, n));
+            }
+            if (r->stride_other[op]) {
+                printf(" other:%.1f%%", pct(r->stride_other[op], n));
+            }
+            printf("\n");
+        }
+    }
+}
+
+static void report_reuse(void) {
+    uint64_t n = reuse_cold;
+    unsigned b;
+
+    for (b = 0; b < REUSE_BUCKETS; b++) {
+        n += reuse_hist[b];
+    }
+    printf("\n== Reuse distance (distinct RAM words between reuses) ==\n");
+    printf("  %-12s %12" PRIu64 " %6.2f%%\n", "cold", reuse_cold, pct(reuse_cold, n));
+    for (b = 0; b < REUSE_BUCKETS; b++) {
+        char label[24];
+        if (b == 0u) {
+            snprintf(label, sizeof(label), "0");
+        } else if (b == 1u) {
+            snprintf(label, sizeof(label), "1");
+        } else {
+            snprintf(label, sizeof(label), "%u-%u", 1u << (b - 1u), (1u << b) - 1u);
+        }
+        if (reuse_hist[b]) {
+            printf("  %-12s %12" PRIu64 " %6.2f%%\n", label, reuse_hist[b], pct(reuse_hist[b], n));
+        }
+    }
+}
+
+static unsigned ilog2_u64(uint64_t v) {
+    unsigned n = 0;
+    while (v >>= 1) {
+        n++;
+    }
+    return n;
+}
+
+static void report_heatmap(unsigned top) {
+    static const char ramp[] = " .:-=+*#%@";
+    uint64_t max = 0;
+    uint32_t w, row, col;
+    uint32_t best[64];
+    unsigned nbest = 0, k;
+
+    for (w = 0; w < RAM_WORDS; w++) {
+        if (word_hits[w] > max) {
+            max = word_hits[w];
+        }
+    }
+    printf("\n== Hot-word heatmap (word_index 0..8191, 2 words/char, log scale) ==\n");
+    if (max == 0u) {
+        printf("  (no main-RAM traffic)\n");
+        return;
+    }
+    for (row = 0; row < RAM_WORDS / 128u; row++) {
+        printf("  %4u 0x%04x |", row * 128u, row * 512u);
+        for (col = 0; col < 64u; col++) {
+            uint64_t v = word_hits[row * 128u + col * 2u] + word_hits[row * 128u + col * 2u + 1u];
+            unsigned level = 0;
+            if (v) {
+                level = 1u + (8u * ilog2_u64(v)) / (ilog2_u64(max) ? ilog2_u64(max) : 1u);
+                if (level > 9u) {
+                    level = 9u;
+                }
+            }
+            putchar(ramp[level]);
+        }
+        printf("|\n");
+    }
+
+    if (top > 64u) {
+        top = 64u;
+    }
+    for (w = 0; w < RAM_WORDS; w++) {
+        if (word_hits[w] == 0u) {
+            continue;
+        }
+        if (nbest < top) {
+            best[nbest++] = w;
+        } else if (word_hits[w] > word_hits[best[nbest - 1u]]) {
+            best[nbest - 1u] = w;
+        } else {
+            continue;
+        }
+        for (k = nbest - 1u; k > 0u && word_hits[best[k]] > word_hits[best[k - 1u]]; k--) {
+            uint32_t t = best[k];
+            best[k] = best[k - 1u];
+            best[k - 1u] = t;
+        }
+    }
+    printf("\n  hottest words:\n");
+    for (k = 0; k < nbest; k++) {
+        region_t *r = region_find(best[k] * 4u);
+        printf("  word %4" PRIu32 " 0x%08" PRIx32 " %-10s %12" PRIu64 "\n",
+               best[k], best[k] * 4u, r ? r->name : "-", word_hits[best[k]]);
+    }
+}
+
+static int write_heatmap_csv(const char *path) {
+    FILE *f = fopen(path, "w");
+    uint32_t w;
+
+    if (f == NULL) {
+        perror(path);
+        return -1;
+    }
+    fprintf(f, "word_index,addr_hex,accesses\n");
+    for (w = 0; w < RAM_WORDS; w++) {
+        fprintf(f, "%" PRIu32 ",0x%08" PRIx32 ",%" PRIu64 "\n", w, w * 4u, word_hits[w]);
+    }
+    fclose(f);
+    return 0;
+}
+
+static void process_csv_line(const char *line) {
+    int op;
+    uint32_t addr, data;
+
+    if (strncmp(line, "# trigger start", 15) == 0) {
+        trigger_windows++;
+        return;
+    }
+    if (line[0] < '0' || line[0] > '9') {
+        return; /* header, stop marker or blank */
+    }
+    if (!parse_record(line, &op, &addr, &data)) {
+        bad_records++;
+        return;
+    }
+    account(op, addr, data);
+}
+
+static void usage(const char *argv0) {
+    fprintf(stderr,
+            "usage: %s [--map FILE.map] [--range name=lo:hi]... [--top N]\n"
+            "          [--heatmap-csv FILE] [mem.log | -]\n",
+            argv0);
+}
+
+int main(int argc, char **argv) {
+    const char *map_path = NULL;
+    const char *log_path = "mem.log";
+    const char *heatmap_csv = NULL;
+    unsigned top = 8;
+    FILE *in;
+    char head[MEMLOG_BIN_MAGIC_LEN];
+    size_t got;
+    char *line = NULL;
+    size_t cap = 0;
+    int i;
+
+    for (i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--map") == 0 && i + 1 < argc) {
+            map_path = argv[++i];
+        } else if (strcmp(argv[i], "--range") == 0 && i + 1 < argc) {
+            if (parse_range(argv[++i]) != 0) {
+                fprintf(stderr, "memlog_analyze: bad range '%s' (want name=lo:hi)\n", argv[i]);
+                return 2;
+            }
+        } else if (strcmp(argv[i], "--top") == 0 && i + 1 < argc) {
+            top = (unsigned)strtoul(argv[++i], NULL, 0);
+        } else if (strcmp(argv[i], "--heatmap-csv") == 0 && i + 1 < argc) {
+            heatmap_csv = argv[++i];
+        } else if (argv[i][0] == '-' && argv[i][1] != '\0') {
+            usage(argv[0]);
+            return 2;
+        } else {
+            log_path = argv[i];
+        }
+    }
+
+    /* User ranges were added first and win over map/default regions. */
+    if (map_path != NULL && load_map(map_path) != 0) {
+        return 1;
+    }
+    region_add("ram", 0u, RAM_BYTES - 1u);
+    region_add("vga", VGA_PLANES_LO, VGA_PLANES_HI);
+    region_add("vga_swap", VGA_SWAP_LO, VGA_SWAP_HI);
+    region_add("other", 0u, 0xFFFFFFFFu);
+
+    for (i = 0; i < (int)RAM_WORDS; i++) {
+        reuse_slot_of[i] = -1;
+    }
+    shadow = calloc(SHADOW_SLOTS, sizeof(*shadow));
+    if (shadow == NULL) {
+        fprintf(stderr, "memlog_analyze: out of memory\n");
+        return 1;
+    }
+
+    in = strcmp(log_path, "-") == 0 ? stdin : fopen(log_path, "rb");
+    if (in == NULL) {
+        perror(log_path);
+        return 1;
+    }
+    got = fread(head, 1, MEMLOG_BIN_MAGIC_LEN, in);
+    if (got == MEMLOG_BIN_MAGIC_LEN && memcmp(head, MEMLOG_BIN_MAGIC, MEMLOG_BIN_MAGIC_LEN) == 0) {
+        memlog_codec_t codec;
+        memlog_rec_t rec;
+        memset(&codec, 0, sizeof(codec));
+        while (memlog_decode(&codec, in, &rec)) {
+            if (rec.size == MEMLOG_SIZE_MARKER) {
+                trigger_windows += rec.is_write;
+                continue;
+            }
+            account(rec.is_write ? OP_WRITE : OP_READ, rec.addr, rec.data);
+        }
+    } else if (got > 0u) {
+        /* CSV: glue the peeked bytes back onto the rest of the first line. */
+        char *first;
+        ssize_t rest = getline(&line, &cap, in);
+        first = malloc(got + (rest > 0 ? (size_t)rest : 0u) + 1u);
+        if (first == NULL) {
+            fprintf(stderr, "memlog_analyze: out of memory\n");
+            return 1;
+        }
+        memcpy(first, head, got);
+        memcpy(first + got, rest > 0 ? line : "", rest > 0 ? (size_t)rest : 0u);
+        first[got + (rest > 0 ? (size_t)rest : 0u)] = '\0';
+        process_csv_line(first);
+        free(first);
+        while (getline(&line, &cap, in) > 0) {
+            process_csv_line(line);
+        }
+    }
+    free(line);
+    if (in != stdin) {
+        fclose(in);
+    }
+
+    printf("records: %" PRIu64 " (malformed: %" PRIu64 ")\n", total_records, bad_records);
+    if (trigger_windows) {
+        printf("trigger windows: %" PRIu64 "\n", trigger_windows);
+    }
+    printf("\n");
+    report_regions(top);
+    report_reuse();
+    report_heatmap(top);
+    if (shadow_full_drops) {
+        printf("\nnote: %" PRIu64 " accesses skipped redundant-store tracking (shadow table full)\n",
+               shadow_full_drops);
+    }
+    free(shadow);
+
+    if (heatmap_csv != NULL && write_heatmap_csv(heatmap_csv) != 0) {
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,426 @@
+/*
+ * DPI-C trace backend for mem_memlog.sv (compile the SV with +define+MEMLOG_DPI).
+ *
+ * The simulator thread only does a filter test, an optional golden-memory
+ * check and a push into a lock-free SPSC ring; a background thread drains
+ * the ring, aggregates per-region counts and writes the trace (CSV in the
+ * exact mem.log layout, or the compact MLOGBIN1 format from memlog_format.h).
+ * No SV string formatting or file I/O is left on the simulation path.
+ * Triggered-capture start/stop markers (memlog_dpi_note) travel through the
+ * same ring, so they land between the right records in either format.
+ *
+ * Options (comma-separated, passed through the DPI_OPTIONS parameter):
+ *   format=csv|bin     trace encoding (default csv)
+ *   range=LO:HI        only trace addresses in [LO, HI]; repeatable
+ *   ops=r|w|rw         only trace reads / writes (default rw)
+ *   golden=1           shadow main RAM and flag reads that disagree with it
+ *   image=FILE.mem     preload the golden shadow from a $(PROGRAM).mem image
+ *   wdata=laned        write data is already shifted into its byte lane
+ *                      (default: register value, RISC-V store semantics)
+ *   ring=N             ring capacity 2^N records (default 16)
+ *
+ * Build: make tools/libmemlog_dpi.so  (or compile this file into the
+ * simulator, e.g. verilator ... +define+MEMLOG_DPI tools/memlog_dpi.c)
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <inttypes.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "memlog_format.h"
+#include "spsc_ring.h"
+
+#define MEMLOG_MAX_HANDLES  8
+#define MEMLOG_MAX_RANGES   8
+#define MEMLOG_BATCH        4096u
+#define MEMLOG_RAM_BYTES    0x8000u
+#define MEMLOG_VGA_LO       0x10000000u
+#define MEMLOG_VGA_HI       0x1003FFFFu
+
+#define MEMLOG_DPI_CHECK    1
+#define MEMLOG_DPI_TRACE    2
+
+enum { REGION_RAM, REGION_VGA, REGION_OTHER, REGION_COUNT };
+
+SPSC_RING_DEFINE(trace_ring, memlog_rec_t)
+
+typedef struct {
+    int used;
+    FILE *out;
+    int binary;
+    memlog_codec_t codec;
+    trace_ring_t ring;
+    pthread_t writer;
+    atomic_int stop;
+
+    uint32_t range_lo[MEMLOG_MAX_RANGES];
+    uint32_t range_hi[MEMLOG_MAX_RANGES];
+    unsigned range_count;
+    unsigned ops_mask; /* bit0 = read, bit1 = write */
+
+    int golden;
+    int wdata_laned;
+    uint8_t *gold;
+    uint8_t *gold_valid;
+    uint32_t last_expected;
+
+    /* Producer-side counters. */
+    uint64_t accesses[2];
+    uint64_t filtered;
+    uint64_t stalls;
+    uint64_t mismatches;
+
+    /* Writer-side counters. */
+    uint64_t region_counts[REGION_COUNT][2];
+    uint64_t bytes_out;
+} memlog_dpi_t;
+
+static memlog_dpi_t handles[MEMLOG_MAX_HANDLES];
+
+static unsigned region_of(uint32_t addr) {
+    if (addr < MEMLOG_RAM_BYTES) {
+        return REGION_RAM;
+    }
+    if (addr >= MEMLOG_VGA_LO && addr <= MEMLOG_VGA_HI) {
+        return REGION_VGA;
+    }
+    return REGION_OTHER;
+}
+
+static void emit(memlog_dpi_t *m, const memlog_rec_t *r) {
+    if (r->size != MEMLOG_SIZE_MARKER) {
+        m->region_counts[region_of(r->addr)][r->is_write]++;
+    }
+    if (m->binary) {
+        uint8_t buf[MEMLOG_BIN_MAX_REC];
+        unsigned n = memlog_encode(&m->codec, r, buf);
+        fwrite(buf, 1, n, m->out);
+        m->bytes_out += n;
+    } else if (r->size == MEMLOG_SIZE_MARKER) {
+        int n = fprintf(m->out, "# trigger %s at %" PRIu64 "\n", r->is_write ? "start" : "stop", r->time);
+        m->bytes_out += n > 0 ? (uint64_t)n : 0u;
+    } else {
+        int n = fprintf(m->out, "%" PRIu64 ",%s,0x%08" PRIx32 ",%" PRIu32 ",0x%08" PRIx32 "\n",
+                        r->time, r->is_write ? "WRITE" : "READ", r->addr,
+                        (r->addr >> 2) & 0x1FFFu, r->data);
+        m->bytes_out += n > 0 ? (uint64_t)n : 0u;
+    }
+}
+
+static void *writer_main(void *arg) {
+    memlog_dpi_t *m = (memlog_dpi_t *)arg;
+    memlog_rec_t batch[MEMLOG_BATCH];
+
+    for (;;) {
+        unsigned n = trace_ring_pop(&m->ring, batch, MEMLOG_BATCH);
+        unsigned i;
+        if (n == 0u) {
+            struct timespec nap = { 0, 50000 };
+            if (atomic_load(&m->stop)) {
+                n = trace_ring_pop(&m->ring, batch, MEMLOG_BATCH);
+                if (n == 0u) {
+                    break;
+                }
+            } else {
+                nanosleep(&nap, NULL);
+                continue;
+            }
+        }
+        for (i = 0; i < n; i++) {
+            emit(m, &batch[i]);
+        }
+    }
+    fflush(m->out);
+    return NULL;
+}
+
+static int load_image(memlog_dpi_t *m, const char *path) {
+    FILE *f = fopen(path, "r");
+    char line[64];
+    uint32_t addr = 0;
+
+    if (f == NULL) {
+        fprintf(stderr, "memlog_dpi: cannot open image '%s'\n", path);
+        return -1;
+    }
+    while (addr + 4u <= MEMLOG_RAM_BYTES && fgets(line, sizeof(line), f) != NULL) {
+        char *end;
+        uint32_t word = (uint32_t)strtoul(line, &end, 16);
+        unsigned k;
+        if (end == line) {
+            continue;
+        }
+        for (k = 0; k < 4u; k++) {
+            m->gold[addr + k] = (uint8_t)(word >> (8u * k));
+            m->gold_valid[addr + k] = 1u;
+        }
+        addr += 4u;
+    }
+    fclose(f);
+    return 0;
+}
+
+static int parse_options(memlog_dpi_t *m, const char *options, unsigned *ring_log2) {
+    char buf[512];
+    char *save = NULL;
+    char *tok;
+
+    snprintf(buf, sizeof(buf), "%s", options != NULL ? options : "");
+    for (tok = strtok_r(buf, ",", &save); tok != NULL; tok = strtok_r(NULL, ",", &save)) {
+        char *val = strchr(tok, '=');
+        if (val == NULL) {
+            fprintf(stderr, "memlog_dpi: ignoring option '%s'\n", tok);
+            continue;
+        }
+        *val++ = '\0';
+        if (strcmp(tok, "format") == 0) {
+            m->binary = strcmp(val, "bin") == 0;
+        } else if (strcmp(tok, "range") == 0 && m->range_count < MEMLOG_MAX_RANGES) {
+            char *end;
+            m->range_lo[m->range_count] = (uint32_t)strtoul(val, &end, 0);
+            m->range_hi[m->range_count] = (uint32_t)strtoul(*end == ':' ? end + 1 : end, NULL, 0);
+            m->range_count++;
+        } else if (strcmp(tok, "ops") == 0) {
+            m->ops_mask = (strchr(val, 'r') ? 1u : 0u) | (strchr(val, 'w') ? 2u : 0u);
+        } else if (strcmp(tok, "golden") == 0) {
+            m->golden = atoi(val) != 0;
+        } else if (strcmp(tok, "image") == 0) {
+            m->golden = 1;
+            free(m->gold);
+            free(m->gold_valid);
+            m->gold = calloc(MEMLOG_RAM_BYTES, 1);
+            m->gold_valid = calloc(MEMLOG_RAM_BYTES, 1);
+            if (m->gold == NULL || m->gold_valid == NULL || load_image(m, val) != 0) {
+                return -1;
+            }
+        } else if (strcmp(tok, "wdata") == 0) {
+            m->wdata_laned = strcmp(val, "laned") == 0;
+        } else if (strcmp(tok, "ring") == 0) {
+            *ring_log2 = (unsigned)atoi(val);
+            if (*ring_log2 < 4u || *ring_log2 > 26u) {
+                *ring_log2 = 16u;
+            }
+        } else {
+            fprintf(stderr, "memlog_dpi: ignoring option '%s'\n", tok);
+        }
+    }
+    return 0;
+}
+
+/* Undo what memlog_dpi_open allocated before a failure; returns -1 */
+static int open_failed(memlog_dpi_t *m) {
+    free(m->gold);
+    free(m->gold_valid);
+    m->gold = NULL;
+    m->gold_valid = NULL;
+    return -1;
+}
+
+int memlog_dpi_open(const char *filename, const char *options) {
+    memlog_dpi_t *m = NULL;
+    unsigned ring_log2 = 16u;
+    int h;
+
+    for (h = 0; h < MEMLOG_MAX_HANDLES; h++) {
+        if (!handles[h].used) {
+            m = &handles[h];
+            break;
+        }
+    }
+    if (m == NULL) {
+        fprintf(stderr, "memlog_dpi: too many open logs\n");
+        return -1;
+    }
+    memset(m, 0, sizeof(*m));
+    m->ops_mask = 3u;
+    if (parse_options(m, options, &ring_log2) != 0) {
+        return open_failed(m);
+    }
+    if (m->golden && m->gold == NULL) {
+        m->gold = calloc(MEMLOG_RAM_BYTES, 1);
+        m->gold_valid = calloc(MEMLOG_RAM_BYTES, 1);
+        if (m->gold == NULL || m->gold_valid == NULL) {
+            return open_failed(m);
+        }
+    }
+
+    m->out = fopen(filename, m->binary ? "wb" : "w");
+    if (m->out == NULL) {
+        fprintf(stderr, "memlog_dpi: failed to open log file '%s'\n", filename);
+        return open_failed(m);
+    }
+    setvbuf(m->out, NULL, _IOFBF, 1u << 20);
+    if (m->binary) {
+        fwrite(MEMLOG_BIN_MAGIC, 1, MEMLOG_BIN_MAGIC_LEN, m->out);
+    } else {
+        fprintf(m->out, "time,op,addr_hex,word_index,data_hex\n");
+    }
+
+    if (trace_ring_init(&m->ring, ring_log2) != 0) {
+        fclose(m->out);
+        return open_failed(m);
+    }
+    atomic_init(&m->stop, 0);
+    if (pthread_create(&m->writer, NULL, writer_main, m) != 0) {
+        trace_ring_free(&m->ring);
+        fclose(m->out);
+        return open_failed(m);
+    }
+    m->used = 1;
+    return h;
+}
+
+/* Returns 1 when a read disagrees with the golden shadow (see memlog_dpi_expected). */
+static int golden_check(memlog_dpi_t *m, const memlog_rec_t *r) {
+    uint32_t nbytes = 1u << (r->size > 2u ? 2u : r->size);
+    uint32_t addr = r->addr;
+    uint32_t k;
+    int bad = 0;
+
+    if (addr >= MEMLOG_RAM_BYTES || addr + nbytes > MEMLOG_RAM_BYTES) {
+        return 0;
+    }
+    if (r->is_write) {
+        for (k = 0; k < nbytes; k++) {
+            uint32_t shift = m->wdata_laned ? 8u * ((addr + k) & 3u) : 8u * k;
+            m->gold[addr + k] = (uint8_t)(r->data >> shift);
+            m->gold_valid[addr + k] = 1u;
+        }
+        return 0;
+    }
+
+    /* Read data is the raw memory word: compare only the accessed lanes. */
+    m->last_expected = r->data;
+    for (k = 0; k < nbytes; k++) {
+        uint32_t shift = 8u * ((addr + k) & 3u);
+        if (m->gold_valid[addr + k] && (uint8_t)(r->data >> shift) != m->gold[addr + k]) {
+            m->last_expected = (m->last_expected & ~(0xFFu << shift)) |
+                               ((uint32_t)m->gold[addr + k] << shift);
+            bad = 1;
+        }
+    }
+    if (bad) {
+        m->mismatches++;
+    }
+    return bad;
+}
+
+/*
+ * flags: MEMLOG_DPI_CHECK runs the golden check, MEMLOG_DPI_TRACE queues the
+ * record for the trace. mem_memlog checks every live access but traces only
+ * inside capture windows, replaying its pre-trigger buffer trace-only.
+ */
+int memlog_dpi_access(int handle, unsigned long long t, int is_write, int size,
+                      unsigned int addr, unsigned int data, int flags) {
+    memlog_dpi_t *m;
+    memlog_rec_t r;
+    int bad = 0;
+    unsigned i;
+
+    if (handle < 0 || handle >= MEMLOG_MAX_HANDLES || !handles[handle].used) {
+        return 0;
+    }
+    m = &handles[handle];
+    r.time = t;
+    r.addr = addr;
+    r.data = data;
+    r.is_write = (uint8_t)(is_write != 0);
+    r.size = (uint8_t)(size & 3);
+    if (flags & MEMLOG_DPI_CHECK) {
+        m->accesses[r.is_write]++;
+    }
+
+    if ((flags & MEMLOG_DPI_CHECK) && m->golden) {
+        bad = golden_check(m, &r);
+    }
+    if (!(flags & MEMLOG_DPI_TRACE)) {
+        return bad;
+    }
+
+    if (!(m->ops_mask & (1u << r.is_write))) {
+        m->filtered++;
+        return bad;
+    }
+    if (m->range_count != 0u) {
+        for (i = 0; i < m->range_count; i++) {
+            if (addr >= m->range_lo[i] && addr <= m->range_hi[i]) {
+                break;
+            }
+        }
+        if (i == m->range_count) {
+            m->filtered++;
+            return bad;
+        }
+    }
+
+    while (!trace_ring_push(&m->ring, &r)) {
+        m->stalls++;
+        sched_yield();
+    }
+    return bad;
+}
+
+/* Trigger window marker at time t: start != 0 opens a window, 0 closes it. */
+void memlog_dpi_note(int handle, unsigned long long t, int start) {
+    memlog_dpi_t *m;
+    memlog_rec_t r;
+
+    if (handle < 0 || handle >= MEMLOG_MAX_HANDLES || !handles[handle].used) {
+        return;
+    }
+    m = &handles[handle];
+    r.time = t;
+    r.addr = 0u;
+    r.data = 0u;
+    r.is_write = (uint8_t)(start != 0);
+    r.size = (uint8_t)MEMLOG_SIZE_MARKER;
+    while (!trace_ring_push(&m->ring, &r)) {
+        m->stalls++;
+        sched_yield();
+    }
+}
+
+unsigned int memlog_dpi_expected(int handle) {
+    if (handle < 0 || handle >= MEMLOG_MAX_HANDLES) {
+        return 0u;
+    }
+    return handles[handle].last_expected;
+}
+
+void memlog_dpi_close(int handle) {
+    static const char *region_name[REGION_COUNT] = { "ram", "vga", "other" };
+    memlog_dpi_t *m;
+    unsigned g;
+
+    if (handle < 0 || handle >= MEMLOG_MAX_HANDLES || !handles[handle].used) {
+        return;
+    }
+    m = &handles[handle];
+    atomic_store(&m->stop, 1);
+    pthread_join(m->writer, NULL);
+    fclose(m->out);
+    trace_ring_free(&m->ring);
+
+    printf("memlog_dpi: %" PRIu64 " reads, %" PRIu64 " writes, %" PRIu64 " filtered, "
+           "%" PRIu64 " ring stalls, %" PRIu64 " bytes written\n",
+           m->accesses[0], m->accesses[1], m->filtered, m->stalls, m->bytes_out);
+    for (g = 0; g < REGION_COUNT; g++) {
+        if (m->region_counts[g][0] || m->region_counts[g][1]) {
+            printf("memlog_dpi:   %-5s %12" PRIu64 " reads %12" PRIu64 " writes\n",
+                   region_name[g], m->region_counts[g][0], m->region_counts[g][1]);
+        }
+    }
+    if (m->golden) {
+        printf("memlog_dpi: golden memory mismatches: %" PRIu64 "\n", m->mismatches);
+    }
+    free(m->gold);
+    free(m->gold_valid);
+    m->used = 0;
+}
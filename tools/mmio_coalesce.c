@@ -0,0 +1,719 @@
+/*
+ * Static MMIO store-coalescing analyzer.
+ *
+ * Disassembles every function in a built ELF and looks for byte and
+ * halfword stores to the VGA colour planes that could have been one SW:
+ *
+ *   block   narrow stores in one basic block that together cover an
+ *           aligned word of a plane (e.g. four SB at +0..+3)
+ *   loop    narrow stores in a loop whose address register advances by a
+ *           constant step each iteration and whose stores tile that step
+ *           (e.g. "sb; addi a5,a5,1" byte loops): an SW-per-word loop
+ *           would issue 4 / bytes-per-store times fewer stores
+ *
+ * Addresses are resolved by a per-function dataflow pass over the basic
+ * blocks. Each register holds a constant, a pointer into one VGA plane
+ * with a known power-of-two alignment, or an unknown value (with
+ * alignment). lui/auipc/addi/add/slli/andi and calls (which clobber the
+ * caller-saved registers) are followed. Inside a block, registers are
+ * tracked as "entry value + constant" so relative offsets are exact even
+ * when the base is not.
+ *
+ * Usage:
+ *   tools/mmio_coalesce [-v] [--fail-above N] program.elf
+ *     -v              list every candidate store group / loop
+ *     --fail-above N  exit 1 if more than N stores could be coalesced
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <inttypes.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "elf32.h"
+#include "rv32i_model.h"
+
+#define VGA_BASE        0x10000000u
+#define VGA_PLANE_SIZE  0x10000u
+#define VGA_PLANES      3u
+
+#define MAX_INSNS       8192u
+#define MAX_STORES      1024u
+#define ALIGN_MAX       0x80000000u
+
+/* Abstract register value for the dataflow pass. */
+typedef enum { AV_TOP = 0, AV_CONST, AV_PLANE, AV_UNKNOWN } av_kind_t;
+
+typedef struct {
+    uint8_t kind;
+    uint8_t plane;              /* AV_PLANE: 0..2 */
+    uint32_t value;             /* AV_CONST */
+    uint32_t align;             /* known power-of-two divisor (AV_PLANE/AV_UNKNOWN) */
+} av_t;
+
+typedef struct {
+    av_t r[32];
+} state_t;
+
+/* Register inside one block: abstract value plus "sym + off" identity. */
+typedef struct {
+    av_t av;
+    uint32_t sym;               /* 0: absolute (av is AV_CONST, off is the value) */
+    uint32_t off;
+    uint32_t sym_align;         /* alignment of the sym's value */
+} sreg_t;
+
+typedef struct {
+    uint32_t pc;
+    uint32_t sym;
+    uint32_t off;
+    uint32_t base_align;
+    uint8_t size;
+    uint8_t plane;
+    uint8_t reg;
+    uint8_t in_group;
+    uint32_t block;
+} vstore_t;
+
+typedef struct {
+    uint32_t sb, sh, sw;
+    uint32_t block_stores;      /* narrow stores in word-covering groups */
+    uint32_t block_words;       /* SW that would replace them */
+    uint32_t loop_stores;       /* narrow stores in tiling stride loops */
+    uint32_t loops;
+} fn_stats_t;
+
+static rv32i_insn_t insns[MAX_INSNS];
+static uint8_t valid[MAX_INSNS];
+static uint8_t leader[MAX_INSNS];
+static uint32_t block_of[MAX_INSNS];
+static uint32_t block_start[MAX_INSNS];
+static state_t block_in[MAX_INSNS];
+static vstore_t stores[MAX_STORES];
+static uint32_t store_count;
+static uint32_t next_sym;
+static int verbose;
+
+static uint32_t lowbit(uint32_t v) {
+    return v == 0u ? ALIGN_MAX : (v & (~v + 1u));
+}
+
+static uint32_t min_u32(uint32_t a, uint32_t b) {
+    return a < b ? a : b;
+}
+
+static int plane_of(uint32_t addr) {
+    if (addr < VGA_BASE || addr >= VGA_BASE + VGA_PLANES * VGA_PLANE_SIZE) {
+        return -1;
+    }
+    return (int)((addr - VGA_BASE) / VGA_PLANE_SIZE);
+}
+
+static av_t av_const(uint32_t v) {
+    av_t a = { AV_CONST, 0, v, 0 };
+    return a;
+}
+
+static av_t av_unknown(uint32_t align) {
+    av_t a = { AV_UNKNOWN, 0, 0, align };
+    return a;
+}
+
+static uint32_t av_align(const av_t *a) {
+    return a->kind == AV_CONST ? lowbit(a->value) : a->align;
+}
+
+static av_t av_join(av_t a, av_t b) {
+    av_t r;
+    int pa, pb;
+
+    if (a.kind == AV_TOP) {
+        return b;
+    }
+    if (b.kind == AV_TOP) {
+        return a;
+    }
+    if (a.kind == AV_CONST && b.kind == AV_CONST && a.value == b.value) {
+        return a;
+    }
+    pa = a.kind == AV_CONST ? plane_of(a.value) : a.kind == AV_PLANE ? a.plane : -1;
+    pb = b.kind == AV_CONST ? plane_of(b.value) : b.kind == AV_PLANE ? b.plane : -1;
+    r.align = min_u32(av_align(&a), av_align(&b));
+    r.value = 0;
+    if (pa >= 0 && pa == pb) {
+        r.kind = AV_PLANE;
+        r.plane = (uint8_t)pa;
+    } else {
+        r.kind = AV_UNKNOWN;
+        r.plane = 0;
+    }
+    return r;
+}
+
+static int av_equal(const av_t *a, const av_t *b) {
+    return a->kind == b->kind && a->plane == b->plane && a->value == b->value && a->align == b->align;
+}
+
+/* a + b where b has alignment / maybe a constant value. */
+static av_t av_add(av_t a, av_t b) {
+    int p;
+
+    if (a.kind == AV_TOP || b.kind == AV_TOP) {
+        return av_unknown(1u);
+    }
+    if (a.kind == AV_CONST && b.kind == AV_CONST) {
+        return av_const(a.value + b.value);
+    }
+    if (b.kind == AV_PLANE || (b.kind == AV_CONST && plane_of(b.value) >= 0)) {
+        av_t t = a;
+        a = b;
+        b = t;
+    }
+    // pointer into a plane plus an offset stays in that plane
+    p = a.kind == AV_CONST ? plane_of(a.value) : a.kind == AV_PLANE ? a.plane : -1;
+    if (p >= 0 && b.kind != AV_PLANE) {
+        av_t r = { AV_PLANE, (uint8_t)p, 0, min_u32(av_align(&a), av_align(&b)) };
+        return r;
+    }
+    return av_unknown(min_u32(av_align(&a), av_align(&b)));
+}
+
+static int is_caller_saved(unsigned r) {
+    return r == 1u || (r >= 5u && r <= 7u) || (r >= 10u && r <= 17u) || r >= 28u;
+}
+
+/* Abstract effect of one instruction on register state (dataflow pass). */
+static void transfer(av_t *r, const rv32i_insn_t *d, uint32_t pc) {
+    av_t a = r[d->rs1];
+    av_t b = r[d->rs2];
+    av_t imm = av_const((uint32_t)d->imm);
+    av_t v;
+
+    switch (d->op) {
+    case RV32I_OP_LUI:
+        v = imm;
+        break;
+    case RV32I_OP_AUIPC:
+        v = av_const(pc + (uint32_t)d->imm);
+        break;
+    case RV32I_OP_JAL:
+    case RV32I_OP_JALR:
+        if (d->rd == 1u) {
+            for (unsigned i = 1; i < 32u; ++i) {
+                if (is_caller_saved(i)) {
+                    r[i] = av_unknown(1u);
+                }
+            }
+        }
+        v = av_const(pc + 4u);
+        break;
+    case RV32I_OP_ADDI:
+        v = av_add(a, imm);
+        break;
+    case RV32I_OP_CSRRW: case RV32I_OP_CSRRS: case RV32I_OP_CSRRC:
+    case RV32I_OP_CSRRWI: case RV32I_OP_CSRRSI: case RV32I_OP_CSRRCI:
+        v = av_unknown(1u);
+        break;
+    case RV32I_OP_ADD:
+        v = av_add(a, b);
+        break;
+    case RV32I_OP_SUB:
+        if (a.kind == AV_CONST && b.kind == AV_CONST) {
+            v = av_const(a.value - b.value);
+        } else if (b.kind == AV_CONST) {
+            v = av_add(a, av_const(0u - b.value));
+        } else {
+            v = av_unknown(min_u32(av_align(&a), av_align(&b)));
+        }
+        break;
+    case RV32I_OP_SLLI:
+        if (a.kind == AV_CONST) {
+            v = av_const(a.value << (d->imm & 31));
+        } else {
+            uint32_t al = av_align(&a);
+            v = av_unknown(al >= (ALIGN_MAX >> (d->imm & 31)) ? ALIGN_MAX : al << (d->imm & 31));
+        }
+        break;
+    case RV32I_OP_ANDI:
+        if (a.kind == AV_CONST) {
+            v = av_const(a.value & (uint32_t)d->imm);
+        } else {
+            uint32_t al = av_align(&a);
+            uint32_t m = lowbit((uint32_t)d->imm);
+            v = av_unknown(al > m ? al : m);
+        }
+        break;
+    default:
+        switch (rv32i_format_of(d->op)) {
+        case RV32I_FMT_R:
+            v = (a.kind == AV_CONST && b.kind == AV_CONST) ?
+                av_const(rv32i_alu(d->op, a.value, b.value)) : av_unknown(1u);
+            break;
+        case RV32I_FMT_I:
+            if (d->op >= RV32I_OP_LB && d->op <= RV32I_OP_LHU) {
+                v = av_unknown(1u);
+            } else {
+                v = (a.kind == AV_CONST) ? av_const(rv32i_alu(d->op, a.value, (uint32_t)d->imm)) :
+                    av_unknown(1u);
+            }
+            break;
+        default:
+            return;     /* stores, branches, fence, system: no rd */
+        }
+    }
+    if (d->rd != 0u) {
+        r[d->rd] = v;
+    }
+}
+
+static int is_branch(rv32i_op_t op) {
+    return op >= RV32I_OP_BEQ && op <= RV32I_OP_BGEU;
+}
+
+static int is_store(rv32i_op_t op) {
+    return op == RV32I_OP_SB || op == RV32I_OP_SH || op == RV32I_OP_SW;
+}
+
+static uint32_t store_size(rv32i_op_t op) {
+    return op == RV32I_OP_SW ? 4u : op == RV32I_OP_SH ? 2u : 1u;
+}
+
+/* Ends the block after insn i? Also returns the in-function target, if any. */
+static int ends_block(uint32_t i, uint32_t base, uint32_t n, uint32_t *target) {
+    const rv32i_insn_t *d = &insns[i];
+    uint32_t pc = base + 4u * i;
+
+    *target = UINT32_MAX;
+    if (!valid[i]) {
+        return 1;
+    }
+    if (is_branch(d->op) || (d->op == RV32I_OP_JAL && d->rd == 0u)) {
+        uint32_t t = pc + (uint32_t)d->imm;
+        if (t >= base && t < base + 4u * n) {
+            *target = (t - base) / 4u;
+        }
+        return 1;
+    }
+    return d->op == RV32I_OP_JALR && d->rd == 0u;
+}
+
+static int falls_through(uint32_t i) {
+    const rv32i_insn_t *d = &insns[i];
+    return valid[i] && !(d->op == RV32I_OP_JALR && d->rd == 0u) && !(d->op == RV32I_OP_JAL && d->rd == 0u);
+}
+
+static int merge_into(uint32_t blk, const state_t *s) {
+    int changed = 0;
+
+    for (unsigned r = 0; r < 32u; ++r) {
+        av_t j = av_join(block_in[blk].r[r], s->r[r]);
+        if (!av_equal(&j, &block_in[blk].r[r])) {
+            block_in[blk].r[r] = j;
+            changed = 1;
+        }
+    }
+    return changed;
+}
+
+static void dataflow(uint32_t base, uint32_t n, uint32_t nblocks) {
+    uint8_t *queued = calloc(nblocks, 1);
+    int again = 1;
+
+    if (queued == NULL) {
+        perror("calloc");
+        exit(2);
+    }
+
+    memset(block_in, 0, sizeof(block_in[0]) * nblocks);
+    for (unsigned r = 0; r < 32u; ++r) {
+        block_in[0].r[r] = av_unknown(1u);
+    }
+    block_in[0].r[0] = av_const(0u);
+    block_in[0].r[2] = av_unknown(16u);     /* sp */
+    queued[0] = 1;
+
+    while (again) {
+        again = 0;
+        for (uint32_t b = 0; b < nblocks; ++b) {
+            state_t s;
+            uint32_t i = block_start[b];
+            uint32_t target;
+            if (!queued[b]) {
+                continue;
+            }
+            queued[b] = 0;
+            s = block_in[b];
+            for (;; ++i) {
+                if (valid[i]) {
+                    transfer(s.r, &insns[i], base + 4u * i);
+                    s.r[0] = av_const(0u);
+                }
+                if (ends_block(i, base, n, &target) || i + 1u >= n || leader[i + 1u]) {
+                    break;
+                }
+            }
+            if (target != UINT32_MAX && merge_into(block_of[target], &s)) {
+                queued[block_of[target]] = 1;
+                again = 1;
+            }
+            if (falls_through(i) && i + 1u < n && merge_into(block_of[i + 1u], &s)) {
+                queued[block_of[i + 1u]] = 1;
+                again = 1;
+            }
+        }
+    }
+    free(queued);
+}
+
+static void sreg_fresh(sreg_t *r, av_t av) {
+    r->av = av;
+    if (av.kind == AV_CONST) {
+        r->sym = 0u;
+        r->off = av.value;
+        r->sym_align = ALIGN_MAX;
+    } else {
+        r->sym = ++next_sym;
+        r->off = 0u;
+        r->sym_align = av.align;
+    }
+}
+
+/* Symbolic effect of one instruction inside a block. */
+static void sym_step(sreg_t *s, const rv32i_insn_t *d, uint32_t pc) {
+    av_t avs[32];
+    sreg_t a = s[d->rs1];
+    sreg_t b = s[d->rs2];
+
+    for (unsigned r = 0; r < 32u; ++r) {
+        avs[r] = s[r].av;
+    }
+    transfer(avs, d, pc);
+    if ((d->op == RV32I_OP_JAL || d->op == RV32I_OP_JALR) && d->rd == 1u) {
+        for (unsigned r = 1; r < 32u; ++r) {
+            if (is_caller_saved(r)) {
+                sreg_fresh(&s[r], avs[r]);
+            }
+        }
+    }
+    if (d->rd == 0u || is_store(d->op) || is_branch(d->op)) {
+        return;
+    }
+    if (d->op == RV32I_OP_ADDI) {
+        s[d->rd].av = avs[d->rd];
+        s[d->rd].sym = a.sym;
+        s[d->rd].off = a.off + (uint32_t)d->imm;
+        s[d->rd].sym_align = a.sym_align;
+    } else if (d->op == RV32I_OP_ADD && (a.sym == 0u || b.sym == 0u)) {
+        s[d->rd].av = avs[d->rd];
+        s[d->rd].sym = a.sym == 0u ? b.sym : a.sym;
+        s[d->rd].off = a.off + b.off;
+        s[d->rd].sym_align = a.sym == 0u ? b.sym_align : a.sym_align;
+    } else {
+        sreg_fresh(&s[d->rd], avs[d->rd]);
+    }
+}
+
+static int plane_of_reg(const sreg_t *r, uint32_t imm) {
+    if (r->av.kind == AV_CONST) {
+        return plane_of(r->av.value + imm);
+    }
+    return r->av.kind == AV_PLANE ? r->av.plane : -1;
+}
+
+static void collect_stores(uint32_t base, uint32_t n, uint32_t nblocks, fn_stats_t *st) {
+    store_count = 0;
+    for (uint32_t b = 0; b < nblocks; ++b) {
+        sreg_t s[32];
+        uint32_t target;
+        if (block_in[b].r[0].kind == AV_TOP) {
+            continue;   /* unreachable */
+        }
+        for (unsigned r = 0; r < 32u; ++r) {
+            sreg_fresh(&s[r], block_in[b].r[r]);
+        }
+        for (uint32_t i = block_start[b];; ++i) {
+            const rv32i_insn_t *d = &insns[i];
+            if (valid[i] && is_store(d->op)) {
+                int plane = plane_of_reg(&s[d->rs1], (uint32_t)d->imm);
+                if (plane >= 0) {
+                    uint32_t size = store_size(d->op);
+                    st->sb += size == 1u;
+                    st->sh += size == 2u;
+                    st->sw += size == 4u;
+                    if (store_count < MAX_STORES) {
+                        vstore_t *v = &stores[store_count++];
+                        v->pc = base + 4u * i;
+                        v->sym = s[d->rs1].sym;
+                        v->off = s[d->rs1].off + (uint32_t)d->imm;
+                        v->base_align = s[d->rs1].sym_align;
+                        v->size = (uint8_t)size;
+                        v->plane = (uint8_t)plane;
+                        v->reg = d->rs1;
+                        v->in_group = 0;
+                        v->block = b;
+                    }
+                }
+            }
+            if (valid[i]) {
+                sym_step(s, d, base + 4u * i);
+            }
+            if (ends_block(i, base, n, &target) || i + 1u >= n || leader[i + 1u]) {
+                break;
+            }
+        }
+    }
+}
+
+/* Straight-line groups: narrow stores in one block covering an aligned word. */
+static void find_block_groups(const char *fn, fn_stats_t *st) {
+    for (uint32_t i = 0; i < store_count; ++i) {
+        vstore_t *v = &stores[i];
+        uint32_t word;
+        uint32_t mask = 0;
+        uint32_t k = 0;
+        if (v->size == 4u || v->in_group || v->base_align < 4u) {
+            continue;
+        }
+        word = v->off & ~3u;
+        for (uint32_t j = i; j < store_count; ++j) {
+            const vstore_t *w = &stores[j];
+            if (w->block == v->block && w->sym == v->sym && w->size != 4u && (w->off & ~3u) == word) {
+                mask |= ((1u << w->size) - 1u) << (w->off & 3u);
+                ++k;
+            }
+        }
+        if (mask != 0xFu || k < 2u) {
+            continue;
+        }
+        for (uint32_t j = i; j < store_count; ++j) {
+            vstore_t *w = &stores[j];
+            if (w->block == v->block && w->sym == v->sym && w->size != 4u && (w->off & ~3u) == word) {
+                w->in_group = 1;
+            }
+        }
+        st->block_stores += k;
+        st->block_words += 1u;
+        if (verbose) {
+            printf("    %s: block at 0x%08x: %u narrow stores cover one word of plane %u\n",
+                   fn, v->pc, k, v->plane);
+        }
+    }
+}
+
+/*
+ * Stride loops: for each backward branch/jump, walk its body once in
+ * address order. A register that ends as "entry + d" is an induction
+ * pointer with step d; narrow plane stores through it whose byte ranges
+ * tile [0, |d|) write a contiguous stream. Back edges are visited in
+ * address order, so inner loops claim their stores before outer ones.
+ */
+static void find_stride_loops(const char *fn, uint32_t base, uint32_t n, fn_stats_t *st) {
+    for (uint32_t e = 0; e < n; ++e) {
+        vstore_t body[64];
+        uint32_t body_count = 0;
+        uint32_t entry_sym[32];
+        sreg_t s[32];
+        uint32_t target;
+        uint32_t h;
+
+        if (!ends_block(e, base, n, &target) || target == UINT32_MAX || target > e) {
+            continue;
+        }
+        h = target;
+        if (block_in[block_of[h]].r[0].kind == AV_TOP) {
+            continue;
+        }
+        for (unsigned r = 0; r < 32u; ++r) {
+            sreg_fresh(&s[r], block_in[block_of[h]].r[r]);
+            entry_sym[r] = s[r].sym;
+        }
+        for (uint32_t i = h; i <= e; ++i) {
+            const rv32i_insn_t *d = &insns[i];
+            if (!valid[i]) {
+                continue;
+            }
+            if (is_store(d->op) && body_count < 64u) {
+                int plane = plane_of_reg(&s[d->rs1], (uint32_t)d->imm);
+                for (uint32_t j = 0; plane >= 0 && j < store_count; ++j) {
+                    if (stores[j].pc == base + 4u * i && !stores[j].in_group) {
+                        vstore_t *v = &body[body_count++];
+                        *v = stores[j];
+                        v->sym = s[d->rs1].sym;
+                        v->off = s[d->rs1].off + (uint32_t)d->imm;
+                        v->block = j;       /* index into stores[] */
+                        break;
+                    }
+                }
+            }
+            sym_step(s, d, base + 4u * i);
+        }
+        for (unsigned r = 1; r < 32u && body_count != 0u; ++r) {
+            uint32_t step = s[r].off;
+            uint32_t bytes = (step & 0x80000000u) ? 0u - step : step;
+            uint64_t covered = 0;
+            uint32_t narrow = 0;
+            uint32_t lo = UINT32_MAX;
+
+            if (entry_sym[r] == 0u || s[r].sym != entry_sym[r] || bytes == 0u || bytes > 32u) {
+                continue;
+            }
+            for (uint32_t j = 0; j < body_count; ++j) {
+                if (body[j].sym == entry_sym[r] && body[j].off < lo) {
+                    lo = body[j].off;
+                }
+            }
+            for (uint32_t j = 0; j < body_count; ++j) {
+                const vstore_t *v = &body[j];
+                if (v->sym != entry_sym[r] || v->off - lo + v->size > bytes) {
+                    continue;
+                }
+                covered |= ((1ull << v->size) - 1u) << (v->off - lo);
+                narrow += v->size != 4u;
+            }
+            if (narrow == 0u || covered != (1ull << bytes) - 1u) {
+                continue;
+            }
+            for (uint32_t j = 0; j < body_count; ++j) {
+                if (body[j].sym == entry_sym[r]) {
+                    stores[body[j].block].in_group = 1;
+                }
+            }
+            st->loop_stores += narrow;
+            st->loops++;
+            if (verbose) {
+                printf("    %s: loop 0x%08x..0x%08x: %u narrow stores per %u-byte step of %s "
+                       "(%u.%02u stores per word, 1 with SW)\n",
+                       fn, base + 4u * h, base + 4u * e, narrow, bytes, rv32i_reg_name(r),
+                       narrow * 4u / bytes, (narrow * 400u / bytes) % 100u);
+            }
+        }
+    }
+}
+
+static int analyze_function(const elf32_sym_t *fn, const uint8_t *text, uint32_t text_addr,
+                            uint32_t text_size, fn_stats_t *st) {
+    uint32_t base = fn->value;
+    uint32_t n = fn->size / 4u;
+    uint32_t nblocks = 0;
+
+    memset(st, 0, sizeof(*st));
+    if (n == 0u || base < text_addr || base - text_addr > text_size - fn->size) {
+        return -1;
+    }
+    if (n > MAX_INSNS) {
+        fprintf(stderr, "mmio_coalesce: %s is too large (%u insns), skipped\n", fn->name, n);
+        return -1;
+    }
+    memset(leader, 0, n);
+    leader[0] = 1;
+    for (uint32_t i = 0; i < n; ++i) {
+        const uint8_t *p = text + (base - text_addr) + 4u * i;
+        uint32_t word = (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+        valid[i] = (uint8_t)rv32i_decode(word, &insns[i]);
+    }
+    for (uint32_t i = 0; i < n; ++i) {
+        uint32_t target;
+        if (ends_block(i, base, n, &target)) {
+            if (i + 1u < n) {
+                leader[i + 1u] = 1;
+            }
+            if (target != UINT32_MAX) {
+                leader[target] = 1;
+            }
+        }
+    }
+    for (uint32_t i = 0; i < n; ++i) {
+        if (leader[i]) {
+            block_start[nblocks++] = i;
+        }
+        block_of[i] = nblocks - 1u;
+    }
+
+    next_sym = 0;
+    dataflow(base, n, nblocks);
+    collect_stores(base, n, nblocks, st);
+    find_block_groups(fn->name, st);
+    find_stride_loops(fn->name, base, n, st);
+    return 0;
+}
+
+static void usage(const char *argv0) {
+    fprintf(stderr, "usage: %s [-v] [--fail-above N] program.elf\n", argv0);
+}
+
+int main(int argc, char **argv) {
+    const char *path = NULL;
+    long fail_above = -1;
+    elf32_file_t elf;
+    elf32_sym_t sym;
+    const uint8_t *text;
+    uint32_t text_addr, text_size;
+    fn_stats_t total;
+    uint32_t functions = 0;
+
+    for (int i = 1; i < argc; ++i) {
+        if (strcmp(argv[i], "-v") == 0) {
+            verbose = 1;
+        } else if (strcmp(argv[i], "--fail-above") == 0 && i + 1 < argc) {
+            fail_above = strtol(argv[++i], NULL, 0);
+        } else if (argv[i][0] != '-' && path == NULL) {
+            path = argv[i];
+        } else {
+            usage(argv[0]);
+            return 2;
+        }
+    }
+    if (path == NULL) {
+        usage(argv[0]);
+        return 2;
+    }
+    if (elf32_open(&elf, path) != 0) {
+        return 1;
+    }
+    if (elf32_section(&elf, ".text", &text_addr, &text_size, &text) != 0 || text == NULL) {
+        fprintf(stderr, "%s: no .text section\n", path);
+        elf32_close(&elf);
+        return 1;
+    }
+
+    memset(&total, 0, sizeof(total));
+    printf("%-36s %5s %5s %5s  %12s %6s  %10s %5s\n",
+           "function", "sb", "sh", "sw", "block-narrow", "->sw", "loop-narrow", "loops");
+    for (uint32_t i = 1; elf32_symbol_at_index(&elf, i, &sym) == 0; ++i) {
+        fn_stats_t st;
+        if (sym.type != ELF32_STT_FUNC || sym.size == 0u) {
+            continue;
+        }
+        if (analyze_function(&sym, text, text_addr, text_size, &st) != 0) {
+            continue;
+        }
+        ++functions;
+        total.sb += st.sb;
+        total.sh += st.sh;
+        total.sw += st.sw;
+        total.block_stores += st.block_stores;
+        total.block_words += st.block_words;
+        total.loop_stores += st.loop_stores;
+        total.loops += st.loops;
+        if (st.sb + st.sh + st.sw == 0u) {
+            continue;
+        }
+        printf("%-36s %5u %5u %5u  %12u %6u  %10u %5u\n", sym.name, st.sb, st.sh, st.sw,
+               st.block_stores, st.block_words, st.loop_stores, st.loops);
+    }
+    printf("%-36s %5u %5u %5u  %12u %6u  %10u %5u\n", "total", total.sb, total.sh, total.sw,
+           total.block_stores, total.block_words, total.loop_stores, total.loops);
+    printf("%u functions; %u static VGA stores could be coalesced into SW "
+           "(%u in blocks -> %u SW, %u in %u stride loops)\n",
+           functions, total.block_stores + total.loop_stores, total.block_stores, total.block_words,
+           total.loop_stores, total.loops);
+    elf32_close(&elf);
+
+    if (fail_above >= 0 && (long)(total.block_stores + total.loop_stores) > fail_above) {
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,154 @@
+/*
+ * Host check of the division-free formatter (num_format.c/.h) against the
+ * C library.
+ *
+ *   - num_divu10 for every 32-bit value (quotient and remainder)
+ *   - --count random values (default 20000000) through num_format_u32,
+ *     num_format_i32 (both pads, widths 0..13), num_format_u64 and
+ *     num_format_hex32 (1..8 digits), each compared with snprintf
+ *   - edge values: 0, 9, 10, the 32-bit and 64-bit limits, INT32_MIN
+ *
+ * Prints the first mismatches and exits 1 if there is any.
+ *
+ * Usage:
+ *   tools/num_format_test [--count N] [--seed S] [--no-exhaustive]
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <inttypes.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../num_format.h"
+
+#define MAX_REPORTS 10u
+
+static uint64_t failures;
+
+static void check(const char *what, const char *got, const char *want) {
+    if (strcmp(got, want) != 0) {
+        if (failures < MAX_REPORTS) {
+            fprintf(stderr, "num_format_test: %s: got \"%s\", expected \"%s\"\n", what, got, want);
+        }
+        failures++;
+    }
+}
+
+static void check_u32(uint32_t v, uint32_t width, char pad) {
+    char got[32];
+    char want[32];
+
+    num_format_u32(got, v, width, pad);
+    snprintf(want, sizeof(want), pad == '0' ? "%0*" PRIu32 : "%*" PRIu32, (int)width, v);
+    check("u32", got, want);
+}
+
+static void check_i32(int32_t v, uint32_t width, char pad) {
+    char got[32];
+    char want[32];
+
+    num_format_i32(got, v, width, pad);
+    snprintf(want, sizeof(want), pad == '0' ? "%0*" PRId32 : "%*" PRId32, (int)width, v);
+    check("i32", got, want);
+}
+
+static void check_u64(uint64_t v) {
+    char got[32];
+    char want[32];
+
+    num_format_u64(got, v, 0u, '0');
+    snprintf(want, sizeof(want), "%" PRIu64, v);
+    check("u64", got, want);
+}
+
+static void check_hex(uint32_t v, uint32_t digits) {
+    char got[16];
+    char want[16];
+
+    num_format_hex32(got, v, digits);
+    snprintf(want, sizeof(want), "%08" PRIx32, v);
+    check("hex32", got, want + 8u - digits);
+}
+
+static uint64_t xorshift64(uint64_t *s) {
+    uint64_t x = *s;
+    x ^= x << 13;
+    x ^= x >> 7;
+    x ^= x << 17;
+    *s = x;
+    return x;
+}
+
+static void usage(const char *argv0) {
+    fprintf(stderr, "usage: %s [--count N] [--seed S] [--no-exhaustive]\n", argv0);
+}
+
+int main(int argc, char **argv) {
+    static const uint64_t edges[] = {
+        0u, 9u, 10u, 99u, 100u, 0x7FFFFFFFu, 0x80000000u, 0xFFFFFFFFu, 0x100000000u,
+        9999999999999999999u, 10000000000000000000u, UINT64_MAX - 1u, UINT64_MAX,
+    };
+    uint64_t count = 20000000u;
+    uint64_t seed = 88172645463325252u;
+    int exhaustive = 1;
+
+    for (int i = 1; i < argc; ++i) {
+        if (strcmp(argv[i], "--count") == 0 && i + 1 < argc) {
+            count = strtoull(argv[++i], NULL, 0);
+        } else if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc) {
+            seed = strtoull(argv[++i], NULL, 0);
+        } else if (strcmp(argv[i], "--no-exhaustive") == 0) {
+            exhaustive = 0;
+        } else {
+            usage(argv[0]);
+            return 2;
+        }
+    }
+    if (seed == 0u) {
+        seed = 1u;
+    }
+
+    if (exhaustive) {
+        uint64_t bad = 0;
+        for (uint64_t v = 0; v <= UINT32_MAX; ++v) {
+            uint32_t rem;
+            uint32_t q = num_divu10((uint32_t)v, &rem);
+            if (q != (uint32_t)(v / 10u) || rem != (uint32_t)(v % 10u)) {
+                if (bad < MAX_REPORTS) {
+                    fprintf(stderr, "num_format_test: num_divu10(%" PRIu64 ") = %" PRIu32 " rem %" PRIu32 "\n", v, q,
+                            rem);
+                }
+                bad++;
+            }
+        }
+        failures += bad;
+        printf("num_divu10: all 2^32 values, %" PRIu64 " wrong\n", bad);
+    }
+
+    for (uint64_t i = 0; i < count; ++i) {
+        // Shift so short numbers are as common as long ones
+        uint64_t v = xorshift64(&seed) >> (i & 63u);
+        uint32_t width = (uint32_t)(i % 14u);
+        char pad = (i & 1u) ? '0' : ' ';
+
+        check_u32((uint32_t)v, width, pad);
+        check_i32((int32_t)(uint32_t)v, width, pad);
+        check_u64(v);
+        check_hex((uint32_t)v, 1u + (uint32_t)(i & 7u));
+    }
+    for (size_t i = 0; i < sizeof(edges) / sizeof(edges[0]); ++i) {
+        check_u64(edges[i]);
+        check_u32((uint32_t)edges[i], 0u, '0');
+        check_i32((int32_t)(uint32_t)edges[i], 12u, ' ');
+        check_hex((uint32_t)edges[i], 8u);
+    }
+    check_i32(INT32_MIN, 0u, '0');
+    check_i32(INT32_MIN, 13u, '0');
+    check_i32(-1, 5u, '0');
+
+    printf("num_format: %" PRIu64 " random values, %" PRIu64 " mismatches\n", count, failures);
+    return failures != 0u;
+}
@@ -0,0 +1,510 @@
+/*
+ * Parameter sweeps over a self-checking program on the reference model.
+ *
+ * Loads $(PROGRAM).elf once, then runs it many times across worker
+ * threads, each run with its parameter block (params.h) patched in RAM:
+ * the cross product of every --values list, times --seeds random values of
+ * the "seed" parameter. A run ends when the program spins on a
+ * jump-to-self (main returned to boot.S), on ecall/ebreak, on a trap or at
+ * --max-insns. It passes when the --pass word (default test_result) is 0.
+ * The --collect words are recorded per run; by default test_mem_hammer's
+ * test_result, fail_phase, fail_index, fail_expected and fail_actual.
+ *
+ * There is no MMIO: any access outside RAM or any CSR counts as a trap.
+ *
+ * Built with -DPARAM_SWEEP_AOT and a program translated by tools/rvaot
+ * (make aot-sweep), runs call the native rvaot_run instead of stepping the
+ * reference model; the ELF must be the one that was translated. Results,
+ * timeouts included, match the interpreter's. CSR instructions trap as
+ * illegal either way.
+ *
+ * Usage:
+ *   tools/param_sweep [options] program.elf
+ *     --jobs N              worker threads (default: online CPUs)
+ *     --set NAME=VALUE      parameter for every run (repeatable)
+ *     --values NAME=A,B,... sweep a parameter (repeatable, cross product)
+ *     --seeds N             random "seed" values per combination (default 1: keep)
+ *     --seed S              seed of those seeds (default 1)
+ *     --max-insns N         per-run limit (default 100000000)
+ *     --pass SYM            pass when SYM reads 0 (default test_result)
+ *     --collect SYM         record SYM per run (repeatable)
+ *     --csv FILE            one line per run
+ *     --failures N          print the first N failing runs (default 20)
+ *     --ram-base A --ram-size N   main RAM (default 0x0, 0x8000)
+ *
+ * Exit status: 0 all passed, 1 a run failed, timed out or trapped.
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <inttypes.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "elf32.h"
+#include "params_image.h"
+#include "rv32i_model.h"
+#ifdef PARAM_SWEEP_AOT
+#include "rvaot.h"
+#define AOT_TAG " (translated)"
+#else
+#define AOT_TAG ""
+#endif
+
+#define MAX_SETS     32
+#define MAX_SWEEPS   8
+#define MAX_COLLECT  16
+
+typedef enum { RUN_PASS, RUN_FAIL, RUN_TIMEOUT, RUN_TRAP } run_status_t;
+
+static const char *const status_names[] = { "pass", "fail", "timeout", "trap" };
+
+typedef struct {
+    char name[PARAMS_NAME_LEN + 1u];
+    uint32_t *values;
+    uint32_t count;
+} sweep_t;
+
+typedef struct {
+    uint8_t status;
+    uint64_t instret;
+    uint32_t pc;
+    uint32_t collected[MAX_COLLECT];
+} run_t;
+
+typedef struct {
+    /* configuration */
+    uint32_t ram_base;
+    uint32_t ram_size;
+    uint64_t max_insns;
+    sweep_t sweeps[MAX_SWEEPS + 1];     /* + "seed" for --seeds */
+    unsigned sweep_count;
+    uint32_t pass_addr;
+    uint32_t collect_addr[MAX_COLLECT];
+    const char *collect_name[MAX_COLLECT];
+    unsigned collect_count;
+
+    const uint8_t *image;               /* RAM after loading and --set */
+    uint32_t entry;
+    uint64_t runs;
+    run_t *results;
+    atomic_ullong next;
+} sweep_ctx_t;
+
+static uint64_t rng_state;
+
+static uint32_t rnd(void) {
+    /* xorshift64* */
+    rng_state ^= rng_state >> 12;
+    rng_state ^= rng_state << 25;
+    rng_state ^= rng_state >> 27;
+    return (uint32_t)((rng_state * 0x2545F4914F6CDD1DULL) >> 32);
+}
+
+static uint32_t ram_word(const uint8_t *ram, const sweep_ctx_t *c, uint32_t addr) {
+    const uint8_t *p = ram + (addr - c->ram_base);
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+/* Parameter values of run r: mixed-radix digits, last sweep fastest. */
+static uint32_t param_value(const sweep_ctx_t *c, uint64_t r, unsigned s) {
+    for (unsigned k = c->sweep_count; k-- > s + 1u;) {
+        r /= c->sweeps[k].count;
+    }
+    return c->sweeps[s].values[r % c->sweeps[s].count];
+}
+
+#ifdef PARAM_SWEEP_AOT
+static void run_one(const sweep_ctx_t *c, uint8_t *ram, uint64_t r, run_t *out) {
+    rvaot_cpu_t cpu;
+    rvaot_stop_t stop;
+
+    memcpy(ram, c->image, c->ram_size);
+    for (unsigned s = 0; s < c->sweep_count; ++s) {
+        params_set(ram, c->ram_size, c->sweeps[s].name, param_value(c, r, s));
+    }
+    memset(&cpu, 0, sizeof(cpu));
+    cpu.ram = ram;
+    cpu.pc = c->entry;
+    cpu.max_insns = c->max_insns;
+
+    stop = rvaot_run(&cpu);
+    if (stop == RVAOT_STOP_SPIN || stop == RVAOT_STOP_ECALL || stop == RVAOT_STOP_EBREAK) {
+        out->status = (ram_word(ram, c, c->pass_addr) == 0u) ? RUN_PASS : RUN_FAIL;
+    } else {
+        out->status = (stop == RVAOT_STOP_LIMIT) ? RUN_TIMEOUT : RUN_TRAP;
+    }
+    out->instret = cpu.instret;
+    out->pc = cpu.pc;
+    for (unsigned k = 0; k < c->collect_count; ++k) {
+        out->collected[k] = ram_word(ram, c, c->collect_addr[k]);
+    }
+}
+#else
+static void run_one(const sweep_ctx_t *c, uint8_t *ram, uint64_t r, run_t *out) {
+    rv32i_cpu_t cpu;
+    rv32i_retire_t ret;
+
+    memcpy(ram, c->image, c->ram_size);
+    for (unsigned s = 0; s < c->sweep_count; ++s) {
+        params_set(ram, c->ram_size, c->sweeps[s].name, param_value(c, r, s));
+    }
+    rv32i_init(&cpu, ram, c->ram_base, c->ram_size);
+    cpu.pc = c->entry;
+
+    out->status = RUN_TIMEOUT;
+    while (cpu.instret < c->max_insns) {
+        rv32i_status_t st = rv32i_step(&cpu, &ret);
+        if (st == RV32I_ECALL || st == RV32I_EBREAK || (st == RV32I_OK && ret.next_pc == ret.pc)) {
+            out->status = (ram_word(ram, c, c->pass_addr) == 0u) ? RUN_PASS : RUN_FAIL;
+            break;
+        }
+        if (st != RV32I_OK) {
+            out->status = RUN_TRAP;
+            break;
+        }
+    }
+    out->instret = cpu.instret;
+    out->pc = cpu.pc;
+    for (unsigned k = 0; k < c->collect_count; ++k) {
+        out->collected[k] = ram_word(ram, c, c->collect_addr[k]);
+    }
+}
+#endif
+
+static void *worker(void *arg) {
+    sweep_ctx_t *c = arg;
+    uint8_t *ram = malloc(c->ram_size);
+
+    if (ram == NULL) {
+        perror("malloc");
+        return NULL;
+    }
+    for (;;) {
+        uint64_t r = atomic_fetch_add(&c->next, 1u);
+        if (r >= c->runs) {
+            break;
+        }
+        run_one(c, ram, r, &c->results[r]);
+    }
+    free(ram);
+    return NULL;
+}
+
+static int parse_list(const char *arg, sweep_t *s) {
+    const char *eq = strchr(arg, '=');
+    const char *p;
+    uint32_t n = 1;
+
+    if (eq == NULL || eq == arg || (size_t)(eq - arg) > PARAMS_NAME_LEN) {
+        return -1;
+    }
+    memcpy(s->name, arg, (size_t)(eq - arg));
+    s->name[eq - arg] = '\0';
+    for (p = eq + 1; *p != '\0'; ++p) {
+        n += *p == ',';
+    }
+    s->values = calloc(n, sizeof(*s->values));
+    if (s->values == NULL) {
+        return -1;
+    }
+    s->count = 0;
+    p = eq + 1;
+    while (s->count < n) {
+        char *end;
+        s->values[s->count++] = (uint32_t)strtoul(p, &end, 0);
+        if (end == p || (*end != ',' && *end != '\0')) {
+            return -1;
+        }
+        p = end + 1;
+    }
+    return 0;
+}
+
+static int symbol_addr(const elf32_file_t *elf, const sweep_ctx_t *c, const char *name, uint32_t *addr) {
+    elf32_sym_t sym;
+
+    if (elf32_symbol(elf, name, &sym) != 0) {
+        return -1;
+    }
+    if (sym.value < c->ram_base || sym.value - c->ram_base > c->ram_size - 4u || (sym.value & 3u) != 0u) {
+        fprintf(stderr, "param_sweep: %s (0x%08x) is not a RAM word\n", name, sym.value);
+        return -1;
+    }
+    *addr = sym.value;
+    return 0;
+}
+
+static void print_run(FILE *fp, const sweep_ctx_t *c, uint64_t r, const char *sep, int csv) {
+    const run_t *res = &c->results[r];
+
+    fprintf(fp, "%" PRIu64, r);
+    for (unsigned s = 0; s < c->sweep_count; ++s) {
+        if (csv) {
+            fprintf(fp, "%s0x%x", sep, param_value(c, r, s));
+        } else {
+            fprintf(fp, "%s%s=0x%x", sep, c->sweeps[s].name, param_value(c, r, s));
+        }
+    }
+    fprintf(fp, csv ? "%s%s%s%" PRIu64 "%s0x%08x" : "%s%s%sinsns=%" PRIu64 "%spc=0x%08x",
+            sep, status_names[res->status], sep, res->instret, sep, res->pc);
+    for (unsigned k = 0; k < c->collect_count; ++k) {
+        if (csv) {
+            fprintf(fp, "%s0x%08x", sep, res->collected[k]);
+        } else {
+            fprintf(fp, "%s%s=0x%08x", sep, c->collect_name[k], res->collected[k]);
+        }
+    }
+    fputc('\n', fp);
+}
+
+static int write_csv(const sweep_ctx_t *c, const char *path) {
+    FILE *fp = fopen(path, "w");
+
+    if (fp == NULL) {
+        perror(path);
+        return -1;
+    }
+    fprintf(fp, "run");
+    for (unsigned s = 0; s < c->sweep_count; ++s) {
+        fprintf(fp, ",%s", c->sweeps[s].name);
+    }
+    fprintf(fp, ",status,insns,pc");
+    for (unsigned k = 0; k < c->collect_count; ++k) {
+        fprintf(fp, ",%s", c->collect_name[k]);
+    }
+    fputc('\n', fp);
+    for (uint64_t r = 0; r < c->runs; ++r) {
+        print_run(fp, c, r, ",", 1);
+    }
+    return fclose(fp);
+}
+
+static void usage(const char *argv0) {
+    fprintf(stderr,
+            "usage: %s [--jobs N] [--set NAME=VALUE]... [--values NAME=A,B,...]... [--seeds N]\n"
+            "       [--seed S] [--max-insns N] [--pass SYM] [--collect SYM]... [--csv FILE]\n"
+            "       [--failures N] [--ram-base A] [--ram-size N] program.elf\n"
+            "No MMIO or CSRs: an access outside RAM is a bus error, and a CSR\n"
+            "instruction traps as illegal (in the translated build too).\n",
+            argv0);
+}
+
+int main(int argc, char **argv) {
+    static const char *const default_collect[] = {
+        "test_result", "fail_phase", "fail_index", "fail_expected", "fail_actual",
+    };
+    static sweep_ctx_t ctx;
+    sweep_ctx_t *c = &ctx;
+    const char *path = NULL;
+    const char *csv_path = NULL;
+    const char *pass_sym = "test_result";
+    const char *sets[MAX_SETS];
+    const char *collect[MAX_COLLECT];
+    unsigned set_count = 0;
+    unsigned collect_count = 0;
+    unsigned jobs = 0;
+    unsigned max_failures = 20;
+    uint32_t seeds = 1;
+    uint64_t master_seed = 1;
+    uint64_t counts[4] = { 0 };
+    uint64_t insns = 0;
+    pthread_t *threads;
+    struct timespec t0, t1;
+    double secs;
+    elf32_file_t elf;
+    uint8_t *image;
+    unsigned shown = 0;
+
+    memset(&elf, 0, sizeof(elf));
+    c->ram_base = 0x0u;
+    c->ram_size = 0x8000u;
+    c->max_insns = 100000000u;
+
+    for (int i = 1; i < argc; ++i) {
+        if (strcmp(argv[i], "--jobs") == 0 && i + 1 < argc) {
+            jobs = (unsigned)strtoul(argv[++i], NULL, 0);
+        } else if (strcmp(argv[i], "--set") == 0 && i + 1 < argc && set_count < MAX_SETS) {
+            sets[set_count++] = argv[++i];
+        } else if (strcmp(argv[i], "--values") == 0 && i + 1 < argc && c->sweep_count < MAX_SWEEPS) {
+            if (parse_list(argv[++i], &c->sweeps[c->sweep_count++]) != 0) {
+                fprintf(stderr, "param_sweep: bad list '%s'\n", argv[i]);
+                return 2;
+            }
+        } else if (strcmp(argv[i], "--seeds") == 0 && i + 1 < argc) {
+            seeds = (uint32_t)strtoul(argv[++i], NULL, 0);
+        } else if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc) {
+            master_seed = strtoull(argv[++i], NULL, 0);
+        } else if (strcmp(argv[i], "--max-insns") == 0 && i + 1 < argc) {
+            c->max_insns = strtoull(argv[++i], NULL, 0);
+        } else if (strcmp(argv[i], "--pass") == 0 && i + 1 < argc) {
+            pass_sym = argv[++i];
+        } else if (strcmp(argv[i], "--collect") == 0 && i + 1 < argc && collect_count < MAX_COLLECT) {
+            collect[collect_count++] = argv[++i];
+        } else if (strcmp(argv[i], "--csv") == 0 && i + 1 < argc) {
+            csv_path = argv[++i];
+        } else if (strcmp(argv[i], "--failures") == 0 && i + 1 < argc) {
+            max_failures = (unsigned)strtoul(argv[++i], NULL, 0);
+        } else if (strcmp(argv[i], "--ram-base") == 0 && i + 1 < argc) {
+            c->ram_base = (uint32_t)strtoul(argv[++i], NULL, 0);
+        } else if (strcmp(argv[i], "--ram-size") == 0 && i + 1 < argc) {
+            c->ram_size = (uint32_t)strtoul(argv[++i], NULL, 0);
+        } else if (argv[i][0] != '-' && path == NULL) {
+            path = argv[i];
+        } else {
+            usage(argv[0]);
+            return 2;
+        }
+    }
+    if (path == NULL || seeds == 0u || c->ram_size < 4u) {
+        usage(argv[0]);
+        return 2;
+    }
+    if (jobs == 0u) {
+        long n = sysconf(_SC_NPROCESSORS_ONLN);
+        jobs = (n > 0) ? (unsigned)n : 1u;
+    }
+
+    image = calloc(1, c->ram_size);
+    if (image == NULL) {
+        perror("calloc");
+        return 1;
+    }
+    if (elf32_open(&elf, path) != 0 || elf32_load(&elf, image, c->ram_base, c->ram_size) != 0) {
+        return 1;
+    }
+    c->entry = elf.entry;
+    c->image = image;
+#ifdef PARAM_SWEEP_AOT
+    if (rvaot_image.ram_base != c->ram_base || rvaot_image.ram_size != c->ram_size ||
+        rvaot_image.entry != c->entry || rvaot_image.code_end - c->ram_base > c->ram_size ||
+        rvaot_hash(image + (rvaot_image.code_base - c->ram_base), rvaot_image.code_end - rvaot_image.code_base) !=
+            rvaot_image.code_hash) {
+        fprintf(stderr, "param_sweep: %s is not the program translated from %s (rerun tools/rvaot)\n", path,
+                rvaot_image.source);
+        return 2;
+    }
+#endif
+    if (params_count(image, c->ram_size) < 0) {
+        fprintf(stderr, "param_sweep: %s has no parameter block at 0x%x\n", path, PARAMS_OFFSET);
+        return 1;
+    }
+    for (unsigned i = 0; i < set_count; ++i) {
+        if (params_apply(image, c->ram_size, sets[i]) != 0) {
+            return 2;
+        }
+    }
+    for (unsigned s = 0; s < c->sweep_count; ++s) {
+        uint32_t v;
+        if (params_get(image, c->ram_size, c->sweeps[s].name, &v) != 0) {
+            fprintf(stderr, "param_sweep: no parameter '%s'\n", c->sweeps[s].name);
+            return 2;
+        }
+    }
+    if (seeds > 1u) {
+        sweep_t *s = &c->sweeps[c->sweep_count++];
+        uint32_t v;
+        strcpy(s->name, "seed");
+        if (params_get(image, c->ram_size, "seed", &v) != 0) {
+            fprintf(stderr, "param_sweep: --seeds needs a 'seed' parameter\n");
+            return 2;
+        }
+        s->values = calloc(seeds, sizeof(*s->values));
+        if (s->values == NULL) {
+            perror("calloc");
+            return 1;
+        }
+        rng_state = master_seed ? master_seed : 1u;
+        for (uint32_t i = 0; i < seeds; ++i) {
+            do {
+                v = rnd();
+            } while (v == 0u);
+            s->values[i] = v;
+        }
+        s->count = seeds;
+    }
+
+    if (symbol_addr(&elf, c, pass_sym, &c->pass_addr) != 0) {
+        fprintf(stderr, "param_sweep: no pass symbol %s\n", pass_sym);
+        return 2;
+    }
+    if (collect_count == 0u) {
+        for (unsigned k = 0; k < sizeof(default_collect) / sizeof(default_collect[0]); ++k) {
+            if (symbol_addr(&elf, c, default_collect[k], &c->collect_addr[c->collect_count]) == 0) {
+                c->collect_name[c->collect_count++] = default_collect[k];
+            }
+        }
+    } else {
+        for (unsigned k = 0; k < collect_count; ++k) {
+            if (symbol_addr(&elf, c, collect[k], &c->collect_addr[c->collect_count]) != 0) {
+                fprintf(stderr, "param_sweep: no symbol %s\n", collect[k]);
+                return 2;
+            }
+            c->collect_name[c->collect_count++] = collect[k];
+        }
+    }
+
+    c->runs = 1;
+    for (unsigned s = 0; s < c->sweep_count; ++s) {
+        c->runs *= c->sweeps[s].count;
+    }
+    c->results = calloc(c->runs, sizeof(*c->results));
+    threads = calloc(jobs, sizeof(*threads));
+    if (c->results == NULL || threads == NULL) {
+        perror("calloc");
+        return 1;
+    }
+    atomic_init(&c->next, 0u);
+
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    for (unsigned t = 0; t < jobs; ++t) {
+        if (pthread_create(&threads[t], NULL, worker, c) != 0) {
+            fprintf(stderr, "param_sweep: cannot start thread %u\n", t);
+            jobs = t;
+            break;
+        }
+    }
+    for (unsigned t = 0; t < jobs; ++t) {
+        pthread_join(threads[t], NULL);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    secs = (double)(t1.tv_sec - t0.tv_sec) + (double)(t1.tv_nsec - t0.tv_nsec) * 1e-9;
+    if (atomic_load(&c->next) < c->runs) {
+        return 1;
+    }
+
+    for (uint64_t r = 0; r < c->runs; ++r) {
+        const run_t *res = &c->results[r];
+        counts[res->status]++;
+        insns += res->instret;
+        if (res->status != RUN_PASS && shown < max_failures) {
+            if (shown++ == 0u) {
+                printf("param_sweep: failing runs (first %u):\n", max_failures);
+            }
+            printf("  ");
+            print_run(stdout, c, r, "  ", 0);
+        }
+    }
+    printf("param_sweep: %s%s: %" PRIu64 " runs on %u thread%s in %.2f s (%.1f M instructions/s)\n",
+           path, AOT_TAG, c->runs, jobs, jobs == 1u ? "" : "s", secs, secs > 0.0 ? (double)insns / secs / 1e6 : 0.0);
+    printf("  pass %" PRIu64 ", fail %" PRIu64 ", timeout %" PRIu64 ", trap %" PRIu64 "\n",
+           counts[RUN_PASS], counts[RUN_FAIL], counts[RUN_TIMEOUT], counts[RUN_TRAP]);
+
+    if (csv_path != NULL && write_csv(c, csv_path) != 0) {
+        return 1;
+    }
+    for (unsigned s = 0; s < c->sweep_count; ++s) {
+        free(c->sweeps[s].values);
+    }
+    free(c->results);
+    free(threads);
+    free(image);
+    elf32_close(&elf);
+    return counts[RUN_PASS] == c->runs ? 0 : 1;
+}
@@ -0,0 +1,216 @@
+/*
+ * Load-time parameter blocks in program images. See params_image.h.
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "params_image.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#define ENTRY_BYTES (PARAMS_NAME_LEN + 4u)
+
+static uint32_t get32(const uint8_t *p) {
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static void put32(uint8_t *p, uint32_t v) {
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+    p[2] = (uint8_t)(v >> 16);
+    p[3] = (uint8_t)(v >> 24);
+}
+
+int params_count(const uint8_t *img, uint32_t size) {
+    uint32_t count;
+
+    if (size < PARAMS_OFFSET + 8u || get32(img + PARAMS_OFFSET) != PARAMS_MAGIC) {
+        return -1;
+    }
+    count = get32(img + PARAMS_OFFSET + 4u);
+    if (count > PARAMS_MAX_ENTRIES || count * ENTRY_BYTES > size - PARAMS_OFFSET - 8u) {
+        return -1;
+    }
+    return (int)count;
+}
+
+static const uint8_t *entry_at(const uint8_t *img, uint32_t i) {
+    return img + PARAMS_OFFSET + 8u + i * ENTRY_BYTES;
+}
+
+int params_entry(const uint8_t *img, uint32_t size, uint32_t i, char name[PARAMS_NAME_LEN + 1u],
+                 uint32_t *value) {
+    int count = params_count(img, size);
+    const uint8_t *e;
+
+    if (count < 0 || i >= (uint32_t)count) {
+        return -1;
+    }
+    e = entry_at(img, i);
+    memcpy(name, e, PARAMS_NAME_LEN);
+    name[PARAMS_NAME_LEN] = '\0';
+    *value = get32(e + PARAMS_NAME_LEN);
+    return 0;
+}
+
+static int find(const uint8_t *img, uint32_t size, const char *name) {
+    int count = params_count(img, size);
+    char n[PARAMS_NAME_LEN + 1u];
+    uint32_t v;
+
+    for (int i = 0; i < count; ++i) {
+        if (params_entry(img, size, (uint32_t)i, n, &v) == 0 && strcmp(n, name) == 0) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+int params_get(const uint8_t *img, uint32_t size, const char *name, uint32_t *value) {
+    int i = find(img, size, name);
+
+    if (i < 0) {
+        return -1;
+    }
+    *value = get32(entry_at(img, (uint32_t)i) + PARAMS_NAME_LEN);
+    return 0;
+}
+
+int params_set(uint8_t *img, uint32_t size, const char *name, uint32_t value) {
+    int i = find(img, size, name);
+
+    if (i < 0) {
+        return -1;
+    }
+    put32(img + PARAMS_OFFSET + 8u + (uint32_t)i * ENTRY_BYTES + PARAMS_NAME_LEN, value);
+    return 0;
+}
+
+int params_apply(uint8_t *img, uint32_t size, const char *assignment) {
+    const char *eq = strchr(assignment, '=');
+    char name[PARAMS_NAME_LEN + 1u];
+    char *end;
+    unsigned long v;
+
+    if (params_count(img, size) < 0) {
+        fprintf(stderr, "params: image has no parameter block at 0x%x\n", PARAMS_OFFSET);
+        return -1;
+    }
+    if (eq == NULL || eq == assignment || (size_t)(eq - assignment) > PARAMS_NAME_LEN) {
+        fprintf(stderr, "params: expected name=value, got '%s'\n", assignment);
+        return -1;
+    }
+    memcpy(name, assignment, (size_t)(eq - assignment));
+    name[eq - assignment] = '\0';
+    v = strtoul(eq + 1, &end, 0);
+    if (end == eq + 1 || *end != '\0' || v > 0xFFFFFFFFul) {
+        fprintf(stderr, "params: bad value in '%s'\n", assignment);
+        return -1;
+    }
+    if (params_set(img, size, name, (uint32_t)v) != 0) {
+        fprintf(stderr, "params: no parameter '%s'\n", name);
+        return -1;
+    }
+    return 0;
+}
+
+void params_print(const uint8_t *img, uint32_t size, FILE *fp) {
+    int count = params_count(img, size);
+    char name[PARAMS_NAME_LEN + 1u];
+    uint32_t v;
+
+    for (int i = 0; i < count; ++i) {
+        if (params_entry(img, size, (uint32_t)i, name, &v) == 0) {
+            fprintf(fp, "%-8s = 0x%08x (%u)\n", name, v, v);
+        }
+    }
+}
+
+static int has_suffix(const char *s, const char *suffix) {
+    size_t n = strlen(s);
+    size_t k = strlen(suffix);
+    return n > k && strcmp(s + n - k, suffix) == 0;
+}
+
+static int grow(uint8_t **buf, size_t *cap, size_t need) {
+    uint8_t *p;
+    size_t n = *cap ? *cap : 4096u;
+
+    while (n < need) {
+        n *= 2u;
+    }
+    if (n == *cap) {
+        return 0;
+    }
+    p = realloc(*buf, n);
+    if (p == NULL) {
+        return -1;
+    }
+    *buf = p;
+    *cap = n;
+    return 0;
+}
+
+int params_image_read(const char *path, uint8_t **data, uint32_t *size, int *is_mem) {
+    FILE *fp = fopen(path, "rb");
+    uint8_t *buf = NULL;
+    size_t cap = 0;
+    size_t len = 0;
+    int rc = 0;
+
+    if (fp == NULL) {
+        perror(path);
+        return -1;
+    }
+    *is_mem = has_suffix(path, ".mem");
+    if (*is_mem) {
+        char line[64];
+        while (rc == 0 && fgets(line, sizeof(line), fp) != NULL) {
+            char *end;
+            uint32_t word = (uint32_t)strtoul(line, &end, 16);
+            if (end == line) {
+                continue;
+            }
+            rc = grow(&buf, &cap, len + 4u);
+            if (rc == 0) {
+                put32(buf + len, word);
+                len += 4u;
+            }
+        }
+    } else {
+        size_t n;
+        do {
+            rc = grow(&buf, &cap, len + 4096u);
+            n = (rc == 0) ? fread(buf + len, 1, cap - len, fp) : 0u;
+            len += n;
+        } while (rc == 0 && n != 0u);
+    }
+    if (rc != 0 || ferror(fp)) {
+        fprintf(stderr, "%s: read failed\n", path);
+        fclose(fp);
+        free(buf);
+        return -1;
+    }
+    fclose(fp);
+    *data = buf;
+    *size = (uint32_t)len;
+    return 0;
+}
+
+int params_image_write(const char *path, const uint8_t *data, uint32_t size, int is_mem) {
+    FILE *fp = fopen(path, "wb");
+
+    if (fp == NULL) {
+        perror(path);
+        return -1;
+    }
+    if (is_mem) {
+        for (uint32_t off = 0; off + 4u <= size; off += 4u) {
+            fprintf(fp, "%08x\n", get32(data + off));
+        }
+    } else {
+        fwrite(data, 1, size, fp);
+    }
+    return fclose(fp);
+}
@@ -0,0 +1,47 @@
+/*
+ * Load-time parameter blocks (params.h) in program images, host side.
+ *
+ * The block sits at PARAMS_OFFSET from the RAM base: a magic word, an entry
+ * count, then { char name[8]; uint32_t value; } per entry, little-endian.
+ * All functions take the image as RAM bytes starting at the RAM base (an
+ * ELF loaded into a RAM buffer, or a .bin / .mem read with params_image_read).
+ */
+
+#ifndef PARAMS_IMAGE_H
+#define PARAMS_IMAGE_H
+
+#include <stdint.h>
+#include <stdio.h>
+
+#include "../params.h"
+
+/* The RAM base is 0, so the block's offset in an image is its address */
+#define PARAMS_OFFSET       PARAMS_ADDR
+#define PARAMS_MAX_ENTRIES  64u
+
+/* Number of entries, or -1 if there is no valid block. */
+int params_count(const uint8_t *img, uint32_t size);
+
+/* Entry i: name (NUL-terminated) and value. Returns 0 on success. */
+int params_entry(const uint8_t *img, uint32_t size, uint32_t i, char name[PARAMS_NAME_LEN + 1u],
+                 uint32_t *value);
+
+/* By name. Return 0 on success, -1 if there is no such entry. */
+int params_get(const uint8_t *img, uint32_t size, const char *name, uint32_t *value);
+int params_set(uint8_t *img, uint32_t size, const char *name, uint32_t value);
+
+/* Apply "name=value" (value as for strtoul base 0). Prints why on failure. */
+int params_apply(uint8_t *img, uint32_t size, const char *assignment);
+
+/* One "name = value" line per entry. */
+void params_print(const uint8_t *img, uint32_t size, FILE *fp);
+
+/*
+ * Read a raw .bin or a packed .mem ($readmemh, one 32-bit word per line)
+ * into a malloc'd buffer; *is_mem tells params_image_write which format to
+ * write back. Returns 0 on success, else prints why and returns -1.
+ */
+int params_image_read(const char *path, uint8_t **data, uint32_t *size, int *is_mem);
+int params_image_write(const char *path, const uint8_t *data, uint32_t size, int is_mem);
+
+#endif
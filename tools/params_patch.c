@@ -0,0 +1,83 @@
+/*
+ * Change a program's load-time parameters (params.h) in its memory image.
+ *
+ * Rewrites the parameter block at 0x40 in $(PROGRAM).mem or .bin, so a
+ * testbench ($readmemh) or the FPGA loader picks up new values without a
+ * rebuild. The block names its entries, so no ELF is needed.
+ *
+ * Usage:
+ *   tools/params_patch [options] image.mem|image.bin
+ *     --set NAME=VALUE      change a parameter (repeatable)
+ *     -o FILE               write here instead of in place (same format)
+ *     --list                print the parameters (after --set)
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "params_image.h"
+
+#define MAX_SETS 64
+
+static void usage(const char *argv0) {
+    fprintf(stderr, "usage: %s [--set NAME=VALUE]... [-o FILE] [--list] image.mem|image.bin\n", argv0);
+}
+
+int main(int argc, char **argv) {
+    const char *path = NULL;
+    const char *out = NULL;
+    const char *sets[MAX_SETS];
+    unsigned set_count = 0;
+    int list = 0;
+    uint8_t *img;
+    uint32_t size;
+    int is_mem;
+    int status = 0;
+
+    for (int i = 1; i < argc; ++i) {
+        if (strcmp(argv[i], "--set") == 0 && i + 1 < argc && set_count < MAX_SETS) {
+            sets[set_count++] = argv[++i];
+        } else if (strcmp(argv[i], "-o") == 0 && i + 1 < argc) {
+            out = argv[++i];
+        } else if (strcmp(argv[i], "--list") == 0) {
+            list = 1;
+        } else if (argv[i][0] != '-' && path == NULL) {
+            path = argv[i];
+        } else {
+            usage(argv[0]);
+            return 2;
+        }
+    }
+    if (path == NULL || (set_count == 0u && !list)) {
+        usage(argv[0]);
+        return 2;
+    }
+
+    if (params_image_read(path, &img, &size, &is_mem) != 0) {
+        return 1;
+    }
+    if (params_count(img, size) < 0) {
+        fprintf(stderr, "%s: no parameter block at 0x%x (program not built with params.h?)\n",
+                path, PARAMS_OFFSET);
+        free(img);
+        return 1;
+    }
+    for (unsigned i = 0; i < set_count; ++i) {
+        if (params_apply(img, size, sets[i]) != 0) {
+            free(img);
+            return 1;
+        }
+    }
+    if (set_count != 0u && params_image_write(out != NULL ? out : path, img, size, is_mem) != 0) {
+        status = 1;
+    }
+    if (list) {
+        params_print(img, size, stdout);
+    }
+    free(img);
+    return status;
+}
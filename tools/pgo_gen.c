@@ -0,0 +1,273 @@
+/*
+ * Profile-guided build inputs from an rvsim --profile file (make PGO=1).
+ *
+ * --header OUT: one PGO_FN_<name> define per PGO_FN(name) marker found in
+ *   the given sources, classifying the function as
+ *     PGO_HOT   in the smallest set of functions (by cycles) that covers
+ *               --hot-percent of the profiled cycles (default 90)
+ *     PGO_COLD  entered at most once and under --cold-permille of the
+ *               cycles (default 5), including never executed
+ *     (empty)   everything else, or not in the profile (inlined / dropped)
+ *   GCC clones (name.constprop.0, name.part.0, ...) count towards name.
+ *
+ * --ld-script IN --ld-out OUT: copy of IN with the line containing
+ *   PGO_HOT_TEXT replaced by input-section patterns for the hot set, in
+ *   descending cycle order, so hot code is packed at the start of .text.
+ *
+ * Usage:
+ *   tools/pgo_gen --profile P [--hot-percent N] [--cold-permille N]
+ *                 [--header OUT src.c...] [--ld-script link.ld --ld-out OUT]
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <ctype.h>
+#include <inttypes.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define MAX_FNS     4096
+#define MAX_MARKS   1024
+#define NAME_MAX_LEN 128
+
+typedef struct {
+    char name[NAME_MAX_LEN];
+    uint64_t cycles;
+    uint64_t insns;
+    uint64_t calls;
+    int hot;
+} fn_t;
+
+static fn_t fns[MAX_FNS];
+static uint32_t fn_count;
+static uint64_t total_cycles;
+
+static char marks[MAX_MARKS][NAME_MAX_LEN];
+static uint32_t mark_count;
+
+static int read_profile(const char *path) {
+    FILE *fp = fopen(path, "r");
+    char line[512];
+
+    if (fp == NULL) {
+        perror(path);
+        return -1;
+    }
+    while (fgets(line, sizeof(line), fp) != NULL) {
+        fn_t f;
+        uint32_t size;
+        if (line[0] == '#') {
+            continue;
+        }
+        memset(&f, 0, sizeof(f));
+        if (sscanf(line, "%" SCNu64 " %" SCNu64 " %" SCNu64 " %" SCNu32 " %127s",
+                   &f.cycles, &f.insns, &f.calls, &size, f.name) != 5) {
+            continue;
+        }
+        if (fn_count == MAX_FNS) {
+            fprintf(stderr, "%s: more than %u functions\n", path, MAX_FNS);
+            fclose(fp);
+            return -1;
+        }
+        fns[fn_count++] = f;
+        total_cycles += f.cycles;
+    }
+    fclose(fp);
+    return 0;
+}
+
+/* rvsim writes the profile sorted by cycles, so the hot set is a prefix. */
+static uint32_t mark_hot(unsigned hot_percent, uint64_t *hot_cycles) {
+    uint64_t sum = 0;
+    uint32_t n = 0;
+
+    for (uint32_t i = 0; i < fn_count && fns[i].cycles != 0u; ++i) {
+        if (sum * 100u >= total_cycles * hot_percent) {
+            break;
+        }
+        fns[i].hot = 1;
+        sum += fns[i].cycles;
+        ++n;
+    }
+    *hot_cycles = sum;
+    return n;
+}
+
+static int scan_markers(const char *path) {
+    FILE *fp = fopen(path, "r");
+    char line[1024];
+
+    if (fp == NULL) {
+        perror(path);
+        return -1;
+    }
+    while (fgets(line, sizeof(line), fp) != NULL) {
+        for (char *p = strstr(line, "PGO_FN("); p != NULL; p = strstr(p + 1, "PGO_FN(")) {
+            char name[NAME_MAX_LEN];
+            size_t len = 0;
+            uint32_t i;
+            p += strlen("PGO_FN(");
+            while ((isalnum((unsigned char)p[len]) || p[len] == '_') && len + 1u < sizeof(name)) {
+                name[len] = p[len];
+                ++len;
+            }
+            name[len] = '\0';
+            if (len == 0u || p[len] != ')') {
+                continue;
+            }
+            for (i = 0; i < mark_count && strcmp(marks[i], name) != 0; ++i) {
+            }
+            if (i == mark_count && mark_count < MAX_MARKS) {
+                strcpy(marks[mark_count++], name);
+            }
+        }
+    }
+    fclose(fp);
+    return 0;
+}
+
+/* Does profile name (possibly a GCC clone) belong to source function base? */
+static int same_function(const char *profile_name, const char *base) {
+    size_t n = strlen(base);
+    return strncmp(profile_name, base, n) == 0 && (profile_name[n] == '\0' || profile_name[n] == '.');
+}
+
+static int write_header(const char *path, const char *profile_path, unsigned cold_permille) {
+    FILE *fp = fopen(path, "w");
+
+    if (fp == NULL) {
+        perror(path);
+        return -1;
+    }
+    fprintf(fp, "/* Generated by tools/pgo_gen from %s; do not edit. */\n", profile_path);
+    fprintf(fp, "#define PGO_PROFILE_LOADED 1\n");
+    for (uint32_t m = 0; m < mark_count; ++m) {
+        uint64_t cycles = 0;
+        uint64_t calls = 0;
+        int found = 0;
+        int hot = 0;
+        for (uint32_t i = 0; i < fn_count; ++i) {
+            if (same_function(fns[i].name, marks[m])) {
+                found = 1;
+                hot |= fns[i].hot;
+                cycles += fns[i].cycles;
+                calls += fns[i].calls;
+            }
+        }
+        fprintf(fp, "#define PGO_FN_%s", marks[m]);
+        if (!found) {
+            fprintf(fp, "  /* not in profile */\n");
+        } else if (hot) {
+            fprintf(fp, " PGO_HOT  /* %" PRIu64 " cycles */\n", cycles);
+        } else if (calls <= 1u && cycles * 1000u < total_cycles * cold_permille) {
+            fprintf(fp, " PGO_COLD  /* %" PRIu64 " cycles, %" PRIu64 " calls */\n", cycles, calls);
+        } else {
+            fprintf(fp, "  /* %" PRIu64 " cycles, %" PRIu64 " calls */\n", cycles, calls);
+        }
+    }
+    return fclose(fp);
+}
+
+static int write_ld(const char *in_path, const char *out_path, uint32_t hot_count, uint64_t hot_cycles) {
+    FILE *in = fopen(in_path, "r");
+    FILE *out;
+    char line[1024];
+    int replaced = 0;
+
+    if (in == NULL) {
+        perror(in_path);
+        return -1;
+    }
+    out = fopen(out_path, "w");
+    if (out == NULL) {
+        perror(out_path);
+        fclose(in);
+        return -1;
+    }
+    while (fgets(line, sizeof(line), in) != NULL) {
+        size_t indent = strspn(line, " \t");
+        if (strstr(line, "PGO_HOT_TEXT") == NULL) {
+            fputs(line, out);
+            continue;
+        }
+        fprintf(out, "%.*s/* PGO hot text: %u functions, %" PRIu64 " of %" PRIu64 " cycles */\n",
+                (int)indent, line, hot_count, hot_cycles, total_cycles);
+        for (uint32_t i = 0; i < fn_count; ++i) {
+            if (fns[i].hot) {
+                fprintf(out, "%.*s*(.text.%s .text.hot.%s .text.startup.%s)\n",
+                        (int)indent, line, fns[i].name, fns[i].name, fns[i].name);
+            }
+        }
+        replaced = 1;
+    }
+    fclose(in);
+    if (fclose(out) != 0) {
+        perror(out_path);
+        return -1;
+    }
+    if (!replaced) {
+        fprintf(stderr, "%s: no PGO_HOT_TEXT marker\n", in_path);
+        return -1;
+    }
+    return 0;
+}
+
+static void usage(const char *argv0) {
+    fprintf(stderr,
+            "usage: %s --profile P [--hot-percent N] [--cold-permille N]\n"
+            "       [--header OUT src.c...] [--ld-script link.ld --ld-out OUT]\n",
+            argv0);
+}
+
+int main(int argc, char **argv) {
+    const char *profile_path = NULL;
+    const char *header_path = NULL;
+    const char *ld_in = NULL;
+    const char *ld_out = NULL;
+    unsigned hot_percent = 90u;
+    unsigned cold_permille = 5u;
+    uint64_t hot_cycles;
+    uint32_t hot_count;
+
+    for (int i = 1; i < argc; ++i) {
+        if (strcmp(argv[i], "--profile") == 0 && i + 1 < argc) {
+            profile_path = argv[++i];
+        } else if (strcmp(argv[i], "--hot-percent") == 0 && i + 1 < argc) {
+            hot_percent = (unsigned)strtoul(argv[++i], NULL, 0);
+        } else if (strcmp(argv[i], "--cold-permille") == 0 && i + 1 < argc) {
+            cold_permille = (unsigned)strtoul(argv[++i], NULL, 0);
+        } else if (strcmp(argv[i], "--header") == 0 && i + 1 < argc) {
+            header_path = argv[++i];
+        } else if (strcmp(argv[i], "--ld-script") == 0 && i + 1 < argc) {
+            ld_in = argv[++i];
+        } else if (strcmp(argv[i], "--ld-out") == 0 && i + 1 < argc) {
+            ld_out = argv[++i];
+        } else if (argv[i][0] != '-') {
+            if (scan_markers(argv[i]) != 0) {
+                return 1;
+            }
+        } else {
+            usage(argv[0]);
+            return 2;
+        }
+    }
+    if (profile_path == NULL || hot_percent > 100u || (ld_in == NULL) != (ld_out == NULL) ||
+        (header_path == NULL && ld_in == NULL)) {
+        usage(argv[0]);
+        return 2;
+    }
+
+    if (read_profile(profile_path) != 0) {
+        return 1;
+    }
+    hot_count = mark_hot(hot_percent, &hot_cycles);
+    if (header_path != NULL && write_header(header_path, profile_path, cold_permille) != 0) {
+        return 1;
+    }
+    if (ld_in != NULL && write_ld(ld_in, ld_out, hot_count, hot_cycles) != 0) {
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,455 @@
+/*
+ * DPI-C co-simulation library around the RV32I reference model
+ * (tools/rv32i_model.c), for lock-step checking in the Wizard Core
+ * testbench: see rv32i_cosim.sv.
+ *
+ * The testbench reports every retired instruction with rv32i_dpi_retire();
+ * the model executes the same instruction and compares the PC, instruction
+ * word, destination register and value, and the memory address and data.
+ * The first divergence is reported with the simulation time it happened at,
+ * instead of surfacing later in an offline diff of mem.log. With resync=1
+ * (default) the model then adopts the RTL's PC and rd value, and undoes a
+ * register write the RTL did not make, so one bug does not cascade into a
+ * mismatch per instruction.
+ *
+ * Memory is serviced from the RTL: the load data the core saw is passed
+ * with the retirement and fed to the model, so MMIO reads the same on both
+ * sides. With mem=rtl every load and the instruction word come from the
+ * RTL and no image is needed. With mem=model (default when image= is
+ * given) the model fetches and loads main RAM from its own copy, shadowed
+ * by the retired stores and rv32i_dpi_write_mem(), and cross-checks the
+ * RTL's instruction word and load data.
+ *
+ * Options (comma-separated, passed through the OPTIONS parameter):
+ *   image=FILE         $(PROGRAM).mem (hex words), .elf or raw .bin
+ *   mem=model|rtl      where instructions and RAM loads come from (above)
+ *   ram_base=A         model RAM base (default 0)
+ *   ram_size=N         model RAM size in bytes (default 0x8000)
+ *   ldata=laned        load/store data is the raw bus word, bytes in their
+ *                      address lanes (default: the loaded value / register
+ *                      value in the low bits, RISC-V semantics)
+ *   resync=0|1         adopt the RTL's state after a mismatch (default 1)
+ *   max_errors=N       rv32i_dpi_retire() returns 2 after N mismatches
+ *                      (default 10, 0 = never)
+ *   quiet=1            no per-mismatch messages, only the summary
+ *
+ * Instructions the model does not implement are retired using the RTL's
+ * rd value and counted as skipped. ecall/ebreak retire as no-ops.
+ *
+ * Build: make tools/librv32i_dpi.so  (or compile this file together with
+ * rv32i_model.c and elf32.c into the simulator, e.g. under Verilator)
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <inttypes.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "elf32.h"
+#include "rv32i_model.h"
+
+#define RV32I_DPI_MAX_HANDLES   4
+#define RV32I_DPI_RAM_BASE      0x00000000u
+#define RV32I_DPI_RAM_BYTES     0x8000u
+
+/* rv32i_dpi_retire() results */
+#define RV32I_DPI_MATCH         0
+#define RV32I_DPI_MISMATCH      1
+#define RV32I_DPI_FATAL         2
+
+typedef struct {
+    int used;
+    rv32i_cpu_t cpu;
+    uint8_t *ram;
+    uint32_t ram_base;
+    uint32_t ram_size;
+
+    int mem_rtl;
+    int laned;
+    int resync;
+    int quiet;
+    uint64_t max_errors;
+
+    /* The RTL's data for the access being retired, for MMIO loads. */
+    uint32_t rtl_data;
+
+    uint64_t retired;
+    uint64_t mismatches;
+    uint64_t skipped;
+    uint64_t first_mismatch_t;
+} rv32i_dpi_t;
+
+static rv32i_dpi_t handles[RV32I_DPI_MAX_HANDLES];
+
+static rv32i_dpi_t *handle_of(int h) {
+    if (h < 0 || h >= RV32I_DPI_MAX_HANDLES || !handles[h].used) {
+        return NULL;
+    }
+    return &handles[h];
+}
+
+/* Byte k of an access at addr in the RTL's data word. */
+static uint8_t data_byte(const rv32i_dpi_t *d, uint32_t data, uint32_t addr, uint32_t k) {
+    uint32_t shift = d->laned ? 8u * ((addr + k) & 3u) : 8u * k;
+    return (uint8_t)(data >> shift);
+}
+
+static uint32_t data_value(const rv32i_dpi_t *d, uint32_t data, uint32_t addr, uint32_t size) {
+    uint32_t v = 0;
+    for (uint32_t k = 0; k < size; ++k) {
+        v |= (uint32_t)data_byte(d, data, addr, k) << (8u * k);
+    }
+    return v;
+}
+
+static int bus_load(void *ctx, uint32_t addr, uint32_t size, uint32_t *value) {
+    rv32i_dpi_t *d = ctx;
+    *value = data_value(d, d->rtl_data, addr, size);
+    return 0;
+}
+
+static int bus_store(void *ctx, uint32_t addr, uint32_t size, uint32_t value) {
+    (void)ctx;
+    (void)addr;
+    (void)size;
+    (void)value;
+    return 0;
+}
+
+static int in_ram(const rv32i_dpi_t *d, uint32_t addr, uint32_t size) {
+    uint32_t off = addr - d->ram_base;
+    return off < d->ram_size && size <= d->ram_size - off;
+}
+
+static int load_image(rv32i_dpi_t *d, const char *path) {
+    FILE *fp = fopen(path, "rb");
+    unsigned char magic[4] = { 0 };
+    size_t n;
+
+    if (fp == NULL) {
+        fprintf(stderr, "rv32i_dpi: cannot open image '%s'\n", path);
+        return -1;
+    }
+    n = fread(magic, 1, sizeof(magic), fp);
+    if (n == sizeof(magic) && memcmp(magic, "\177ELF", 4) == 0) {
+        elf32_file_t elf;
+        int rc;
+        fclose(fp);
+        if (elf32_open(&elf, path) != 0) {
+            return -1;
+        }
+        rc = elf32_load(&elf, d->ram, d->ram_base, d->ram_size);
+        d->cpu.pc = elf.entry;
+        elf32_close(&elf);
+        return rc;
+    }
+    rewind(fp);
+    n = strlen(path);
+    if (n > 4u && strcmp(path + n - 4u, ".mem") == 0) {
+        char line[64];
+        uint32_t off = 0;
+        while (off + 4u <= d->ram_size && fgets(line, sizeof(line), fp) != NULL) {
+            char *end;
+            uint32_t word = (uint32_t)strtoul(line, &end, 16);
+            if (end == line) {
+                continue;
+            }
+            for (uint32_t k = 0; k < 4u; ++k) {
+                d->ram[off + k] = (uint8_t)(word >> (8u * k));
+            }
+            off += 4u;
+        }
+    } else if (fread(d->ram, 1, d->ram_size, fp) == 0u && ferror(fp)) {
+        fprintf(stderr, "rv32i_dpi: cannot read image '%s'\n", path);
+        fclose(fp);
+        return -1;
+    }
+    fclose(fp);
+    return 0;
+}
+
+static int parse_options(rv32i_dpi_t *d, const char *options, char *image, size_t image_size) {
+    char buf[512];
+    char *save = NULL;
+    char *tok;
+    int mem_set = 0;
+
+    snprintf(buf, sizeof(buf), "%s", options != NULL ? options : "");
+    for (tok = strtok_r(buf, ",", &save); tok != NULL; tok = strtok_r(NULL, ",", &save)) {
+        char *val = strchr(tok, '=');
+        if (val == NULL) {
+            fprintf(stderr, "rv32i_dpi: ignoring option '%s'\n", tok);
+            continue;
+        }
+        *val++ = '\0';
+        if (strcmp(tok, "image") == 0) {
+            snprintf(image, image_size, "%s", val);
+        } else if (strcmp(tok, "mem") == 0) {
+            d->mem_rtl = strcmp(val, "rtl") == 0;
+            mem_set = 1;
+        } else if (strcmp(tok, "ram_base") == 0) {
+            d->ram_base = (uint32_t)strtoul(val, NULL, 0);
+        } else if (strcmp(tok, "ram_size") == 0) {
+            d->ram_size = (uint32_t)strtoul(val, NULL, 0);
+        } else if (strcmp(tok, "ldata") == 0) {
+            d->laned = strcmp(val, "laned") == 0;
+        } else if (strcmp(tok, "resync") == 0) {
+            d->resync = atoi(val) != 0;
+        } else if (strcmp(tok, "max_errors") == 0) {
+            d->max_errors = strtoull(val, NULL, 0);
+        } else if (strcmp(tok, "quiet") == 0) {
+            d->quiet = atoi(val) != 0;
+        } else {
+            fprintf(stderr, "rv32i_dpi: ignoring option '%s'\n", tok);
+        }
+    }
+    if (!mem_set) {
+        d->mem_rtl = image[0] == '\0';
+    }
+    if (!d->mem_rtl && image[0] == '\0') {
+        fprintf(stderr, "rv32i_dpi: mem=model needs image=\n");
+        return -1;
+    }
+    return 0;
+}
+
+int rv32i_dpi_open(const char *options) {
+    rv32i_dpi_t *d = NULL;
+    char image[256] = "";
+    int h;
+
+    for (h = 0; h < RV32I_DPI_MAX_HANDLES; h++) {
+        if (!handles[h].used) {
+            d = &handles[h];
+            break;
+        }
+    }
+    if (d == NULL) {
+        fprintf(stderr, "rv32i_dpi: too many open models\n");
+        return -1;
+    }
+    memset(d, 0, sizeof(*d));
+    d->ram_base = RV32I_DPI_RAM_BASE;
+    d->ram_size = RV32I_DPI_RAM_BYTES;
+    d->resync = 1;
+    d->max_errors = 10u;
+    if (parse_options(d, options, image, sizeof(image)) != 0) {
+        return -1;
+    }
+    d->ram = calloc(d->ram_size, 1);
+    if (d->ram == NULL) {
+        return -1;
+    }
+    rv32i_init(&d->cpu, d->ram, d->ram_base, d->ram_size);
+    d->cpu.bus_ctx = d;
+    d->cpu.bus_load = bus_load;
+    d->cpu.bus_store = bus_store;
+    if (image[0] != '\0' && load_image(d, image) != 0) {
+        free(d->ram);
+        return -1;
+    }
+    d->used = 1;
+    return h;
+}
+
+static void report(rv32i_dpi_t *d, unsigned long long t, uint32_t pc, uint32_t insn, const char *what,
+                   uint32_t rtl, uint32_t model) {
+    rv32i_insn_t dec;
+
+    if (d->mismatches++ == 0u) {
+        d->first_mismatch_t = t;
+    }
+    if (d->quiet) {
+        return;
+    }
+    if (!rv32i_decode(insn, &dec)) {
+        dec.op = RV32I_OP_ILLEGAL;
+    }
+    fprintf(stderr, "rv32i_dpi: t=%llu pc=0x%08" PRIx32 " insn=0x%08" PRIx32 " (%s): %s rtl 0x%08" PRIx32
+                    " model 0x%08" PRIx32 "\n",
+            t, pc, insn, rv32i_op_name(dec.op), what, rtl, model);
+}
+
+/*
+ * One instruction retired by the RTL. rd is 0 when it wrote no register;
+ * mem_addr/mem_data are the access of a load or store (data as configured
+ * by ldata=). Returns RV32I_DPI_MATCH, _MISMATCH, or _FATAL once max_errors
+ * mismatches have been seen.
+ */
+int rv32i_dpi_retire(int h, unsigned long long t, unsigned int pc, unsigned int insn, int rd,
+                     unsigned int rd_value, unsigned int mem_addr, unsigned int mem_data) {
+    rv32i_dpi_t *d = handle_of(h);
+    rv32i_retire_t r;
+    rv32i_insn_t dec;
+    rv32i_status_t st;
+    uint64_t before;
+    uint32_t model_rd;
+    uint32_t x_before[32];
+
+    if (d == NULL) {
+        return RV32I_DPI_FATAL;
+    }
+    before = d->mismatches;
+    d->retired++;
+
+    if (d->cpu.pc != pc) {
+        report(d, t, pc, insn, "pc", pc, d->cpu.pc);
+        if (d->resync) {
+            d->cpu.pc = pc;
+        }
+    }
+    if (in_ram(d, pc, 4u)) {
+        uint8_t *p = d->ram + (pc - d->ram_base);
+        uint32_t word = (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+        if (d->mem_rtl) {
+            p[0] = (uint8_t)insn;
+            p[1] = (uint8_t)(insn >> 8);
+            p[2] = (uint8_t)(insn >> 16);
+            p[3] = (uint8_t)(insn >> 24);
+        } else if (word != insn) {
+            report(d, t, pc, insn, "insn", insn, word);
+        }
+    }
+
+    /* MMIO loads read what the RTL read through the bus callback; with
+     * mem=rtl RAM loads do too, by patching RAM before executing. */
+    d->rtl_data = mem_data;
+    if (d->mem_rtl && rv32i_decode(insn, &dec) && dec.op >= RV32I_OP_LB && dec.op <= RV32I_OP_LHU) {
+        uint32_t size = (dec.op == RV32I_OP_LW) ? 4u : (dec.op == RV32I_OP_LH || dec.op == RV32I_OP_LHU) ? 2u : 1u;
+        if (in_ram(d, mem_addr, size)) {
+            for (uint32_t k = 0; k < size; ++k) {
+                d->ram[mem_addr - d->ram_base + k] = data_byte(d, mem_data, mem_addr, k);
+            }
+        }
+    }
+
+    /* Kept to undo a register write the RTL did not make (resync below) */
+    memcpy(x_before, d->cpu.x, sizeof(x_before));
+    st = rv32i_step(&d->cpu, &r);
+    switch (st) {
+    case RV32I_OK:
+        break;
+    case RV32I_ECALL:
+    case RV32I_EBREAK:
+        d->cpu.pc += 4u;
+        d->cpu.instret++;
+        r.rd = 0;
+        r.mem_op = 0;
+        break;
+    case RV32I_ILLEGAL:
+        /* Not in the model (e.g. CSRs): take the RTL's result */
+        d->skipped++;
+        d->cpu.pc = pc + 4u;
+        d->cpu.instret++;
+        if (rd > 0 && rd < 32) {
+            d->cpu.x[rd] = rd_value;
+        }
+        return (d->mismatches != before) ? RV32I_DPI_MISMATCH : RV32I_DPI_MATCH;
+    default:
+        report(d, t, pc, insn, (st == RV32I_MISALIGNED) ? "misaligned" : "bus error", mem_addr, r.mem_addr);
+        d->cpu.pc = pc + 4u;
+        return (d->max_errors != 0u && d->mismatches >= d->max_errors) ? RV32I_DPI_FATAL : RV32I_DPI_MISMATCH;
+    }
+
+    model_rd = r.rd;
+    if ((uint32_t)rd != model_rd) {
+        report(d, t, pc, insn, "rd", (uint32_t)rd, model_rd);
+    } else if (model_rd != 0u && rd_value != r.rd_value) {
+        report(d, t, pc, insn, "rd value", rd_value, r.rd_value);
+    }
+    if (d->resync && rd > 0 && rd < 32) {
+        d->cpu.x[rd] = rd_value;
+    }
+    if (d->resync && model_rd != 0u && model_rd != (uint32_t)rd) {
+        /* The model wrote a register the RTL did not: put it back */
+        d->cpu.x[model_rd] = x_before[model_rd];
+    }
+    if (r.mem_op != 0u) {
+        if (mem_addr != r.mem_addr) {
+            report(d, t, pc, insn, "mem addr", mem_addr, r.mem_addr);
+        } else if (data_value(d, mem_data, mem_addr, r.mem_size) != r.mem_value) {
+            report(d, t, pc, insn, (r.mem_op == 2u) ? "store data" : "load data",
+                   data_value(d, mem_data, mem_addr, r.mem_size), r.mem_value);
+        }
+    }
+
+    if (d->mismatches == before) {
+        return RV32I_DPI_MATCH;
+    }
+    return (d->max_errors != 0u && d->mismatches >= d->max_errors) ? RV32I_DPI_FATAL : RV32I_DPI_MISMATCH;
+}
+
+/* Run n instructions with no RTL to compare against; returns how many ran. */
+int rv32i_dpi_step(int h, int n) {
+    rv32i_dpi_t *d = handle_of(h);
+    int i;
+
+    if (d == NULL) {
+        return 0;
+    }
+    d->rtl_data = 0;
+    for (i = 0; i < n; ++i) {
+        if (rv32i_step(&d->cpu, NULL) != RV32I_OK) {
+            break;
+        }
+    }
+    return i;
+}
+
+/* A store the model cannot see (testbench preload, DMA, ...). */
+void rv32i_dpi_write_mem(int h, unsigned int addr, int size, unsigned int data) {
+    rv32i_dpi_t *d = handle_of(h);
+
+    if (d == NULL || size < 1 || size > 4 || !in_ram(d, addr, (uint32_t)size)) {
+        return;
+    }
+    for (uint32_t k = 0; k < (uint32_t)size; ++k) {
+        d->ram[addr - d->ram_base + k] = data_byte(d, data, addr, k);
+    }
+}
+
+unsigned int rv32i_dpi_get_reg(int h, int reg) {
+    rv32i_dpi_t *d = handle_of(h);
+    return (d != NULL && reg >= 0 && reg < 32) ? d->cpu.x[reg] : 0u;
+}
+
+void rv32i_dpi_set_reg(int h, int reg, unsigned int value) {
+    rv32i_dpi_t *d = handle_of(h);
+    if (d != NULL && reg > 0 && reg < 32) {
+        d->cpu.x[reg] = value;
+    }
+}
+
+unsigned int rv32i_dpi_get_pc(int h) {
+    rv32i_dpi_t *d = handle_of(h);
+    return (d != NULL) ? d->cpu.pc : 0u;
+}
+
+void rv32i_dpi_set_pc(int h, unsigned int pc) {
+    rv32i_dpi_t *d = handle_of(h);
+    if (d != NULL) {
+        d->cpu.pc = pc;
+    }
+}
+
+/* Prints the summary; returns the number of mismatches (saturated). */
+int rv32i_dpi_close(int h) {
+    rv32i_dpi_t *d = handle_of(h);
+    int mismatches;
+
+    if (d == NULL) {
+        return 0;
+    }
+    fprintf(stderr, "rv32i_dpi: %" PRIu64 " retired, %" PRIu64 " mismatches", d->retired, d->mismatches);
+    if (d->mismatches != 0u) {
+        fprintf(stderr, " (first at t=%" PRIu64 ")", d->first_mismatch_t);
+    }
+    fprintf(stderr, ", %" PRIu64 " skipped (not in model)\n", d->skipped);
+    mismatches = (d->mismatches > 0x7FFFFFFFu) ? 0x7FFFFFFF : (int)d->mismatches;
+    free(d->ram);
+    d->used = 0;
+    return mismatches;
+}
@@ -0,0 +1,496 @@
+/*
+ * RV32I reference model: decoder, encoder and interpreter.
+ * See rv32i_model.h for the interface.
+ */
+
+#include "rv32i_model.h"
+
+#include <string.h>
+
+static const char *const op_names[RV32I_OP_COUNT] = {
+    "illegal",
+    "lui", "auipc", "jal", "jalr",
+    "beq", "bne", "blt", "bge", "bltu", "bgeu",
+    "lb", "lh", "lw", "lbu", "lhu",
+    "sb", "sh", "sw",
+    "addi", "slti", "sltiu", "xori", "ori", "andi",
+    "slli", "srli", "srai",
+    "add", "sub", "sll", "slt", "sltu",
+    "xor", "srl", "sra", "or", "and",
+    "fence", "ecall", "ebreak",
+    "csrrw", "csrrs", "csrrc", "csrrwi", "csrrsi", "csrrci",
+};
+
+static const char *const reg_names[32] = {
+    "zero", "ra", "sp", "gp", "tp", "t0", "t1", "t2",
+    "s0", "s1", "a0", "a1", "a2", "a3", "a4", "a5",
+    "a6", "a7", "s2", "s3", "s4", "s5", "s6", "s7",
+    "s8", "s9", "s10", "s11", "t3", "t4", "t5", "t6",
+};
+
+const char *rv32i_op_name(rv32i_op_t op) {
+    return (op < RV32I_OP_COUNT) ? op_names[op] : "illegal";
+}
+
+const char *rv32i_reg_name(unsigned reg) {
+    return reg_names[reg & 31u];
+}
+
+rv32i_fmt_t rv32i_format_of(rv32i_op_t op) {
+    switch (op) {
+    case RV32I_OP_LUI:
+    case RV32I_OP_AUIPC:
+        return RV32I_FMT_U;
+    case RV32I_OP_JAL:
+        return RV32I_FMT_J;
+    case RV32I_OP_BEQ: case RV32I_OP_BNE: case RV32I_OP_BLT:
+    case RV32I_OP_BGE: case RV32I_OP_BLTU: case RV32I_OP_BGEU:
+        return RV32I_FMT_B;
+    case RV32I_OP_SB: case RV32I_OP_SH: case RV32I_OP_SW:
+        return RV32I_FMT_S;
+    case RV32I_OP_ADD: case RV32I_OP_SUB: case RV32I_OP_SLL: case RV32I_OP_SLT:
+    case RV32I_OP_SLTU: case RV32I_OP_XOR: case RV32I_OP_SRL: case RV32I_OP_SRA:
+    case RV32I_OP_OR: case RV32I_OP_AND:
+        return RV32I_FMT_R;
+    case RV32I_OP_FENCE: case RV32I_OP_ECALL: case RV32I_OP_EBREAK:
+        return RV32I_FMT_SYS;
+    default:
+        return RV32I_FMT_I;
+    }
+}
+
+/* ---------- decode ---------- */
+
+static int32_t imm_i(uint32_t w) { return (int32_t)w >> 20; }
+
+static int32_t imm_s(uint32_t w) {
+    return (int32_t)(((int32_t)w >> 25) * 32) | (int32_t)((w >> 7) & 0x1Fu);
+}
+
+static int32_t imm_b(uint32_t w) {
+    uint32_t v = ((w >> 31) << 12) | (((w >> 7) & 1u) << 11) |
+                 (((w >> 25) & 0x3Fu) << 5) | (((w >> 8) & 0xFu) << 1);
+    return (int32_t)(v << 19) >> 19;
+}
+
+static int32_t imm_j(uint32_t w) {
+    uint32_t v = ((w >> 31) << 20) | (((w >> 12) & 0xFFu) << 12) |
+                 (((w >> 20) & 1u) << 11) | (((w >> 21) & 0x3FFu) << 1);
+    return (int32_t)(v << 11) >> 11;
+}
+
+int rv32i_decode(uint32_t w, rv32i_insn_t *d) {
+    static const rv32i_op_t branch_ops[8] = {
+        RV32I_OP_BEQ, RV32I_OP_BNE, RV32I_OP_ILLEGAL, RV32I_OP_ILLEGAL,
+        RV32I_OP_BLT, RV32I_OP_BGE, RV32I_OP_BLTU, RV32I_OP_BGEU,
+    };
+    static const rv32i_op_t load_ops[8] = {
+        RV32I_OP_LB, RV32I_OP_LH, RV32I_OP_LW, RV32I_OP_ILLEGAL,
+        RV32I_OP_LBU, RV32I_OP_LHU, RV32I_OP_ILLEGAL, RV32I_OP_ILLEGAL,
+    };
+    static const rv32i_op_t store_ops[8] = {
+        RV32I_OP_SB, RV32I_OP_SH, RV32I_OP_SW, RV32I_OP_ILLEGAL,
+        RV32I_OP_ILLEGAL, RV32I_OP_ILLEGAL, RV32I_OP_ILLEGAL, RV32I_OP_ILLEGAL,
+    };
+    static const rv32i_op_t imm_ops[8] = {
+        RV32I_OP_ADDI, RV32I_OP_SLLI, RV32I_OP_SLTI, RV32I_OP_SLTIU,
+        RV32I_OP_XORI, RV32I_OP_SRLI, RV32I_OP_ORI, RV32I_OP_ANDI,
+    };
+    static const rv32i_op_t reg_ops[8] = {
+        RV32I_OP_ADD, RV32I_OP_SLL, RV32I_OP_SLT, RV32I_OP_SLTU,
+        RV32I_OP_XOR, RV32I_OP_SRL, RV32I_OP_OR, RV32I_OP_AND,
+    };
+    static const rv32i_op_t csr_ops[8] = {
+        RV32I_OP_ILLEGAL, RV32I_OP_CSRRW, RV32I_OP_CSRRS, RV32I_OP_CSRRC,
+        RV32I_OP_ILLEGAL, RV32I_OP_CSRRWI, RV32I_OP_CSRRSI, RV32I_OP_CSRRCI,
+    };
+    uint32_t f3 = (w >> 12) & 7u;
+    uint32_t f7 = w >> 25;
+
+    memset(d, 0, sizeof(*d));
+    d->rd = (uint8_t)((w >> 7) & 31u);
+    d->rs1 = (uint8_t)((w >> 15) & 31u);
+    d->rs2 = (uint8_t)((w >> 20) & 31u);
+
+    switch (w & 0x7Fu) {
+    case 0x37:
+        d->op = RV32I_OP_LUI;
+        d->imm = (int32_t)(w & 0xFFFFF000u);
+        break;
+    case 0x17:
+        d->op = RV32I_OP_AUIPC;
+        d->imm = (int32_t)(w & 0xFFFFF000u);
+        break;
+    case 0x6F:
+        d->op = RV32I_OP_JAL;
+        d->imm = imm_j(w);
+        break;
+    case 0x67:
+        d->op = (f3 == 0u) ? RV32I_OP_JALR : RV32I_OP_ILLEGAL;
+        d->imm = imm_i(w);
+        break;
+    case 0x63:
+        d->op = branch_ops[f3];
+        d->imm = imm_b(w);
+        break;
+    case 0x03:
+        d->op = load_ops[f3];
+        d->imm = imm_i(w);
+        break;
+    case 0x23:
+        d->op = store_ops[f3];
+        d->imm = imm_s(w);
+        break;
+    case 0x13:
+        d->op = imm_ops[f3];
+        d->imm = imm_i(w);
+        if (f3 == 1u || f3 == 5u) {
+            d->imm &= 0x1F;
+            if (f3 == 1u && f7 != 0u) {
+                d->op = RV32I_OP_ILLEGAL;
+            } else if (f3 == 5u) {
+                d->op = (f7 == 0u) ? RV32I_OP_SRLI : (f7 == 0x20u) ? RV32I_OP_SRAI : RV32I_OP_ILLEGAL;
+            }
+        }
+        break;
+    case 0x33:
+        if (f7 == 0u) {
+            d->op = reg_ops[f3];
+        } else if (f7 == 0x20u && f3 == 0u) {
+            d->op = RV32I_OP_SUB;
+        } else if (f7 == 0x20u && f3 == 5u) {
+            d->op = RV32I_OP_SRA;
+        } else {
+            d->op = RV32I_OP_ILLEGAL;
+        }
+        break;
+    case 0x0F:
+        d->op = RV32I_OP_FENCE;
+        break;
+    case 0x73:
+        if (w == 0x00000073u) {
+            d->op = RV32I_OP_ECALL;
+        } else if (w == 0x00100073u) {
+            d->op = RV32I_OP_EBREAK;
+        } else {
+            d->op = csr_ops[f3];
+            d->imm = (int32_t)(w >> 20);
+        }
+        break;
+    default:
+        d->op = RV32I_OP_ILLEGAL;
+        break;
+    }
+    return d->op != RV32I_OP_ILLEGAL;
+}
+
+/* ---------- encode ---------- */
+
+static uint32_t enc_r(uint32_t f7, uint32_t f3, uint32_t opc, const rv32i_insn_t *d) {
+    return (f7 << 25) | ((uint32_t)d->rs2 << 20) | ((uint32_t)d->rs1 << 15) |
+           (f3 << 12) | ((uint32_t)d->rd << 7) | opc;
+}
+
+static uint32_t enc_i(uint32_t f3, uint32_t opc, const rv32i_insn_t *d) {
+    return (((uint32_t)d->imm & 0xFFFu) << 20) | ((uint32_t)d->rs1 << 15) |
+           (f3 << 12) | ((uint32_t)d->rd << 7) | opc;
+}
+
+static uint32_t enc_s(uint32_t f3, const rv32i_insn_t *d) {
+    uint32_t imm = (uint32_t)d->imm;
+    return (((imm >> 5) & 0x7Fu) << 25) | ((uint32_t)d->rs2 << 20) | ((uint32_t)d->rs1 << 15) |
+           (f3 << 12) | ((imm & 0x1Fu) << 7) | 0x23u;
+}
+
+static uint32_t enc_b(uint32_t f3, const rv32i_insn_t *d) {
+    uint32_t imm = (uint32_t)d->imm;
+    return (((imm >> 12) & 1u) << 31) | (((imm >> 5) & 0x3Fu) << 25) |
+           ((uint32_t)d->rs2 << 20) | ((uint32_t)d->rs1 << 15) | (f3 << 12) |
+           (((imm >> 1) & 0xFu) << 8) | (((imm >> 11) & 1u) << 7) | 0x63u;
+}
+
+static uint32_t enc_j(const rv32i_insn_t *d) {
+    uint32_t imm = (uint32_t)d->imm;
+    return (((imm >> 20) & 1u) << 31) | (((imm >> 1) & 0x3FFu) << 21) |
+           (((imm >> 11) & 1u) << 20) | (((imm >> 12) & 0xFFu) << 12) |
+           ((uint32_t)d->rd << 7) | 0x6Fu;
+}
+
+uint32_t rv32i_encode(const rv32i_insn_t *d) {
+    rv32i_insn_t sh = *d;
+
+    switch (d->op) {
+    case RV32I_OP_LUI:   return ((uint32_t)d->imm & 0xFFFFF000u) | ((uint32_t)d->rd << 7) | 0x37u;
+    case RV32I_OP_AUIPC: return ((uint32_t)d->imm & 0xFFFFF000u) | ((uint32_t)d->rd << 7) | 0x17u;
+    case RV32I_OP_JAL:   return enc_j(d);
+    case RV32I_OP_JALR:  return enc_i(0u, 0x67u, d);
+    case RV32I_OP_BEQ:   return enc_b(0u, d);
+    case RV32I_OP_BNE:   return enc_b(1u, d);
+    case RV32I_OP_BLT:   return enc_b(4u, d);
+    case RV32I_OP_BGE:   return enc_b(5u, d);
+    case RV32I_OP_BLTU:  return enc_b(6u, d);
+    case RV32I_OP_BGEU:  return enc_b(7u, d);
+    case RV32I_OP_LB:    return enc_i(0u, 0x03u, d);
+    case RV32I_OP_LH:    return enc_i(1u, 0x03u, d);
+    case RV32I_OP_LW:    return enc_i(2u, 0x03u, d);
+    case RV32I_OP_LBU:   return enc_i(4u, 0x03u, d);
+    case RV32I_OP_LHU:   return enc_i(5u, 0x03u, d);
+    case RV32I_OP_SB:    return enc_s(0u, d);
+    case RV32I_OP_SH:    return enc_s(1u, d);
+    case RV32I_OP_SW:    return enc_s(2u, d);
+    case RV32I_OP_ADDI:  return enc_i(0u, 0x13u, d);
+    case RV32I_OP_SLTI:  return enc_i(2u, 0x13u, d);
+    case RV32I_OP_SLTIU: return enc_i(3u, 0x13u, d);
+    case RV32I_OP_XORI:  return enc_i(4u, 0x13u, d);
+    case RV32I_OP_ORI:   return enc_i(6u, 0x13u, d);
+    case RV32I_OP_ANDI:  return enc_i(7u, 0x13u, d);
+    case RV32I_OP_SLLI:  sh.imm &= 0x1F; return enc_i(1u, 0x13u, &sh);
+    case RV32I_OP_SRLI:  sh.imm &= 0x1F; return enc_i(5u, 0x13u, &sh);
+    case RV32I_OP_SRAI:  sh.imm = (sh.imm & 0x1F) | 0x400; return enc_i(5u, 0x13u, &sh);
+    case RV32I_OP_ADD:   return enc_r(0x00u, 0u, 0x33u, d);
+    case RV32I_OP_SUB:   return enc_r(0x20u, 0u, 0x33u, d);
+    case RV32I_OP_SLL:   return enc_r(0x00u, 1u, 0x33u, d);
+    case RV32I_OP_SLT:   return enc_r(0x00u, 2u, 0x33u, d);
+    case RV32I_OP_SLTU:  return enc_r(0x00u, 3u, 0x33u, d);
+    case RV32I_OP_XOR:   return enc_r(0x00u, 4u, 0x33u, d);
+    case RV32I_OP_SRL:   return enc_r(0x00u, 5u, 0x33u, d);
+    case RV32I_OP_SRA:   return enc_r(0x20u, 5u, 0x33u, d);
+    case RV32I_OP_OR:    return enc_r(0x00u, 6u, 0x33u, d);
+    case RV32I_OP_AND:   return enc_r(0x00u, 7u, 0x33u, d);
+    case RV32I_OP_FENCE: return 0x0FF0000Fu;
+    case RV32I_OP_ECALL: return 0x00000073u;
+    case RV32I_OP_EBREAK: return 0x00100073u;
+    case RV32I_OP_CSRRW:  return enc_i(1u, 0x73u, d);
+    case RV32I_OP_CSRRS:  return enc_i(2u, 0x73u, d);
+    case RV32I_OP_CSRRC:  return enc_i(3u, 0x73u, d);
+    case RV32I_OP_CSRRWI: return enc_i(5u, 0x73u, d);
+    case RV32I_OP_CSRRSI: return enc_i(6u, 0x73u, d);
+    case RV32I_OP_CSRRCI: return enc_i(7u, 0x73u, d);
+    default:             return 0u;
+    }
+}
+
+/* ---------- execute ---------- */
+
+uint32_t rv32i_alu(rv32i_op_t op, uint32_t a, uint32_t b) {
+    switch (op) {
+    case RV32I_OP_ADD: case RV32I_OP_ADDI: return a + b;
+    case RV32I_OP_SUB:                     return a - b;
+    case RV32I_OP_SLL: case RV32I_OP_SLLI: return a << (b & 31u);
+    case RV32I_OP_SLT: case RV32I_OP_SLTI: return (int32_t)a < (int32_t)b;
+    case RV32I_OP_SLTU: case RV32I_OP_SLTIU: return a < b;
+    case RV32I_OP_XOR: case RV32I_OP_XORI: return a ^ b;
+    case RV32I_OP_SRL: case RV32I_OP_SRLI: return a >> (b & 31u);
+    case RV32I_OP_SRA: case RV32I_OP_SRAI: return (uint32_t)((int32_t)a >> (b & 31u));
+    case RV32I_OP_OR: case RV32I_OP_ORI:   return a | b;
+    case RV32I_OP_AND: case RV32I_OP_ANDI: return a & b;
+    default:                               return 0u;
+    }
+}
+
+void rv32i_init(rv32i_cpu_t *cpu, uint8_t *ram, uint32_t ram_base, uint32_t ram_size) {
+    memset(cpu, 0, sizeof(*cpu));
+    cpu->ram = ram;
+    cpu->ram_base = ram_base;
+    cpu->ram_size = ram_size;
+    cpu->pc = ram_base;
+}
+
+static int mem_load(rv32i_cpu_t *cpu, uint32_t addr, uint32_t size, uint32_t *value) {
+    uint32_t off = addr - cpu->ram_base;
+
+    if (off < cpu->ram_size && size <= cpu->ram_size - off) {
+        const uint8_t *p = cpu->ram + off;
+        uint32_t v = p[0];
+        if (size > 1u) {
+            v |= (uint32_t)p[1] << 8;
+        }
+        if (size > 2u) {
+            v |= ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+        }
+        *value = v;
+        return 0;
+    }
+    if (cpu->bus_load != NULL) {
+        return cpu->bus_load(cpu->bus_ctx, addr, size, value);
+    }
+    return 1;
+}
+
+static int mem_store(rv32i_cpu_t *cpu, uint32_t addr, uint32_t size, uint32_t value) {
+    uint32_t off = addr - cpu->ram_base;
+
+    if (off < cpu->ram_size && size <= cpu->ram_size - off) {
+        uint8_t *p = cpu->ram + off;
+        p[0] = (uint8_t)value;
+        if (size > 1u) {
+            p[1] = (uint8_t)(value >> 8);
+        }
+        if (size > 2u) {
+            p[2] = (uint8_t)(value >> 16);
+            p[3] = (uint8_t)(value >> 24);
+        }
+        return 0;
+    }
+    if (cpu->bus_store != NULL) {
+        return cpu->bus_store(cpu->bus_ctx, addr, size, value);
+    }
+    return 1;
+}
+
+/* Zicsr read-modify-write. rd gets the old value; csrrs/csrrc with a zero
+ * source do not write, so reading a read-only counter is legal. */
+static int csr_access(rv32i_cpu_t *cpu, const rv32i_insn_t *d, uint32_t src, uint32_t *old) {
+    uint32_t csr = (uint32_t)d->imm & 0xFFFu;
+    int set = d->op == RV32I_OP_CSRRS || d->op == RV32I_OP_CSRRSI;
+    int clear = d->op == RV32I_OP_CSRRC || d->op == RV32I_OP_CSRRCI;
+    int write = !(set || clear) || d->rs1 != 0u;
+    uint32_t v;
+
+    if (cpu->csr_read == NULL || (write && ((csr >> 10) == 3u || cpu->csr_write == NULL))) {
+        return 1;
+    }
+    if (cpu->csr_read(cpu->bus_ctx, csr, old) != 0) {
+        return 1;
+    }
+    if (!write) {
+        return 0;
+    }
+    v = set ? (*old | src) : clear ? (*old & ~src) : src;
+    return cpu->csr_write(cpu->bus_ctx, csr, v);
+}
+
+rv32i_status_t rv32i_step(rv32i_cpu_t *cpu, rv32i_retire_t *ret) {
+    rv32i_retire_t local;
+    rv32i_retire_t *r = (ret != NULL) ? ret : &local;
+    rv32i_insn_t *d = &r->dec;
+    uint32_t pc = cpu->pc;
+    uint32_t off = pc - cpu->ram_base;
+    uint32_t a, b, v = 0;
+    uint32_t next = pc + 4u;
+    uint32_t size;
+    int write_rd = 0;
+
+    r->pc = pc;
+    r->rd = 0;
+    r->mem_op = 0;
+    r->taken = 0;
+
+    if ((pc & 3u) != 0u) {
+        return RV32I_MISALIGNED;
+    }
+    if (off >= cpu->ram_size || cpu->ram_size - off < 4u) {
+        return RV32I_BUS_ERROR;
+    }
+    r->insn = (uint32_t)cpu->ram[off] | ((uint32_t)cpu->ram[off + 1u] << 8) |
+              ((uint32_t)cpu->ram[off + 2u] << 16) | ((uint32_t)cpu->ram[off + 3u] << 24);
+    if (!rv32i_decode(r->insn, d)) {
+        return RV32I_ILLEGAL;
+    }
+
+    a = cpu->x[d->rs1];
+    b = cpu->x[d->rs2];
+
+    switch (d->op) {
+    case RV32I_OP_LUI:
+        v = (uint32_t)d->imm;
+        write_rd = 1;
+        break;
+    case RV32I_OP_AUIPC:
+        v = pc + (uint32_t)d->imm;
+        write_rd = 1;
+        break;
+    case RV32I_OP_JAL:
+        v = pc + 4u;
+        next = pc + (uint32_t)d->imm;
+        write_rd = 1;
+        r->taken = 1;
+        break;
+    case RV32I_OP_JALR:
+        v = pc + 4u;
+        next = (a + (uint32_t)d->imm) & ~1u;
+        write_rd = 1;
+        r->taken = 1;
+        break;
+    case RV32I_OP_BEQ:  r->taken = a == b; break;
+    case RV32I_OP_BNE:  r->taken = a != b; break;
+    case RV32I_OP_BLT:  r->taken = (int32_t)a < (int32_t)b; break;
+    case RV32I_OP_BGE:  r->taken = (int32_t)a >= (int32_t)b; break;
+    case RV32I_OP_BLTU: r->taken = a < b; break;
+    case RV32I_OP_BGEU: r->taken = a >= b; break;
+    case RV32I_OP_LB: case RV32I_OP_LH: case RV32I_OP_LW:
+    case RV32I_OP_LBU: case RV32I_OP_LHU:
+        size = (d->op == RV32I_OP_LW) ? 4u :
+               (d->op == RV32I_OP_LH || d->op == RV32I_OP_LHU) ? 2u : 1u;
+        r->mem_op = 1;
+        r->mem_size = (uint8_t)size;
+        r->mem_addr = a + (uint32_t)d->imm;
+        if ((r->mem_addr & (size - 1u)) != 0u) {
+            return RV32I_MISALIGNED;
+        }
+        if (mem_load(cpu, r->mem_addr, size, &v) != 0) {
+            return RV32I_BUS_ERROR;
+        }
+        r->mem_value = v;
+        if (d->op == RV32I_OP_LB) {
+            v = (uint32_t)(int32_t)(int8_t)v;
+        } else if (d->op == RV32I_OP_LH) {
+            v = (uint32_t)(int32_t)(int16_t)v;
+        }
+        write_rd = 1;
+        break;
+    case RV32I_OP_SB: case RV32I_OP_SH: case RV32I_OP_SW:
+        size = (d->op == RV32I_OP_SW) ? 4u : (d->op == RV32I_OP_SH) ? 2u : 1u;
+        r->mem_op = 2;
+        r->mem_size = (uint8_t)size;
+        r->mem_addr = a + (uint32_t)d->imm;
+        r->mem_value = (size == 4u) ? b : (b & ((1u << (8u * size)) - 1u));
+        if ((r->mem_addr & (size - 1u)) != 0u) {
+            return RV32I_MISALIGNED;
+        }
+        if (mem_store(cpu, r->mem_addr, size, b) != 0) {
+            return RV32I_BUS_ERROR;
+        }
+        break;
+    case RV32I_OP_ADDI: case RV32I_OP_SLTI: case RV32I_OP_SLTIU: case RV32I_OP_XORI:
+    case RV32I_OP_ORI: case RV32I_OP_ANDI: case RV32I_OP_SLLI: case RV32I_OP_SRLI:
+    case RV32I_OP_SRAI:
+        v = rv32i_alu(d->op, a, (uint32_t)d->imm);
+        write_rd = 1;
+        break;
+    case RV32I_OP_ADD: case RV32I_OP_SUB: case RV32I_OP_SLL: case RV32I_OP_SLT:
+    case RV32I_OP_SLTU: case RV32I_OP_XOR: case RV32I_OP_SRL: case RV32I_OP_SRA:
+    case RV32I_OP_OR: case RV32I_OP_AND:
+        v = rv32i_alu(d->op, a, b);
+        write_rd = 1;
+        break;
+    case RV32I_OP_FENCE:
+        break;
+    case RV32I_OP_ECALL:
+        return RV32I_ECALL;
+    case RV32I_OP_EBREAK:
+        return RV32I_EBREAK;
+    case RV32I_OP_CSRRW: case RV32I_OP_CSRRS: case RV32I_OP_CSRRC:
+    case RV32I_OP_CSRRWI: case RV32I_OP_CSRRSI: case RV32I_OP_CSRRCI:
+        if (csr_access(cpu, d, (d->op >= RV32I_OP_CSRRWI) ? d->rs1 : a, &v) != 0) {
+            return RV32I_ILLEGAL;
+        }
+        write_rd = 1;
+        break;
+    default:
+        return RV32I_ILLEGAL;
+    }
+
+    if (r->taken && d->op >= RV32I_OP_BEQ && d->op <= RV32I_OP_BGEU) {
+        next = pc + (uint32_t)d->imm;
+    }
+    if (write_rd && d->rd != 0u) {
+        cpu->x[d->rd] = v;
+        r->rd = d->rd;
+        r->rd_value = v;
+    }
+    r->next_pc = next;
+    cpu->pc = next;
+    cpu->instret++;
+    return RV32I_OK;
+}
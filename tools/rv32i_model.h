@@ -0,0 +1,115 @@
+/*
+ * RV32I reference model (host side).
+ *
+ * A small, dependency-free interpreter for the RV32I base ISA used as the
+ * golden reference by the host tools (random program generator, simulator).
+ * Main RAM is a flat byte array; any access outside it goes to the optional
+ * bus callbacks (MMIO). Misaligned accesses are reported, not emulated, to
+ * match Wizard Core.
+ *
+ * Zicsr instructions decode as I-format with the CSR number (0..0xFFF) in
+ * imm; for csrrwi/csrrsi/csrrci rs1 holds the 5-bit immediate. They execute
+ * only when the embedder supplies csr_read/csr_write (rvsim backs the
+ * Zicntr and hpm counters with its timing model); otherwise they are
+ * illegal, as on a core without Zicsr.
+ */
+
+#ifndef RV32I_MODEL_H
+#define RV32I_MODEL_H
+
+#include <stdint.h>
+
+typedef enum {
+    RV32I_OP_ILLEGAL = 0,
+    RV32I_OP_LUI, RV32I_OP_AUIPC, RV32I_OP_JAL, RV32I_OP_JALR,
+    RV32I_OP_BEQ, RV32I_OP_BNE, RV32I_OP_BLT, RV32I_OP_BGE, RV32I_OP_BLTU, RV32I_OP_BGEU,
+    RV32I_OP_LB, RV32I_OP_LH, RV32I_OP_LW, RV32I_OP_LBU, RV32I_OP_LHU,
+    RV32I_OP_SB, RV32I_OP_SH, RV32I_OP_SW,
+    RV32I_OP_ADDI, RV32I_OP_SLTI, RV32I_OP_SLTIU, RV32I_OP_XORI, RV32I_OP_ORI, RV32I_OP_ANDI,
+    RV32I_OP_SLLI, RV32I_OP_SRLI, RV32I_OP_SRAI,
+    RV32I_OP_ADD, RV32I_OP_SUB, RV32I_OP_SLL, RV32I_OP_SLT, RV32I_OP_SLTU,
+    RV32I_OP_XOR, RV32I_OP_SRL, RV32I_OP_SRA, RV32I_OP_OR, RV32I_OP_AND,
+    RV32I_OP_FENCE, RV32I_OP_ECALL, RV32I_OP_EBREAK,
+    RV32I_OP_CSRRW, RV32I_OP_CSRRS, RV32I_OP_CSRRC, RV32I_OP_CSRRWI, RV32I_OP_CSRRSI, RV32I_OP_CSRRCI,
+    RV32I_OP_COUNT
+} rv32i_op_t;
+
+typedef enum {
+    RV32I_FMT_R, RV32I_FMT_I, RV32I_FMT_S, RV32I_FMT_B, RV32I_FMT_U, RV32I_FMT_J, RV32I_FMT_SYS
+} rv32i_fmt_t;
+
+typedef struct {
+    rv32i_op_t op;
+    uint8_t rd;
+    uint8_t rs1;
+    uint8_t rs2;
+    int32_t imm;
+} rv32i_insn_t;
+
+typedef enum {
+    RV32I_OK = 0,
+    RV32I_ILLEGAL,
+    RV32I_MISALIGNED,
+    RV32I_BUS_ERROR,
+    RV32I_ECALL,
+    RV32I_EBREAK
+} rv32i_status_t;
+
+/* MMIO callbacks: return 0 on success, nonzero for a bus error. */
+typedef int (*rv32i_load_fn)(void *ctx, uint32_t addr, uint32_t size, uint32_t *value);
+typedef int (*rv32i_store_fn)(void *ctx, uint32_t addr, uint32_t size, uint32_t value);
+
+/* CSR callbacks (bus_ctx is passed): return 0 on success, nonzero if the CSR
+ * does not exist or is not writable. The model itself rejects writes to the
+ * read-only range (csr[11:10] == 3) before calling csr_write. */
+typedef int (*rv32i_csr_read_fn)(void *ctx, uint32_t csr, uint32_t *value);
+typedef int (*rv32i_csr_write_fn)(void *ctx, uint32_t csr, uint32_t value);
+
+typedef struct {
+    uint32_t x[32];
+    uint32_t pc;
+    uint64_t instret;
+
+    uint8_t *ram;
+    uint32_t ram_base;
+    uint32_t ram_size;
+
+    void *bus_ctx;
+    rv32i_load_fn bus_load;
+    rv32i_store_fn bus_store;
+    rv32i_csr_read_fn csr_read;
+    rv32i_csr_write_fn csr_write;
+} rv32i_cpu_t;
+
+/* What one step retired; enough for co-simulation, tracing and timing. */
+typedef struct {
+    uint32_t pc;
+    uint32_t insn;
+    rv32i_insn_t dec;
+    uint32_t next_pc;
+    uint8_t rd;             /* 0 when nothing was written */
+    uint32_t rd_value;
+    uint8_t mem_op;         /* 0 none, 1 load, 2 store */
+    uint8_t mem_size;
+    uint32_t mem_addr;
+    uint32_t mem_value;
+    uint8_t taken;          /* branch taken or jump */
+} rv32i_retire_t;
+
+void rv32i_init(rv32i_cpu_t *cpu, uint8_t *ram, uint32_t ram_base, uint32_t ram_size);
+
+/* Execute one instruction. On error pc is left at the faulting instruction. */
+rv32i_status_t rv32i_step(rv32i_cpu_t *cpu, rv32i_retire_t *ret);
+
+/* Decode / encode a single instruction word. decode returns 0 if illegal. */
+int rv32i_decode(uint32_t word, rv32i_insn_t *out);
+uint32_t rv32i_encode(const rv32i_insn_t *insn);
+
+rv32i_fmt_t rv32i_format_of(rv32i_op_t op);
+const char *rv32i_op_name(rv32i_op_t op);
+const char *rv32i_reg_name(unsigned reg);
+
+/* Compute the ALU result of a register-register or register-immediate op. */
+uint32_t rv32i_alu(rv32i_op_t op, uint32_t a, uint32_t b);
+
+#endif
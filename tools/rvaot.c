@@ -0,0 +1,520 @@
+/*
+ * Ahead-of-time translator: RV32I ELF -> host C (see rvaot.h).
+ *
+ * Every word of the executable sections is decoded once. Block leaders
+ * are the entry point, branch and jump targets, the instruction after any
+ * branch, jump or stop, every symbol in the code, and every code address
+ * that appears as a data word in the image or is built by lui/auipc + addi
+ * (function pointers, jump tables). Each block becomes a label in one
+ * function, rvaot_run:
+ *
+ *   L_00000124:
+ *       if (left < 5u) { pc = 0x00000124u; goto limit; }   stepped: rvaot_step_tail
+ *       left -= 5u;
+ *       x2 = x2 - 0x10u;           addi sp, sp, -16
+ *       ...
+ *       if (x15 != x14) goto L_00000124;
+ *
+ * Registers x1..x31 are locals of rvaot_run, loads and stores go straight
+ * to the RAM array when the address is aligned and inside RAM and through
+ * rvaot_load_slow / rvaot_store_slow (MMIO hook, traps) otherwise. jalr
+ * jumps to the dispatch switch over all leaders.
+ *
+ * Usage:
+ *   tools/rvaot [options] -o program.aot.c program.elf
+ *     --leader ADDR          extra block leader (indirect-jump target the
+ *                            scan missed; repeatable)
+ *     --ram-base A --ram-size N   main RAM (default 0x0, 0x8000)
+ *
+ * Build the output with a runner, e.g. make PROGRAM=... aot-sweep.
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "elf32.h"
+#include "rv32i_model.h"
+#include "rvaot.h"
+
+#define SHT_NOBITS      8u
+#define SHF_ALLOC       2u
+#define SHF_EXECINSTR   4u
+
+#define MAX_RANGES      16u
+#define MAX_LEADERS     64u
+
+typedef struct {
+    uint32_t start;
+    uint32_t end;
+} range_t;
+
+typedef struct {
+    uint32_t ram_base;
+    uint32_t ram_size;
+    uint8_t *ram;
+    range_t ranges[MAX_RANGES];
+    unsigned range_count;
+    uint8_t *leader;            /* per RAM word */
+    rv32i_insn_t *insn;         /* per RAM word, decoded code words only */
+    uint8_t *is_code;           /* per RAM word */
+} aot_t;
+
+static uint32_t rd32(const uint8_t *p) {
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static int code_at(const aot_t *t, uint32_t addr) {
+    uint32_t off = addr - t->ram_base;
+    return (addr & 3u) == 0u && off < t->ram_size && t->is_code[off >> 2];
+}
+
+static void mark_leader(aot_t *t, uint32_t addr) {
+    if (code_at(t, addr)) {
+        t->leader[(addr - t->ram_base) >> 2] = 1u;
+    }
+}
+
+static int is_branch(rv32i_op_t op) {
+    return op >= RV32I_OP_BEQ && op <= RV32I_OP_BGEU;
+}
+
+/* Control leaves the straight line after this instruction */
+static int ends_block(rv32i_op_t op) {
+    return op == RV32I_OP_JAL || op == RV32I_OP_JALR || is_branch(op) || op == RV32I_OP_ECALL ||
+           op == RV32I_OP_EBREAK || op == RV32I_OP_ILLEGAL || op >= RV32I_OP_CSRRW;
+}
+
+/* Never falls through to the next instruction */
+static int no_fallthrough(rv32i_op_t op) {
+    return op == RV32I_OP_JAL || op == RV32I_OP_JALR || op == RV32I_OP_ECALL || op == RV32I_OP_EBREAK ||
+           op == RV32I_OP_ILLEGAL || op >= RV32I_OP_CSRRW;
+}
+
+static int find_code(aot_t *t, const elf32_file_t *elf) {
+    if (elf->shdrs == NULL) {
+        fprintf(stderr, "rvaot: no section headers\n");
+        return -1;
+    }
+    for (uint32_t i = 0; i < elf->shnum; ++i) {
+        const uint8_t *s = elf->shdrs + i * elf->shentsize;
+        uint32_t flags = rd32(s + 8);
+        uint32_t addr = rd32(s + 12);
+        uint32_t size = rd32(s + 20);
+
+        if (rd32(s + 4) == SHT_NOBITS || (flags & (SHF_ALLOC | SHF_EXECINSTR)) != (SHF_ALLOC | SHF_EXECINSTR) ||
+            size < 4u) {
+            continue;
+        }
+        if (addr < t->ram_base || addr - t->ram_base > t->ram_size || size > t->ram_size - (addr - t->ram_base) ||
+            (addr & 3u) != 0u) {
+            fprintf(stderr, "rvaot: code section at 0x%08x+0x%x is not in RAM\n", addr, size);
+            return -1;
+        }
+        if (t->range_count == MAX_RANGES) {
+            fprintf(stderr, "rvaot: more than %u code sections\n", MAX_RANGES);
+            return -1;
+        }
+        t->ranges[t->range_count].start = addr;
+        t->ranges[t->range_count].end = addr + (size & ~3u);
+        t->range_count++;
+        for (uint32_t a = addr; a + 4u <= addr + size; a += 4u) {
+            uint32_t w = (a - t->ram_base) >> 2;
+            t->is_code[w] = 1u;
+            rv32i_decode(rd32(t->ram + (a - t->ram_base)), &t->insn[w]);
+        }
+    }
+    if (t->range_count == 0u) {
+        fprintf(stderr, "rvaot: no executable sections\n");
+        return -1;
+    }
+    return 0;
+}
+
+static void find_leaders(aot_t *t, const elf32_file_t *elf, const uint32_t *extra, unsigned extra_count) {
+    elf32_sym_t sym;
+
+    mark_leader(t, elf->entry);
+    for (unsigned i = 0; i < extra_count; ++i) {
+        mark_leader(t, extra[i]);
+    }
+    for (unsigned r = 0; r < t->range_count; ++r) {
+        uint32_t known = 0, val[32];
+
+        mark_leader(t, t->ranges[r].start);
+        for (uint32_t a = t->ranges[r].start; a < t->ranges[r].end; a += 4u) {
+            const rv32i_insn_t *d = &t->insn[(a - t->ram_base) >> 2];
+            rv32i_fmt_t fmt = rv32i_format_of(d->op);
+            uint32_t k1 = (known >> d->rs1) & 1u;
+
+            if (d->op == RV32I_OP_JAL || is_branch(d->op)) {
+                mark_leader(t, a + (uint32_t)d->imm);
+            }
+            // Addresses built by lui/auipc + addi (la, function pointers) or
+            // jumped to by auipc + jalr
+            if (d->op == RV32I_OP_JALR && k1) {
+                mark_leader(t, (val[d->rs1] + (uint32_t)d->imm) & ~1u);
+            }
+            if (d->op == RV32I_OP_LUI || d->op == RV32I_OP_AUIPC) {
+                val[d->rd] = (uint32_t)d->imm + (d->op == RV32I_OP_AUIPC ? a : 0u);
+                known |= 1u << d->rd;
+            } else if (d->op == RV32I_OP_ADDI && k1) {
+                val[d->rd] = val[d->rs1] + (uint32_t)d->imm;
+                known |= 1u << d->rd;
+                mark_leader(t, val[d->rd]);
+            } else if (fmt != RV32I_FMT_S && fmt != RV32I_FMT_B && fmt != RV32I_FMT_SYS) {
+                known &= ~(1u << d->rd);
+            }
+            known &= ~1u;
+            if (ends_block(d->op)) {
+                mark_leader(t, a + 4u);
+                known = 0u;
+            }
+        }
+    }
+    for (uint32_t i = 1; elf32_symbol_at_index(elf, i, &sym) == 0; ++i) {
+        if (sym.shndx != 0u && sym.name[0] != '$') {
+            mark_leader(t, sym.value);
+        }
+    }
+    // Code addresses stored as data: function pointers, jump tables
+    for (uint32_t off = 0; off + 4u <= t->ram_size; off += 4u) {
+        if (!t->is_code[off >> 2]) {
+            mark_leader(t, rd32(t->ram + off));
+        }
+    }
+}
+
+static const char *reg(unsigned r, char buf[8]) {
+    if (r == 0u) {
+        return "0u";
+    }
+    snprintf(buf, 8, "x%u", r);
+    return buf;
+}
+
+static void imm_str(int32_t imm, char buf[24]) {
+    if (imm < 0) {
+        snprintf(buf, 24, "- 0x%xu", (unsigned)-(int64_t)imm);
+    } else {
+        snprintf(buf, 24, "+ 0x%xu", (unsigned)imm);
+    }
+}
+
+/* Direct transfer to target */
+static void emit_goto(FILE *fp, const aot_t *t, uint32_t pc, uint32_t target) {
+    if (target == pc) {
+        fprintf(fp, "{ pc = 0x%08xu; stop = RVAOT_STOP_SPIN; goto out; }", pc);
+    } else if (code_at(t, target)) {
+        fprintf(fp, "goto L_%08x;", target);
+    } else {
+        fprintf(fp, "{ pc = 0x%08xu; goto dispatch; }", target);
+    }
+}
+
+static void emit_insn(FILE *fp, const aot_t *t, uint32_t pc, const rv32i_insn_t *d, uint32_t rem) {
+    static const char *const alu_fmt[RV32I_OP_COUNT] = {
+        [RV32I_OP_ADD] = "%s + %s", [RV32I_OP_SUB] = "%s - %s",
+        [RV32I_OP_SLL] = "%s << (%s & 31u)", [RV32I_OP_SRL] = "%s >> (%s & 31u)",
+        [RV32I_OP_SRA] = "(uint32_t)((int32_t)%s >> (%s & 31u))",
+        [RV32I_OP_SLT] = "(uint32_t)((int32_t)%s < (int32_t)%s)", [RV32I_OP_SLTU] = "(uint32_t)(%s < %s)",
+        [RV32I_OP_XOR] = "%s ^ %s", [RV32I_OP_OR] = "%s | %s", [RV32I_OP_AND] = "%s & %s",
+    };
+    static const char *const cond_fmt[RV32I_OP_COUNT] = {
+        [RV32I_OP_BEQ] = "%s == %s", [RV32I_OP_BNE] = "%s != %s",
+        [RV32I_OP_BLT] = "(int32_t)%s < (int32_t)%s", [RV32I_OP_BGE] = "(int32_t)%s >= (int32_t)%s",
+        [RV32I_OP_BLTU] = "%s < %s", [RV32I_OP_BGEU] = "%s >= %s",
+    };
+    char b1[8], b2[8], bd[8], im[24];
+    const char *s1 = reg(d->rs1, b1);
+    const char *s2 = reg(d->rs2, b2);
+    const char *rd = reg(d->rd, bd);
+    uint32_t u = (uint32_t)d->imm;
+    uint32_t size;
+
+    fprintf(fp, "    /* %08x: %s */\n", pc, rv32i_op_name(d->op));
+    imm_str(d->imm, im);
+    switch (d->op) {
+    case RV32I_OP_LUI:
+    case RV32I_OP_AUIPC:
+        if (d->rd != 0u) {
+            fprintf(fp, "    %s = 0x%08xu;\n", rd, d->op == RV32I_OP_AUIPC ? pc + u : u);
+        }
+        break;
+    case RV32I_OP_JAL:
+        if (d->rd != 0u) {
+            fprintf(fp, "    %s = 0x%08xu;\n", rd, pc + 4u);
+        }
+        fprintf(fp, "    ");
+        emit_goto(fp, t, pc, pc + u);
+        fprintf(fp, "\n");
+        break;
+    case RV32I_OP_JALR:
+        fprintf(fp, "    a = (%s %s) & ~1u;\n", s1, im);
+        if (d->rd != 0u) {
+            fprintf(fp, "    %s = 0x%08xu;\n", rd, pc + 4u);
+        }
+        fprintf(fp, "    if (a == 0x%08xu) { pc = a; stop = RVAOT_STOP_SPIN; goto out; }\n", pc);
+        fprintf(fp, "    pc = a;\n    goto dispatch;\n");
+        break;
+    case RV32I_OP_BEQ: case RV32I_OP_BNE: case RV32I_OP_BLT:
+    case RV32I_OP_BGE: case RV32I_OP_BLTU: case RV32I_OP_BGEU:
+        // Fold the comparisons the host compiler would warn about
+        if (d->rs1 == d->rs2 || (d->rs2 == 0u && (d->op == RV32I_OP_BLTU || d->op == RV32I_OP_BGEU))) {
+            if (d->op == RV32I_OP_BEQ || d->op == RV32I_OP_BGE || d->op == RV32I_OP_BGEU) {
+                fprintf(fp, "    ");
+                emit_goto(fp, t, pc, pc + u);
+                fprintf(fp, "\n");
+            }
+            break;
+        }
+        fprintf(fp, "    if (");
+        if (d->rs1 == 0u && (d->op == RV32I_OP_BLTU || d->op == RV32I_OP_BGEU)) {
+            fprintf(fp, d->op == RV32I_OP_BLTU ? "%s != 0u" : "%s == 0u", s2);
+        } else {
+            fprintf(fp, cond_fmt[d->op], s1, s2);
+        }
+        fprintf(fp, ") ");
+        emit_goto(fp, t, pc, pc + u);
+        fprintf(fp, "\n");
+        break;
+    case RV32I_OP_LB: case RV32I_OP_LH: case RV32I_OP_LW:
+    case RV32I_OP_LBU: case RV32I_OP_LHU:
+        size = (d->op == RV32I_OP_LW) ? 4u : (d->op == RV32I_OP_LH || d->op == RV32I_OP_LHU) ? 2u : 1u;
+        fprintf(fp, "    a = %s %s;\n", s1, im);
+        fprintf(fp, "    if (RAM_OK(a, %uu)) { v = %s(ram + (a - RAM_BASE)); }\n", size,
+                size == 4u ? "ld32" : size == 2u ? "ld16" : "ld8");
+        fprintf(fp, "    else if ((st = rvaot_load_slow(c, a, %uu, &v)) != RV32I_OK) TRAP(0x%08xu, %uu, st);\n",
+                size, pc, rem);
+        if (d->rd != 0u) {
+            fprintf(fp, "    %s = %s;\n", rd,
+                    d->op == RV32I_OP_LB ? "(uint32_t)(int32_t)(int8_t)v" :
+                    d->op == RV32I_OP_LH ? "(uint32_t)(int32_t)(int16_t)v" : "v");
+        }
+        break;
+    case RV32I_OP_SB: case RV32I_OP_SH: case RV32I_OP_SW:
+        size = (d->op == RV32I_OP_SW) ? 4u : (d->op == RV32I_OP_SH) ? 2u : 1u;
+        fprintf(fp, "    a = %s %s;\n", s1, im);
+        fprintf(fp, "    if (RAM_OK(a, %uu)) { %s(ram + (a - RAM_BASE), %s); }\n", size,
+                size == 4u ? "st32" : size == 2u ? "st16" : "st8", s2);
+        fprintf(fp, "    else if ((st = rvaot_store_slow(c, a, %uu, %s)) != RV32I_OK) TRAP(0x%08xu, %uu, st);\n",
+                size, s2, pc, rem);
+        break;
+    case RV32I_OP_ADDI: case RV32I_OP_XORI: case RV32I_OP_ORI: case RV32I_OP_ANDI:
+    case RV32I_OP_SLTI: case RV32I_OP_SLTIU:
+        if (d->rd == 0u) {
+            break;
+        }
+        if (d->op == RV32I_OP_ADDI && d->rs1 == 0u) {
+            fprintf(fp, "    %s = 0x%08xu;\n", rd, u);
+            break;
+        } else if (d->op == RV32I_OP_ADDI) {
+            fprintf(fp, "    %s = %s %s;\n", rd, s1, im);
+            break;
+        }
+        fprintf(fp, "    %s = ", rd);
+        if (d->op == RV32I_OP_SLTI) {
+            fprintf(fp, "(uint32_t)((int32_t)%s < %d);\n", s1, d->imm);
+        } else if (d->op == RV32I_OP_SLTIU) {
+            fprintf(fp, u == 0u ? "0u;\n" : "(uint32_t)(%s < 0x%08xu);\n", s1, u);
+        } else {
+            fprintf(fp, "%s %c 0x%08xu;\n", s1, d->op == RV32I_OP_XORI ? '^' : d->op == RV32I_OP_ORI ? '|' : '&', u);
+        }
+        break;
+    case RV32I_OP_SLLI: case RV32I_OP_SRLI: case RV32I_OP_SRAI:
+        if (d->rd != 0u) {
+            fprintf(fp, d->op == RV32I_OP_SRAI ? "    %s = (uint32_t)((int32_t)%s >> %u);\n" :
+                        d->op == RV32I_OP_SLLI ? "    %s = %s << %u;\n" : "    %s = %s >> %u;\n",
+                    rd, s1, u & 31u);
+        }
+        break;
+    case RV32I_OP_ADD: case RV32I_OP_SUB: case RV32I_OP_SLL: case RV32I_OP_SLT:
+    case RV32I_OP_SLTU: case RV32I_OP_XOR: case RV32I_OP_SRL: case RV32I_OP_SRA:
+    case RV32I_OP_OR: case RV32I_OP_AND:
+        if (d->rd == 0u) {
+            break;
+        }
+        fprintf(fp, "    %s = ", rd);
+        if ((d->op == RV32I_OP_SLT || d->op == RV32I_OP_SLTU) && (d->rs1 == d->rs2 ||
+                                                                 (d->op == RV32I_OP_SLTU && d->rs2 == 0u))) {
+            fprintf(fp, "0u;\n");
+        } else if (d->op == RV32I_OP_SLTU && d->rs1 == 0u) {
+            fprintf(fp, "(uint32_t)(%s != 0u);\n", s2);
+        } else {
+            fprintf(fp, alu_fmt[d->op], s1, s2);
+            fprintf(fp, ";\n");
+        }
+        break;
+    case RV32I_OP_FENCE:
+        break;
+    case RV32I_OP_ECALL:
+    case RV32I_OP_EBREAK:
+        // Not retired, as in rv32i_step
+        fprintf(fp, "    pc = 0x%08xu;\n    left += 1u;\n    stop = %s;\n    goto out;\n", pc,
+                d->op == RV32I_OP_ECALL ? "RVAOT_STOP_ECALL" : "RVAOT_STOP_EBREAK");
+        break;
+    default:
+        // Illegal, or a CSR access (no CSR callbacks in translated code)
+        fprintf(fp, "    TRAP(0x%08xu, %uu, RV32I_ILLEGAL);\n", pc, rem);
+        break;
+    }
+}
+
+static void emit(FILE *fp, const aot_t *t, const elf32_file_t *elf, const char *src) {
+    uint32_t base = t->ranges[0].start, end = t->ranges[0].end;
+    uint32_t blocks = 0;
+
+    for (unsigned r = 1; r < t->range_count; ++r) {
+        base = t->ranges[r].start < base ? t->ranges[r].start : base;
+        end = t->ranges[r].end > end ? t->ranges[r].end : end;
+    }
+    for (uint32_t w = 0; w < t->ram_size >> 2; ++w) {
+        blocks += t->leader[w];
+    }
+
+    fprintf(fp, "/* Generated by tools/rvaot from %s: do not edit. See tools/rvaot.h. */\n\n", src);
+    fprintf(fp, "#include <stdint.h>\n#include <string.h>\n\n#include \"rvaot.h\"\n\n");
+    fprintf(fp, "#define RAM_BASE 0x%08xu\n#define RAM_SIZE 0x%08xu\n\n", t->ram_base, t->ram_size);
+    fprintf(fp, "/* Aligned and inside RAM: the fast path */\n");
+    fprintf(fp, "#define RAM_OK(a, n) ((((a) & ((n) - 1u)) == 0u) & ((uint32_t)((a) - RAM_BASE) <= RAM_SIZE - (n)))\n");
+    fprintf(fp, "#define TRAP(at, rem, why) do { pc = (at); left += (rem); c->status = (why); "
+                "stop = RVAOT_STOP_TRAP; goto out; } while (0)\n\n");
+    fprintf(fp, "static inline uint32_t ld32(const uint8_t *p) { uint32_t v; memcpy(&v, p, 4u); return v; }\n");
+    fprintf(fp, "static inline uint32_t ld16(const uint8_t *p) { uint16_t v; memcpy(&v, p, 2u); return v; }\n");
+    fprintf(fp, "static inline uint32_t ld8(const uint8_t *p) { return *p; }\n");
+    fprintf(fp, "static inline void st32(uint8_t *p, uint32_t v) { memcpy(p, &v, 4u); }\n");
+    fprintf(fp, "static inline void st16(uint8_t *p, uint32_t v) { uint16_t h = (uint16_t)v; memcpy(p, &h, 2u); }\n");
+    fprintf(fp, "static inline void st8(uint8_t *p, uint32_t v) { *p = (uint8_t)v; }\n\n");
+    fprintf(fp, "const rvaot_image_t rvaot_image = {\n");
+    fprintf(fp, "    \"%s\", 0x%08xu, 0x%08xu, 0x%08xu, 0x%08xu, 0x%08xu, 0x%08xu, %uu,\n};\n\n", src, t->ram_base,
+            t->ram_size, elf->entry, base, end, rvaot_hash(t->ram + (base - t->ram_base), end - base), blocks);
+
+    fprintf(fp, "rvaot_stop_t rvaot_run(rvaot_cpu_t *c) {\n");
+    fprintf(fp, "    uint8_t *const ram = c->ram;\n");
+    for (unsigned r = 1; r < 32u; ++r) {
+        fprintf(fp, "    uint32_t x%u = c->x[%u];\n", r, r);
+    }
+    fprintf(fp, "    uint64_t left0 = c->max_insns > c->instret ? c->max_insns - c->instret : 0u;\n");
+    fprintf(fp, "    uint64_t left = left0;\n");
+    fprintf(fp, "    uint32_t pc = c->pc, a = 0, v = 0;\n");
+    fprintf(fp, "    rv32i_status_t st = RV32I_OK;\n");
+    fprintf(fp, "    rvaot_stop_t stop;\n\n");
+    fprintf(fp, "    (void)a;\n    (void)v;\n    (void)st;\n    goto dispatch;\n");
+
+    for (unsigned r = 0; r < t->range_count; ++r) {
+        const rv32i_insn_t *last = NULL;
+        for (uint32_t pc = t->ranges[r].start; pc < t->ranges[r].end; pc += 4u) {
+            uint32_t w = (pc - t->ram_base) >> 2;
+            const rv32i_insn_t *d = &t->insn[w];
+            uint32_t rem = 1;
+
+            while (pc + 4u * rem < t->ranges[r].end && !t->leader[w + rem]) {
+                ++rem;
+            }
+            if (t->leader[w]) {
+                fprintf(fp, "\nL_%08x:\n", pc);
+                fprintf(fp, "    if (left < %uu) { pc = 0x%08xu; goto limit; }\n    left -= %uu;\n", rem, pc, rem);
+            }
+            emit_insn(fp, t, pc, d, rem);
+            last = d;
+        }
+        if (last != NULL && !no_fallthrough(last->op)) {
+            fprintf(fp, "    pc = 0x%08xu;\n    goto dispatch;\n", t->ranges[r].end);
+        }
+    }
+
+    fprintf(fp, "\ndispatch:\n    switch (pc) {\n");
+    for (uint32_t w = 0; w < t->ram_size >> 2; ++w) {
+        if (t->leader[w]) {
+            uint32_t pc = t->ram_base + (w << 2);
+            fprintf(fp, "    case 0x%08xu: goto L_%08x;\n", pc, pc);
+        }
+    }
+    fprintf(fp, "    default: break;\n    }\n");
+    fprintf(fp, "    if ((pc & 3u) != 0u) {\n        c->status = RV32I_MISALIGNED;\n        stop = RVAOT_STOP_TRAP;\n");
+    fprintf(fp, "    } else if ((uint32_t)(pc - RAM_BASE) > RAM_SIZE - 4u) {\n");
+    fprintf(fp, "        c->status = RV32I_BUS_ERROR;\n        stop = RVAOT_STOP_TRAP;\n");
+    fprintf(fp, "    } else {\n        stop = RVAOT_STOP_NO_CODE;\n    }\n    goto out;\n");
+    fprintf(fp, "\nlimit:\n    stop = RVAOT_STOP_LIMIT;\n");
+    fprintf(fp, "\nout:\n");
+    for (unsigned r = 1; r < 32u; ++r) {
+        fprintf(fp, "    c->x[%u] = x%u;\n", r, r);
+    }
+    fprintf(fp, "    c->pc = pc;\n    c->instret += left0 - left;\n");
+    fprintf(fp, "    if (stop == RVAOT_STOP_LIMIT && left != 0u) {\n");
+    fprintf(fp, "        stop = rvaot_step_tail(c, RAM_BASE, RAM_SIZE, left);\n    }\n");
+    fprintf(fp, "    return stop;\n}\n");
+}
+
+static void usage(const char *argv0) {
+    fprintf(stderr, "usage: %s [--leader ADDR]... [--ram-base A] [--ram-size N] -o out.c program.elf\n", argv0);
+}
+
+int main(int argc, char **argv) {
+    const char *path = NULL;
+    const char *out_path = NULL;
+    uint32_t extra[MAX_LEADERS];
+    unsigned extra_count = 0;
+    elf32_file_t elf;
+    aot_t t;
+    FILE *fp;
+
+    memset(&t, 0, sizeof(t));
+    t.ram_base = 0x0u;
+    t.ram_size = 0x8000u;
+    for (int i = 1; i < argc; ++i) {
+        if (strcmp(argv[i], "-o") == 0 && i + 1 < argc) {
+            out_path = argv[++i];
+        } else if (strcmp(argv[i], "--leader") == 0 && i + 1 < argc && extra_count < MAX_LEADERS) {
+            extra[extra_count++] = (uint32_t)strtoul(argv[++i], NULL, 0);
+        } else if (strcmp(argv[i], "--ram-base") == 0 && i + 1 < argc) {
+            t.ram_base = (uint32_t)strtoul(argv[++i], NULL, 0);
+        } else if (strcmp(argv[i], "--ram-size") == 0 && i + 1 < argc) {
+            t.ram_size = (uint32_t)strtoul(argv[++i], NULL, 0);
+        } else if (argv[i][0] != '-' && path == NULL) {
+            path = argv[i];
+        } else {
+            usage(argv[0]);
+            return 2;
+        }
+    }
+    if (path == NULL || out_path == NULL || t.ram_size < 4u || (t.ram_size & 3u) != 0u) {
+        usage(argv[0]);
+        return 2;
+    }
+
+    t.ram = calloc(1, t.ram_size);
+    t.leader = calloc(t.ram_size >> 2, 1);
+    t.is_code = calloc(t.ram_size >> 2, 1);
+    t.insn = calloc(t.ram_size >> 2, sizeof(*t.insn));
+    if (t.ram == NULL || t.leader == NULL || t.is_code == NULL || t.insn == NULL) {
+        perror("calloc");
+        return 1;
+    }
+    if (elf32_open(&elf, path) != 0 || elf32_load(&elf, t.ram, t.ram_base, t.ram_size) != 0 ||
+        find_code(&t, &elf) != 0) {
+        return 1;
+    }
+    find_leaders(&t, &elf, extra, extra_count);
+
+    fp = fopen(out_path, "w");
+    if (fp == NULL) {
+        perror(out_path);
+        return 1;
+    }
+    emit(fp, &t, &elf, path);
+    if (fclose(fp) != 0) {
+        perror(out_path);
+        return 1;
+    }
+
+    elf32_close(&elf);
+    free(t.ram);
+    free(t.leader);
+    free(t.is_code);
+    free(t.insn);
+    return 0;
+}
@@ -0,0 +1,144 @@
+/*
+ * Ahead-of-time translated RV32I programs (tools/rvaot), host side.
+ *
+ * tools/rvaot turns a built $(PROGRAM).elf into one C function, rvaot_run,
+ * that is compiled natively together with a runner (param_sweep built with
+ * -DPARAM_SWEEP_AOT). Basic blocks become labels, direct branches become
+ * gotos and guest registers are locals, so the host compiler keeps them in
+ * host registers and optimises across each block. Indirect jumps (jalr)
+ * go through one switch over the block addresses.
+ *
+ * Semantics match rv32i_step on a CPU without CSR callbacks: the same trap
+ * causes, pc left at the faulting instruction, ecall/ebreak not retired.
+ * Main RAM is a flat byte array; accesses outside it go to the optional bus
+ * callbacks (MMIO), as in rv32i_cpu_t. The instruction limit is checked at
+ * block entry; a block longer than what is left runs on rv32i_step one
+ * instruction at a time (rvaot_step_tail), so a LIMIT stop retires exactly
+ * max_insns and stops at the same pc as the interpreter. CSR instructions
+ * trap as illegal (there are no CSR callbacks), in the tail too.
+ *
+ * The translation is of the code bytes at translation time: a program that
+ * writes to its own code, or jumps to a computed address that is not a
+ * known block (RVAOT_STOP_NO_CODE), needs the interpreter or --leader.
+ */
+
+#ifndef RVAOT_H
+#define RVAOT_H
+
+#include <stdint.h>
+#include <string.h>
+
+#include "rv32i_model.h"
+
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ != __ORDER_LITTLE_ENDIAN__
+#error "translated programs access guest RAM with host loads: little-endian hosts only"
+#endif
+
+typedef enum {
+    RVAOT_STOP_SPIN = 0,        /* jump-to-self (main returned to boot.S); retired */
+    RVAOT_STOP_ECALL,
+    RVAOT_STOP_EBREAK,
+    RVAOT_STOP_LIMIT,           /* max_insns reached */
+    RVAOT_STOP_TRAP,            /* cause in status */
+    RVAOT_STOP_NO_CODE          /* jump to an address with no translated block */
+} rvaot_stop_t;
+
+typedef struct {
+    uint32_t x[32];             /* in: initial registers; out: at the stop */
+    uint32_t pc;                /* in: entry; out: stopping instruction */
+    uint64_t instret;
+    uint64_t max_insns;         /* stop once instret would pass this */
+    rv32i_status_t status;      /* RVAOT_STOP_TRAP cause */
+
+    uint8_t *ram;               /* rvaot_image.ram_size bytes at ram_base */
+    void *bus_ctx;
+    rv32i_load_fn bus_load;
+    rv32i_store_fn bus_store;
+} rvaot_cpu_t;
+
+/* What was translated, to check the program at run time */
+typedef struct {
+    const char *source;         /* ELF path given to tools/rvaot */
+    uint32_t ram_base;
+    uint32_t ram_size;
+    uint32_t entry;
+    uint32_t code_base;         /* executable sections, lowest .. highest address */
+    uint32_t code_end;
+    uint32_t code_hash;         /* rvaot_hash over code_base..code_end of the loaded image */
+    uint32_t blocks;
+} rvaot_image_t;
+
+/* Defined by the generated file */
+extern const rvaot_image_t rvaot_image;
+rvaot_stop_t rvaot_run(rvaot_cpu_t *cpu);
+
+/* FNV-1a over len bytes */
+static inline uint32_t rvaot_hash(const uint8_t *p, uint32_t len) {
+    uint32_t h = 0x811C9DC5u;
+    for (uint32_t i = 0; i < len; ++i) {
+        h = (h ^ p[i]) * 0x01000193u;
+    }
+    return h;
+}
+
+/*
+ * The last `left` instructions before max_insns, fewer than the next block
+ * holds, on the reference model from the state in c (registers, pc and
+ * instret already written back). Stops as rvaot_run would.
+ */
+static inline rvaot_stop_t rvaot_step_tail(rvaot_cpu_t *c, uint32_t ram_base, uint32_t ram_size, uint64_t left) {
+    rvaot_stop_t stop = RVAOT_STOP_LIMIT;
+    rv32i_cpu_t m;
+    rv32i_retire_t r;
+
+    rv32i_init(&m, c->ram, ram_base, ram_size);
+    memcpy(m.x, c->x, sizeof(m.x));
+    m.pc = c->pc;
+    m.instret = 0;
+    m.bus_ctx = c->bus_ctx;
+    m.bus_load = c->bus_load;
+    m.bus_store = c->bus_store;
+    for (; left != 0u; --left) {
+        rv32i_status_t st = rv32i_step(&m, &r);
+        if (st == RV32I_ECALL || st == RV32I_EBREAK) {
+            stop = (st == RV32I_ECALL) ? RVAOT_STOP_ECALL : RVAOT_STOP_EBREAK;
+            break;
+        }
+        if (st != RV32I_OK) {
+            c->status = st;
+            stop = RVAOT_STOP_TRAP;
+            break;
+        }
+        if (r.next_pc == r.pc) {
+            stop = RVAOT_STOP_SPIN;
+            break;
+        }
+    }
+    memcpy(c->x, m.x, sizeof(c->x));
+    c->pc = m.pc;
+    c->instret += m.instret;
+    return stop;
+}
+
+/* Slow paths of the generated loads and stores: misaligned, or outside RAM */
+static inline rv32i_status_t rvaot_load_slow(rvaot_cpu_t *cpu, uint32_t addr, uint32_t size, uint32_t *value) {
+    if ((addr & (size - 1u)) != 0u) {
+        return RV32I_MISALIGNED;
+    }
+    if (cpu->bus_load == NULL || cpu->bus_load(cpu->bus_ctx, addr, size, value) != 0) {
+        return RV32I_BUS_ERROR;
+    }
+    return RV32I_OK;
+}
+
+static inline rv32i_status_t rvaot_store_slow(rvaot_cpu_t *cpu, uint32_t addr, uint32_t size, uint32_t value) {
+    if ((addr & (size - 1u)) != 0u) {
+        return RV32I_MISALIGNED;
+    }
+    if (cpu->bus_store == NULL || cpu->bus_store(cpu->bus_ctx, addr, size, value) != 0) {
+        return RV32I_BUS_ERROR;
+    }
+    return RV32I_OK;
+}
+
+#endif
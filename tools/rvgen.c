@@ -0,0 +1,677 @@
+/*
+ * Random self-checking RV32I program generator.
+ *
+ * Emits a .S file that builds through the normal Makefile + boot.S flow
+ * (make rvgen RVGEN_SEED=N, or tools/rvgen -o rvgen_N.S and make
+ * PROGRAM=rvgen_N). The program runs a long random body of RV32I
+ * instructions, dumps every pool register next to a 64-word scratch area,
+ * and compares the whole signature against a table computed up front by
+ * the reference model (rv32i_model.c). Results use the same globals as
+ * test_rv32i.c: test_result (0 pass), test_passed, test_failed, plus
+ * fail_index (first mismatching signature word, -1 if none).
+ *
+ * Hazard density is controlled per instruction:
+ *   --dep P       % of sources taken from the previous (or second previous)
+ *                 destination: back-to-back RAW through the forwarding paths
+ *   --load-use P  % of units that are a load immediately consumed
+ *   --branch P    % of units that are forward conditional branches; targets
+ *                 land 1..4 units ahead, so branches skip over branches
+ *   --mem P       % of units that are plain loads/stores on the scratch area
+ *   --jump P      % of units that are jal/jalr/auipc fragments
+ *
+ * Everything the body computes is independent of where it is linked: the
+ * PC-relative fragments fold their PC values back out, and memory is only
+ * addressed through s0 (scratch base), which is never a destination.
+ *
+ * Usage:
+ *   tools/rvgen [--seed N] [--count N] [--dep P] [--load-use P] [--branch P]
+ *               [--mem P] [--jump P] [-o out.S]
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <inttypes.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "rv32i_model.h"
+
+#define SCRATCH_WORDS   64u
+#define REG_SLOTS       32u
+#define SIG_WORDS       (SCRATCH_WORDS + REG_SLOTS)
+#define REGS_OFFSET     (SCRATCH_WORDS * 4u)
+
+#define MAX_BODY        5000u           /* keeps the program inside 32KB RAM */
+#define MODEL_RAM_SIZE  0x10000u
+#define MODEL_SCRATCH   0xC000u         /* body at 0, scratch well above it */
+
+#define BASE_REG        8u              /* s0: scratch base, never written */
+
+/* Pool of registers the body may read and write (not ra/sp/gp/tp/s0). */
+static const uint8_t pool[] = {
+    5, 6, 7, 9, 10, 11, 12, 13, 14, 15, 16, 17, 18,
+    19, 20, 21, 22, 23, 24, 25, 26, 27, 28, 29, 30, 31,
+};
+#define POOL_SIZE (sizeof(pool) / sizeof(pool[0]))
+
+typedef struct {
+    rv32i_insn_t in;
+    int32_t target;         /* instruction index for branch/jal, else -1 */
+    int32_t target_unit;    /* unresolved branch target unit, else -1 */
+} item_t;
+
+typedef struct {
+    unsigned dep;
+    unsigned load_use;
+    unsigned branch;
+    unsigned mem;
+    unsigned jump;
+} mix_t;
+
+typedef struct {
+    uint64_t executed;
+    uint64_t raw1;          /* source = rd of the previous retired insn */
+    uint64_t raw2;          /* source = rd of the insn before that */
+    uint64_t load_use;
+    uint64_t branches;
+    uint64_t taken;
+    uint64_t loads;
+    uint64_t stores;
+    uint32_t static_branches;
+    uint32_t branch_over_branch;
+} stats_t;
+
+static item_t body[MAX_BODY + 16u];
+static uint32_t n_body;
+static int32_t unit_start[MAX_BODY + 16u];
+static uint32_t n_units;
+static uint8_t is_target[MAX_BODY + 17u];
+
+static uint32_t init_regs[32];
+static uint32_t scratch_init[SCRATCH_WORDS];
+static uint32_t expected[SIG_WORDS];
+
+static uint64_t rng_state;
+static uint8_t last_rd[2];
+
+/* ---------- random helpers ---------- */
+
+static uint32_t rnd(void) {
+    /* xorshift64* */
+    rng_state ^= rng_state >> 12;
+    rng_state ^= rng_state << 25;
+    rng_state ^= rng_state >> 27;
+    return (uint32_t)((rng_state * 0x2545F4914F6CDD1DULL) >> 32);
+}
+
+static uint32_t rnd_below(uint32_t n) {
+    return (uint32_t)(((uint64_t)rnd() * n) >> 32);
+}
+
+static int chance(unsigned percent) {
+    return rnd_below(100u) < percent;
+}
+
+/* Values biased towards the corners the ALU and comparators care about. */
+static uint32_t rnd_value(void) {
+    static const uint32_t corners[] = {
+        0x00000000u, 0x00000001u, 0xFFFFFFFFu, 0x80000000u, 0x7FFFFFFFu,
+        0x0000FFFFu, 0xFFFF0000u, 0x000000FFu, 0x00000800u, 0xFFFFF800u,
+    };
+    switch (rnd_below(4u)) {
+    case 0:
+        return corners[rnd_below((uint32_t)(sizeof(corners) / sizeof(corners[0])))];
+    case 1:
+        return rnd_below(64u) - 32u;
+    default:
+        return rnd();
+    }
+}
+
+static int32_t rnd_imm12(void) {
+    static const int32_t corners[] = { 0, 1, -1, 2047, -2048, 31, 32 };
+    if (chance(25u)) {
+        return corners[rnd_below((uint32_t)(sizeof(corners) / sizeof(corners[0])))];
+    }
+    return (int32_t)rnd_below(4096u) - 2048;
+}
+
+static uint8_t rnd_pool(void) {
+    return pool[rnd_below((uint32_t)POOL_SIZE)];
+}
+
+static uint8_t pick_rd(void) {
+    return chance(3u) ? 0u : rnd_pool();
+}
+
+static uint8_t pick_src(const mix_t *mix) {
+    if (last_rd[0] != 0u && chance(mix->dep)) {
+        return last_rd[0];
+    }
+    if (last_rd[1] != 0u && chance(mix->dep / 2u)) {
+        return last_rd[1];
+    }
+    return chance(2u) ? 0u : rnd_pool();
+}
+
+/* ---------- body construction ---------- */
+
+static void emit(rv32i_op_t op, uint8_t rd, uint8_t rs1, uint8_t rs2, int32_t imm) {
+    item_t *it = &body[n_body++];
+    it->in.op = op;
+    it->in.rd = rd;
+    it->in.rs1 = rs1;
+    it->in.rs2 = rs2;
+    it->in.imm = imm;
+    it->target = -1;
+    it->target_unit = -1;
+    if (rv32i_format_of(op) != RV32I_FMT_S && rv32i_format_of(op) != RV32I_FMT_B) {
+        last_rd[1] = last_rd[0];
+        last_rd[0] = rd;
+    }
+}
+
+static void emit_alu(const mix_t *mix, uint8_t rd) {
+    static const rv32i_op_t r_ops[] = {
+        RV32I_OP_ADD, RV32I_OP_SUB, RV32I_OP_SLL, RV32I_OP_SLT, RV32I_OP_SLTU,
+        RV32I_OP_XOR, RV32I_OP_SRL, RV32I_OP_SRA, RV32I_OP_OR, RV32I_OP_AND,
+    };
+    static const rv32i_op_t i_ops[] = {
+        RV32I_OP_ADDI, RV32I_OP_SLTI, RV32I_OP_SLTIU, RV32I_OP_XORI, RV32I_OP_ORI,
+        RV32I_OP_ANDI, RV32I_OP_SLLI, RV32I_OP_SRLI, RV32I_OP_SRAI,
+    };
+    uint32_t kind = rnd_below(16u);
+
+    if (kind < 7u) {
+        rv32i_op_t op = r_ops[rnd_below((uint32_t)(sizeof(r_ops) / sizeof(r_ops[0])))];
+        uint8_t rs1 = pick_src(mix);
+        uint8_t rs2 = pick_src(mix);
+        emit(op, rd, rs1, rs2, 0);
+    } else if (kind < 14u) {
+        rv32i_op_t op = i_ops[rnd_below((uint32_t)(sizeof(i_ops) / sizeof(i_ops[0])))];
+        int32_t imm = (op >= RV32I_OP_SLLI) ? (int32_t)rnd_below(32u) : rnd_imm12();
+        emit(op, rd, pick_src(mix), 0, imm);
+    } else {
+        emit(RV32I_OP_LUI, rd, 0, 0, (int32_t)(rnd() & 0xFFFFF000u));
+    }
+}
+
+static void emit_load(uint8_t rd) {
+    static const rv32i_op_t ops[] = {
+        RV32I_OP_LB, RV32I_OP_LH, RV32I_OP_LW, RV32I_OP_LBU, RV32I_OP_LHU,
+    };
+    rv32i_op_t op = ops[rnd_below(5u)];
+    uint32_t align = (op == RV32I_OP_LW) ? 4u : (op == RV32I_OP_LH || op == RV32I_OP_LHU) ? 2u : 1u;
+    uint32_t off = rnd_below(SCRATCH_WORDS * 4u) & ~(align - 1u);
+    emit(op, rd, BASE_REG, 0, (int32_t)off);
+}
+
+static void emit_store(const mix_t *mix) {
+    static const rv32i_op_t ops[] = { RV32I_OP_SB, RV32I_OP_SH, RV32I_OP_SW };
+    rv32i_op_t op = ops[rnd_below(3u)];
+    uint32_t align = (op == RV32I_OP_SW) ? 4u : (op == RV32I_OP_SH) ? 2u : 1u;
+    uint32_t off = rnd_below(SCRATCH_WORDS * 4u) & ~(align - 1u);
+    emit(op, 0, BASE_REG, pick_src(mix), (int32_t)off);
+}
+
+static void emit_fillers(const mix_t *mix, uint32_t k) {
+    for (uint32_t i = 0; i < k; ++i) {
+        emit_alu(mix, rnd_pool());
+    }
+}
+
+/*
+ * PC-relative fragments. Each leaves only link-address-independent values
+ * behind: PC values are subtracted from each other, and the register left
+ * holding a raw PC is masked down to its (always zero) low bits.
+ */
+static void emit_jump_fragment(const mix_t *mix) {
+    uint8_t ra = rnd_pool();
+    uint8_t rb = rnd_pool();
+    uint8_t rd = pick_rd();
+    uint32_t k = 1u + rnd_below(3u);
+    uint32_t at;
+
+    while (rb == ra) {
+        rb = rnd_pool();
+    }
+    switch (rnd_below(3u)) {
+    case 0:
+        /* auipc pair: ra = 4 + ((i2 - i1) << 12) */
+        emit(RV32I_OP_AUIPC, ra, 0, 0, (int32_t)(rnd() & 0xFFFFF000u));
+        emit(RV32I_OP_AUIPC, rb, 0, 0, (int32_t)(rnd() & 0xFFFFF000u));
+        emit(RV32I_OP_SUB, ra, rb, ra, 0);
+        emit(RV32I_OP_ANDI, rb, rb, 0, 3);
+        break;
+    case 1:
+        /* jal over k dead instructions: rd = 4 * k */
+        at = n_body;
+        emit(RV32I_OP_JAL, rd, 0, 0, (int32_t)(4u * (k + 1u)));
+        body[at].target = (int32_t)(at + k + 1u);
+        emit_fillers(mix, k);
+        emit(RV32I_OP_AUIPC, ra, 0, 0, 0);
+        emit(RV32I_OP_SUB, rd, ra, rd, 0);
+        emit(RV32I_OP_ANDI, ra, ra, 0, 3);
+        break;
+    default:
+        /* jalr through auipc over k dead instructions: rd = 8 (0 if rd == ra) */
+        emit(RV32I_OP_AUIPC, ra, 0, 0, 0);
+        emit(RV32I_OP_JALR, rd, ra, 0, (int32_t)(8u + 4u * k));
+        emit_fillers(mix, k);
+        emit(RV32I_OP_SUB, rd, rd, ra, 0);
+        emit(RV32I_OP_ANDI, ra, ra, 0, 3);
+        break;
+    }
+}
+
+static void build_body(const mix_t *mix, uint32_t count) {
+    static const rv32i_op_t br_ops[] = {
+        RV32I_OP_BEQ, RV32I_OP_BNE, RV32I_OP_BLT, RV32I_OP_BGE, RV32I_OP_BLTU, RV32I_OP_BGEU,
+    };
+
+    n_body = 0;
+    n_units = 0;
+    while (n_body < count) {
+        uint32_t roll = rnd_below(100u);
+        uint32_t cut = 0;
+
+        unit_start[n_units++] = (int32_t)n_body;
+        if (roll < (cut += mix->branch)) {
+            item_t *it;
+            rv32i_op_t op = br_ops[rnd_below(6u)];
+            uint8_t rs1 = pick_src(mix);
+            uint8_t rs2 = chance(30u) ? rs1 : pick_src(mix);
+            emit(op, 0, rs1, rs2, 0);
+            it = &body[n_body - 1u];
+            it->target_unit = (int32_t)(n_units + rnd_below(4u));
+        } else if (roll < (cut += mix->load_use)) {
+            static const rv32i_op_t use_ops[] = {
+                RV32I_OP_ADD, RV32I_OP_SUB, RV32I_OP_XOR, RV32I_OP_SLTU, RV32I_OP_SRA,
+            };
+            uint8_t rd = rnd_pool();
+            emit_load(rd);
+            emit(use_ops[rnd_below(5u)], pick_rd(), rd, pick_src(mix), 0);
+        } else if (roll < (cut += mix->mem)) {
+            if (chance(50u)) {
+                emit_load(pick_rd());
+            } else {
+                emit_store(mix);
+            }
+        } else if (roll < (cut += mix->jump)) {
+            emit_jump_fragment(mix);
+        } else {
+            emit_alu(mix, pick_rd());
+        }
+    }
+
+    /* Resolve forward branch targets to instruction indices. */
+    memset(is_target, 0, sizeof(is_target));
+    for (uint32_t i = 0; i < n_body; ++i) {
+        item_t *it = &body[i];
+        if (it->target_unit >= 0) {
+            it->target = ((uint32_t)it->target_unit < n_units) ?
+                         unit_start[it->target_unit] : (int32_t)n_body;
+            it->in.imm = (it->target - (int32_t)i) * 4;
+        }
+        if (it->target >= 0) {
+            is_target[it->target] = 1;
+        }
+    }
+}
+
+/* ---------- reference run ---------- */
+
+static int reads_rs1(rv32i_op_t op) {
+    rv32i_fmt_t f = rv32i_format_of(op);
+    return f == RV32I_FMT_R || f == RV32I_FMT_I || f == RV32I_FMT_S || f == RV32I_FMT_B;
+}
+
+static int reads_rs2(rv32i_op_t op) {
+    rv32i_fmt_t f = rv32i_format_of(op);
+    return f == RV32I_FMT_R || f == RV32I_FMT_S || f == RV32I_FMT_B;
+}
+
+static int is_load(rv32i_op_t op) {
+    return op >= RV32I_OP_LB && op <= RV32I_OP_LHU;
+}
+
+static int reads_reg(const rv32i_insn_t *in, uint8_t r) {
+    return r != 0u && ((reads_rs1(in->op) && in->rs1 == r) || (reads_rs2(in->op) && in->rs2 == r));
+}
+
+static int run_model(stats_t *st) {
+    static uint8_t ram[MODEL_RAM_SIZE];
+    rv32i_cpu_t cpu;
+    rv32i_retire_t ret;
+    uint32_t end = n_body * 4u;
+    uint8_t prev_rd[2] = { 0, 0 };
+    int prev_load = 0;
+
+    memset(ram, 0, sizeof(ram));
+    for (uint32_t i = 0; i < n_body; ++i) {
+        uint32_t w = rv32i_encode(&body[i].in);
+        memcpy(ram + 4u * i, &w, 4u);
+    }
+    for (uint32_t i = 0; i < SCRATCH_WORDS; ++i) {
+        memcpy(ram + MODEL_SCRATCH + 4u * i, &scratch_init[i], 4u);
+    }
+
+    rv32i_init(&cpu, ram, 0u, MODEL_RAM_SIZE);
+    memcpy(cpu.x, init_regs, sizeof(cpu.x));
+    cpu.x[BASE_REG] = MODEL_SCRATCH;
+
+    while (cpu.pc != end) {
+        rv32i_status_t s = rv32i_step(&cpu, &ret);
+        if (s != RV32I_OK) {
+            fprintf(stderr, "rvgen: reference model stopped at pc 0x%08" PRIx32 " (%s, status %d)\n",
+                    cpu.pc, rv32i_op_name(ret.dec.op), (int)s);
+            return 1;
+        }
+        if (cpu.instret > 16u * MAX_BODY) {
+            fprintf(stderr, "rvgen: body did not terminate\n");
+            return 1;
+        }
+        st->executed++;
+        if (reads_reg(&ret.dec, prev_rd[0])) {
+            st->raw1++;
+            st->load_use += (uint64_t)prev_load;
+        } else if (reads_reg(&ret.dec, prev_rd[1])) {
+            st->raw2++;
+        }
+        if (rv32i_format_of(ret.dec.op) == RV32I_FMT_B) {
+            st->branches++;
+            st->taken += ret.taken;
+        }
+        st->loads += (ret.mem_op == 1u);
+        st->stores += (ret.mem_op == 2u);
+        prev_rd[1] = prev_rd[0];
+        prev_rd[0] = ret.rd;
+        prev_load = is_load(ret.dec.op);
+    }
+
+    for (uint32_t i = 0; i < SCRATCH_WORDS; ++i) {
+        memcpy(&expected[i], ram + MODEL_SCRATCH + 4u * i, 4u);
+    }
+    for (uint32_t i = 0; i < POOL_SIZE; ++i) {
+        expected[SCRATCH_WORDS + pool[i]] = cpu.x[pool[i]];
+    }
+    return 0;
+}
+
+static void static_stats(stats_t *st) {
+    for (uint32_t i = 0; i < n_body; ++i) {
+        if (rv32i_format_of(body[i].in.op) != RV32I_FMT_B) {
+            continue;
+        }
+        st->static_branches++;
+        for (int32_t j = (int32_t)i + 1; j < body[i].target; ++j) {
+            if (rv32i_format_of(body[j].in.op) == RV32I_FMT_B) {
+                st->branch_over_branch++;
+                break;
+            }
+        }
+    }
+}
+
+/* ---------- output ---------- */
+
+static void print_insn(FILE *out, const item_t *it) {
+    const rv32i_insn_t *in = &it->in;
+    const char *op = rv32i_op_name(in->op);
+
+    switch (rv32i_format_of(in->op)) {
+    case RV32I_FMT_R:
+        fprintf(out, "    %-6s %s, %s, %s\n", op, rv32i_reg_name(in->rd),
+                rv32i_reg_name(in->rs1), rv32i_reg_name(in->rs2));
+        break;
+    case RV32I_FMT_I:
+        if (is_load(in->op) || in->op == RV32I_OP_JALR) {
+            fprintf(out, "    %-6s %s, %" PRId32 "(%s)\n", op, rv32i_reg_name(in->rd),
+                    in->imm, rv32i_reg_name(in->rs1));
+        } else {
+            fprintf(out, "    %-6s %s, %s, %" PRId32 "\n", op, rv32i_reg_name(in->rd),
+                    rv32i_reg_name(in->rs1), in->imm);
+        }
+        break;
+    case RV32I_FMT_S:
+        fprintf(out, "    %-6s %s, %" PRId32 "(%s)\n", op, rv32i_reg_name(in->rs2),
+                in->imm, rv32i_reg_name(in->rs1));
+        break;
+    case RV32I_FMT_B:
+        fprintf(out, "    %-6s %s, %s, .Li%" PRId32 "\n", op, rv32i_reg_name(in->rs1),
+                rv32i_reg_name(in->rs2), it->target);
+        break;
+    case RV32I_FMT_U:
+        fprintf(out, "    %-6s %s, 0x%" PRIx32 "\n", op, rv32i_reg_name(in->rd),
+                (uint32_t)in->imm >> 12);
+        break;
+    case RV32I_FMT_J:
+        fprintf(out, "    %-6s %s, .Li%" PRId32 "\n", op, rv32i_reg_name(in->rd), it->target);
+        break;
+    default:
+        fprintf(out, "    %s\n", op);
+        break;
+    }
+}
+
+static void print_percent(FILE *out, const char *label, uint64_t num, uint64_t den) {
+    fprintf(out, " *   %-22s %8" PRIu64 "  (%" PRIu64 ".%" PRIu64 "%%)\n", label, num,
+            den ? (num * 100u) / den : 0u, den ? ((num * 1000u) / den) % 10u : 0u);
+}
+
+static void write_program(FILE *out, uint64_t seed, uint32_t count, const mix_t *mix,
+                          const stats_t *st) {
+    /* ra, s0..s11 saved; frame rounded up to 16 bytes */
+    static const uint8_t saved[] = { 1, 8, 9, 18, 19, 20, 21, 22, 23, 24, 25, 26, 27 };
+    const uint32_t frame = 64u;
+
+    fprintf(out, "/*\n");
+    fprintf(out, " * Generated by tools/rvgen -- do not edit.\n");
+    fprintf(out, " *   tools/rvgen --seed %" PRIu64 " --count %" PRIu32
+                 " --dep %u --load-use %u --branch %u --mem %u --jump %u\n",
+            seed, count, mix->dep, mix->load_use, mix->branch, mix->mem, mix->jump);
+    fprintf(out, " *\n");
+    fprintf(out, " * Body: %" PRIu32 " instructions, %" PRIu64 " executed by the reference model\n",
+            n_body, st->executed);
+    print_percent(out, "RAW distance 1", st->raw1, st->executed);
+    print_percent(out, "RAW distance 2", st->raw2, st->executed);
+    print_percent(out, "load-use", st->load_use, st->executed);
+    print_percent(out, "loads", st->loads, st->executed);
+    print_percent(out, "stores", st->stores, st->executed);
+    print_percent(out, "branches", st->branches, st->executed);
+    print_percent(out, "taken branches", st->taken, st->branches);
+    fprintf(out, " *   %-22s %8" PRIu32 " of %" PRIu32 " static branches\n",
+            "branch over branch", st->branch_over_branch, st->static_branches);
+    fprintf(out, " *\n");
+    fprintf(out, " * Pass: test_result == 0. On failure fail_index is the first bad\n");
+    fprintf(out, " * signature word: 0..%u scratch, %u + N register xN.\n",
+            SCRATCH_WORDS - 1u, SCRATCH_WORDS);
+    fprintf(out, " */\n\n");
+
+    fprintf(out, "    .section .text\n");
+    fprintf(out, "    .globl main\n");
+    fprintf(out, "    .balign 4\n");
+    fprintf(out, "main:\n");
+    fprintf(out, "    addi   sp, sp, -%" PRIu32 "\n", frame);
+    for (uint32_t i = 0; i < sizeof(saved); ++i) {
+        fprintf(out, "    sw     %s, %" PRIu32 "(sp)\n", rv32i_reg_name(saved[i]),
+                frame - 4u * (i + 1u));
+    }
+    fprintf(out, "    la     s0, rvgen_scratch\n");
+    for (uint32_t i = 0; i < POOL_SIZE; ++i) {
+        fprintf(out, "    li     %s, 0x%08" PRIx32 "\n", rv32i_reg_name(pool[i]), init_regs[pool[i]]);
+    }
+
+    fprintf(out, "\n    .globl rvgen_body\n");
+    fprintf(out, "rvgen_body:\n");
+    for (uint32_t i = 0; i < n_body; ++i) {
+        if (is_target[i]) {
+            fprintf(out, ".Li%" PRIu32 ":\n", i);
+        }
+        print_insn(out, &body[i]);
+    }
+    fprintf(out, ".Li%" PRIu32 ":\n", n_body);
+    fprintf(out, "    .globl rvgen_body_end\n");
+    fprintf(out, "rvgen_body_end:\n\n");
+
+    fprintf(out, "    /* register signature */\n");
+    for (uint32_t i = 0; i < POOL_SIZE; ++i) {
+        fprintf(out, "    sw     %s, %u(s0)\n", rv32i_reg_name(pool[i]), REGS_OFFSET + 4u * pool[i]);
+    }
+
+    fprintf(out, "\n    /* compare scratch + registers against rvgen_expected */\n");
+    fprintf(out, "    mv     t0, s0\n");
+    fprintf(out, "    la     t1, rvgen_expected\n");
+    fprintf(out, "    li     t2, 0\n");
+    fprintf(out, "    li     t3, 0\n");
+    fprintf(out, "    li     t4, 0\n");
+    fprintf(out, "    li     t5, -1\n");
+    fprintf(out, "    li     t6, %u\n", SIG_WORDS);
+    fprintf(out, "1:\n");
+    fprintf(out, "    lw     a1, 0(t0)\n");
+    fprintf(out, "    lw     a2, 0(t1)\n");
+    fprintf(out, "    beq    a1, a2, 2f\n");
+    fprintf(out, "    addi   t4, t4, 1\n");
+    fprintf(out, "    bgez   t5, 3f\n");
+    fprintf(out, "    mv     t5, t2\n");
+    fprintf(out, "    j      3f\n");
+    fprintf(out, "2:\n");
+    fprintf(out, "    addi   t3, t3, 1\n");
+    fprintf(out, "3:\n");
+    fprintf(out, "    addi   t0, t0, 4\n");
+    fprintf(out, "    addi   t1, t1, 4\n");
+    fprintf(out, "    addi   t2, t2, 1\n");
+    fprintf(out, "    blt    t2, t6, 1b\n");
+    fprintf(out, "    la     a3, test_passed\n");
+    fprintf(out, "    sw     t3, 0(a3)\n");
+    fprintf(out, "    la     a3, test_failed\n");
+    fprintf(out, "    sw     t4, 0(a3)\n");
+    fprintf(out, "    la     a3, fail_index\n");
+    fprintf(out, "    sw     t5, 0(a3)\n");
+    fprintf(out, "    snez   a0, t4\n");
+    fprintf(out, "    la     a3, test_result\n");
+    fprintf(out, "    sw     a0, 0(a3)\n\n");
+    for (uint32_t i = 0; i < sizeof(saved); ++i) {
+        fprintf(out, "    lw     %s, %" PRIu32 "(sp)\n", rv32i_reg_name(saved[i]),
+                frame - 4u * (i + 1u));
+    }
+    fprintf(out, "    addi   sp, sp, %" PRIu32 "\n", frame);
+    fprintf(out, "    ret\n\n");
+
+    fprintf(out, "    .section .data\n");
+    fprintf(out, "    .balign 4\n");
+    fprintf(out, "    .globl test_result, test_passed, test_failed, fail_index\n");
+    fprintf(out, "test_result: .word 0\n");
+    fprintf(out, "test_passed: .word 0\n");
+    fprintf(out, "test_failed: .word 0\n");
+    fprintf(out, "fail_index:  .word -1\n");
+    fprintf(out, "    .globl rvgen_scratch, rvgen_regs\n");
+    fprintf(out, "rvgen_scratch:\n");
+    for (uint32_t i = 0; i < SCRATCH_WORDS; i += 4u) {
+        fprintf(out, "    .word  0x%08" PRIx32 ", 0x%08" PRIx32 ", 0x%08" PRIx32 ", 0x%08" PRIx32 "\n",
+                scratch_init[i], scratch_init[i + 1u], scratch_init[i + 2u], scratch_init[i + 3u]);
+    }
+    fprintf(out, "rvgen_regs:\n");
+    fprintf(out, "    .space %u\n\n", REG_SLOTS * 4u);
+
+    fprintf(out, "    .section .rodata\n");
+    fprintf(out, "    .balign 4\n");
+    fprintf(out, "    .globl rvgen_expected\n");
+    fprintf(out, "rvgen_expected:\n");
+    for (uint32_t i = 0; i < SIG_WORDS; i += 4u) {
+        fprintf(out, "    .word  0x%08" PRIx32 ", 0x%08" PRIx32 ", 0x%08" PRIx32 ", 0x%08" PRIx32 "\n",
+                expected[i], expected[i + 1u], expected[i + 2u], expected[i + 3u]);
+    }
+}
+
+static void usage(const char *argv0) {
+    fprintf(stderr,
+            "usage: %s [--seed N] [--count N] [--dep P] [--load-use P] [--branch P]\n"
+            "       [--mem P] [--jump P] [-o out.S]\n"
+            "  P are percentages; load-use + branch + mem + jump must not exceed 100\n",
+            argv0);
+}
+
+static int parse_percent(const char *s, unsigned *out) {
+    char *end;
+    unsigned long v = strtoul(s, &end, 0);
+    if (*end != '\0' || v > 100u) {
+        return 1;
+    }
+    *out = (unsigned)v;
+    return 0;
+}
+
+int main(int argc, char **argv) {
+    mix_t mix = { 60u, 10u, 12u, 15u, 4u };
+    uint64_t seed = 1;
+    uint32_t count = 1000;
+    const char *out_path = NULL;
+    stats_t st;
+    FILE *out = stdout;
+
+    for (int i = 1; i < argc; ++i) {
+        int bad = 0;
+        if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc) {
+            seed = strtoull(argv[++i], NULL, 0);
+        } else if (strcmp(argv[i], "--count") == 0 && i + 1 < argc) {
+            count = (uint32_t)strtoul(argv[++i], NULL, 0);
+        } else if (strcmp(argv[i], "--dep") == 0 && i + 1 < argc) {
+            bad = parse_percent(argv[++i], &mix.dep);
+        } else if (strcmp(argv[i], "--load-use") == 0 && i + 1 < argc) {
+            bad = parse_percent(argv[++i], &mix.load_use);
+        } else if (strcmp(argv[i], "--branch") == 0 && i + 1 < argc) {
+            bad = parse_percent(argv[++i], &mix.branch);
+        } else if (strcmp(argv[i], "--mem") == 0 && i + 1 < argc) {
+            bad = parse_percent(argv[++i], &mix.mem);
+        } else if (strcmp(argv[i], "--jump") == 0 && i + 1 < argc) {
+            bad = parse_percent(argv[++i], &mix.jump);
+        } else if (strcmp(argv[i], "-o") == 0 && i + 1 < argc) {
+            out_path = argv[++i];
+        } else {
+            bad = 1;
+        }
+        if (bad) {
+            usage(argv[0]);
+            return 2;
+        }
+    }
+    if (mix.load_use + mix.branch + mix.mem + mix.jump > 100u || count == 0u || count > MAX_BODY) {
+        usage(argv[0]);
+        fprintf(stderr, "  --count must be 1..%u\n", MAX_BODY);
+        return 2;
+    }
+
+    rng_state = (seed ^ 0x9E3779B97F4A7C15ULL) | 1u;
+    memset(init_regs, 0, sizeof(init_regs));
+    for (uint32_t i = 0; i < POOL_SIZE; ++i) {
+        init_regs[pool[i]] = rnd_value();
+    }
+    for (uint32_t i = 0; i < SCRATCH_WORDS; ++i) {
+        scratch_init[i] = rnd_value();
+    }
+    memset(expected, 0, sizeof(expected));
+    memset(&st, 0, sizeof(st));
+
+    build_body(&mix, count);
+    if (run_model(&st) != 0) {
+        return 1;
+    }
+    static_stats(&st);
+
+    if (out_path != NULL) {
+        out = fopen(out_path, "w");
+        if (out == NULL) {
+            perror(out_path);
+            return 1;
+        }
+    }
+    write_program(out, seed, count, &mix, &st);
+    if (out != stdout && fclose(out) != 0) {
+        perror(out_path);
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,1429 @@
+/*
+ * Host simulator for Spellbook programs.
+ *
+ * Runs $(PROGRAM).elf (or a raw .bin linked at the RAM base) on the RV32I
+ * reference model with the VGA frame buffers and scanout timing modelled
+ * in vga_model.c, and reports whether the program's drawing and swap
+ * pacing would tear on the real display.
+ *
+ * Cycle model: one cycle per instruction, plus --load-use cycles when an
+ * instruction reads the destination of the load right before it, plus
+ * --branch-penalty cycles for every taken branch or jump. Cycles convert
+ * to beam position through --cpu-hz (default 5 MHz).
+ *
+ * Counters: the Zicntr CSRs read from this model, so programs that time
+ * themselves with rdcycle/csrr run unchanged. cycle and instret are the
+ * totals above, time ticks at --time-hz (default: the CPU clock), and
+ * hpmcounter3..8 count loads, stores, MMIO stores, taken branches/jumps,
+ * stall cycles (load-use plus branch penalty) and MMIO bytes stored. The
+ * *h halves, the mcycle/minstret/mhpmcounter aliases and mhpmevent3..8
+ * (event ids 1..6) are there too; the machine counters are writable, the rest of the hpm
+ * counters read as zero.
+ *
+ * The run ends when the program spins on a jump-to-self (the end of
+ * main's for (;;) or boot.S after main returns), on ecall/ebreak, after
+ * --max-cycles, or after --frames frames have reached the screen.
+ *
+ * Output threads: the simulating thread only appends records to pipes
+ * (sim_pipe.h) -- every load/store for --trace, a copy of each shown frame
+ * for --frame-csv/--frame-dir, a (pc, cycles) sample per instruction for
+ * --profile -- and one worker thread per pipe encodes the trace, hashes
+ * and writes the frames and aggregates the profile. The files are the same
+ * with --no-threads, which runs those consumers on the simulating thread;
+ * that is also the default when only one CPU is online, where the hand-off
+ * costs more than it saves.
+ *
+ * Hot reload: --snapshot-at SYM (or --snapshot-after SYM, when SYM first
+ * returns) saves the machine -- registers, RAM, scanout and DMA state,
+ * counters, and how far each output file got -- the first time execution
+ * reaches SYM. With --watch the simulator then waits for the ELF to be
+ * rebuilt, and compares the new image with the old one byte by byte. If
+ * no changed byte was fetched or loaded before the snapshot, the run
+ * before it would have been the same, so the changed bytes it did not
+ * store to are patched into the snapshot and the run resumes there: the
+ * outputs are cut back to the snapshot and regenerated from it (frames,
+ * CSV, trace, profile, report). Anything else (a changed byte used before
+ * the snapshot, a moved symbol or entry point, no snapshot yet) restarts
+ * from the entry point. Blit-engine copies out of RAM are not tracked.
+ *
+ * Usage:
+ *   tools/rvsim [options] program.elf|program.bin
+ *     --cpu-hz N            CPU clock (default 5000000)
+ *     --time-hz N           rate of the time CSR (default: --cpu-hz)
+ *     --latch immediate|vblank
+ *                           when a swap reaches the display (default immediate)
+ *     --max-cycles N        stop after N cycles (default 100000000, 0 = no limit)
+ *     --frames N            stop once N swapped frames have been shown
+ *     --load-use N          load-use stall cycles (default 1)
+ *     --branch-penalty N    taken branch/jump cycles (default 2)
+ *     --ram-base A --ram-size N   main RAM (default 0x0, 0x8000)
+ *     --param NAME=VALUE    patch a load-time parameter (params.h, repeatable)
+ *     --events N            print the first N hazard events (default 10)
+ *     --frame-csv FILE      one line per swapped frame (with a hash of the shown pixels)
+ *     --frame-dir DIR       write every shown frame as DIR/frame_NNNNN.ppm (NNNNN = seq)
+ *     --trace FILE          every load and store, in the MLOGBIN1 format (memlog_format.h)
+ *     --ppm FILE            dump the displayed buffer at exit
+ *     --print SYM           print the word at SYM at exit (repeatable)
+ *     --profile FILE        cycles, instructions and calls per function (ELF only)
+ *     --bench-out FILE      write the benchmark table (bench_table.h) as CSV at exit
+ *     --dma                 model the blit/fill engine at 0x1004_0000 (vga_dma.h)
+ *     --dma-bw N            engine bytes per cycle (default 4)
+ *     --dma-latency N       cycles from a command reaching the engine to its first row (default 8)
+ *     --dma-fifo N          commands queued before a CTRL write stalls the CPU (default 4)
+ *     --fail-on-tear        exit 3 if any mid-frame swap or store ahead of the beam
+ *     --no-threads          write the trace, frames and profile on the simulating thread
+ *     --snapshot-at SYM     save the machine when execution first reaches SYM (ELF only)
+ *     --snapshot-after SYM  save it when SYM first returns instead
+ *     --watch               after the run, rerun whenever the ELF changes, from the snapshot if still valid
+ *     -v                    print every frame report
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <inttypes.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "bench_results.h"
+#include "elf32.h"
+#include "memlog_format.h"
+#include "params_image.h"
+#include "rv32i_model.h"
+#include "sim_pipe.h"
+#include "vga_dma.h"
+#include "vga_model.h"
+
+#define MAX_PRINT_SYMS  16
+#define MAX_PARAMS      32
+
+/* Pipe chunks: records per chunk trade hand-off cost against latency */
+#define TRACE_CHUNK     (64u * 1024u)
+#define PROF_CHUNK      (64u * 1024u)
+#define PIPE_CHUNKS     16u
+#define FRAME_CHUNKS    8u
+
+/* Visible pixels of one buffer, 3 planes of VGA_MODEL_ROWS packed rows */
+#define FRAME_PIXEL_BYTES   (3u * VGA_MODEL_ROWS * VGA_MODEL_ROW_BYTES)
+
+/* sim_t.ram_use: what the run before the snapshot did to each RAM byte */
+#define USE_READ        1u      /* fetched or loaded */
+#define USE_WRITTEN     2u
+
+#define WATCH_POLL_NS   100000000L
+
+/* CSR numbers (counter index in bits 4:0) */
+#define CSR_MCOUNTINHIBIT   0x320u  /* followed by mhpmevent3..31 */
+#define CSR_MCYCLE          0xB00u
+#define CSR_MCYCLEH         0xB80u
+#define CSR_CYCLE           0xC00u
+#define CSR_CYCLEH          0xC80u
+
+enum {
+    CTR_CYCLE = 0,
+    CTR_TIME = 1,
+    CTR_INSTRET = 2,
+    CTR_LOADS = 3,          /* hpmcounter3..8, mhpmevent value = index - 2 */
+    CTR_STORES,
+    CTR_MMIO_STORES,
+    CTR_TAKEN,
+    CTR_STALL_CYCLES,
+    CTR_MMIO_BYTES,
+    CTR_COUNT
+};
+
+typedef struct {
+    const char *name;
+    uint32_t start;
+    uint32_t size;
+    uint64_t cycles;
+    uint64_t insns;
+    uint64_t calls;
+} prof_fn_t;
+
+typedef struct {
+    uint32_t pc;
+    uint32_t cost;
+} prof_sample_t;
+
+/* Frame pipe record; FRAME_PIXEL_BYTES of pixels follow shown frames */
+typedef struct {
+    vga_frame_report_t report;
+    uint32_t has_pixels;
+    uint32_t pad;
+    uint8_t pixels[];
+} frame_rec_t;
+
+typedef struct {
+    /* configuration */
+    uint32_t ram_base;
+    uint32_t ram_size;
+    vga_latch_t latch;
+    uint32_t dma_bw;
+    uint32_t dma_latency;
+    uint32_t dma_fifo;
+    uint32_t cpu_hz;
+    uint32_t time_hz;
+    uint64_t max_cycles;
+    uint64_t max_frames;
+    uint32_t load_use_cycles;
+    uint32_t branch_cycles;
+    unsigned max_events;
+    int verbose;
+
+    rv32i_cpu_t cpu;
+    vga_model_t vga;
+    vga_dma_t dma;
+    int dma_enabled;
+    uint64_t cycle;
+    uint32_t bus_stall;                 /* extra cycles for the current access (full DMA FIFO) */
+    unsigned last_load_rd;              /* across run() calls, for the snapshot */
+
+    uint64_t load_use_stalls;
+    uint64_t taken;
+    uint64_t loads;
+    uint64_t stores;
+    uint64_t mmio_stores;
+    uint64_t mmio_bytes;
+    uint64_t stall_cycles;
+    uint64_t ctr_offset[CTR_COUNT];     /* set by writes to the machine counters */
+    unsigned events_printed;
+
+    /* Output pipes; each consumer's state is only touched by its worker until the pipe closes */
+    int threaded;
+    int tracing;
+    int framing;
+    sim_pipe_t trace_pipe;
+    sim_pipe_t frame_pipe;
+    sim_pipe_t prof_pipe;
+    FILE *trace;
+    memlog_codec_t codec;
+    uint64_t trace_bytes;
+    FILE *frame_csv;
+    const char *frame_dir;
+    uint64_t frames_written;
+    uint64_t frame_errors;
+    uint64_t frame_seq_end;             /* 1 + last frame seq consumed */
+    long csv_start;                     /* after the header */
+
+    /* --snapshot-at / --snapshot-after */
+    int before_snap;                    /* still looking for the snapshot point */
+    int snap_after;
+    int snap_returning;                 /* --snapshot-after: SYM was entered, waiting for the return */
+    uint32_t snap_sym;
+    uint32_t snap_pc;                   /* pc to stop at: SYM, then its return address */
+    uint32_t snap_sp;
+    uint8_t *ram_use;                   /* USE_* per RAM byte */
+
+    /* --profile: function table and RAM word -> function index + 1 */
+    prof_fn_t *fns;
+    uint32_t fn_count;
+    uint32_t *fn_of_word;
+} sim_t;
+
+/* The machine at the snapshot point, and the consumers' state there */
+typedef struct {
+    int valid;
+    rv32i_cpu_t cpu;
+    vga_model_t vga;
+    vga_dma_t dma;
+    uint64_t cycle;
+    unsigned last_load_rd;
+    uint64_t load_use_stalls;
+    uint64_t taken;
+    uint64_t loads;
+    uint64_t stores;
+    uint64_t mmio_stores;
+    uint64_t mmio_bytes;
+    uint64_t stall_cycles;
+    uint64_t ctr_offset[CTR_COUNT];
+    unsigned events_printed;
+    uint8_t *ram;
+
+    long trace_pos;
+    memlog_codec_t codec;
+    uint64_t trace_bytes;
+    long csv_pos;
+    uint64_t frames_written;
+    uint64_t frame_errors;
+    uint64_t frame_seq_end;
+    prof_fn_t *fns;                     /* names not kept: matched by start address */
+    uint32_t fn_count;
+} snapshot_t;
+
+static sim_t sim;
+static snapshot_t snap;
+static uint8_t *ram;
+static uint8_t *image;                  /* the program as loaded, parameters applied */
+
+static double to_ms(const sim_t *s, uint64_t cycles) {
+    return (double)cycles * 1000.0 / (double)s->cpu_hz;
+}
+
+static int bus_load(void *ctx, uint32_t addr, uint32_t size, uint32_t *value) {
+    sim_t *s = ctx;
+    if (s->dma_enabled) {
+        if (vga_dma_load(&s->dma, s->cycle, addr, size, value) == 0) {
+            return 0;
+        }
+        vga_dma_advance(&s->dma, s->cycle);
+    }
+    return vga_model_load(&s->vga, addr, size, value) != 0;
+}
+
+static int bus_store(void *ctx, uint32_t addr, uint32_t size, uint32_t value) {
+    sim_t *s = ctx;
+    if (s->dma_enabled) {
+        if (vga_dma_store(&s->dma, s->cycle, addr, size, value, &s->bus_stall) == 0) {
+            return 0;
+        }
+        // Rows the engine finished earlier land before this store
+        vga_dma_advance(&s->dma, s->cycle);
+    }
+    return vga_model_store(&s->vga, s->cycle, addr, size, value) != 0;
+}
+
+static uint64_t counter_raw(const sim_t *s, unsigned i) {
+    switch (i) {
+    case CTR_CYCLE:        return s->cycle;
+    case CTR_TIME:         return s->cycle / s->cpu_hz * s->time_hz + s->cycle % s->cpu_hz * s->time_hz / s->cpu_hz;
+    case CTR_INSTRET:      return s->cpu.instret;
+    case CTR_LOADS:        return s->loads;
+    case CTR_STORES:       return s->stores;
+    case CTR_MMIO_STORES:  return s->mmio_stores;
+    case CTR_TAKEN:        return s->taken;
+    case CTR_STALL_CYCLES: return s->stall_cycles;
+    case CTR_MMIO_BYTES:   return s->mmio_bytes;
+    default:               return 0u;
+    }
+}
+
+static int csr_read(void *ctx, uint32_t csr, uint32_t *value) {
+    sim_t *s = ctx;
+    unsigned i = csr & 31u;
+    uint64_t v;
+
+    if ((csr & ~31u) == CSR_MCOUNTINHIBIT) {
+        *value = (csr == CSR_MCOUNTINHIBIT || i < CTR_LOADS || i >= CTR_COUNT) ? 0u : i - 2u;
+        return 0;
+    }
+    switch (csr & ~31u) {
+    case CSR_CYCLE: case CSR_CYCLEH: case CSR_MCYCLE: case CSR_MCYCLEH:
+        break;
+    default:
+        return 1;
+    }
+    if (i == CTR_TIME && (csr & 0xF00u) == CSR_MCYCLE) {
+        return 1;               /* there is no mtime CSR */
+    }
+    v = (i < CTR_COUNT) ? counter_raw(s, i) + s->ctr_offset[i] : 0u;
+    *value = (csr & 0x80u) ? (uint32_t)(v >> 32) : (uint32_t)v;
+    return 0;
+}
+
+/* Only reached for the machine range; the model rejects writes to 0xC00+. */
+static int csr_write(void *ctx, uint32_t csr, uint32_t value) {
+    sim_t *s = ctx;
+    unsigned i = csr & 31u;
+    uint64_t v;
+
+    if ((csr & ~31u) == CSR_MCOUNTINHIBIT) {
+        return 0;               /* events are fixed; mcountinhibit is not implemented */
+    }
+    if ((csr & ~0x9Fu) != CSR_MCYCLE || i == CTR_TIME) {
+        return 1;
+    }
+    if (i >= CTR_COUNT) {
+        return 0;               /* unimplemented counters are hard-wired to zero */
+    }
+    v = counter_raw(s, i) + s->ctr_offset[i];
+    v = (csr & 0x80u) ? ((uint64_t)value << 32) | (uint32_t)v : (v & ~(uint64_t)0xFFFFFFFFu) | value;
+    s->ctr_offset[i] = v - counter_raw(s, i);
+    return 0;
+}
+
+static void on_event(void *ctx, const vga_event_t *ev) {
+    sim_t *s = ctx;
+
+    if (s->events_printed >= s->max_events) {
+        return;
+    }
+    if (s->events_printed++ == 0u) {
+        printf("rvsim: hazards (first %u):\n", s->max_events);
+    }
+    printf("  [%10.3f ms refresh %" PRIu64 " line %3u] ", to_ms(s, ev->cycle), ev->refresh, ev->line);
+    switch (ev->kind) {
+    case VGA_EV_WRITE_DISPLAYED:
+        printf("store to displayed buffer 0x%08x (%s the beam)\n", ev->addr,
+               ev->ahead ? "ahead of" : "behind");
+        break;
+    case VGA_EV_SWAP_MID_FRAME:
+        printf("swap during active lines\n");
+        break;
+    case VGA_EV_SWAP_PENDING:
+        printf("swap while the previous swap waits for vblank\n");
+        break;
+    case VGA_EV_FRAME_DROPPED:
+        printf("frame replaced before it was scanned out\n");
+        break;
+    }
+}
+
+static void frame_snapshot(const vga_model_t *m, unsigned sel, uint8_t *out) {
+    for (unsigned p = 0; p < 3u; ++p) {
+        for (uint32_t y = 0; y < VGA_MODEL_ROWS; ++y) {
+            memcpy(out, &m->fb[sel & 1u][p][y * VGA_MODEL_ROW_STRIDE], VGA_MODEL_ROW_BYTES);
+            out += VGA_MODEL_ROW_BYTES;
+        }
+    }
+}
+
+static uint32_t frame_rec_bytes(uint32_t has_pixels) {
+    return ((uint32_t)sizeof(frame_rec_t) + (has_pixels ? FRAME_PIXEL_BYTES : 0u) + 7u) & ~7u;
+}
+
+static void on_frame(void *ctx, const vga_frame_report_t *fr) {
+    sim_t *s = ctx;
+    int dropped = fr->shown_at == VGA_MODEL_NEVER;
+
+    // The pixels as they first reach the screen; the workers do the rest
+    if (s->framing) {
+        frame_rec_t *r = sim_pipe_reserve(&s->frame_pipe, frame_rec_bytes(!dropped));
+        r->report = *fr;
+        r->has_pixels = !dropped;
+        if (!dropped) {
+            frame_snapshot(&s->vga, fr == &s->vga.buf[1].report, r->pixels);
+        }
+    }
+    if (!s->verbose) {
+        return;
+    }
+    if (dropped) {
+        printf("  frame %4" PRIu64 ": dropped (draw %.3f ms, %u stores)\n", fr->seq,
+               to_ms(s, fr->swap_at - fr->draw_start), fr->stores);
+    } else {
+        printf("  frame %4" PRIu64 ": refresh %" PRIu64 " line %3u  draw %8.3f ms  latency %8.3f ms  "
+               "slack %7.3f ms  stores %u  hazards %u\n",
+               fr->seq, fr->refresh, fr->start_line, to_ms(s, fr->swap_at - fr->draw_start),
+               to_ms(s, fr->shown_at - fr->draw_start), to_ms(s, fr->shown_at - fr->swap_at),
+               fr->stores, fr->hazards);
+    }
+}
+
+static int profile_init(sim_t *s, const elf32_file_t *elf) {
+    uint32_t base = s->ram_base;
+    uint32_t size = s->ram_size;
+    elf32_sym_t sym;
+
+    free(s->fns);
+    free(s->fn_of_word);
+    s->fn_count = 0;
+    s->fns = calloc(elf->symcount ? elf->symcount : 1u, sizeof(*s->fns));
+    s->fn_of_word = calloc(size / 4u, sizeof(*s->fn_of_word));
+    if (s->fns == NULL || s->fn_of_word == NULL) {
+        perror("calloc");
+        return -1;
+    }
+    for (uint32_t i = 1; elf32_symbol_at_index(elf, i, &sym) == 0; ++i) {
+        prof_fn_t *f;
+        if (sym.type != ELF32_STT_FUNC || sym.size == 0u || sym.value < base ||
+            sym.value - base > size - sym.size) {
+            continue;
+        }
+        f = &s->fns[s->fn_count++];
+        f->name = sym.name;
+        f->start = sym.value;
+        f->size = sym.size;
+        for (uint32_t w = (sym.value - base) / 4u; w < (sym.value - base + sym.size + 3u) / 4u; ++w) {
+            s->fn_of_word[w] = s->fn_count;
+        }
+    }
+    return 0;
+}
+
+static void profile_retire(sim_t *s, uint32_t pc, uint32_t cost) {
+    uint32_t idx = s->fn_of_word[(pc - s->ram_base) / 4u];
+
+    if (idx != 0u) {
+        prof_fn_t *f = &s->fns[idx - 1u];
+        f->cycles += cost;
+        f->insns++;
+        f->calls += pc == f->start;
+    }
+}
+
+static void prof_consume(void *ctx, const uint8_t *data, uint32_t bytes) {
+    const prof_sample_t *p = (const prof_sample_t *)(const void *)data;
+
+    for (uint32_t i = 0; i < bytes / (uint32_t)sizeof(*p); ++i) {
+        profile_retire(ctx, p[i].pc, p[i].cost);
+    }
+}
+
+static int by_cycles(const void *a, const void *b) {
+    const prof_fn_t *fa = a;
+    const prof_fn_t *fb = b;
+
+    if (fa->cycles != fb->cycles) {
+        return fa->cycles < fb->cycles ? 1 : -1;
+    }
+    return strcmp(fa->name, fb->name);
+}
+
+static int profile_write(const sim_t *s, const char *path, const char *program) {
+    // Sorted copy: fn_of_word indexes s->fns, and --watch keeps using it
+    prof_fn_t *fns = malloc((s->fn_count ? s->fn_count : 1u) * sizeof(*fns));
+    FILE *fp;
+    uint64_t in_fns = 0;
+
+    if (fns == NULL) {
+        perror("malloc");
+        return -1;
+    }
+    fp = fopen(path, "w");
+    if (fp == NULL) {
+        perror(path);
+        free(fns);
+        return -1;
+    }
+    memcpy(fns, s->fns, s->fn_count * sizeof(*fns));
+    qsort(fns, s->fn_count, sizeof(*fns), by_cycles);
+    for (uint32_t i = 0; i < s->fn_count; ++i) {
+        in_fns += fns[i].cycles;
+    }
+    fprintf(fp, "# rvsim profile of %s: %" PRIu64 " cycles, %" PRIu64 " in functions\n",
+            program, s->cycle, in_fns);
+    fprintf(fp, "# cycles insns calls size function\n");
+    for (uint32_t i = 0; i < s->fn_count; ++i) {
+        const prof_fn_t *f = &fns[i];
+        fprintf(fp, "%" PRIu64 " %" PRIu64 " %" PRIu64 " %u %s\n",
+                f->cycles, f->insns, f->calls, f->size, f->name);
+    }
+    free(fns);
+    return fclose(fp);
+}
+
+/* Wait until every worker is idle and the files hold everything so far */
+static void drain_outputs(sim_t *s) {
+    if (s->tracing) {
+        sim_pipe_drain(&s->trace_pipe);
+        fflush(s->trace);
+    }
+    if (s->framing) {
+        sim_pipe_drain(&s->frame_pipe);
+        if (s->frame_csv != NULL) {
+            fflush(s->frame_csv);
+        }
+    }
+    if (s->fn_of_word != NULL) {
+        sim_pipe_drain(&s->prof_pipe);
+    }
+}
+
+/* Cut a drained output file back to pos */
+static void truncate_output(FILE *fp, long pos) {
+    fflush(fp);
+    if (ftruncate(fileno(fp), (off_t)pos) != 0) {
+        perror("rvsim: ftruncate");
+    }
+    fseek(fp, pos, SEEK_SET);
+}
+
+static void snapshot_take(sim_t *s) {
+    drain_outputs(s);
+    snap.cpu = s->cpu;
+    snap.vga = s->vga;
+    snap.dma = s->dma;
+    snap.cycle = s->cycle;
+    snap.last_load_rd = s->last_load_rd;
+    snap.load_use_stalls = s->load_use_stalls;
+    snap.taken = s->taken;
+    snap.loads = s->loads;
+    snap.stores = s->stores;
+    snap.mmio_stores = s->mmio_stores;
+    snap.mmio_bytes = s->mmio_bytes;
+    snap.stall_cycles = s->stall_cycles;
+    memcpy(snap.ctr_offset, s->ctr_offset, sizeof(snap.ctr_offset));
+    snap.events_printed = s->events_printed;
+    memcpy(snap.ram, ram, s->ram_size);
+
+    snap.trace_pos = s->trace != NULL ? ftell(s->trace) : 0;
+    snap.codec = s->codec;
+    snap.trace_bytes = s->trace_bytes;
+    snap.csv_pos = s->frame_csv != NULL ? ftell(s->frame_csv) : 0;
+    snap.frames_written = s->frames_written;
+    snap.frame_errors = s->frame_errors;
+    snap.frame_seq_end = s->frame_seq_end;
+    free(snap.fns);
+    snap.fns = NULL;
+    snap.fn_count = 0;
+    if (s->fn_count != 0u) {
+        snap.fns = malloc(s->fn_count * sizeof(*snap.fns));
+        if (snap.fns != NULL) {
+            memcpy(snap.fns, s->fns, s->fn_count * sizeof(*snap.fns));
+            snap.fn_count = s->fn_count;
+        }
+    }
+    snap.valid = 1;
+    s->before_snap = 0;
+    printf("rvsim: snapshot at pc 0x%08x after %" PRIu64 " instructions, %" PRIu64 " cycles\n",
+           s->cpu.pc, s->cpu.instret, s->cycle);
+}
+
+/* Back to the snapshot; the profile table must already be built for the current ELF */
+static void snapshot_restore(sim_t *s) {
+    s->cpu = snap.cpu;
+    s->vga = snap.vga;
+    s->dma = snap.dma;
+    s->cycle = snap.cycle;
+    s->bus_stall = 0u;
+    s->last_load_rd = snap.last_load_rd;
+    s->load_use_stalls = snap.load_use_stalls;
+    s->taken = snap.taken;
+    s->loads = snap.loads;
+    s->stores = snap.stores;
+    s->mmio_stores = snap.mmio_stores;
+    s->mmio_bytes = snap.mmio_bytes;
+    s->stall_cycles = snap.stall_cycles;
+    memcpy(s->ctr_offset, snap.ctr_offset, sizeof(s->ctr_offset));
+    s->events_printed = snap.events_printed;
+    memcpy(ram, snap.ram, s->ram_size);
+    s->before_snap = 0;
+
+    if (s->trace != NULL) {
+        truncate_output(s->trace, snap.trace_pos);
+    }
+    s->codec = snap.codec;
+    s->trace_bytes = snap.trace_bytes;
+    if (s->frame_csv != NULL) {
+        truncate_output(s->frame_csv, snap.csv_pos);
+    }
+    s->frames_written = snap.frames_written;
+    s->frame_errors = snap.frame_errors;
+    s->frame_seq_end = snap.frame_seq_end;
+    for (uint32_t i = 0; i < s->fn_count; ++i) {
+        prof_fn_t *f = &s->fns[i];
+        f->cycles = f->insns = f->calls = 0u;
+        for (uint32_t j = 0; j < snap.fn_count; ++j) {
+            if (snap.fns[j].start == f->start) {
+                f->cycles = snap.fns[j].cycles;
+                f->insns = snap.fns[j].insns;
+                f->calls = snap.fns[j].calls;
+                break;
+            }
+        }
+    }
+}
+
+/* Power-on state at entry, outputs emptied back to their headers */
+static void sim_reset(sim_t *s, uint32_t entry) {
+    rv32i_init(&s->cpu, ram, s->ram_base, s->ram_size);
+    s->cpu.pc = entry;
+    s->cpu.bus_ctx = s;
+    s->cpu.bus_load = bus_load;
+    s->cpu.bus_store = bus_store;
+    s->cpu.csr_read = csr_read;
+    s->cpu.csr_write = csr_write;
+    vga_model_init(&s->vga, s->cpu_hz, s->latch);
+    s->vga.cb_ctx = s;
+    s->vga.on_event = on_event;
+    s->vga.on_frame = on_frame;
+    vga_dma_init(&s->dma, &s->vga, ram, s->ram_base, s->ram_size, s->dma_bw, s->dma_latency, s->dma_fifo);
+    s->cycle = 0u;
+    s->bus_stall = 0u;
+    s->last_load_rd = 0u;
+    s->load_use_stalls = s->taken = s->loads = s->stores = s->mmio_stores = s->mmio_bytes = s->stall_cycles = 0u;
+    memset(s->ctr_offset, 0, sizeof(s->ctr_offset));
+    s->events_printed = 0u;
+
+    if (s->trace != NULL) {
+        truncate_output(s->trace, MEMLOG_BIN_MAGIC_LEN);
+    }
+    memset(&s->codec, 0, sizeof(s->codec));
+    s->trace_bytes = MEMLOG_BIN_MAGIC_LEN;
+    if (s->frame_csv != NULL) {
+        truncate_output(s->frame_csv, s->csv_start);
+    }
+    s->frames_written = 0u;
+    s->frame_errors = 0u;
+    s->frame_seq_end = 0u;
+
+    if (s->ram_use != NULL) {
+        memset(s->ram_use, 0, s->ram_size);
+        s->before_snap = 1;
+        s->snap_returning = 0;
+        s->snap_pc = s->snap_sym;
+    }
+}
+
+/* Before the snapshot: remember which RAM bytes the run read and wrote */
+static void note_use(sim_t *s, const rv32i_retire_t *ret) {
+    uint32_t off = ret->pc - s->ram_base;
+
+    if (off <= s->ram_size - 4u) {
+        s->ram_use[off] |= USE_READ;
+        s->ram_use[off + 1u] |= USE_READ;
+        s->ram_use[off + 2u] |= USE_READ;
+        s->ram_use[off + 3u] |= USE_READ;
+    }
+    off = ret->mem_addr - s->ram_base;
+    if (ret->mem_op != 0u && off <= s->ram_size - ret->mem_size) {
+        for (uint32_t i = 0; i < ret->mem_size; ++i) {
+            s->ram_use[off + i] |= (ret->mem_op == 1u) ? USE_READ : USE_WRITTEN;
+        }
+    }
+}
+
+/* At the top of an instruction before the snapshot: has the snapshot point come? */
+static void snapshot_check(sim_t *s) {
+    if (s->snap_after && !s->snap_returning) {
+        s->snap_returning = 1;
+        s->snap_pc = s->cpu.x[1];
+        s->snap_sp = s->cpu.x[2];
+    } else if (!s->snap_after || s->cpu.x[2] == s->snap_sp) {
+        snapshot_take(s);
+    }
+}
+
+/* Does insn read register r (r != 0)? */
+static int reads_reg(const rv32i_insn_t *d, unsigned r) {
+    switch (rv32i_format_of(d->op)) {
+    case RV32I_FMT_R:
+    case RV32I_FMT_S:
+    case RV32I_FMT_B:
+        return d->rs1 == r || d->rs2 == r;
+    case RV32I_FMT_I:
+        return d->rs1 == r && d->op < RV32I_OP_CSRRWI;
+    default:
+        return 0;
+    }
+}
+
+static const char *run(sim_t *s) {
+    rv32i_retire_t ret;
+    unsigned last_load_rd = s->last_load_rd;
+
+    for (;;) {
+        rv32i_status_t st;
+        uint32_t cost = 1u;
+
+        if (s->before_snap && s->cpu.pc == s->snap_pc) {
+            s->last_load_rd = last_load_rd;
+            snapshot_check(s);
+        }
+
+        if (s->max_cycles != 0u && s->cycle >= s->max_cycles) {
+            return "cycle limit";
+        }
+        if (s->max_frames != 0u && s->vga.stats.frames_shown >= s->max_frames) {
+            return "frame limit";
+        }
+        st = rv32i_step(&s->cpu, &ret);
+        switch (st) {
+        case RV32I_OK:
+            break;
+        case RV32I_ECALL:
+            return "ecall";
+        case RV32I_EBREAK:
+            return "ebreak";
+        case RV32I_ILLEGAL:
+            fprintf(stderr, "rvsim: illegal instruction 0x%08x at pc 0x%08x\n", ret.insn, ret.pc);
+            return NULL;
+        case RV32I_MISALIGNED:
+            fprintf(stderr, "rvsim: misaligned access at pc 0x%08x (addr 0x%08x)\n", ret.pc, ret.mem_addr);
+            return NULL;
+        case RV32I_BUS_ERROR:
+            fprintf(stderr, "rvsim: bus error at pc 0x%08x (addr 0x%08x)\n", ret.pc,
+                    ret.mem_op != 0 ? ret.mem_addr : ret.pc);
+            return NULL;
+        }
+
+        if (last_load_rd != 0u && reads_reg(&ret.dec, last_load_rd)) {
+            cost += s->load_use_cycles;
+            s->load_use_stalls++;
+        }
+        last_load_rd = (ret.mem_op == 1u) ? ret.rd : 0u;
+        if (s->before_snap) {
+            note_use(s, &ret);
+        }
+        if (s->tracing && ret.mem_op != 0u) {
+            memlog_rec_t *r = sim_pipe_reserve(&s->trace_pipe, sizeof(*r));
+            r->time = s->cycle;
+            r->addr = ret.mem_addr;
+            r->data = ret.mem_value;
+            r->is_write = ret.mem_op == 2u;
+            r->size = (uint8_t)(ret.mem_size >> 1);
+        }
+        if (ret.taken) {
+            cost += s->branch_cycles;
+            s->taken++;
+        }
+        if (ret.mem_op == 1u) {
+            s->loads++;
+        } else if (ret.mem_op == 2u) {
+            s->stores++;
+            if (ret.mem_addr - s->cpu.ram_base >= s->cpu.ram_size) {
+                s->mmio_stores++;
+                s->mmio_bytes += ret.mem_size;
+            }
+        }
+        cost += s->bus_stall;
+        s->bus_stall = 0u;
+        s->stall_cycles += cost - 1u;
+        s->cycle += cost;
+        if (s->fn_of_word != NULL) {
+            prof_sample_t *p = sim_pipe_reserve(&s->prof_pipe, sizeof(*p));
+            p->pc = ret.pc;
+            p->cost = cost;
+        }
+        if (s->cycle >= s->dma.next_event) {
+            vga_dma_advance(&s->dma, s->cycle);
+        }
+        if (s->cycle >= s->vga.next_event) {
+            vga_model_advance(&s->vga, s->cycle);
+        }
+        if (ret.next_pc == ret.pc) {
+            return "halted";
+        }
+    }
+}
+
+static int load_program(const char *path, elf32_file_t *elf, uint8_t *img, uint32_t ram_base, uint32_t ram_size,
+                        uint32_t *entry) {
+    FILE *fp;
+    unsigned char magic[4] = { 0 };
+    size_t n;
+
+    fp = fopen(path, "rb");
+    if (fp == NULL) {
+        perror(path);
+        return -1;
+    }
+    n = fread(magic, 1, sizeof(magic), fp);
+    if (n == sizeof(magic) && memcmp(magic, "\177ELF", 4) == 0) {
+        fclose(fp);
+        if (elf32_open(elf, path) != 0 || elf32_load(elf, img, ram_base, ram_size) != 0) {
+            return -1;
+        }
+        *entry = elf->entry;
+        return 0;
+    }
+    // Raw image (objcopy -O binary) linked at the RAM base
+    rewind(fp);
+    n = fread(img, 1, ram_size, fp);
+    if (ferror(fp) || fgetc(fp) != EOF) {
+        fprintf(stderr, "%s: image larger than RAM (0x%x bytes)\n", path, ram_size);
+        fclose(fp);
+        return -1;
+    }
+    fclose(fp);
+    *entry = ram_base;
+    return 0;
+}
+
+/* pixels: FRAME_PIXEL_BYTES from frame_snapshot */
+static int write_ppm(const uint8_t *pixels, const char *path) {
+    uint8_t line[VGA_MODEL_ROW_BYTES * 2u * 3u];
+    FILE *fp = fopen(path, "wb");
+
+    if (fp == NULL) {
+        perror(path);
+        return -1;
+    }
+    fprintf(fp, "P6\n%u %u\n255\n", VGA_MODEL_ROW_BYTES * 2u, VGA_MODEL_ROWS);
+    for (uint32_t y = 0; y < VGA_MODEL_ROWS; ++y) {
+        for (unsigned p = 0; p < 3u; ++p) {
+            const uint8_t *row = pixels + (p * VGA_MODEL_ROWS + y) * VGA_MODEL_ROW_BYTES;
+            for (uint32_t x = 0; x < VGA_MODEL_ROW_BYTES; ++x) {
+                line[(x * 2u) * 3u + p] = (uint8_t)((row[x] & 0x0Fu) * 17u);
+                line[(x * 2u + 1u) * 3u + p] = (uint8_t)((row[x] >> 4) * 17u);
+            }
+        }
+        fwrite(line, 1, sizeof(line), fp);
+    }
+    return fclose(fp);
+}
+
+/* FNV-1a */
+static uint32_t frame_hash(const uint8_t *p, uint32_t len) {
+    uint32_t h = 0x811C9DC5u;
+    for (uint32_t i = 0; i < len; ++i) {
+        h = (h ^ p[i]) * 0x01000193u;
+    }
+    return h;
+}
+
+static void frame_consume(void *ctx, const uint8_t *data, uint32_t bytes) {
+    sim_t *s = ctx;
+
+    for (uint32_t off = 0; off < bytes; ) {
+        const frame_rec_t *r = (const frame_rec_t *)(const void *)(data + off);
+        const vga_frame_report_t *fr = &r->report;
+
+        off += frame_rec_bytes(r->has_pixels);
+        s->frame_seq_end = fr->seq + 1u;
+        if (s->frame_csv != NULL) {
+            fprintf(s->frame_csv, "%" PRIu64 ",%" PRIu64 ",%" PRIu64 ",", fr->seq, fr->draw_start, fr->swap_at);
+            if (!r->has_pixels) {
+                fprintf(s->frame_csv, ",,,%u,%u,,,\n", fr->stores, fr->hazards);
+            } else {
+                fprintf(s->frame_csv, "%" PRIu64 ",%" PRIu64 ",%u,%u,%u,%" PRIu64 ",%" PRIu64 ",0x%08x\n",
+                        fr->shown_at, fr->refresh, fr->start_line, fr->stores, fr->hazards,
+                        fr->shown_at - fr->draw_start, fr->shown_at - fr->swap_at,
+                        frame_hash(r->pixels, FRAME_PIXEL_BYTES));
+            }
+        }
+        if (s->frame_dir != NULL && r->has_pixels) {
+            char name[4096];
+            snprintf(name, sizeof(name), "%s/frame_%05" PRIu64 ".ppm", s->frame_dir, fr->seq);
+            if (write_ppm(r->pixels, name) != 0) {
+                s->frame_errors++;
+            } else {
+                s->frames_written++;
+            }
+        }
+    }
+}
+
+static void trace_consume(void *ctx, const uint8_t *data, uint32_t bytes) {
+    sim_t *s = ctx;
+    const memlog_rec_t *r = (const memlog_rec_t *)(const void *)data;
+    uint8_t buf[4096];
+    uint32_t n = 0;
+
+    for (uint32_t i = 0; i < bytes / (uint32_t)sizeof(*r); ++i) {
+        if (n > sizeof(buf) - MEMLOG_BIN_MAX_REC) {
+            fwrite(buf, 1, n, s->trace);
+            s->trace_bytes += n;
+            n = 0;
+        }
+        n += memlog_encode(&s->codec, &r[i], buf + n);
+    }
+    fwrite(buf, 1, n, s->trace);
+    s->trace_bytes += n;
+}
+
+static int open_pipe(sim_t *s, sim_pipe_t *p, const char *name, uint32_t chunk_bytes, unsigned chunks,
+                     sim_pipe_fn fn) {
+    if (sim_pipe_open(p, name, chunk_bytes, chunks, s->threaded, fn, s) != 0) {
+        fprintf(stderr, "rvsim: cannot start the %s pipe\n", name);
+        return -1;
+    }
+    return 0;
+}
+
+static void pipe_report(const sim_pipe_t *p) {
+    printf("  %-7s %" PRIu64 " chunks of %u KiB, %" PRIu64 " waits for a free chunk\n",
+           p->name, p->submitted, p->chunk_bytes / 1024u, p->stalls);
+}
+
+static void report(const sim_t *s, const char *path, const char *why) {
+    const vga_model_stats_t *v = &s->vga.stats;
+
+    printf("rvsim: %s: %s at pc 0x%08x after %" PRIu64 " instructions, %" PRIu64 " cycles (%.3f ms at %.3f MHz)\n",
+           path, why, s->cpu.pc, s->cpu.instret, s->cycle, to_ms(s, s->cycle), (double)s->cpu_hz / 1e6);
+    printf("  stalls: %" PRIu64 " load-use, %" PRIu64 " taken branches/jumps, %" PRIu64 " stall cycles\n",
+           s->load_use_stalls, s->taken, s->stall_cycles);
+    printf("  loads %" PRIu64 ", stores %" PRIu64 " (%" PRIu64 " MMIO, %" PRIu64 " bytes)\n", s->loads, s->stores,
+           s->mmio_stores, s->mmio_bytes);
+    printf("scanout: %" PRIu64 " refreshes, %s latch\n", s->vga.refresh,
+           s->vga.latch == VGA_LATCH_VBLANK ? "vblank" : "immediate");
+    printf("  swaps %" PRIu64 ", frames shown %" PRIu64 ", dropped %" PRIu64 "\n",
+           v->swaps, v->frames_shown, v->frames_dropped);
+    printf("  VGA stores %" PRIu64 ", into the displayed buffer %" PRIu64 " (%" PRIu64 " ahead of the beam)\n",
+           v->stores, v->writes_displayed, v->writes_displayed_ahead);
+    printf("  mid-frame swaps %" PRIu64 ", swaps while pending %" PRIu64 "\n",
+           v->swaps_mid_frame, v->swaps_pending);
+    if (v->frames_shown != 0u) {
+        printf("  draw-to-display latency: min %.3f  avg %.3f  max %.3f ms\n",
+               to_ms(s, v->latency_min), to_ms(s, v->latency_sum / v->frames_shown), to_ms(s, v->latency_max));
+        printf("  swap-to-display slack:   min %.3f  avg %.3f  max %.3f ms\n",
+               to_ms(s, v->slack_min), to_ms(s, v->slack_sum / v->frames_shown), to_ms(s, v->slack_max));
+    }
+    if (s->tracing || s->framing || s->fn_of_word != NULL) {
+        printf("output: %s\n", s->threaded ? "worker threads" : "inline");
+        if (s->tracing) {
+            pipe_report(&s->trace_pipe);
+            printf("          %" PRIu64 " accesses, %" PRIu64 " bytes\n", s->loads + s->stores, s->trace_bytes);
+        }
+        if (s->framing) {
+            pipe_report(&s->frame_pipe);
+            if (s->frame_dir != NULL) {
+                printf("          %" PRIu64 " PPM files in %s\n", s->frames_written, s->frame_dir);
+            }
+        }
+        if (s->fn_of_word != NULL) {
+            pipe_report(&s->prof_pipe);
+        }
+    }
+    if (s->dma_enabled) {
+        const vga_dma_stats_t *d = &s->dma.stats;
+        printf("dma: %u B/cycle, latency %u, fifo %u\n", s->dma.bytes_per_cycle, s->dma.latency,
+               s->dma.fifo_depth);
+        printf("  commands %" PRIu64 " (%" PRIu64 " rejected), bytes %" PRIu64 ", busy %" PRIu64 " cycles (%.1f%%)\n",
+               d->commands, d->errors, d->bytes, d->busy_cycles,
+               s->cycle != 0u ? 100.0 * (double)d->busy_cycles / (double)s->cycle : 0.0);
+        printf("  CPU stalled on a full FIFO %" PRIu64 " times, %" PRIu64 " cycles\n", d->full_stalls,
+               d->stall_cycles);
+        if (s->dma.queued != 0u) {
+            printf("  %u commands still queued at exit\n", s->dma.queued);
+        }
+    }
+}
+
+static int write_bench(const char *path, uint32_t ram_base, uint32_t ram_size) {
+    static bench_results_t results;
+    FILE *fp;
+
+    if (bench_results_from_ram(&results, ram, ram_base, ram_size) != 0) {
+        fprintf(stderr, "rvsim: no benchmark table at 0x%x\n", BENCH_TABLE_ADDR);
+        return -1;
+    }
+    if (!results.done) {
+        fprintf(stderr, "rvsim: warning: benchmark table not marked done\n");
+    }
+    fp = fopen(path, "w");
+    if (fp == NULL) {
+        perror(path);
+        return -1;
+    }
+    bench_results_write_csv(&results, fp);
+    return fclose(fp);
+}
+
+/* Wait until path has a new modification time or size and has stopped changing */
+static void wait_for_change(const char *path, struct stat *last) {
+    struct timespec nap = { 0, WATCH_POLL_NS };
+    struct stat now;
+    int seen = 0;
+
+    for (;;) {
+        nanosleep(&nap, NULL);
+        if (stat(path, &now) != 0) {
+            continue;           /* mid-rebuild */
+        }
+        if (now.st_mtim.tv_sec == last->st_mtim.tv_sec && now.st_mtim.tv_nsec == last->st_mtim.tv_nsec &&
+            now.st_size == last->st_size) {
+            if (seen) {
+                return;         /* the same for one whole poll: the linker is done */
+            }
+            continue;
+        }
+        *last = now;
+        seen = 1;
+    }
+}
+
+/*
+ * Load the rebuilt program into image, with the parameters applied. Returns
+ * 1 when the snapshot still holds (and patches it), 0 to restart from the
+ * entry point, -1 if the new file does not load (nothing changed).
+ */
+static int reload(sim_t *s, const char *path, elf32_file_t *elf, uint32_t *entry, const char *snap_name,
+                  const char *const *params, unsigned param_count) {
+    struct {
+        const char *name;
+        uint32_t bytes;
+    } sections[8];
+    unsigned section_count = 0;
+    elf32_file_t nelf;
+    elf32_sym_t sym;
+    uint8_t *nimg = calloc(1, s->ram_size);
+    uint32_t nentry;
+    uint32_t changed = 0;
+    uint32_t used = UINT32_MAX;
+    const char *why = NULL;
+    char why_used[96];
+
+    memset(&nelf, 0, sizeof(nelf));
+    if (nimg == NULL || load_program(path, &nelf, nimg, s->ram_base, s->ram_size, &nentry) != 0) {
+        free(nimg);
+        elf32_close(&nelf);
+        return -1;
+    }
+    for (unsigned i = 0; i < param_count; ++i) {
+        if (params_apply(nimg, s->ram_size, params[i]) != 0) {
+            free(nimg);
+            elf32_close(&nelf);
+            return -1;
+        }
+    }
+
+    for (uint32_t off = 0; off < s->ram_size; ++off) {
+        const char *name = "?";
+        unsigned k;
+        if (image[off] == nimg[off]) {
+            continue;
+        }
+        changed++;
+        if (s->ram_use != NULL && (s->ram_use[off] & USE_READ) != 0u && used == UINT32_MAX) {
+            used = off;
+        }
+        (void)elf32_section_at(&nelf, s->ram_base + off, &name);
+        for (k = 0; k < section_count && strcmp(sections[k].name, name) != 0; ++k) {
+        }
+        if (k == section_count && section_count < 8u) {
+            sections[section_count].name = name;
+            sections[section_count++].bytes = 0;
+        }
+        if (k < section_count) {
+            sections[k].bytes++;
+        }
+    }
+    printf("rvsim: %s changed: %u bytes", path, changed);
+    for (unsigned k = 0; k < section_count; ++k) {
+        printf("%s%s %u", k == 0u ? " (" : ", ", sections[k].name, sections[k].bytes);
+    }
+    printf("%s\n", section_count != 0u ? ")" : "");
+
+    if (!snap.valid) {
+        why = "no snapshot was taken";
+    } else if (nentry != *entry) {
+        why = "the entry point moved";
+    } else if (elf32_symbol(&nelf, snap_name, &sym) != 0 || sym.value != s->snap_sym) {
+        why = "the snapshot symbol moved";
+    } else if (used != UINT32_MAX) {
+        snprintf(why_used, sizeof(why_used), "0x%08x was changed and used before the snapshot",
+                 s->ram_base + used);
+        why = why_used;
+    }
+    if (why == NULL) {
+        // Bytes the run stored to before the snapshot keep the stored value
+        for (uint32_t off = 0; off < s->ram_size; ++off) {
+            if (image[off] != nimg[off] && (s->ram_use[off] & USE_WRITTEN) == 0u) {
+                snap.ram[off] = nimg[off];
+            }
+        }
+    }
+    memcpy(image, nimg, s->ram_size);
+    free(nimg);
+    elf32_close(elf);
+    *elf = nelf;
+    *entry = nentry;
+    if (why != NULL) {
+        printf("rvsim: restarting from the entry point: %s\n", why);
+        return 0;
+    }
+    printf("rvsim: resuming from the snapshot\n");
+    return 1;
+}
+
+/* Remove frame files a previous, longer run left behind */
+static void remove_stale_frames(const sim_t *s, uint64_t from, uint64_t to) {
+    char name[4096];
+
+    for (uint64_t seq = from; seq < to; ++seq) {
+        snprintf(name, sizeof(name), "%s/frame_%05" PRIu64 ".ppm", s->frame_dir, seq);
+        (void)remove(name);
+    }
+}
+
+static void usage(const char *argv0) {
+    fprintf(stderr,
+            "usage: %s [--cpu-hz N] [--time-hz N] [--latch immediate|vblank] [--max-cycles N] [--frames N]\n"
+            "       [--load-use N] [--branch-penalty N] [--ram-base A] [--ram-size N] [--param NAME=VALUE]...\n"
+            "       [--events N] [--frame-csv FILE] [--frame-dir DIR] [--trace FILE] [--ppm FILE] [--print SYM]...\n"
+            "       [--profile FILE] [--bench-out FILE] [--dma] [--dma-bw N] [--dma-latency N] [--dma-fifo N]\n"
+            "       [--fail-on-tear] [--no-threads] [--snapshot-at SYM | --snapshot-after SYM] [--watch] [-v]\n"
+            "       program.elf|program.bin\n",
+            argv0);
+}
+
+int main(int argc, char **argv) {
+    const char *path = NULL;
+    const char *csv_path = NULL;
+    const char *trace_path = NULL;
+    const char *ppm_path = NULL;
+    const char *profile_path = NULL;
+    const char *bench_path = NULL;
+    const char *snap_name = NULL;
+    const char *print_syms[MAX_PRINT_SYMS];
+    unsigned print_count = 0;
+    const char *params[MAX_PARAMS];
+    unsigned param_count = 0;
+    uint32_t entry;
+    int fail_on_tear = 0;
+    int watch = 0;
+    int resume = 0;
+    elf32_file_t elf;
+    struct stat elf_stat;
+    int status = 0;
+
+    memset(&elf, 0, sizeof(elf));
+    sim.ram_base = 0x0u;
+    sim.ram_size = 0x8000u;
+    sim.latch = VGA_LATCH_IMMEDIATE;
+    sim.dma_bw = 4u;
+    sim.dma_latency = 8u;
+    sim.dma_fifo = 4u;
+    sim.threaded = sysconf(_SC_NPROCESSORS_ONLN) > 1;
+    sim.cpu_hz = 5000000u;
+    sim.max_cycles = 100000000u;
+    sim.load_use_cycles = 1u;
+    sim.branch_cycles = 2u;
+    sim.max_events = 10u;
+
+    for (int i = 1; i < argc; ++i) {
+        if (strcmp(argv[i], "--cpu-hz") == 0 && i + 1 < argc) {
+            sim.cpu_hz = (uint32_t)strtoul(argv[++i], NULL, 0);
+        } else if (strcmp(argv[i], "--time-hz") == 0 && i + 1 < argc) {
+            sim.time_hz = (uint32_t)strtoul(argv[++i], NULL, 0);
+        } else if (strcmp(argv[i], "--latch") == 0 && i + 1 < argc) {
+            ++i;
+            if (strcmp(argv[i], "immediate") == 0) {
+                sim.latch = VGA_LATCH_IMMEDIATE;
+            } else if (strcmp(argv[i], "vblank") == 0) {
+                sim.latch = VGA_LATCH_VBLANK;
+            } else {
+                usage(argv[0]);
+                return 2;
+            }
+        } else if (strcmp(argv[i], "--max-cycles") == 0 && i + 1 < argc) {
+            sim.max_cycles = strtoull(argv[++i], NULL, 0);
+        } else if (strcmp(argv[i], "--frames") == 0 && i + 1 < argc) {
+            sim.max_frames = strtoull(argv[++i], NULL, 0);
+        } else if (strcmp(argv[i], "--load-use") == 0 && i + 1 < argc) {
+            sim.load_use_cycles = (uint32_t)strtoul(argv[++i], NULL, 0);
+        } else if (strcmp(argv[i], "--branch-penalty") == 0 && i + 1 < argc) {
+            sim.branch_cycles = (uint32_t)strtoul(argv[++i], NULL, 0);
+        } else if (strcmp(argv[i], "--ram-base") == 0 && i + 1 < argc) {
+            sim.ram_base = (uint32_t)strtoul(argv[++i], NULL, 0);
+        } else if (strcmp(argv[i], "--ram-size") == 0 && i + 1 < argc) {
+            sim.ram_size = (uint32_t)strtoul(argv[++i], NULL, 0);
+        } else if (strcmp(argv[i], "--param") == 0 && i + 1 < argc && param_count < MAX_PARAMS) {
+            params[param_count++] = argv[++i];
+        } else if (strcmp(argv[i], "--events") == 0 && i + 1 < argc) {
+            sim.max_events = (unsigned)strtoul(argv[++i], NULL, 0);
+        } else if (strcmp(argv[i], "--frame-csv") == 0 && i + 1 < argc) {
+            csv_path = argv[++i];
+        } else if (strcmp(argv[i], "--frame-dir") == 0 && i + 1 < argc) {
+            sim.frame_dir = argv[++i];
+        } else if (strcmp(argv[i], "--trace") == 0 && i + 1 < argc) {
+            trace_path = argv[++i];
+        } else if (strcmp(argv[i], "--ppm") == 0 && i + 1 < argc) {
+            ppm_path = argv[++i];
+        } else if (strcmp(argv[i], "--print") == 0 && i + 1 < argc && print_count < MAX_PRINT_SYMS) {
+            print_syms[print_count++] = argv[++i];
+        } else if (strcmp(argv[i], "--profile") == 0 && i + 1 < argc) {
+            profile_path = argv[++i];
+        } else if (strcmp(argv[i], "--bench-out") == 0 && i + 1 < argc) {
+            bench_path = argv[++i];
+        } else if (strcmp(argv[i], "--dma") == 0) {
+            sim.dma_enabled = 1;
+        } else if (strcmp(argv[i], "--dma-bw") == 0 && i + 1 < argc) {
+            sim.dma_bw = (uint32_t)strtoul(argv[++i], NULL, 0);
+        } else if (strcmp(argv[i], "--dma-latency") == 0 && i + 1 < argc) {
+            sim.dma_latency = (uint32_t)strtoul(argv[++i], NULL, 0);
+        } else if (strcmp(argv[i], "--dma-fifo") == 0 && i + 1 < argc) {
+            sim.dma_fifo = (uint32_t)strtoul(argv[++i], NULL, 0);
+        } else if (strcmp(argv[i], "--fail-on-tear") == 0) {
+            fail_on_tear = 1;
+        } else if (strcmp(argv[i], "--no-threads") == 0) {
+            sim.threaded = 0;
+        } else if ((strcmp(argv[i], "--snapshot-at") == 0 || strcmp(argv[i], "--snapshot-after") == 0) &&
+                   i + 1 < argc && snap_name == NULL) {
+            sim.snap_after = strcmp(argv[i], "--snapshot-after") == 0;
+            snap_name = argv[++i];
+        } else if (strcmp(argv[i], "--watch") == 0) {
+            watch = 1;
+        } else if (strcmp(argv[i], "-v") == 0) {
+            sim.verbose = 1;
+        } else if (argv[i][0] != '-' && path == NULL) {
+            path = argv[i];
+        } else {
+            usage(argv[0]);
+            return 2;
+        }
+    }
+    if (path == NULL || sim.cpu_hz == 0u || sim.ram_size < 4u) {
+        usage(argv[0]);
+        return 2;
+    }
+    if (sim.time_hz == 0u) {
+        sim.time_hz = sim.cpu_hz;
+    }
+
+    ram = calloc(1, sim.ram_size);
+    image = calloc(1, sim.ram_size);
+    if (ram == NULL || image == NULL) {
+        perror("calloc");
+        return 1;
+    }
+    if (stat(path, &elf_stat) != 0) {
+        perror(path);
+        return 1;
+    }
+    if (load_program(path, &elf, image, sim.ram_base, sim.ram_size, &entry) != 0) {
+        return 1;
+    }
+    for (unsigned i = 0; i < param_count; ++i) {
+        if (params_apply(image, sim.ram_size, params[i]) != 0) {
+            return 2;
+        }
+    }
+    if ((profile_path != NULL || snap_name != NULL) && elf.data == NULL) {
+        fprintf(stderr, "rvsim: --profile and --snapshot-* need an ELF with symbols\n");
+        return 2;
+    }
+    if (snap_name != NULL) {
+        elf32_sym_t sym;
+        if (elf32_symbol(&elf, snap_name, &sym) != 0) {
+            fprintf(stderr, "rvsim: no symbol %s\n", snap_name);
+            return 2;
+        }
+        sim.snap_sym = sym.value;
+        sim.ram_use = calloc(1, sim.ram_size);
+        snap.ram = malloc(sim.ram_size);
+        if (sim.ram_use == NULL || snap.ram == NULL) {
+            perror("calloc");
+            return 1;
+        }
+    }
+
+    if (csv_path != NULL) {
+        sim.frame_csv = fopen(csv_path, "w");
+        if (sim.frame_csv == NULL) {
+            perror(csv_path);
+            return 1;
+        }
+        fprintf(sim.frame_csv, "seq,draw_start,swap_at,shown_at,refresh,start_line,stores,hazards,"
+                               "latency_cycles,slack_cycles,hash\n");
+        sim.csv_start = ftell(sim.frame_csv);
+    }
+    if (csv_path != NULL || sim.frame_dir != NULL) {
+        if (open_pipe(&sim, &sim.frame_pipe, "frames", 4u * frame_rec_bytes(1), FRAME_CHUNKS, frame_consume) != 0) {
+            return 1;
+        }
+        sim.framing = 1;
+    }
+    if (trace_path != NULL) {
+        sim.trace = fopen(trace_path, "wb");
+        if (sim.trace == NULL) {
+            perror(trace_path);
+            return 1;
+        }
+        setvbuf(sim.trace, NULL, _IOFBF, 1u << 20);
+        fwrite(MEMLOG_BIN_MAGIC, 1, MEMLOG_BIN_MAGIC_LEN, sim.trace);
+        if (open_pipe(&sim, &sim.trace_pipe, "trace", TRACE_CHUNK, PIPE_CHUNKS, trace_consume) != 0) {
+            return 1;
+        }
+        sim.tracing = 1;
+    }
+    if (profile_path != NULL &&
+        open_pipe(&sim, &sim.prof_pipe, "profile", PROF_CHUNK, PIPE_CHUNKS, prof_consume) != 0) {
+        return 1;
+    }
+
+    for (;;) {
+        struct timespec t0, t1;
+        uint64_t frames_before = sim.frame_seq_end;
+        const char *why;
+
+        clock_gettime(CLOCK_MONOTONIC, &t0);
+        status = 0;
+        if (profile_path != NULL && profile_init(&sim, &elf) != 0) {
+            return 1;
+        }
+        if (resume) {
+            snapshot_restore(&sim);
+        } else {
+            memcpy(ram, image, sim.ram_size);
+            snap.valid = 0;
+            sim_reset(&sim, entry);
+        }
+
+        why = run(&sim);
+        if (why == NULL) {
+            why = "stopped on error";
+            status = 1;
+        }
+        // Wait for the workers before anything reads what they produce
+        drain_outputs(&sim);
+        report(&sim, path, why);
+
+        for (unsigned i = 0; i < print_count; ++i) {
+            elf32_sym_t sym;
+            uint32_t off;
+            if (elf32_symbol(&elf, print_syms[i], &sym) != 0) {
+                fprintf(stderr, "rvsim: no symbol %s\n", print_syms[i]);
+                status = status ? status : 1;
+                continue;
+            }
+            off = sym.value - sim.ram_base;
+            if (sym.value < sim.ram_base || off > sim.ram_size - 4u) {
+                fprintf(stderr, "rvsim: %s (0x%08x) is outside RAM\n", print_syms[i], sym.value);
+                continue;
+            }
+            printf("%s = 0x%08x\n", print_syms[i],
+                   (uint32_t)ram[off] | ((uint32_t)ram[off + 1u] << 8) |
+                   ((uint32_t)ram[off + 2u] << 16) | ((uint32_t)ram[off + 3u] << 24));
+        }
+
+        if (sim.frame_errors != 0u) {
+            status = 1;
+        }
+        if (profile_path != NULL && profile_write(&sim, profile_path, path) != 0) {
+            status = 1;
+        }
+        if (ppm_path != NULL) {
+            static uint8_t pixels[FRAME_PIXEL_BYTES];
+            frame_snapshot(&sim.vga, sim.vga.display_sel, pixels);
+            if (write_ppm(pixels, ppm_path) != 0) {
+                status = 1;
+            }
+        }
+        if (bench_path != NULL && write_bench(bench_path, sim.ram_base, sim.ram_size) != 0) {
+            status = 1;
+        }
+        if (status == 0 && fail_on_tear &&
+            (sim.vga.stats.swaps_mid_frame != 0u || sim.vga.stats.writes_displayed_ahead != 0u)) {
+            status = 3;
+        }
+        if (!watch) {
+            break;
+        }
+
+        if (sim.frame_dir != NULL) {
+            remove_stale_frames(&sim, sim.frame_seq_end, frames_before);
+        }
+        clock_gettime(CLOCK_MONOTONIC, &t1);
+        printf("rvsim: %s in %.3f s (status %d); watching %s\n", resume ? "resumed run" : "run",
+               (double)(t1.tv_sec - t0.tv_sec) + (double)(t1.tv_nsec - t0.tv_nsec) / 1e9, status, path);
+        fflush(stdout);
+        do {
+            wait_for_change(path, &elf_stat);
+            resume = reload(&sim, path, &elf, &entry, snap_name, params, param_count);
+        } while (resume < 0);
+    }
+
+    if (sim.tracing) {
+        sim_pipe_close(&sim.trace_pipe);
+    }
+    if (sim.framing) {
+        sim_pipe_close(&sim.frame_pipe);
+    }
+    if (profile_path != NULL) {
+        sim_pipe_close(&sim.prof_pipe);
+    }
+    if (sim.frame_csv != NULL && fclose(sim.frame_csv) != 0) {
+        perror(csv_path);
+        status = 1;
+    }
+    if (sim.trace != NULL && fclose(sim.trace) != 0) {
+        perror(trace_path);
+        status = 1;
+    }
+    elf32_close(&elf);
+    free(sim.fns);
+    free(sim.fn_of_word);
+    free(sim.ram_use);
+    free(snap.ram);
+    free(snap.fns);
+    free(image);
+    free(ram);
+    return status;
+}
@@ -0,0 +1,143 @@
+/*
+ * Producer -> worker-thread record pipe for the host simulator (see sim_pipe.h).
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "sim_pipe.h"
+
+#include <sched.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+static void *worker_main(void *arg) {
+    sim_pipe_t *p = (sim_pipe_t *)arg;
+    sim_chunk_t *batch[16];
+
+    for (;;) {
+        unsigned n = sim_chunk_ring_pop(&p->full, batch, 16u);
+        unsigned i;
+        if (n == 0u) {
+            struct timespec nap = { 0, 50000 };
+            if (atomic_load(&p->stop)) {
+                n = sim_chunk_ring_pop(&p->full, batch, 16u);
+                if (n == 0u) {
+                    break;
+                }
+            } else {
+                nanosleep(&nap, NULL);
+                continue;
+            }
+        }
+        for (i = 0; i < n; i++) {
+            p->fn(p->ctx, batch[i]->data, batch[i]->used);
+            batch[i]->used = 0;
+            atomic_fetch_add(&p->consumed, 1u);
+            /* The free ring holds every chunk, so this cannot fail */
+            (void)sim_chunk_ring_push(&p->free, &batch[i]);
+        }
+    }
+    return NULL;
+}
+
+int sim_pipe_open(sim_pipe_t *p, const char *name, uint32_t chunk_bytes, unsigned chunk_count, int threaded,
+                  sim_pipe_fn fn, void *ctx) {
+    unsigned log2 = 1;
+    unsigned i;
+
+    memset(p, 0, sizeof(*p));
+    p->name = name;
+    p->fn = fn;
+    p->ctx = ctx;
+    p->threaded = threaded;
+    p->chunk_bytes = (chunk_bytes + 7u) & ~7u;
+    p->chunk_count = chunk_count < 2u ? 2u : chunk_count;
+    if (!threaded) {
+        p->chunk_count = 1;
+    }
+
+    p->chunks = (sim_chunk_t **)calloc(p->chunk_count, sizeof(*p->chunks));
+    if (p->chunks == NULL) {
+        return -1;
+    }
+    for (i = 0; i < p->chunk_count; i++) {
+        p->chunks[i] = (sim_chunk_t *)calloc(1, sizeof(sim_chunk_t) + p->chunk_bytes);
+        if (p->chunks[i] == NULL) {
+            sim_pipe_close(p);
+            return -1;
+        }
+    }
+    p->cur = p->chunks[0];
+    if (!threaded) {
+        return 0;
+    }
+
+    while ((1u << log2) < p->chunk_count) {
+        log2++;
+    }
+    if (sim_chunk_ring_init(&p->full, log2) != 0 || sim_chunk_ring_init(&p->free, log2) != 0) {
+        sim_pipe_close(p);
+        return -1;
+    }
+    for (i = 1; i < p->chunk_count; i++) {
+        (void)sim_chunk_ring_push(&p->free, &p->chunks[i]);
+    }
+    atomic_init(&p->stop, 0);
+    atomic_init(&p->consumed, 0u);
+    if (pthread_create(&p->worker, NULL, worker_main, p) != 0) {
+        sim_pipe_close(p);
+        return -1;
+    }
+    p->started = 1;
+    return 0;
+}
+
+void sim_pipe_submit(sim_pipe_t *p) {
+    if (p->cur->used == 0u) {
+        return;
+    }
+    p->submitted++;
+    if (!p->threaded) {
+        p->fn(p->ctx, p->cur->data, p->cur->used);
+        p->cur->used = 0;
+        return;
+    }
+
+    /* The full ring has room for every chunk, so only the free side can wait */
+    (void)sim_chunk_ring_push(&p->full, &p->cur);
+    while (sim_chunk_ring_pop(&p->free, &p->cur, 1u) == 0u) {
+        p->stalls++;
+        sched_yield();
+    }
+}
+
+void sim_pipe_drain(sim_pipe_t *p) {
+    sim_pipe_submit(p);
+    while (p->threaded && atomic_load(&p->consumed) != p->submitted) {
+        sched_yield();
+    }
+}
+
+void sim_pipe_close(sim_pipe_t *p) {
+    unsigned i;
+
+    if (p->started) {
+        sim_pipe_submit(p);
+        atomic_store(&p->stop, 1);
+        pthread_join(p->worker, NULL);
+        p->started = 0;
+    } else if (p->cur != NULL && !p->threaded) {
+        sim_pipe_submit(p);
+    }
+    sim_chunk_ring_free(&p->full);
+    sim_chunk_ring_free(&p->free);
+    if (p->chunks != NULL) {
+        for (i = 0; i < p->chunk_count; i++) {
+            free(p->chunks[i]);
+        }
+        free(p->chunks);
+    }
+    p->chunks = NULL;
+    p->cur = NULL;
+}
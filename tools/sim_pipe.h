@@ -0,0 +1,85 @@
+/*
+ * Producer -> worker-thread record pipe for the host simulator.
+ *
+ * The simulating thread appends fixed-size records (trace accesses,
+ * profile samples, captured frames) into the current chunk with
+ * sim_pipe_reserve. A full chunk goes to the worker through one SPSC ring
+ * (spsc_ring.h) and an empty one comes back through another, so the
+ * simulating thread never formats, compresses or writes anything; it only
+ * waits when every chunk is still queued (counted in stalls).
+ *
+ * Unthreaded pipes (rvsim --no-threads, or a host without threads to
+ * spare) call the consumer directly from sim_pipe_submit: the same output
+ * in the same order, on one core.
+ */
+
+#ifndef SIM_PIPE_H
+#define SIM_PIPE_H
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdint.h>
+
+#include "spsc_ring.h"
+
+/* Consume bytes of records (a whole number of them) */
+typedef void (*sim_pipe_fn)(void *ctx, const uint8_t *data, uint32_t bytes);
+
+typedef struct {
+    uint32_t used;
+    uint32_t pad;
+    uint8_t data[];             /* 8-byte aligned */
+} sim_chunk_t;
+
+/* Named so that the ring's `const type *` is a pointer to a const pointer */
+typedef sim_chunk_t *sim_chunk_ptr;
+SPSC_RING_DEFINE(sim_chunk_ring, sim_chunk_ptr)
+
+typedef struct {
+    const char *name;
+    sim_pipe_fn fn;
+    void *ctx;
+    int threaded;
+    uint32_t chunk_bytes;
+
+    sim_chunk_t *cur;           /* producer's chunk */
+    sim_chunk_t **chunks;
+    unsigned chunk_count;
+    sim_chunk_ring_t full;      /* producer -> worker */
+    sim_chunk_ring_t free;      /* worker -> producer */
+    pthread_t worker;
+    atomic_int stop;
+    int started;
+
+    uint64_t submitted;         /* chunks */
+    atomic_ullong consumed;     /* chunks the consumer has finished */
+    uint64_t stalls;            /* producer waits for a free chunk */
+} sim_pipe_t;
+
+/* chunk_count chunks of chunk_bytes each (>= the largest record). Returns 0 on success. */
+int sim_pipe_open(sim_pipe_t *p, const char *name, uint32_t chunk_bytes, unsigned chunk_count, int threaded,
+                  sim_pipe_fn fn, void *ctx);
+
+/* Hand the current chunk to the consumer and start a new one */
+void sim_pipe_submit(sim_pipe_t *p);
+
+/* Submit the current chunk and wait until the consumer has finished everything */
+void sim_pipe_drain(sim_pipe_t *p);
+
+/* Submit what is left, then wait for the consumer to finish and free everything */
+void sim_pipe_close(sim_pipe_t *p);
+
+/* Room for one record of bytes (rounded up to 8) in the current chunk */
+static inline void *sim_pipe_reserve(sim_pipe_t *p, uint32_t bytes) {
+    void *rec;
+
+    bytes = (bytes + 7u) & ~7u;
+    if (p->chunk_bytes - p->cur->used < bytes) {
+        sim_pipe_submit(p);
+    }
+    rec = p->cur->data + p->cur->used;
+    p->cur->used += bytes;
+    return rec;
+}
+
+#endif
@@ -0,0 +1,69 @@
+/*
+ * Lock-free single-producer / single-consumer ring buffer.
+ *
+ * SPSC_RING_DEFINE(name, type) generates a ring of `type` elements with:
+ *   int  name_init(name_t *r, unsigned log2_capacity);
+ *   void name_free(name_t *r);
+ *   int  name_push(name_t *r, const type *item);     producer side, 0 if full
+ *   unsigned name_pop(name_t *r, type *out, unsigned max);  consumer side
+ *
+ * Head and tail live on separate cache lines; each side only writes its
+ * own index, so the only synchronization is one acquire/release pair.
+ */
+
+#ifndef SPSC_RING_H
+#define SPSC_RING_H
+
+#include <stdatomic.h>
+#include <stdlib.h>
+
+#define SPSC_RING_CACHE_LINE 64
+
+#define SPSC_RING_DEFINE(name, type)                                            \
+    typedef struct {                                                            \
+        _Alignas(SPSC_RING_CACHE_LINE) atomic_uint head; /* producer writes */  \
+        _Alignas(SPSC_RING_CACHE_LINE) atomic_uint tail; /* consumer writes */  \
+        _Alignas(SPSC_RING_CACHE_LINE) type *slots;                             \
+        unsigned mask;                                                          \
+    } name##_t;                                                                 \
+                                                                                \
+    static inline int name##_init(name##_t *r, unsigned log2_capacity) {        \
+        r->mask = (1u << log2_capacity) - 1u;                                   \
+        r->slots = (type *)calloc((size_t)r->mask + 1u, sizeof(type));          \
+        atomic_init(&r->head, 0u);                                              \
+        atomic_init(&r->tail, 0u);                                              \
+        return r->slots != NULL ? 0 : -1;                                       \
+    }                                                                           \
+                                                                                \
+    static inline void name##_free(name##_t *r) {                               \
+        free(r->slots);                                                         \
+        r->slots = NULL;                                                        \
+    }                                                                           \
+                                                                                \
+    static inline int name##_push(name##_t *r, const type *item) {              \
+        unsigned head = atomic_load_explicit(&r->head, memory_order_relaxed);   \
+        unsigned tail = atomic_load_explicit(&r->tail, memory_order_acquire);   \
+        if (head - tail > r->mask) {                                            \
+            return 0;                                                           \
+        }                                                                       \
+        r->slots[head & r->mask] = *item;                                       \
+        atomic_store_explicit(&r->head, head + 1u, memory_order_release);       \
+        return 1;                                                               \
+    }                                                                           \
+                                                                                \
+    static inline unsigned name##_pop(name##_t *r, type *out, unsigned max) {   \
+        unsigned tail = atomic_load_explicit(&r->tail, memory_order_relaxed);   \
+        unsigned head = atomic_load_explicit(&r->head, memory_order_acquire);   \
+        unsigned n = head - tail;                                               \
+        unsigned i;                                                             \
+        if (n > max) {                                                          \
+            n = max;                                                            \
+        }                                                                       \
+        for (i = 0; i < n; i++) {                                               \
+            out[i] = r->slots[(tail + i) & r->mask];                            \
+        }                                                                       \
+        atomic_store_explicit(&r->tail, tail + n, memory_order_release);        \
+        return n;                                                               \
+    }
+
+#endif
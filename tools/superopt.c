@@ -0,0 +1,1183 @@
+/*
+ * Superoptimizer for the small VGA packing kernels.
+ *
+ * Searches for the shortest straight-line RV32I ALU sequence computing each
+ * target, starting from a literal lowering of its C reference:
+ *   pack2        vga_pack_two_pixels_fast(even_x, odd_x)      (vga_driver.h)
+ *   pack4        pack_four_pixels_16(px_1..px_4)              (vga_driver.c)
+ *   pack8        pack_eight_pixels_32(px_1..px_8)             (vga_driver.c)
+ *   aos4_r/g/b   one channel of 4 Colors (12 bytes loaded as 3 little-endian
+ *                words) packed into 16 bits: the AoS-to-plane step of
+ *                write_quad_4_pixels
+ *
+ * Search, in this order:
+ *   exhaustive  every sequence of up to --max-len instructions over
+ *               {add sub and or xor, andi/ori/xori 0xf 0xf0 0xff -16,
+ *               slli/srli/srai by multiples of 4}; values that match an
+ *               earlier one on the test vectors are not extended. A hit here
+ *               is optimal over that set and ends the search.
+ *   window      each run of up to --window instructions with one live-out
+ *               value is replaced by a shorter exhaustive sequence over the
+ *               values it reads, repeated until nothing shrinks
+ *   stochastic  Metropolis walk (--iters, --seed) from the best sequence so
+ *               far: mutate an opcode, operand or immediate, or turn an
+ *               instruction into a move; the cost is output bits wrong on
+ *               the test vectors plus the live length. Windows run again on
+ *               anything it finds.
+ *
+ * Candidates are checked against the C reference without a solver:
+ *   - on every input, when the live input bits total at most 24 (pack2);
+ *   - otherwise bit by bit: the input bits each result bit can depend on are
+ *     tracked through the sequence (logic ops: union, shifts: move,
+ *     add/sub: all lower bits), unioned with those of the reference
+ *     lowering, and every assignment of that set is tried (at most 2^24).
+ * Such a candidate is "proven". One whose support is wider is only "tested"
+ * on --vectors random inputs and is never written to --header.
+ *
+ * The reference lowering is one instruction per C operator, not GCC -O2
+ * output, so "shorter" is against that baseline. --header writes only the
+ * kernels that beat it, each with a VGA_HAVE_<KERNEL> macro the callers
+ * test; the others keep their C code, which the compiler schedules and
+ * constant-folds freely.
+ *
+ * uint8_t arguments arrive zero-extended (RV32 psABI), so only their low 8
+ * bits are live.
+ *
+ * Usage:
+ *   tools/superopt [--target NAME]... [--max-len N] [--window N] [--iters N]
+ *                  [--seed N] [--vectors N] [--header OUT] [-v]
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <inttypes.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "rv32i_model.h"
+
+#define MAX_IN          8
+#define MAX_LEN         32
+#define MAX_VALS        (MAX_IN + MAX_LEN)
+#define NTESTS          64
+#define SUPPORT_WORDS   ((MAX_IN * 32) / 64)
+#define MAX_EXACT_BITS  24
+#define MAX_ASM_OPERANDS 30
+#define ERR_WEIGHT      4u
+
+typedef struct {
+    rv32i_op_t op;
+    uint8_t a;
+    uint8_t b;
+    int32_t imm;
+} sop_t;
+
+/* SSA: values 0..n_in-1 are the inputs, op[k] defines value n_in + k and the
+ * last one is the result. A move is "addi v, a, 0". */
+typedef struct {
+    uint32_t n_in;
+    uint32_t len;
+    sop_t op[MAX_LEN];
+} prog_t;
+
+typedef struct {
+    const char *name;
+    const char *kernel;
+    const char *doc;
+    uint32_t n_in;
+    uint32_t in_bits;
+    const char *in_type;
+    const char *arg[MAX_IN];
+    uint32_t (*ref)(const uint32_t *in);
+    void (*lower)(prog_t *p);
+} target_t;
+
+typedef enum {
+    VERDICT_WRONG = 0,
+    VERDICT_TESTED,
+    VERDICT_PROVEN
+} verdict_t;
+
+static const char *const verdict_names[] = { "wrong", "tested", "proven" };
+
+static const int32_t logic_imms[] = { 0x0F, 0xF0, 0xFF, -16 };
+static const rv32i_op_t logic_ops[] = { RV32I_OP_ANDI, RV32I_OP_ORI, RV32I_OP_XORI };
+static const rv32i_op_t shift_ops[] = { RV32I_OP_SLLI, RV32I_OP_SRLI, RV32I_OP_SRAI };
+static const rv32i_op_t reg_ops[] = { RV32I_OP_ADD, RV32I_OP_SUB, RV32I_OP_AND, RV32I_OP_OR, RV32I_OP_XOR };
+
+static uint64_t rng_state;
+static int verbose;
+static uint32_t verify_vectors = 1u << 20;
+
+static uint32_t rng_next(void) {
+    /* xorshift64* */
+    rng_state ^= rng_state >> 12;
+    rng_state ^= rng_state << 25;
+    rng_state ^= rng_state >> 27;
+    return (uint32_t)((rng_state * 0x2545F4914F6CDD1DULL) >> 32);
+}
+
+static uint32_t rng_below(uint32_t n) {
+    return (uint32_t)(((uint64_t)rng_next() * n) >> 32);
+}
+
+/* ---- C references and their literal lowerings ---- */
+
+static uint32_t ref_pack2(const uint32_t *in) {
+    return ((in[1] & 0x0Fu) << 4) | (in[0] & 0x0Fu);
+}
+
+static uint32_t ref_pack4(const uint32_t *in) {
+    return ((in[3] & 0x0Fu) << 12) | ((in[2] & 0x0Fu) << 8) | ((in[1] & 0x0Fu) << 4) | (in[0] & 0x0Fu);
+}
+
+static uint32_t ref_pack8(const uint32_t *in) {
+    uint32_t out = 0;
+    for (uint32_t i = 0; i < 8u; ++i) {
+        out |= (in[i] & 0x0Fu) << (i * 4u);
+    }
+    return out;
+}
+
+/* Color c[4] = {r, g, b} x 4 as bytes 0..11 of the little-endian words in[0..2] */
+static uint32_t aos4_plane(const uint32_t *in, uint32_t plane) {
+    uint32_t out = 0;
+    for (uint32_t px = 0; px < 4u; ++px) {
+        uint32_t byte = px * 3u + plane;
+        out |= ((in[byte >> 2] >> ((byte & 3u) * 8u)) & 0x0Fu) << (px * 4u);
+    }
+    return out;
+}
+
+static uint32_t ref_aos4_r(const uint32_t *in) { return aos4_plane(in, 0u); }
+static uint32_t ref_aos4_g(const uint32_t *in) { return aos4_plane(in, 1u); }
+static uint32_t ref_aos4_b(const uint32_t *in) { return aos4_plane(in, 2u); }
+
+static uint8_t emit(prog_t *p, rv32i_op_t op, uint32_t a, uint32_t b, int32_t imm) {
+    sop_t *s = &p->op[p->len++];
+    s->op = op;
+    s->a = (uint8_t)a;
+    s->b = (uint8_t)b;
+    s->imm = imm;
+    return (uint8_t)(p->n_in + p->len - 1u);
+}
+
+/* (in[0] & 0xF) | ((in[i] & 0xF) << 4i) | ... */
+static void lower_pack(prog_t *p) {
+    uint32_t acc = emit(p, RV32I_OP_ANDI, 0, 0, 0x0F);
+    for (uint32_t i = 1; i < p->n_in; ++i) {
+        uint32_t t = emit(p, RV32I_OP_ANDI, i, 0, 0x0F);
+        t = emit(p, RV32I_OP_SLLI, t, 0, (int32_t)(i * 4u));
+        acc = emit(p, RV32I_OP_OR, acc, t, 0);
+    }
+}
+
+/* ((w >> from) & 0xF) << to for each nibble, then or'ed */
+static void lower_aos4(prog_t *p, uint32_t plane) {
+    uint32_t acc = 0;
+    for (uint32_t px = 0; px < 4u; ++px) {
+        uint32_t byte = px * 3u + plane;
+        uint32_t from = (byte & 3u) * 8u;
+        uint32_t to = px * 4u;
+        uint32_t t = byte >> 2;
+        if (from != 0u) {
+            t = emit(p, RV32I_OP_SRLI, t, 0, (int32_t)from);
+        }
+        t = emit(p, RV32I_OP_ANDI, t, 0, 0x0F);
+        if (to != 0u) {
+            t = emit(p, RV32I_OP_SLLI, t, 0, (int32_t)to);
+        }
+        acc = (px == 0u) ? t : emit(p, RV32I_OP_OR, acc, t, 0);
+    }
+}
+
+static void lower_aos4_r(prog_t *p) { lower_aos4(p, 0u); }
+static void lower_aos4_g(prog_t *p) { lower_aos4(p, 1u); }
+static void lower_aos4_b(prog_t *p) { lower_aos4(p, 2u); }
+
+static const target_t targets[] = {
+    { "pack2", "vga_pack_two_pixels_asm",
+      "vga_pack_two_pixels_fast(even_x, odd_x)",
+      2, 8, "uint8_t", { "even_x", "odd_x" }, ref_pack2, lower_pack },
+    { "pack4", "vga_pack_four_pixels_asm",
+      "pack_four_pixels_16(px_1, ..., px_4)",
+      4, 8, "uint8_t", { "px_1", "px_2", "px_3", "px_4" }, ref_pack4, lower_pack },
+    { "pack8", "vga_pack_eight_pixels_asm",
+      "pack_eight_pixels_32(px_1, ..., px_8)",
+      8, 8, "uint8_t", { "px_1", "px_2", "px_3", "px_4", "px_5", "px_6", "px_7", "px_8" },
+      ref_pack8, lower_pack },
+    { "aos4_r", "vga_aos4_red_asm",
+      "pack_four_pixels_16(c[0].r, ..., c[3].r), c[0..3] loaded as words w0..w2",
+      3, 32, "uint32_t", { "w0", "w1", "w2" }, ref_aos4_r, lower_aos4_r },
+    { "aos4_g", "vga_aos4_green_asm",
+      "pack_four_pixels_16(c[0].g, ..., c[3].g), c[0..3] loaded as words w0..w2",
+      3, 32, "uint32_t", { "w0", "w1", "w2" }, ref_aos4_g, lower_aos4_g },
+    { "aos4_b", "vga_aos4_blue_asm",
+      "pack_four_pixels_16(c[0].b, ..., c[3].b), c[0..3] loaded as words w0..w2",
+      3, 32, "uint32_t", { "w0", "w1", "w2" }, ref_aos4_b, lower_aos4_b },
+};
+
+#define TARGET_COUNT (sizeof(targets) / sizeof(targets[0]))
+
+/* ---- evaluation ---- */
+
+static int is_imm_op(rv32i_op_t op) {
+    return op >= RV32I_OP_ADDI && op <= RV32I_OP_SRAI;
+}
+
+static int is_move(const sop_t *s) {
+    return s->op == RV32I_OP_ADDI && s->imm == 0;
+}
+
+static uint32_t eval(const prog_t *p, const uint32_t *in) {
+    uint32_t v[MAX_VALS];
+
+    memcpy(v, in, p->n_in * sizeof(v[0]));
+    for (uint32_t k = 0; k < p->len; ++k) {
+        const sop_t *s = &p->op[k];
+        uint32_t b = is_imm_op(s->op) ? (uint32_t)s->imm : v[s->b];
+        v[p->n_in + k] = rv32i_alu(s->op, v[s->a], b);
+    }
+    return v[p->n_in + p->len - 1u];
+}
+
+static uint32_t in_mask(const target_t *t) {
+    return (t->in_bits == 32u) ? 0xFFFFFFFFu : ((1u << t->in_bits) - 1u);
+}
+
+static void random_inputs(const target_t *t, uint32_t *in) {
+    for (uint32_t i = 0; i < t->n_in; ++i) {
+        in[i] = rng_next() & in_mask(t);
+    }
+}
+
+typedef struct {
+    uint32_t in[NTESTS][MAX_IN];
+    uint32_t expect[NTESTS];
+} tests_t;
+
+static void make_tests(const target_t *t, tests_t *ts) {
+    for (uint32_t n = 0; n < NTESTS; ++n) {
+        if (n == 0u || n == 1u) {
+            for (uint32_t i = 0; i < t->n_in; ++i) {
+                ts->in[n][i] = (n == 0u) ? 0u : in_mask(t);
+            }
+        } else {
+            random_inputs(t, ts->in[n]);
+        }
+        ts->expect[n] = t->ref(ts->in[n]);
+    }
+}
+
+static uint32_t test_errors(const prog_t *p, const tests_t *ts) {
+    uint32_t bits = 0;
+    for (uint32_t n = 0; n < NTESTS; ++n) {
+        bits += (uint32_t)__builtin_popcount(eval(p, ts->in[n]) ^ ts->expect[n]);
+    }
+    return bits;
+}
+
+/* ---- liveness / compaction ---- */
+
+static void mark_live(const prog_t *p, uint8_t *live) {
+    memset(live, 0, MAX_VALS);
+    live[p->n_in + p->len - 1u] = 1u;
+    for (uint32_t k = p->len; k-- > 0u;) {
+        const sop_t *s = &p->op[k];
+        if (!live[p->n_in + k]) {
+            continue;
+        }
+        live[s->a] = 1u;
+        if (!is_imm_op(s->op)) {
+            live[s->b] = 1u;
+        }
+    }
+}
+
+static uint32_t live_length(const prog_t *p) {
+    uint8_t live[MAX_VALS];
+    uint32_t n = 0;
+
+    mark_live(p, live);
+    for (uint32_t k = 0; k < p->len; ++k) {
+        n += live[p->n_in + k] && !is_move(&p->op[k]);
+    }
+    return n;
+}
+
+/* Drop dead instructions and moves. Returns 0 if nothing is left to emit. */
+static int compact(const prog_t *p, prog_t *out) {
+    uint8_t live[MAX_VALS];
+    uint8_t map[MAX_VALS];
+    uint32_t result = p->n_in + p->len - 1u;
+
+    mark_live(p, live);
+    memset(out, 0, sizeof(*out));
+    out->n_in = p->n_in;
+    for (uint32_t i = 0; i < p->n_in; ++i) {
+        map[i] = (uint8_t)i;
+    }
+    for (uint32_t k = 0; k < p->len; ++k) {
+        const sop_t *s = &p->op[k];
+        uint32_t v = p->n_in + k;
+        if (!live[v]) {
+            continue;
+        }
+        if (is_move(s)) {
+            map[v] = map[s->a];
+        } else {
+            map[v] = emit(out, s->op, map[s->a], is_imm_op(s->op) ? 0u : map[s->b], s->imm);
+        }
+    }
+    return out->len != 0u && map[result] == out->n_in + out->len - 1u;
+}
+
+/* ---- verification ---- */
+
+typedef struct {
+    uint64_t w[SUPPORT_WORDS];
+} bitset_t;
+
+static bitset_t sup[MAX_VALS][32];
+
+static void bs_or(bitset_t *d, const bitset_t *s) {
+    for (uint32_t i = 0; i < SUPPORT_WORDS; ++i) {
+        d->w[i] |= s->w[i];
+    }
+}
+
+/* For each result bit, the input bits (in * 32 + bit) it may depend on. */
+static void support(const target_t *t, const prog_t *p, bitset_t out[32]) {
+    memset(sup, 0, sizeof(sup));
+    for (uint32_t i = 0; i < p->n_in; ++i) {
+        for (uint32_t j = 0; j < t->in_bits; ++j) {
+            uint32_t bit = i * 32u + j;
+            sup[i][j].w[bit >> 6] = 1ull << (bit & 63u);
+        }
+    }
+    for (uint32_t k = 0; k < p->len; ++k) {
+        const sop_t *s = &p->op[k];
+        bitset_t *d = sup[p->n_in + k];
+        const bitset_t *a = sup[s->a];
+        const bitset_t *b = sup[s->b];
+        uint32_t imm = (uint32_t)s->imm;
+        uint32_t sh = imm & 31u;
+        bitset_t carry;
+
+        memset(&carry, 0, sizeof(carry));
+        for (uint32_t j = 0; j < 32u; ++j) {
+            switch (s->op) {
+            case RV32I_OP_AND: case RV32I_OP_OR: case RV32I_OP_XOR:
+                d[j] = a[j];
+                bs_or(&d[j], &b[j]);
+                break;
+            case RV32I_OP_ANDI:
+                if ((imm >> j) & 1u) {
+                    d[j] = a[j];
+                }
+                break;
+            case RV32I_OP_ORI:
+                if (!((imm >> j) & 1u)) {
+                    d[j] = a[j];
+                }
+                break;
+            case RV32I_OP_XORI:
+                d[j] = a[j];
+                break;
+            case RV32I_OP_SLLI:
+                if (j >= sh) {
+                    d[j] = a[j - sh];
+                }
+                break;
+            case RV32I_OP_SRLI:
+                if (j + sh < 32u) {
+                    d[j] = a[j + sh];
+                }
+                break;
+            case RV32I_OP_SRAI:
+                d[j] = a[(j + sh < 32u) ? j + sh : 31u];
+                break;
+            case RV32I_OP_ADD: case RV32I_OP_SUB: case RV32I_OP_ADDI:
+                /* bit j sees every lower bit through the carry chain */
+                bs_or(&carry, &a[j]);
+                if (!is_imm_op(s->op)) {
+                    bs_or(&carry, &b[j]);
+                }
+                d[j] = carry;
+                break;
+            default:
+                for (uint32_t x = 0; x < 32u; ++x) {
+                    bs_or(&d[j], &a[x]);
+                    if (!is_imm_op(s->op)) {
+                        bs_or(&d[j], &b[x]);
+                    }
+                }
+                break;
+            }
+        }
+    }
+    memcpy(out, sup[p->n_in + p->len - 1u], 32u * sizeof(bitset_t));
+}
+
+static verdict_t verify(const target_t *t, const prog_t *p, const prog_t *ref_prog) {
+    uint32_t in[MAX_IN];
+    uint32_t total_bits = t->n_in * t->in_bits;
+    bitset_t sc[32];
+    bitset_t sr[32];
+
+    if (total_bits <= MAX_EXACT_BITS) {
+        for (uint32_t x = 0; x < (1u << total_bits); ++x) {
+            for (uint32_t i = 0; i < t->n_in; ++i) {
+                in[i] = (x >> (i * t->in_bits)) & in_mask(t);
+            }
+            if (eval(p, in) != t->ref(in)) {
+                return VERDICT_WRONG;
+            }
+        }
+        return VERDICT_PROVEN;
+    }
+
+    support(t, p, sc);
+    support(t, ref_prog, sr);
+    for (uint32_t j = 0; j < 32u; ++j) {
+        uint32_t bits[MAX_EXACT_BITS];
+        uint32_t n = 0;
+        bs_or(&sc[j], &sr[j]);
+        for (uint32_t x = 0; x < MAX_IN * 32u && n <= MAX_EXACT_BITS; ++x) {
+            if ((sc[j].w[x >> 6] >> (x & 63u)) & 1u) {
+                if (n == MAX_EXACT_BITS) {
+                    ++n;
+                    break;
+                }
+                bits[n++] = x;
+            }
+        }
+        if (n > MAX_EXACT_BITS) {
+            goto sampled;
+        }
+        for (uint32_t x = 0; x < (1u << n); ++x) {
+            /* bits outside the set cannot reach bit j: any background will do */
+            random_inputs(t, in);
+            for (uint32_t k = 0; k < n; ++k) {
+                uint32_t m = 1u << (bits[k] & 31u);
+                in[bits[k] >> 5] = ((x >> k) & 1u) ? (in[bits[k] >> 5] | m) : (in[bits[k] >> 5] & ~m);
+            }
+            if (((eval(p, in) ^ t->ref(in)) >> j) & 1u) {
+                return VERDICT_WRONG;
+            }
+        }
+    }
+    return VERDICT_PROVEN;
+
+sampled:
+    for (uint32_t n = 0; n < verify_vectors; ++n) {
+        random_inputs(t, in);
+        if (eval(p, in) != t->ref(in)) {
+            return VERDICT_WRONG;
+        }
+    }
+    return VERDICT_TESTED;
+}
+
+/* ---- exhaustive search ---- */
+
+typedef struct search search_t;
+
+struct search {
+    prog_t cur;
+    uint32_t vec[MAX_VALS][NTESTS];
+    const uint32_t *expect;
+    uint32_t uses[MAX_VALS];
+    int all_inputs;                 /* every input has to be read */
+    int (*accept)(search_t *s);     /* full check of a test-vector match */
+    const target_t *t;
+    const prog_t *ref_prog;
+    void *ctx;
+    uint64_t nodes;
+    int found;
+    prog_t hit;
+};
+
+static int dfs(search_t *s, uint32_t remaining);
+
+/* Append op, prune, and recurse; returns nonzero once a hit is accepted. */
+static int try_op(search_t *s, rv32i_op_t op, uint32_t a, uint32_t b, int32_t imm, uint32_t remaining) {
+    uint32_t nv = s->cur.n_in + s->cur.len;
+    uint32_t *vec = s->vec[nv];
+    uint32_t unused = 0;
+    int same = 1;
+
+    ++s->nodes;
+    for (uint32_t n = 0; n < NTESTS; ++n) {
+        vec[n] = rv32i_alu(op, s->vec[a][n], is_imm_op(op) ? (uint32_t)imm : s->vec[b][n]);
+        same &= vec[n] == vec[0];
+    }
+    if (same) {
+        return 0;
+    }
+    if (remaining == 1u) {
+        if (memcmp(vec, s->expect, NTESTS * sizeof(uint32_t)) != 0) {
+            return 0;
+        }
+    } else {
+        for (uint32_t v = 0; v < nv; ++v) {
+            if (memcmp(vec, s->vec[v], NTESTS * sizeof(uint32_t)) == 0) {
+                return 0;
+            }
+        }
+    }
+
+    emit(&s->cur, op, a, b, imm);
+    ++s->uses[a];
+    if (!is_imm_op(op)) {
+        ++s->uses[b];
+    }
+    for (uint32_t v = 0; v <= nv; ++v) {
+        unused += s->uses[v] == 0u;
+    }
+    if (remaining == 1u) {
+        if ((!s->all_inputs || unused == 1u) && s->accept(s)) {
+            s->hit = s->cur;
+            s->found = 1;
+        }
+    } else if (!s->all_inputs || unused <= remaining) {
+        /* each later instruction uses at most two values and adds one */
+        dfs(s, remaining - 1u);
+    }
+    --s->uses[a];
+    if (!is_imm_op(op)) {
+        --s->uses[b];
+    }
+    --s->cur.len;
+    return s->found;
+}
+
+static int dfs(search_t *s, uint32_t remaining) {
+    uint32_t nv = s->cur.n_in + s->cur.len;
+
+    for (uint32_t a = 0; a < nv; ++a) {
+        for (uint32_t b = 0; b < nv; ++b) {
+            for (uint32_t o = 0; o < sizeof(reg_ops) / sizeof(reg_ops[0]); ++o) {
+                if (a == b || (reg_ops[o] != RV32I_OP_SUB && a > b)) {
+                    continue;
+                }
+                if (try_op(s, reg_ops[o], a, b, 0, remaining)) {
+                    return 1;
+                }
+            }
+        }
+        for (uint32_t o = 0; o < sizeof(logic_ops) / sizeof(logic_ops[0]); ++o) {
+            for (uint32_t i = 0; i < sizeof(logic_imms) / sizeof(logic_imms[0]); ++i) {
+                if (try_op(s, logic_ops[o], a, 0, logic_imms[i], remaining)) {
+                    return 1;
+                }
+            }
+        }
+        for (uint32_t o = 0; o < sizeof(shift_ops) / sizeof(shift_ops[0]); ++o) {
+            for (int32_t sh = 4; sh < 32; sh += 4) {
+                if (try_op(s, shift_ops[o], a, 0, sh, remaining)) {
+                    return 1;
+                }
+            }
+        }
+    }
+    return 0;
+}
+
+/* Iterative deepening: length of the first accepted hit (in s->hit), or 0. */
+static uint32_t enumerate(search_t *s, uint32_t max_len) {
+    for (uint32_t len = 1; len <= max_len && s->cur.n_in + len <= MAX_VALS; ++len) {
+        if (s->all_inputs && s->cur.n_in > len + 1u) {
+            continue;
+        }
+        dfs(s, len);
+        if (s->found) {
+            return len;
+        }
+    }
+    return 0;
+}
+
+static int accept_proven(search_t *s) {
+    return verify(s->t, &s->cur, s->ref_prog) == VERDICT_PROVEN;
+}
+
+/* Shortest proven sequence of at most max_len instructions; 0 if none. */
+static uint32_t exhaustive(const target_t *t, const tests_t *ts, const prog_t *ref_prog,
+                           uint32_t max_len, prog_t *best, uint64_t *nodes) {
+    static search_t s;
+    uint32_t len;
+
+    memset(&s, 0, sizeof(s));
+    s.cur.n_in = t->n_in;
+    s.expect = ts->expect;
+    s.all_inputs = 1;
+    s.accept = accept_proven;
+    s.t = t;
+    s.ref_prog = ref_prog;
+    for (uint32_t i = 0; i < t->n_in; ++i) {
+        for (uint32_t n = 0; n < NTESTS; ++n) {
+            s.vec[i][n] = ts->in[n][i];
+        }
+    }
+    len = enumerate(&s, max_len);
+    if (len != 0u) {
+        *best = s.hit;
+    }
+    *nodes = s.nodes;
+    return len;
+}
+
+/* ---- peephole windows ---- */
+
+/* One window of a program being rewritten: ops [k0, k0 + w) read the values
+ * in[] from before the window and only out is read after it. */
+typedef struct {
+    const prog_t *p;
+    uint32_t k0;
+    uint32_t w;
+    uint8_t in[MAX_IN];
+    uint32_t n_in;
+    uint32_t out;
+    prog_t result;
+} window_t;
+
+/* Program p with the window replaced by rep (whose inputs are win->in). */
+static void splice(const window_t *win, const prog_t *rep, prog_t *out) {
+    const prog_t *p = win->p;
+    uint32_t first = p->n_in + win->k0;
+    uint32_t after = first + win->w;
+    uint32_t new_out = first + rep->len - 1u;
+
+    memset(out, 0, sizeof(*out));
+    out->n_in = p->n_in;
+    for (uint32_t k = 0; k < win->k0; ++k) {
+        out->op[out->len++] = p->op[k];
+    }
+    for (uint32_t k = 0; k < rep->len; ++k) {
+        sop_t s = rep->op[k];
+        s.a = (uint8_t)((s.a < rep->n_in) ? win->in[s.a] : first + s.a - rep->n_in);
+        s.b = (uint8_t)((s.b < rep->n_in) ? win->in[s.b] : first + s.b - rep->n_in);
+        out->op[out->len++] = s;
+    }
+    for (uint32_t k = win->k0 + win->w; k < p->len; ++k) {
+        sop_t s = p->op[k];
+        s.a = (uint8_t)((s.a < first) ? s.a : (s.a < after) ? new_out : s.a - win->w + rep->len);
+        if (!is_imm_op(s.op)) {
+            s.b = (uint8_t)((s.b < first) ? s.b : (s.b < after) ? new_out : s.b - win->w + rep->len);
+        }
+        out->op[out->len++] = s;
+    }
+}
+
+static int accept_window(search_t *s) {
+    window_t *win = s->ctx;
+    prog_t cand;
+
+    splice(win, &s->cur, &cand);
+    if (verify(s->t, &cand, s->ref_prog) != VERDICT_PROVEN) {
+        return 0;
+    }
+    win->result = cand;
+    return 1;
+}
+
+/* Rewrite ops [k0, k0 + w) with a shorter proven sequence if there is one. */
+static int rewrite_window(const target_t *t, const tests_t *ts, const prog_t *ref_prog,
+                          const prog_t *p, uint32_t k0, uint32_t w, prog_t *out) {
+    static search_t s;
+    static uint32_t vals[NTESTS][MAX_VALS];
+    static uint32_t expect[NTESTS];
+    window_t win;
+    uint32_t first = p->n_in + k0;
+    uint32_t after = first + w;
+    uint32_t live_outs = 0;
+
+    memset(&win, 0, sizeof(win));
+    win.p = p;
+    win.k0 = k0;
+    win.w = w;
+    win.out = after - 1u;
+    for (uint32_t k = k0; k < k0 + w; ++k) {
+        const sop_t *op = &p->op[k];
+        uint8_t reads[2] = { op->a, op->b };
+        for (uint32_t r = 0; r < (is_imm_op(op->op) ? 1u : 2u); ++r) {
+            uint32_t i;
+            if (reads[r] >= first) {
+                continue;
+            }
+            for (i = 0; i < win.n_in && win.in[i] != reads[r]; ++i) {
+            }
+            if (i == win.n_in) {
+                if (win.n_in == MAX_IN) {
+                    return 0;
+                }
+                win.in[win.n_in++] = reads[r];
+            }
+        }
+    }
+    for (uint32_t v = first; v < after; ++v) {
+        int used = (v == p->n_in + p->len - 1u);
+        for (uint32_t k = k0 + w; k < p->len && !used; ++k) {
+            used = p->op[k].a == v || (!is_imm_op(p->op[k].op) && p->op[k].b == v);
+        }
+        if (used) {
+            win.out = v;
+            ++live_outs;
+        }
+    }
+    if (live_outs != 1u) {
+        return 0;
+    }
+
+    for (uint32_t n = 0; n < NTESTS; ++n) {
+        memcpy(vals[n], ts->in[n], p->n_in * sizeof(uint32_t));
+        for (uint32_t k = 0; k < p->len; ++k) {
+            const sop_t *op = &p->op[k];
+            uint32_t b = is_imm_op(op->op) ? (uint32_t)op->imm : vals[n][op->b];
+            vals[n][p->n_in + k] = rv32i_alu(op->op, vals[n][op->a], b);
+        }
+    }
+    memset(&s, 0, sizeof(s));
+    s.cur.n_in = win.n_in;
+    for (uint32_t i = 0; i < win.n_in; ++i) {
+        for (uint32_t n = 0; n < NTESTS; ++n) {
+            s.vec[i][n] = vals[n][win.in[i]];
+        }
+    }
+    for (uint32_t n = 0; n < NTESTS; ++n) {
+        expect[n] = vals[n][win.out];
+    }
+    s.expect = expect;
+    s.accept = accept_window;
+    s.t = t;
+    s.ref_prog = ref_prog;
+    s.ctx = &win;
+    if (enumerate(&s, w - 1u) == 0u) {
+        return 0;
+    }
+    *out = win.result;
+    return 1;
+}
+
+/* Slide windows of up to max_window ops over *best until none shrinks. */
+static uint32_t peephole(const target_t *t, const tests_t *ts, const prog_t *ref_prog,
+                         uint32_t max_window, prog_t *best) {
+    uint32_t rewrites = 0;
+    int changed = 1;
+
+    while (changed) {
+        changed = 0;
+        for (uint32_t w = max_window; w >= 2u && !changed; --w) {
+            for (uint32_t k0 = 0; k0 + w <= best->len && !changed; ++k0) {
+                prog_t next;
+                if (rewrite_window(t, ts, ref_prog, best, k0, w, &next)) {
+                    if (verbose) {
+                        fprintf(stderr, "  %s: ops %u..%u rewritten, %u -> %u instructions\n",
+                                t->name, k0, k0 + w - 1u, best->len, next.len);
+                    }
+                    *best = next;
+                    ++rewrites;
+                    changed = 1;
+                }
+            }
+        }
+    }
+    return rewrites;
+}
+
+/* ---- stochastic search ---- */
+
+static void random_operand_imm(sop_t *s) {
+    if (s->op == RV32I_OP_SLLI || s->op == RV32I_OP_SRLI || s->op == RV32I_OP_SRAI) {
+        s->imm = (int32_t)(1u + rng_below(31u));
+    } else if (rng_next() & 1u) {
+        s->imm = logic_imms[rng_below(sizeof(logic_imms) / sizeof(logic_imms[0]))];
+    } else {
+        s->imm = (int32_t)(rng_below(4096u)) - 2048;
+    }
+}
+
+static void random_op(sop_t *s) {
+    uint32_t n_reg = sizeof(reg_ops) / sizeof(reg_ops[0]);
+    uint32_t n_logic = sizeof(logic_ops) / sizeof(logic_ops[0]);
+    uint32_t n_shift = sizeof(shift_ops) / sizeof(shift_ops[0]);
+    uint32_t pick = rng_below(n_reg + n_logic + n_shift);
+
+    s->op = (pick < n_reg) ? reg_ops[pick]
+          : (pick < n_reg + n_logic) ? logic_ops[pick - n_reg]
+          : shift_ops[pick - n_reg - n_logic];
+}
+
+static void mutate(prog_t *p) {
+    uint32_t k = rng_below(p->len);
+    sop_t *s = &p->op[k];
+    uint32_t nv = p->n_in + k;
+
+    switch (rng_below(5u)) {
+    case 0: {
+        int was_imm = is_imm_op(s->op);
+        random_op(s);
+        if (is_imm_op(s->op)) {
+            random_operand_imm(s);
+        } else if (was_imm) {
+            s->b = (uint8_t)rng_below(nv);
+        }
+        break;
+    }
+    case 1:
+        s->a = (uint8_t)rng_below(nv);
+        break;
+    case 2:
+        if (is_imm_op(s->op)) {
+            random_operand_imm(s);
+        } else {
+            s->b = (uint8_t)rng_below(nv);
+        }
+        break;
+    case 3:
+        s->op = RV32I_OP_ADDI;
+        s->imm = 0;
+        break;
+    default:
+        random_op(s);
+        s->a = (uint8_t)rng_below(nv);
+        s->b = (uint8_t)rng_below(nv);
+        if (is_imm_op(s->op)) {
+            random_operand_imm(s);
+        }
+        break;
+    }
+}
+
+static uint32_t cost_of(const prog_t *p, const tests_t *ts, uint32_t *errors) {
+    *errors = test_errors(p, ts);
+    return *errors * ERR_WEIGHT + live_length(p);
+}
+
+/* Walks from *best (a proven sequence) and improves it in place; returns
+ * the number of improvements. */
+static uint32_t stochastic(const target_t *t, const tests_t *ts, const prog_t *ref_prog,
+                           uint64_t iters, prog_t *best) {
+    prog_t cur = *best;
+    uint32_t errors;
+    uint32_t cost = cost_of(&cur, ts, &errors);
+    uint32_t hits = 0;
+
+    for (uint64_t it = 0; it < iters; ++it) {
+        prog_t next = cur;
+        uint32_t next_cost;
+        mutate(&next);
+        next_cost = cost_of(&next, ts, &errors);
+        if (next_cost > cost) {
+            uint32_t d = next_cost - cost;
+            /* accept a worse sequence with probability 2^-d */
+            if (d >= 32u || (rng_next() & ((1u << d) - 1u)) != 0u) {
+                continue;
+            }
+        }
+        cur = next;
+        cost = next_cost;
+        if (errors == 0u && live_length(&cur) < best->len) {
+            prog_t c;
+            if (compact(&cur, &c) && verify(t, &c, ref_prog) == VERDICT_PROVEN) {
+                *best = c;
+                ++hits;
+                if (verbose) {
+                    fprintf(stderr, "  %s: %u instructions at iteration %" PRIu64 "\n", t->name, c.len, it);
+                }
+            }
+        }
+    }
+    return hits;
+}
+
+/* ---- output ---- */
+
+static void format_imm(char *buf, size_t size, int32_t imm) {
+    if (imm < 10) {
+        snprintf(buf, size, "%d", (int)imm);
+    } else {
+        snprintf(buf, size, "0x%x", (unsigned)imm);
+    }
+}
+
+/* Operand names for the listing: inputs by argument name, temporaries t<k>. */
+static const char *value_name(const target_t *t, const prog_t *p, uint32_t v, char *buf, size_t size) {
+    if (v < p->n_in) {
+        return t->arg[v];
+    }
+    snprintf(buf, size, "t%u", v - p->n_in);
+    return buf;
+}
+
+static void list_prog(FILE *fp, const target_t *t, const prog_t *p) {
+    for (uint32_t k = 0; k < p->len; ++k) {
+        const sop_t *s = &p->op[k];
+        char rd[8];
+        char a[8];
+        char b[16];
+        value_name(t, p, p->n_in + k, rd, sizeof(rd));
+        if (is_imm_op(s->op)) {
+            format_imm(b, sizeof(b), s->imm);
+        } else {
+            snprintf(b, sizeof(b), "%s", value_name(t, p, s->b, a, sizeof(a)));
+        }
+        fprintf(fp, "    %-5s %s, %s, %s\n", rv32i_op_name(s->op), rd,
+                value_name(t, p, s->a, a, sizeof(a)), b);
+    }
+}
+
+/* Map SSA values onto asm operands: inputs are "+r" copies %0..%n-1 that may
+ * be overwritten once dead, extra temporaries follow. Returns the operand
+ * count, or 0 if it exceeds what GCC accepts. */
+static uint32_t allocate(const prog_t *p, uint8_t *slot, uint32_t *result_slot) {
+    int32_t last_use[MAX_VALS];
+    uint8_t busy[MAX_VALS];
+    uint32_t n_slots = p->n_in;
+    uint32_t result = p->n_in + p->len - 1u;
+
+    for (uint32_t v = 0; v < MAX_VALS; ++v) {
+        last_use[v] = -1;
+    }
+    for (uint32_t k = 0; k < p->len; ++k) {
+        last_use[p->op[k].a] = (int32_t)k;
+        if (!is_imm_op(p->op[k].op)) {
+            last_use[p->op[k].b] = (int32_t)k;
+        }
+    }
+    last_use[result] = (int32_t)p->len;
+    memset(busy, 0, sizeof(busy));
+    for (uint32_t i = 0; i < p->n_in; ++i) {
+        slot[i] = (uint8_t)i;
+        busy[i] = last_use[i] >= 0;
+    }
+    for (uint32_t k = 0; k < p->len; ++k) {
+        const sop_t *s = &p->op[k];
+        uint32_t v = p->n_in + k;
+        uint32_t pick = MAX_VALS;
+        if (last_use[s->a] == (int32_t)k) {
+            busy[slot[s->a]] = 0;
+            pick = slot[s->a];
+        }
+        if (!is_imm_op(s->op) && last_use[s->b] == (int32_t)k) {
+            busy[slot[s->b]] = 0;
+            if (pick == MAX_VALS) {
+                pick = slot[s->b];
+            }
+        }
+        for (uint32_t x = 0; x < n_slots && pick == MAX_VALS; ++x) {
+            if (!busy[x]) {
+                pick = x;
+            }
+        }
+        if (pick == MAX_VALS) {
+            pick = n_slots++;
+        }
+        slot[v] = (uint8_t)pick;
+        busy[pick] = 1u;
+    }
+    *result_slot = slot[result];
+    return (n_slots <= MAX_ASM_OPERANDS) ? n_slots : 0u;
+}
+
+static int write_kernel(FILE *fp, const target_t *t, const prog_t *p, uint32_t ref_len) {
+    uint8_t slot[MAX_VALS];
+    uint32_t result_slot;
+    uint32_t n_slots = allocate(p, slot, &result_slot);
+
+    if (n_slots == 0u) {
+        fprintf(stderr, "%s: too many asm operands\n", t->name);
+        return -1;
+    }
+    fprintf(fp, "\n// %s: %u instructions (literal lowering %u)\n", t->doc, p->len, ref_len);
+    fprintf(fp, "#define VGA_HAVE_");
+    for (const char *c = t->kernel + 4; *c != '\0'; ++c) {
+        fputc((*c >= 'a' && *c <= 'z') ? *c - 'a' + 'A' : *c, fp);
+    }
+    fprintf(fp, "\nstatic inline uint32_t %s(", t->kernel);
+    for (uint32_t i = 0; i < t->n_in; ++i) {
+        fprintf(fp, "%s%s %s", i ? ", " : "", t->in_type, t->arg[i]);
+    }
+    fprintf(fp, ") {\n    uint32_t ");
+    for (uint32_t i = 0; i < t->n_in; ++i) {
+        fprintf(fp, "%sr%u = %s", i ? ", " : "", i, t->arg[i]);
+    }
+    fprintf(fp, ";\n");
+    if (n_slots > t->n_in) {
+        fprintf(fp, "    uint32_t ");
+        for (uint32_t x = t->n_in; x < n_slots; ++x) {
+            fprintf(fp, "%sr%u", (x > t->n_in) ? ", " : "", x);
+        }
+        fprintf(fp, ";\n");
+    }
+    fprintf(fp, "    __asm__(\n");
+    for (uint32_t k = 0; k < p->len; ++k) {
+        const sop_t *s = &p->op[k];
+        char b[16];
+        if (is_imm_op(s->op)) {
+            format_imm(b, sizeof(b), s->imm);
+        } else {
+            snprintf(b, sizeof(b), "%%%u", slot[s->b]);
+        }
+        fprintf(fp, "        \"%s %%%u, %%%u, %s\\n\\t\"\n", rv32i_op_name(s->op),
+                slot[p->n_in + k], slot[s->a], b);
+    }
+    fprintf(fp, "        : ");
+    for (uint32_t x = 0; x < n_slots; ++x) {
+        fprintf(fp, "%s\"%s\"(r%u)", x ? ", " : "", (x < t->n_in) ? "+r" : "=r", x);
+    }
+    fprintf(fp, ");\n    return r%u;\n}\n", result_slot);
+    return 0;
+}
+
+static void usage(const char *argv0) {
+    fprintf(stderr,
+            "usage: %s [--target NAME]... [--max-len N] [--window N] [--iters N]\n"
+            "       [--seed N] [--vectors N] [--header OUT] [-v]\n"
+            "targets:",
+            argv0);
+    for (uint32_t i = 0; i < TARGET_COUNT; ++i) {
+        fprintf(stderr, " %s", targets[i].name);
+    }
+    fprintf(stderr, "\n");
+}
+
+int main(int argc, char **argv) {
+    uint8_t selected[TARGET_COUNT];
+    int any_selected = 0;
+    const char *header_path = NULL;
+    uint32_t max_len = 3u;
+    uint32_t window = 4u;
+    uint64_t iters = 1000000u;
+    uint64_t seed = 1u;
+    prog_t best[TARGET_COUNT];
+    uint32_t ref_len[TARGET_COUNT];
+    int failed = 0;
+
+    memset(selected, 0, sizeof(selected));
+    for (int i = 1; i < argc; ++i) {
+        if (strcmp(argv[i], "--target") == 0 && i + 1 < argc) {
+            uint32_t t;
+            ++i;
+            for (t = 0; t < TARGET_COUNT && strcmp(targets[t].name, argv[i]) != 0; ++t) {
+            }
+            if (t == TARGET_COUNT) {
+                fprintf(stderr, "unknown target '%s'\n", argv[i]);
+                usage(argv[0]);
+                return 2;
+            }
+            selected[t] = 1u;
+            any_selected = 1;
+        } else if (strcmp(argv[i], "--max-len") == 0 && i + 1 < argc) {
+            max_len = (uint32_t)strtoul(argv[++i], NULL, 0);
+        } else if (strcmp(argv[i], "--window") == 0 && i + 1 < argc) {
+            window = (uint32_t)strtoul(argv[++i], NULL, 0);
+        } else if (strcmp(argv[i], "--iters") == 0 && i + 1 < argc) {
+            iters = strtoull(argv[++i], NULL, 0);
+        } else if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc) {
+            seed = strtoull(argv[++i], NULL, 0);
+        } else if (strcmp(argv[i], "--vectors") == 0 && i + 1 < argc) {
+            verify_vectors = (uint32_t)strtoul(argv[++i], NULL, 0);
+        } else if (strcmp(argv[i], "--header") == 0 && i + 1 < argc) {
+            header_path = argv[++i];
+        } else if (strcmp(argv[i], "-v") == 0) {
+            verbose = 1;
+        } else {
+            usage(argv[0]);
+            return 2;
+        }
+    }
+    if (!any_selected) {
+        memset(selected, 1, sizeof(selected));
+    }
+    rng_state = (seed ^ 0x9E3779B97F4A7C15ULL) | 1u;
+
+    for (uint32_t i = 0; i < TARGET_COUNT; ++i) {
+        const target_t *t = &targets[i];
+        static tests_t ts;
+        prog_t ref_prog;
+        prog_t hit;
+        uint64_t nodes = 0;
+        uint32_t ex_len;
+        uint32_t ex_max;
+        uint32_t hits = 0;
+        uint32_t rewrites = 0;
+        verdict_t ref_verdict;
+
+        if (!selected[i]) {
+            continue;
+        }
+        memset(&ref_prog, 0, sizeof(ref_prog));
+        ref_prog.n_in = t->n_in;
+        t->lower(&ref_prog);
+        ref_len[i] = ref_prog.len;
+        make_tests(t, &ts);
+
+        /* The bit-support proof trusts the lowering to read the same bits as
+         * the C reference, so it has to check out on its own first. */
+        ref_verdict = verify(t, &ref_prog, &ref_prog);
+        if (ref_verdict != VERDICT_PROVEN) {
+            fprintf(stderr, "%s: reference lowering is %s\n", t->name, verdict_names[ref_verdict]);
+            failed = 1;
+            continue;
+        }
+        best[i] = ref_prog;
+
+        ex_max = (max_len < ref_prog.len) ? max_len : ref_prog.len - 1u;
+        ex_len = exhaustive(t, &ts, &ref_prog, ex_max, &hit, &nodes);
+        if (ex_len != 0u) {
+            best[i] = hit;
+        } else {
+            rewrites += peephole(t, &ts, &ref_prog, window, &best[i]);
+            if (iters != 0u && (hits = stochastic(t, &ts, &ref_prog, iters, &best[i])) != 0u) {
+                rewrites += peephole(t, &ts, &ref_prog, window, &best[i]);
+            }
+        }
+
+        printf("%-7s reference %2u  best %2u  ", t->name, ref_prog.len, best[i].len);
+        if (ex_len != 0u) {
+            printf("(optimal: exhaustive, %" PRIu64 " nodes)\n", nodes);
+        } else {
+            printf("(none <= %u in %" PRIu64 " nodes; %u window rewrites, %u stochastic)\n",
+                   ex_max, nodes, rewrites, hits);
+        }
+        list_prog(stdout, t, &best[i]);
+    }
+    if (failed) {
+        return 1;
+    }
+
+    if (header_path != NULL) {
+        FILE *fp = fopen(header_path, "w");
+        if (fp == NULL) {
+            perror(header_path);
+            return 1;
+        }
+        fprintf(fp, "/* Generated by tools/superopt --seed %" PRIu64 " --iters %" PRIu64
+                    " --max-len %u --window %u;\n * do not edit.\n", seed, iters, max_len, window);
+        fprintf(fp, " * Every kernel is proven equal to its C reference on all inputs\n"
+                    " * (see tools/superopt.c). Results have no bits set above the packed\n"
+                    " * pixels. Only kernels shorter than the literal lowering of the C\n"
+                    " * (one instruction per operator, not measured GCC -O2 output) are\n"
+                    " * here; each defines VGA_HAVE_<KERNEL> for its callers. */\n\n");
+        fprintf(fp, "#ifndef VGA_PACK_ASM_H\n#define VGA_PACK_ASM_H\n\n#include <stdint.h>\n");
+        for (uint32_t i = 0; i < TARGET_COUNT; ++i) {
+            if (!selected[i] || best[i].len >= ref_len[i]) {
+                continue;
+            }
+            if (write_kernel(fp, &targets[i], &best[i], ref_len[i]) != 0) {
+                fclose(fp);
+                return 1;
+            }
+        }
+        fprintf(fp, "\n#endif\n");
+        if (fclose(fp) != 0) {
+            perror(header_path);
+            return 1;
+        }
+    }
+    return 0;
+}
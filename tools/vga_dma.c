@@ -0,0 +1,164 @@
+/*
+ * Blit/fill engine model. See vga_dma.h.
+ */
+
+#include "vga_dma.h"
+
+#include <string.h>
+
+static uint32_t row_cycles(const vga_dma_t *d, const vga_dma_cmd_t *c) {
+    uint32_t n = (c->width + d->bytes_per_cycle - 1u) / d->bytes_per_cycle;
+    return n != 0u ? n : 1u;
+}
+
+void vga_dma_init(vga_dma_t *d, vga_model_t *vga, const uint8_t *ram, uint32_t ram_base, uint32_t ram_size,
+                  uint32_t bytes_per_cycle, uint32_t latency, uint32_t fifo_depth) {
+    memset(d, 0, sizeof(*d));
+    d->bytes_per_cycle = bytes_per_cycle != 0u ? bytes_per_cycle : 1u;
+    d->latency = latency;
+    d->fifo_depth = fifo_depth == 0u ? 1u : fifo_depth > VGA_DMA_FIFO_MAX ? VGA_DMA_FIFO_MAX : fifo_depth;
+    d->vga = vga;
+    d->ram = ram;
+    d->ram_base = ram_base;
+    d->ram_size = ram_size;
+    d->next_event = VGA_MODEL_NEVER;
+}
+
+static void write_row(vga_dma_t *d, const vga_dma_cmd_t *c, uint32_t row, uint64_t at) {
+    uint32_t addr = VGA_MODEL_BASE + c->dst + row * VGA_MODEL_ROW_STRIDE;
+    const uint8_t *src = d->ram + (c->src - d->ram_base) + row * c->src_stride;
+    uint32_t x = 0;
+
+    while (x < c->width) {
+        uint32_t size = 1u;
+        uint32_t value = 0u;
+        if (((addr + x) & 3u) == 0u && c->width - x >= 4u) {
+            size = 4u;
+        } else if (((addr + x) & 1u) == 0u && c->width - x >= 2u) {
+            size = 2u;
+        }
+        for (uint32_t i = 0; i < size; ++i) {
+            value |= (uint32_t)(c->cmd == VGA_DMA_CMD_COPY ? src[x + i] : c->fill) << (8u * i);
+        }
+        vga_model_store(d->vga, at, addr + x, size, value);
+        x += size;
+    }
+    d->stats.bytes += c->width;
+}
+
+void vga_dma_advance(vga_dma_t *d, uint64_t cycle) {
+    while (d->queued != 0u && d->next_event <= cycle) {
+        const vga_dma_cmd_t *c = &d->fifo[d->head];
+
+        write_row(d, c, d->row, d->next_event);
+        if (++d->row < c->height) {
+            d->next_event += row_cycles(d, c);
+            continue;
+        }
+        d->free_at = d->next_event;
+        d->done_count++;
+        d->row = 0u;
+        d->head = (d->head + 1u) % VGA_DMA_FIFO_MAX;
+        d->queued--;
+        d->next_event = VGA_MODEL_NEVER;
+        if (d->queued != 0u) {
+            d->next_event = d->free_at + d->latency + row_cycles(d, &d->fifo[d->head]);
+        }
+    }
+}
+
+static int cmd_valid(const vga_dma_t *d, const vga_dma_cmd_t *c) {
+    uint32_t plane = c->dst >> 16;
+    uint32_t y = (c->dst >> 8) & 0xFFu;
+    uint32_t x = c->dst & 0xFFu;
+
+    if (c->cmd > VGA_DMA_CMD_COPY || plane >= 3u || c->width == 0u || c->height == 0u ||
+        x + c->width > VGA_MODEL_ROW_BYTES || y + c->height > VGA_MODEL_ROWS) {
+        return 0;
+    }
+    if (c->cmd == VGA_DMA_CMD_COPY) {
+        uint64_t first = (uint64_t)c->src;
+        uint64_t last = first + (uint64_t)(c->height - 1u) * c->src_stride + c->width - 1u;
+        if (first < d->ram_base || last >= (uint64_t)d->ram_base + d->ram_size) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+static uint32_t queue_cmd(vga_dma_t *d, uint64_t cycle) {
+    uint32_t stall = 0u;
+    vga_dma_cmd_t *c;
+
+    if (!cmd_valid(d, &d->regs)) {
+        d->status_error = 1u;
+        d->stats.errors++;
+        return 0u;
+    }
+    vga_dma_advance(d, cycle);
+    if (d->queued == d->fifo_depth) {
+        // Wait for the head command's last row
+        const vga_dma_cmd_t *h = &d->fifo[d->head];
+        uint64_t finish = d->next_event + (uint64_t)(h->height - 1u - d->row) * row_cycles(d, h);
+        vga_dma_advance(d, finish);
+        stall = (uint32_t)(finish - cycle);
+        d->stats.full_stalls++;
+        d->stats.stall_cycles += stall;
+        cycle = finish;
+    }
+    c = &d->fifo[(d->head + d->queued) % VGA_DMA_FIFO_MAX];
+    *c = d->regs;
+    if (d->queued++ == 0u) {
+        d->next_event = cycle + d->latency + row_cycles(d, c);
+    }
+    d->stats.commands++;
+    d->stats.busy_cycles += d->latency + (uint64_t)c->height * row_cycles(d, c);
+    return stall;
+}
+
+int vga_dma_store(vga_dma_t *d, uint64_t cycle, uint32_t addr, uint32_t size, uint32_t value, uint32_t *stall) {
+    (void)size;
+    *stall = 0u;
+    if (addr < VGA_DMA_BASE || addr >= VGA_DMA_BASE + VGA_DMA_WINDOW) {
+        return -1;
+    }
+    switch ((addr - VGA_DMA_BASE) & ~3u) {
+    case VGA_DMA_SRC:        d->regs.src = value; break;
+    case VGA_DMA_SRC_STRIDE: d->regs.src_stride = value; break;
+    case VGA_DMA_DST:        d->regs.dst = value; break;
+    case VGA_DMA_WIDTH:      d->regs.width = value; break;
+    case VGA_DMA_HEIGHT:     d->regs.height = value; break;
+    case VGA_DMA_FILL:       d->regs.fill = (uint8_t)value; break;
+    case VGA_DMA_CTRL:
+        d->regs.cmd = value;
+        *stall = queue_cmd(d, cycle);
+        break;
+    case VGA_DMA_STATUS:     d->status_error = 0u; break;
+    default:                 break;  /* DONE is read-only */
+    }
+    return 0;
+}
+
+int vga_dma_load(vga_dma_t *d, uint64_t cycle, uint32_t addr, uint32_t size, uint32_t *value) {
+    (void)size;
+    if (addr < VGA_DMA_BASE || addr >= VGA_DMA_BASE + VGA_DMA_WINDOW) {
+        return -1;
+    }
+    vga_dma_advance(d, cycle);
+    switch ((addr - VGA_DMA_BASE) & ~3u) {
+    case VGA_DMA_SRC:        *value = d->regs.src; break;
+    case VGA_DMA_SRC_STRIDE: *value = d->regs.src_stride; break;
+    case VGA_DMA_DST:        *value = d->regs.dst; break;
+    case VGA_DMA_WIDTH:      *value = d->regs.width; break;
+    case VGA_DMA_HEIGHT:     *value = d->regs.height; break;
+    case VGA_DMA_FILL:       *value = d->regs.fill; break;
+    case VGA_DMA_CTRL:       *value = d->regs.cmd; break;
+    case VGA_DMA_STATUS:
+        *value = (d->queued != 0u ? VGA_DMA_STATUS_BUSY : 0u) |
+                 (d->status_error ? VGA_DMA_STATUS_ERROR : 0u) |
+                 (d->queued == d->fifo_depth ? VGA_DMA_STATUS_FULL : 0u) | (d->queued << 8);
+        break;
+    default:                 *value = d->done_count; break;
+    }
+    return 0;
+}
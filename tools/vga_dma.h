@@ -0,0 +1,120 @@
+/*
+ * Blit/fill engine model next to the VGA frame buffer (host side).
+ *
+ * A proposed DMA engine with a register block at VGA_DMA_BASE. One command
+ * fills a width x height byte rectangle of one colour plane with a constant,
+ * or copies it from RAM (source rows SRC_STRIDE bytes apart). Register
+ * writes only set up the next command; a write to CTRL queues it. Commands
+ * run in order from a FIFO while the CPU keeps executing. A CTRL write to a
+ * full FIFO stalls the CPU until the oldest command completes.
+ *
+ * Timing: each command waits `latency` cycles after it reaches the head of
+ * the FIFO, then writes one row every ceil(width / bytes_per_cycle) cycles.
+ * Rows go through vga_model_store at the cycle they complete, in aligned
+ * chunks of up to 4 bytes, so scanout hazards and frame reports see them
+ * like CPU stores. They land in the buffer that is the draw target when
+ * the row is written: software must wait for the engine before swapping.
+ *
+ * Registers (32-bit, offsets from VGA_DMA_BASE; must match vga_driver.h):
+ *   0x00 SRC         copy source address in RAM
+ *   0x04 SRC_STRIDE  bytes between source rows
+ *   0x08 DST         plane << 16 | y << 8 | x_byte (a VGA address - VGA_MODEL_BASE)
+ *   0x0C WIDTH       bytes per row, 1..80
+ *   0x10 HEIGHT      rows, 1..120
+ *   0x14 FILL        fill byte (bits 7:0)
+ *   0x18 CTRL        write VGA_DMA_CMD_* to queue the command
+ *   0x1C STATUS      read: BUSY, ERROR (sticky, any write clears it), FULL,
+ *                    queued commands in bits 15:8
+ *   0x20 DONE        read: commands completed, wraps
+ * A command with an out-of-range rectangle or source is dropped and sets
+ * ERROR.
+ */
+
+#ifndef VGA_DMA_H
+#define VGA_DMA_H
+
+#include <stdint.h>
+
+#include "vga_model.h"
+
+#define VGA_DMA_BASE            0x10040000u
+#define VGA_DMA_WINDOW          0x24u
+
+#define VGA_DMA_SRC             0x00u
+#define VGA_DMA_SRC_STRIDE      0x04u
+#define VGA_DMA_DST             0x08u
+#define VGA_DMA_WIDTH           0x0Cu
+#define VGA_DMA_HEIGHT          0x10u
+#define VGA_DMA_FILL            0x14u
+#define VGA_DMA_CTRL            0x18u
+#define VGA_DMA_STATUS          0x1Cu
+#define VGA_DMA_DONE            0x20u
+
+#define VGA_DMA_CMD_FILL        0u
+#define VGA_DMA_CMD_COPY        1u
+
+#define VGA_DMA_STATUS_BUSY     0x1u
+#define VGA_DMA_STATUS_ERROR    0x2u
+#define VGA_DMA_STATUS_FULL     0x4u
+
+#define VGA_DMA_FIFO_MAX        64u
+
+typedef struct {
+    uint32_t cmd;
+    uint32_t src;
+    uint32_t src_stride;
+    uint32_t dst;
+    uint32_t width;
+    uint32_t height;
+    uint8_t fill;
+} vga_dma_cmd_t;
+
+typedef struct {
+    uint64_t commands;
+    uint64_t errors;
+    uint64_t bytes;
+    uint64_t busy_cycles;       /* latency + transfer, summed over commands */
+    uint64_t full_stalls;       /* CTRL writes that found the FIFO full */
+    uint64_t stall_cycles;      /* CPU cycles lost to them */
+} vga_dma_stats_t;
+
+typedef struct {
+    /* configuration */
+    uint32_t bytes_per_cycle;
+    uint32_t latency;
+    uint32_t fifo_depth;        /* 1..VGA_DMA_FIFO_MAX */
+
+    vga_model_t *vga;
+    const uint8_t *ram;
+    uint32_t ram_base;
+    uint32_t ram_size;
+
+    vga_dma_cmd_t regs;         /* setup registers, latched by CTRL */
+    uint32_t status_error;
+    uint32_t done_count;
+
+    vga_dma_cmd_t fifo[VGA_DMA_FIFO_MAX];
+    uint32_t head;
+    uint32_t queued;
+    uint32_t row;               /* next row of the head command */
+    uint64_t free_at;           /* cycle the engine finished its last command */
+    uint64_t next_event;        /* cycle the next row completes; VGA_MODEL_NEVER when idle */
+
+    vga_dma_stats_t stats;
+} vga_dma_t;
+
+void vga_dma_init(vga_dma_t *d, vga_model_t *vga, const uint8_t *ram, uint32_t ram_base, uint32_t ram_size,
+                  uint32_t bytes_per_cycle, uint32_t latency, uint32_t fifo_depth);
+
+/* Write every row that completes at or before cycle. */
+void vga_dma_advance(vga_dma_t *d, uint64_t cycle);
+
+/*
+ * Register accesses (addr is the full bus address). Return 0 if addr is in
+ * the DMA window, -1 otherwise. A store sets *stall to the CPU cycles it
+ * must wait (a CTRL write to a full FIFO), else 0.
+ */
+int vga_dma_store(vga_dma_t *d, uint64_t cycle, uint32_t addr, uint32_t size, uint32_t value, uint32_t *stall);
+int vga_dma_load(vga_dma_t *d, uint64_t cycle, uint32_t addr, uint32_t size, uint32_t *value);
+
+#endif
@@ -0,0 +1,253 @@
+/*
+ * VGA frame-buffer and scanout timing model: see vga_model.h.
+ */
+
+#include "vga_model.h"
+
+#include <string.h>
+
+#define FRAME_COUNTS    ((uint64_t)VGA_MODEL_H_COUNTS * VGA_MODEL_V_LINES)
+#define VBLANK_COUNTS   ((uint64_t)VGA_MODEL_H_COUNTS * VGA_MODEL_ACTIVE_LINES)
+
+/* First CPU cycle at or after pixel count p. */
+static uint64_t cycle_of_count(const vga_model_t *m, uint64_t p) {
+    return (p * m->cpu_hz + VGA_MODEL_PIXEL_HZ - 1u) / VGA_MODEL_PIXEL_HZ;
+}
+
+static void schedule(vga_model_t *m) {
+    m->next_event = m->next_vblank < m->next_refresh ? m->next_vblank : m->next_refresh;
+}
+
+static void emit_event(vga_model_t *m, vga_event_kind_t kind, uint64_t cycle, uint32_t line,
+                       uint32_t addr, uint8_t ahead) {
+    vga_event_t ev;
+
+    if (m->on_event == NULL) {
+        return;
+    }
+    ev.kind = kind;
+    ev.cycle = cycle;
+    ev.refresh = m->refresh;
+    ev.line = line;
+    ev.addr = addr;
+    ev.ahead = ahead;
+    m->on_event(m->cb_ctx, &ev);
+}
+
+static void reset_draw(vga_buf_t *b, uint64_t cycle) {
+    memset(&b->report, 0, sizeof(b->report));
+    b->report.draw_start = VGA_MODEL_NEVER;
+    b->report.swap_at = VGA_MODEL_NEVER;
+    b->report.shown_at = VGA_MODEL_NEVER;
+    b->state = VGA_BUF_DRAWING;
+    b->became_draw_at = cycle;
+}
+
+static void mark_shown(vga_model_t *m, unsigned sel, uint64_t cycle, uint32_t line) {
+    vga_buf_t *b = &m->buf[sel];
+    vga_model_stats_t *s = &m->stats;
+    uint64_t latency;
+    uint64_t slack;
+
+    b->state = VGA_BUF_SHOWN;
+    b->report.shown_at = cycle;
+    b->report.refresh = m->refresh;
+    b->report.start_line = line;
+
+    latency = cycle - b->report.draw_start;
+    slack = cycle - b->report.swap_at;
+    if (s->frames_shown == 0u || latency < s->latency_min) {
+        s->latency_min = latency;
+    }
+    if (s->frames_shown == 0u || slack < s->slack_min) {
+        s->slack_min = slack;
+    }
+    if (latency > s->latency_max) {
+        s->latency_max = latency;
+    }
+    if (slack > s->slack_max) {
+        s->slack_max = slack;
+    }
+    s->latency_sum += latency;
+    s->slack_sum += slack;
+    s->frames_shown++;
+
+    if (m->on_frame != NULL) {
+        m->on_frame(m->cb_ctx, &b->report);
+    }
+}
+
+static void drop_frame(vga_model_t *m, unsigned sel, uint64_t cycle, uint32_t line) {
+    m->stats.frames_dropped++;
+    emit_event(m, VGA_EV_FRAME_DROPPED, cycle, line, 0u, 0u);
+    if (m->on_frame != NULL) {
+        m->on_frame(m->cb_ctx, &m->buf[sel].report);
+    }
+}
+
+static void set_display(vga_model_t *m, unsigned sel, uint64_t cycle, uint32_t line) {
+    if (sel == m->display_sel) {
+        return;
+    }
+    m->display_sel = (uint8_t)sel;
+    // During active lines the rest of this refresh already shows it
+    if (line < VGA_MODEL_ACTIVE_LINES && m->buf[sel].state == VGA_BUF_QUEUED) {
+        mark_shown(m, sel, cycle, line);
+    }
+}
+
+void vga_model_init(vga_model_t *m, uint32_t cpu_hz, vga_latch_t latch) {
+    memset(m, 0, sizeof(*m));
+    m->cpu_hz = cpu_hz;
+    m->latch = latch;
+    m->display_sel = 0u;
+    m->draw_sel = 1u;
+    reset_draw(&m->buf[0], 0u);
+    m->buf[0].state = VGA_BUF_SHOWN;
+    reset_draw(&m->buf[1], 0u);
+    m->next_vblank = cycle_of_count(m, VBLANK_COUNTS);
+    m->next_refresh = cycle_of_count(m, FRAME_COUNTS);
+    schedule(m);
+}
+
+uint32_t vga_model_beam(const vga_model_t *m, uint64_t cycle, uint32_t *row) {
+    uint64_t p = cycle * VGA_MODEL_PIXEL_HZ / m->cpu_hz;
+    uint32_t line = (uint32_t)((p % FRAME_COUNTS) / VGA_MODEL_H_COUNTS);
+
+    if (row != NULL) {
+        *row = line < VGA_MODEL_ACTIVE_LINES ? line / VGA_MODEL_LINES_PER_ROW : VGA_MODEL_ROWS;
+    }
+    return line;
+}
+
+void vga_model_advance(vga_model_t *m, uint64_t cycle) {
+    while (m->next_event <= cycle) {
+        if (m->next_vblank < m->next_refresh) {
+            uint64_t at = m->next_vblank;
+            if (m->latch == VGA_LATCH_VBLANK && m->swap_pending) {
+                m->swap_pending = 0u;
+                set_display(m, m->draw_sel ^ 1u, at, VGA_MODEL_ACTIVE_LINES);
+            }
+            m->next_vblank = cycle_of_count(m, (m->refresh + 1u) * FRAME_COUNTS + VBLANK_COUNTS);
+        } else {
+            uint64_t at = m->next_refresh;
+            m->refresh++;
+            if (m->buf[m->display_sel].state == VGA_BUF_QUEUED) {
+                mark_shown(m, m->display_sel, at, 0u);
+            }
+            m->next_refresh = cycle_of_count(m, (m->refresh + 1u) * FRAME_COUNTS);
+        }
+        schedule(m);
+    }
+}
+
+static void swap(vga_model_t *m, uint64_t cycle) {
+    vga_buf_t *done = &m->buf[m->draw_sel];
+    uint32_t line = vga_model_beam(m, cycle, NULL);
+
+    m->stats.swaps++;
+    done->report.seq = m->next_seq++;
+    done->report.swap_at = cycle;
+    if (done->report.draw_start == VGA_MODEL_NEVER) {
+        done->report.draw_start = done->became_draw_at;
+    }
+    done->state = VGA_BUF_QUEUED;
+
+    m->draw_sel ^= 1u;
+    // The new draw target may hold a frame that never reached the screen
+    if (m->buf[m->draw_sel].state == VGA_BUF_QUEUED) {
+        drop_frame(m, m->draw_sel, cycle, line);
+    }
+    reset_draw(&m->buf[m->draw_sel], cycle);
+
+    if (m->latch == VGA_LATCH_IMMEDIATE) {
+        if (line < VGA_MODEL_ACTIVE_LINES) {
+            m->stats.swaps_mid_frame++;
+            emit_event(m, VGA_EV_SWAP_MID_FRAME, cycle, line, 0u, 0u);
+        }
+        set_display(m, m->draw_sel ^ 1u, cycle, line);
+    } else {
+        if (m->swap_pending) {
+            m->stats.swaps_pending++;
+            emit_event(m, VGA_EV_SWAP_PENDING, cycle, line, 0u, 0u);
+        }
+        m->swap_pending = 1u;
+    }
+}
+
+static uint8_t *plane_byte(vga_model_t *m, unsigned sel, uint32_t addr, uint32_t size,
+                           uint32_t *row) {
+    uint32_t off = addr - VGA_MODEL_BASE;
+    uint32_t plane = off / VGA_MODEL_PLANE_STRIDE;
+    uint32_t in_plane = off % VGA_MODEL_PLANE_STRIDE;
+    uint32_t col = in_plane % VGA_MODEL_ROW_STRIDE;
+
+    if (addr < VGA_MODEL_BASE || plane >= 3u || in_plane >= VGA_MODEL_PLANE_SIZE ||
+        col + size > VGA_MODEL_ROW_BYTES) {
+        return NULL;
+    }
+    if (row != NULL) {
+        *row = in_plane / VGA_MODEL_ROW_STRIDE;
+    }
+    return &m->fb[sel][plane][in_plane];
+}
+
+int vga_model_store(vga_model_t *m, uint64_t cycle, uint32_t addr, uint32_t size, uint32_t value) {
+    vga_buf_t *b;
+    uint8_t *p;
+    uint32_t row;
+
+    if (addr >= VGA_MODEL_SWAP_ADDR && addr < VGA_MODEL_SWAP_ADDR + 4u) {
+        vga_model_advance(m, cycle);
+        swap(m, cycle);
+        return 0;
+    }
+    p = plane_byte(m, m->draw_sel, addr, size, &row);
+    if (p == NULL) {
+        return -1;
+    }
+    vga_model_advance(m, cycle);
+    for (uint32_t i = 0; i < size; ++i) {
+        p[i] = (uint8_t)(value >> (8u * i));
+    }
+
+    b = &m->buf[m->draw_sel];
+    m->stats.stores++;
+    b->report.stores++;
+    if (b->report.draw_start == VGA_MODEL_NEVER) {
+        b->report.draw_start = cycle;
+    }
+    if (m->draw_sel == m->display_sel) {
+        uint32_t beam_row;
+        uint32_t line = vga_model_beam(m, cycle, &beam_row);
+        uint8_t ahead = (uint8_t)(row >= beam_row || beam_row == VGA_MODEL_ROWS);
+        m->stats.writes_displayed++;
+        m->stats.writes_displayed_ahead += ahead;
+        b->report.hazards++;
+        emit_event(m, VGA_EV_WRITE_DISPLAYED, cycle, line, addr, ahead);
+    }
+    return 0;
+}
+
+int vga_model_load(vga_model_t *m, uint32_t addr, uint32_t size, uint32_t *value) {
+    const uint8_t *p;
+
+    if (addr >= VGA_MODEL_SWAP_ADDR && addr < VGA_MODEL_SWAP_ADDR + 4u) {
+        *value = 0u;
+        return 0;
+    }
+    p = plane_byte(m, m->draw_sel, addr, size, NULL);
+    if (p == NULL) {
+        return -1;
+    }
+    *value = 0u;
+    for (uint32_t i = 0; i < size; ++i) {
+        *value |= (uint32_t)p[i] << (8u * i);
+    }
+    return 0;
+}
+
+uint8_t vga_model_pixel(const vga_model_t *m, unsigned sel, unsigned plane, uint32_t x, uint32_t y) {
+    uint8_t byte = m->fb[sel & 1u][plane][y * VGA_MODEL_ROW_STRIDE + (x >> 1)];
+    return (x & 1u) ? (uint8_t)(byte >> 4) : (uint8_t)(byte & 0x0Fu);
+}
@@ -0,0 +1,148 @@
+/*
+ * VGA frame-buffer and scanout timing model (host side).
+ *
+ * Models the double-buffered frame memory behind 0x1000_0000..0x1003_0000
+ * and the scanout timing from vga_interface_properties.md: 800 horizontal
+ * counts x 521 lines at 60 Hz, 480 active lines, each frame-buffer row
+ * shown on 4 consecutive lines. Time is in CPU cycles; the beam position
+ * for a cycle is derived from cpu_hz.
+ *
+ * Buffer selection: a write to the swap register flips the CPU write
+ * target at once. With VGA_LATCH_IMMEDIATE the display flips at the same
+ * moment (a swap during active lines tears); with VGA_LATCH_VBLANK the
+ * display follows at the start of the next vertical blank, and until then
+ * the CPU is writing into the buffer that is still on screen.
+ *
+ * Hazards reported through the event callback:
+ *   - store into the displayed buffer (and whether the beam still has to
+ *     scan that row in the current refresh)
+ *   - swap while the beam is in the active area (immediate latch)
+ *   - swap while an earlier swap is still waiting for vblank, or a frame
+ *     that is replaced before any of it was scanned out (dropped)
+ *
+ * Every swapped frame gets a report once its first line is scanned out
+ * (or once it is dropped): when drawing started, when it was swapped,
+ * when it became visible, and the stores/hazards it collected.
+ */
+
+#ifndef VGA_MODEL_H
+#define VGA_MODEL_H
+
+#include <stdint.h>
+
+#define VGA_MODEL_H_COUNTS      800u
+#define VGA_MODEL_V_LINES       521u
+#define VGA_MODEL_ACTIVE_LINES  480u
+#define VGA_MODEL_REFRESH_HZ    60u
+#define VGA_MODEL_PIXEL_HZ      (VGA_MODEL_H_COUNTS * VGA_MODEL_V_LINES * VGA_MODEL_REFRESH_HZ)
+#define VGA_MODEL_LINES_PER_ROW 4u
+
+#define VGA_MODEL_BASE          0x10000000u
+#define VGA_MODEL_PLANE_STRIDE  0x10000u
+#define VGA_MODEL_SWAP_ADDR     0x10030000u
+#define VGA_MODEL_ROWS          120u
+#define VGA_MODEL_ROW_BYTES     80u
+#define VGA_MODEL_ROW_STRIDE    0x100u
+#define VGA_MODEL_PLANE_SIZE    (VGA_MODEL_ROWS * VGA_MODEL_ROW_STRIDE)
+
+#define VGA_MODEL_NEVER         UINT64_MAX
+
+typedef enum {
+    VGA_LATCH_IMMEDIATE = 0,
+    VGA_LATCH_VBLANK
+} vga_latch_t;
+
+typedef enum {
+    VGA_EV_WRITE_DISPLAYED = 0,
+    VGA_EV_SWAP_MID_FRAME,
+    VGA_EV_SWAP_PENDING,
+    VGA_EV_FRAME_DROPPED
+} vga_event_kind_t;
+
+typedef struct {
+    vga_event_kind_t kind;
+    uint64_t cycle;
+    uint64_t refresh;           /* scanout frame number */
+    uint32_t line;              /* beam line 0..520 */
+    uint32_t addr;              /* store address (WRITE_DISPLAYED) */
+    uint8_t ahead;              /* row not yet scanned in this refresh */
+} vga_event_t;
+
+typedef struct {
+    uint64_t seq;               /* 0 for the first swapped frame */
+    uint64_t draw_start;        /* first store (or when the buffer became the draw target) */
+    uint64_t swap_at;
+    uint64_t shown_at;          /* first visible line scanned; VGA_MODEL_NEVER if dropped */
+    uint64_t refresh;           /* scanout frame it first appeared in */
+    uint32_t start_line;        /* beam line it first appeared on (0 unless torn) */
+    uint32_t stores;
+    uint32_t hazards;           /* WRITE_DISPLAYED events while it was being drawn */
+} vga_frame_report_t;
+
+typedef void (*vga_event_fn)(void *ctx, const vga_event_t *ev);
+typedef void (*vga_frame_fn)(void *ctx, const vga_frame_report_t *fr);
+
+typedef enum {
+    VGA_BUF_DRAWING = 0,
+    VGA_BUF_QUEUED,             /* swapped, not yet scanned out */
+    VGA_BUF_SHOWN
+} vga_buf_state_t;
+
+typedef struct {
+    vga_buf_state_t state;
+    vga_frame_report_t report;
+    uint64_t became_draw_at;
+} vga_buf_t;
+
+typedef struct {
+    uint64_t stores;
+    uint64_t writes_displayed;
+    uint64_t writes_displayed_ahead;
+    uint64_t swaps;
+    uint64_t swaps_mid_frame;
+    uint64_t swaps_pending;
+    uint64_t frames_shown;
+    uint64_t frames_dropped;
+    uint64_t latency_min, latency_max, latency_sum;     /* draw_start -> shown_at */
+    uint64_t slack_min, slack_max, slack_sum;           /* swap_at -> shown_at */
+} vga_model_stats_t;
+
+typedef struct {
+    uint32_t cpu_hz;
+    vga_latch_t latch;
+
+    uint8_t fb[2][3][VGA_MODEL_PLANE_SIZE];
+    uint8_t draw_sel;
+    uint8_t display_sel;
+    uint8_t swap_pending;
+    vga_buf_t buf[2];
+    uint64_t next_seq;
+
+    uint64_t refresh;           /* current scanout frame */
+    uint64_t next_vblank;       /* cycle of the next line-480 crossing */
+    uint64_t next_refresh;      /* cycle of the next line-0 crossing */
+    uint64_t next_event;        /* min of the two; call vga_model_advance at or after it */
+
+    vga_model_stats_t stats;
+
+    void *cb_ctx;
+    vga_event_fn on_event;
+    vga_frame_fn on_frame;
+} vga_model_t;
+
+void vga_model_init(vga_model_t *m, uint32_t cpu_hz, vga_latch_t latch);
+
+/* Process vblank / refresh boundaries up to and including cycle. */
+void vga_model_advance(vga_model_t *m, uint64_t cycle);
+
+/* Beam line (0..520) at cycle; *row gets the frame-buffer row or VGA_MODEL_ROWS in blanking. */
+uint32_t vga_model_beam(const vga_model_t *m, uint64_t cycle, uint32_t *row);
+
+/* MMIO accesses. Return 0 if addr is VGA space, -1 otherwise. */
+int vga_model_store(vga_model_t *m, uint64_t cycle, uint32_t addr, uint32_t size, uint32_t value);
+int vga_model_load(vga_model_t *m, uint32_t addr, uint32_t size, uint32_t *value);
+
+/* 4-bit channel value of pixel (x, y) in buffer sel, plane 0=r 1=g 2=b. */
+uint8_t vga_model_pixel(const vga_model_t *m, unsigned sel, unsigned plane, uint32_t x, uint32_t y);
+
+#endif
@@ -0,0 +1,62 @@
+#include "vga_bitmap.h"
+
+/*
+ * 1-bpp bitmap expansion: see vga_bitmap.h.
+ */
+
+void vga_bitmap_lut_build(vga_bitmap_lut_t *lut, Color fg, Color bg) {
+    uint32_t fr = fg.r & 0x0Fu, fgr = fg.g & 0x0Fu, fb = fg.b & 0x0Fu;
+    uint32_t br = bg.r & 0x0Fu, bgr = bg.g & 0x0Fu, bb = bg.b & 0x0Fu;
+
+    // Entry i is entry i >> 1 moved one pixel right with bit 0 of i as
+    // the new leftmost pixel; entry 0 is all background
+    lut->r[0] = vga_nibble_splat((uint8_t)br);
+    lut->g[0] = vga_nibble_splat((uint8_t)bgr);
+    lut->b[0] = vga_nibble_splat((uint8_t)bb);
+    for (uint32_t i = 1; i < 256u; ++i) {
+        uint32_t set = i & 1u;
+        lut->r[i] = (lut->r[i >> 1] << 4) | (set ? fr : br);
+        lut->g[i] = (lut->g[i >> 1] << 4) | (set ? fgr : bgr);
+        lut->b[i] = (lut->b[i >> 1] << 4) | (set ? fb : bb);
+    }
+}
+
+void vga_bitmap_draw(
+    const vga_bitmap_lut_t *lut,
+    const uint8_t *bits,
+    uint32_t width_bytes,
+    uint32_t height,
+    uint32_t stride,
+    uint32_t y,
+    uint32_t x_word
+) {
+    vga_dma_wait();
+    for (uint32_t row = 0; row < height; ++row) {
+        volatile uint32_t *r = (volatile uint32_t *)vga_color_addr_fast(VGA_RED_BASE, y + row, x_word << 2);
+        volatile uint32_t *g = (volatile uint32_t *)vga_color_addr_fast(VGA_GREEN_BASE, y + row, x_word << 2);
+        volatile uint32_t *b = (volatile uint32_t *)vga_color_addr_fast(VGA_BLUE_BASE, y + row, x_word << 2);
+        for (uint32_t k = 0; k < width_bytes; ++k) {
+            uint32_t v = bits[k];
+            r[k] = lut->r[v];
+            g[k] = lut->g[v];
+            b[k] = lut->b[v];
+        }
+        bits += stride;
+    }
+}
+
+void vga_bitmap_expand_row(
+    const vga_bitmap_lut_t *lut,
+    const uint8_t *bits,
+    uint32_t count,
+    uint32_t *restrict red_words,
+    uint32_t *restrict green_words,
+    uint32_t *restrict blue_words
+) {
+    for (uint32_t k = 0; k < count; ++k) {
+        uint32_t v = bits[k];
+        red_words[k] = lut->r[v];
+        green_words[k] = lut->g[v];
+        blue_words[k] = lut->b[v];
+    }
+}
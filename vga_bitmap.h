@@ -0,0 +1,59 @@
+#ifndef VGA_BITMAP_H
+#define VGA_BITMAP_H
+
+#include <stdint.h>
+#include "vga_driver.h"
+
+/*
+ * 1-bpp bitmap expansion (icons, glyphs, masks).
+ *
+ * Bitmaps are stored at one bit per pixel, bit 0 = leftmost pixel (as in
+ * the compositor's text layer), so one source byte is 8 pixels: one packed
+ * plane word. For a foreground/background pair, vga_bitmap_lut_build fills
+ * a 256-entry table per plane with the packed word for every byte value.
+ * Drawing is then one table lookup and one SW per plane per 8 pixels, with
+ * no per-pixel packing.
+ *
+ * Bitmaps are opaque (clear bits draw the background) and land on whole
+ * words, x in units of 8 pixels, since partial words would need a
+ * read-modify-write of VGA memory. Nothing is clipped: the bitmap must fit
+ * on screen.
+ *
+ * RAM: 3 KB per table; build one per color pair in use and keep it.
+ */
+
+typedef struct {
+    uint32_t r[256];
+    uint32_t g[256];
+    uint32_t b[256];
+} vga_bitmap_lut_t;
+
+// Fill lut for set bits = fg, clear bits = bg
+void vga_bitmap_lut_build(vga_bitmap_lut_t *lut, Color fg, Color bg);
+
+////////////////////////////////////////////////////////////
+// Draw width_bytes * 8 by height pixels from bits (rows stride bytes
+// apart) at frame-buffer pixel (8 * x_word, y).
+////////////////////////////////////////////////////////////
+void vga_bitmap_draw(
+    const vga_bitmap_lut_t *lut,
+    const uint8_t *bits,
+    uint32_t width_bytes,
+    uint32_t height,
+    uint32_t stride,
+    uint32_t y,
+    uint32_t x_word
+);
+
+// Expand one bitmap row of count bytes into packed plane words (line
+// buffers, row-cache generators)
+void vga_bitmap_expand_row(
+    const vga_bitmap_lut_t *lut,
+    const uint8_t *bits,
+    uint32_t count,
+    uint32_t *restrict red_words,
+    uint32_t *restrict green_words,
+    uint32_t *restrict blue_words
+);
+
+#endif
@@ -0,0 +1,213 @@
+#include "vga_compositor.h"
+
+/*
+ * Scanline compositor: see vga_compositor.h for the layer model.
+ *
+ * All blending is done on packed words (8 pixels at a time) with nibble
+ * masks, so no layer iterates over individual pixels. Arbitrary X offsets
+ * are handled by splitting a shifted word across two line-buffer words.
+ */
+
+// The only per-frame RAM the compositor needs (240 bytes)
+static vga_line_t vga_line;
+
+// 4 bits of a 1-bpp pattern -> 4 nibble masks (bit 0 = leftmost pixel)
+static const uint16_t nibble_mask_4[16] = {
+    0x0000u, 0x000Fu, 0x00F0u, 0x00FFu, 0x0F00u, 0x0F0Fu, 0x0FF0u, 0x0FFFu,
+    0xF000u, 0xF00Fu, 0xF0F0u, 0xF0FFu, 0xFF00u, 0xFF0Fu, 0xFFF0u, 0xFFFFu,
+};
+
+static inline uint32_t expand_bits_8(uint8_t bits) {
+    return (uint32_t)nibble_mask_4[bits & 0x0Fu] | ((uint32_t)nibble_mask_4[bits >> 4] << 16);
+}
+
+static void clear_line(vga_line_t *line) {
+    for (uint32_t xw = 0; xw < VGA_WIDTH_WORDS; ++xw) {
+        line->r[xw] = 0u;
+        line->g[xw] = 0u;
+        line->b[xw] = 0u;
+    }
+}
+
+// Blend one packed 8-pixel word (r, g, b, mask) whose left pixel is at x=px
+static void blend_word_at(vga_line_t *line, int32_t px, const uint32_t *w) {
+    uint32_t frac = (uint32_t)px & 7u;
+    int32_t xw = (px - (int32_t)frac) / 8;
+    uint32_t sh = frac * 4u;
+
+    if (xw >= 0 && xw < (int32_t)VGA_WIDTH_WORDS) {
+        uint32_t m = w[3] << sh;
+        line->r[xw] = vga_blend_word(line->r[xw], w[0] << sh, m);
+        line->g[xw] = vga_blend_word(line->g[xw], w[1] << sh, m);
+        line->b[xw] = vga_blend_word(line->b[xw], w[2] << sh, m);
+    }
+    ++xw;
+    if (sh != 0u && xw >= 0 && xw < (int32_t)VGA_WIDTH_WORDS) {
+        uint32_t rsh = 32u - sh;
+        uint32_t m = w[3] >> rsh;
+        line->r[xw] = vga_blend_word(line->r[xw], w[0] >> rsh, m);
+        line->g[xw] = vga_blend_word(line->g[xw], w[1] >> rsh, m);
+        line->b[xw] = vga_blend_word(line->b[xw], w[2] >> rsh, m);
+    }
+}
+
+////////////////////////////////////////////////////////////
+// Built-in layers
+////////////////////////////////////////////////////////////
+
+void vga_fill_layer(const void *ctx, uint32_t y, vga_line_t *line) {
+    const vga_fill_layer_t *fill = (const vga_fill_layer_t *)ctx;
+    uint32_t r = vga_nibble_splat(fill->color.r);
+    uint32_t g = vga_nibble_splat(fill->color.g);
+    uint32_t b = vga_nibble_splat(fill->color.b);
+    (void)y;
+
+    for (uint32_t xw = 0; xw < VGA_WIDTH_WORDS; ++xw) {
+        line->r[xw] = r;
+        line->g[xw] = g;
+        line->b[xw] = b;
+    }
+}
+
+void vga_tilemap_layer(const void *ctx, uint32_t y, vga_line_t *line) {
+    const vga_tilemap_layer_t *tm = (const vga_tilemap_layer_t *)ctx;
+    uint32_t map_w_px = (uint32_t)tm->map_w * 8u;
+    uint32_t map_h_px = (uint32_t)tm->map_h * 8u;
+    uint32_t py;
+    uint32_t px;
+    const uint8_t *map_row;
+    const uint32_t *w;
+    uint32_t tile_row;
+    uint32_t tx;
+    uint32_t sh;
+
+    // An empty map has nothing to draw (and nothing to wrap at); clear
+    // the line so a first layer does not repeat the previous row
+    if (map_w_px == 0u || map_h_px == 0u) {
+        clear_line(line);
+        return;
+    }
+    // One remainder per row and axis (a libgcc call without the M
+    // extension); subtracting in a loop would take up to 65535 / map
+    // size iterations for a small map with a large scroll
+    py = (y + tm->scroll_y) % map_h_px;
+    px = tm->scroll_x % map_w_px;
+    map_row = tm->map + (py >> 3) * tm->map_w;
+    tile_row = py & 7u;
+    tx = px >> 3;
+    sh = (px & 7u) * 4u;
+
+    w = tm->tiles[map_row[tx]].row[tile_row];
+    if (sh == 0u) {
+        for (uint32_t xw = 0; xw < VGA_WIDTH_WORDS; ++xw) {
+            line->r[xw] = w[0];
+            line->g[xw] = w[1];
+            line->b[xw] = w[2];
+            if (++tx == tm->map_w) {
+                tx = 0u;
+            }
+            w = tm->tiles[map_row[tx]].row[tile_row];
+        }
+        return;
+    }
+
+    // Fine scroll: each output word is the funnel shift of two tile words
+    for (uint32_t xw = 0; xw < VGA_WIDTH_WORDS; ++xw) {
+        const uint32_t *next;
+        if (++tx == tm->map_w) {
+            tx = 0u;
+        }
+        next = tm->tiles[map_row[tx]].row[tile_row];
+        line->r[xw] = (w[0] >> sh) | (next[0] << (32u - sh));
+        line->g[xw] = (w[1] >> sh) | (next[1] << (32u - sh));
+        line->b[xw] = (w[2] >> sh) | (next[2] << (32u - sh));
+        w = next;
+    }
+}
+
+void vga_sprite_layer(const void *ctx, uint32_t y, vga_line_t *line) {
+    const vga_sprite_layer_t *layer = (const vga_sprite_layer_t *)ctx;
+
+    for (uint32_t i = 0; i < layer->count; ++i) {
+        const vga_sprite_instance_t *inst = &layer->sprites[i];
+        const vga_sprite_t *spr = inst->sprite;
+        int32_t row = (int32_t)y - inst->y;
+        int32_t px = inst->x;
+        const uint32_t *w;
+
+        if (row < 0 || row >= (int32_t)spr->height) {
+            continue;
+        }
+        if (px >= (int32_t)VGA_WIDTH_PIXELS || px + 8 * (int32_t)spr->width_words <= 0) {
+            continue;
+        }
+        w = spr->data + (uint32_t)row * spr->width_words * 4u;
+        for (uint32_t col = 0; col < spr->width_words; ++col) {
+            blend_word_at(line, px, w);
+            px += 8;
+            w += 4;
+        }
+    }
+}
+
+void vga_text_layer(const void *ctx, uint32_t y, vga_line_t *line) {
+    const vga_text_layer_t *t = (const vga_text_layer_t *)ctx;
+    uint32_t r = vga_nibble_splat(t->fg.r);
+    uint32_t g = vga_nibble_splat(t->fg.g);
+    uint32_t b = vga_nibble_splat(t->fg.b);
+    uint32_t dy = y - t->y;
+    uint32_t cols = t->cols;
+    const char *text;
+    uint32_t glyph_row;
+
+    if (y < t->y || dy >= (uint32_t)t->rows * 8u) {
+        return;
+    }
+    if (t->x_word + cols > VGA_WIDTH_WORDS) {
+        cols = (t->x_word < VGA_WIDTH_WORDS) ? (VGA_WIDTH_WORDS - t->x_word) : 0u;
+    }
+    text = t->text + (dy >> 3) * t->cols;
+    glyph_row = dy & 7u;
+
+    for (uint32_t c = 0; c < cols; ++c) {
+        uint32_t idx = (uint32_t)(uint8_t)text[c] - t->first_char;
+        uint32_t xw = t->x_word + c;
+        uint32_t m;
+        if (idx >= t->glyph_count) {
+            continue;
+        }
+        m = expand_bits_8(t->font[idx * 8u + glyph_row]);
+        if (m == 0u) {
+            continue;
+        }
+        line->r[xw] = vga_blend_word(line->r[xw], r, m);
+        line->g[xw] = vga_blend_word(line->g[xw], g, m);
+        line->b[xw] = vga_blend_word(line->b[xw], b, m);
+    }
+}
+
+////////////////////////////////////////////////////////////
+// Compositor
+////////////////////////////////////////////////////////////
+
+void vga_compose_rows(const vga_layer_t *layers, uint32_t count, uint32_t y_start, uint32_t y_end) {
+    if (y_end > VGA_HEIGHT) {
+        y_end = VGA_HEIGHT;
+    }
+    vga_dma_wait();
+    for (uint32_t y = y_start; y < y_end; ++y) {
+        if (count == 0u || y < layers[0].y_start || y >= layers[0].y_end) {
+            clear_line(&vga_line);
+        }
+        for (uint32_t i = 0; i < count; ++i) {
+            if (y >= layers[i].y_start && y < layers[i].y_end) {
+                layers[i].render(layers[i].ctx, y, &vga_line);
+            }
+        }
+        vga_write_rgb_row_words_fast(y, vga_line.r, vga_line.g, vga_line.b, VGA_WIDTH_WORDS);
+    }
+}
+
+void vga_compose_frame(const vga_layer_t *layers, uint32_t count) {
+    vga_compose_rows(layers, count, 0u, VGA_HEIGHT);
+}
@@ -1,3 +1,4 @@
+#include <stddef.h>
 #include "vga_driver.h"
 
 /*
@@ -15,6 +16,79 @@
  * - Addressing is not contiguous per pixel RGB tuple: each color plane is separate.
  */
 
+#ifdef VGA_DMA
+#define DMA_REG(addr) (*(volatile uint32_t *)(addr))
+
+static inline uint32_t dma_dst(uint32_t color_base, uint32_t y, uint32_t x_byte) {
+    return vga_color_addr_fast(color_base, y, x_byte) - VGA_RED_BASE;
+}
+
+// Queue one plane: copy from src, or fill with value when src is NULL
+static void dma_plane(uint32_t dst, const uint8_t *src, uint8_t value) {
+    DMA_REG(VGA_DMA_DST) = dst;
+    if (src != NULL) {
+        DMA_REG(VGA_DMA_SRC) = (uint32_t)(uintptr_t)src;
+        DMA_REG(VGA_DMA_CTRL) = VGA_DMA_CMD_COPY;
+    } else {
+        DMA_REG(VGA_DMA_FILL) = value;
+        DMA_REG(VGA_DMA_CTRL) = VGA_DMA_CMD_FILL;
+    }
+}
+
+// True when a width x height rectangle has fewer than VGA_DMA_MIN_BYTES
+// bytes per plane. No RV32M, so the product is a shift-add over the few
+// bits of a height below the bound rather than a __mulsi3 call.
+static int dma_too_small(uint32_t width, uint32_t height) {
+    uint32_t bytes = 0;
+
+    if (width == 0u || height == 0u) {
+        return 1;
+    }
+    if (width >= VGA_DMA_MIN_BYTES || height >= VGA_DMA_MIN_BYTES) {
+        return 0;
+    }
+    for (; height != 0u; height >>= 1) {
+        if ((height & 1u) != 0u) {
+            bytes += width;
+        }
+        width <<= 1;
+    }
+    return bytes < VGA_DMA_MIN_BYTES;
+}
+
+// Hand a width x height rectangle at (x_byte, y) to the engine, one command
+// per plane (source rows src_stride apart). Returns 0 without queueing
+// anything when the CPU should do it: small requests, after the engine has
+// drained so the CPU stores land in order.
+static int dma_rgb(
+    uint32_t y,
+    uint32_t x_byte,
+    uint32_t width,
+    uint32_t height,
+    uint32_t src_stride,
+    const uint8_t *red_src,
+    const uint8_t *green_src,
+    const uint8_t *blue_src,
+    uint8_t red_byte,
+    uint8_t green_byte,
+    uint8_t blue_byte
+) {
+    if (dma_too_small(width, height)) {
+        vga_dma_wait();
+        return 0;
+    }
+    DMA_REG(VGA_DMA_WIDTH) = width;
+    DMA_REG(VGA_DMA_HEIGHT) = height;
+    DMA_REG(VGA_DMA_SRC_STRIDE) = src_stride;
+    dma_plane(dma_dst(VGA_RED_BASE, y, x_byte), red_src, red_byte);
+    dma_plane(dma_dst(VGA_GREEN_BASE, y, x_byte), green_src, green_byte);
+    dma_plane(dma_dst(VGA_BLUE_BASE, y, x_byte), blue_src, blue_byte);
+    return 1;
+}
+#else
+#define dma_rgb(...) 0
+#endif
+
 // FUNCTIONS
 
 uint32_t color_addr(uint32_t color_base, uint32_t y, uint32_t x_byte) {
@@ -26,17 +100,55 @@ uint8_t pack_two_pixels(uint8_t even_x, uint8_t odd_x) {
 }
 
 void swap_frame(void) {
+    // Engine rows land in the draw buffer current when they are written
+    vga_dma_wait();
     *(volatile uint32_t *)VGA_SWAP_ADDR = 1u;
 }
 
 static inline uint16_t pack_four_pixels_16(uint8_t px_1, uint8_t px_2, uint8_t px_3, uint8_t px_4) {
+#ifdef VGA_HAVE_PACK_FOUR_PIXELS_ASM
+    return (uint16_t)vga_pack_four_pixels_asm(px_1, px_2, px_3, px_4);
+#else
     return (uint16_t)(((px_4 & 0x0Fu) << 12) | ((px_3 & 0x0Fu) << 8) | ((px_2 & 0x0Fu) << 4) | (px_1 & 0x0Fu));
+#endif
 }
 
 static inline uint32_t pack_eight_pixels_32(uint8_t px_1, uint8_t px_2, uint8_t px_3, uint8_t px_4, uint8_t px_5, uint8_t px_6, uint8_t px_7, uint8_t px_8) {
+#ifdef VGA_HAVE_PACK_EIGHT_PIXELS_ASM
+    return vga_pack_eight_pixels_asm(px_1, px_2, px_3, px_4, px_5, px_6, px_7, px_8);
+#else
     return (uint32_t)(((px_8 & 0x0Fu) << 28) | ((px_7 & 0x0Fu) << 24) | ((px_6 & 0x0Fu) << 20) | ((px_5 & 0x0Fu) << 16) | ((px_4 & 0x0Fu) << 12) | ((px_3 & 0x0Fu) << 8) | ((px_2 & 0x0Fu) << 4) | (px_1 & 0x0Fu));
+#endif
+}
+
+#ifdef VGA_PACK_ASM
+// One channel of 4 Colors loaded as 3 little-endian words: bytes 0, 3, 6, 9
+// are red, 1, 4, 7, 10 green, 2, 5, 8, 11 blue
+static inline uint16_t aos4_red(uint32_t w0, uint32_t w1, uint32_t w2) {
+#ifdef VGA_HAVE_AOS4_RED_ASM
+    return (uint16_t)vga_aos4_red_asm(w0, w1, w2);
+#else
+    return pack_four_pixels_16((uint8_t)w0, (uint8_t)(w0 >> 24), (uint8_t)(w1 >> 16), (uint8_t)(w2 >> 8));
+#endif
 }
 
+static inline uint16_t aos4_green(uint32_t w0, uint32_t w1, uint32_t w2) {
+#ifdef VGA_HAVE_AOS4_GREEN_ASM
+    return (uint16_t)vga_aos4_green_asm(w0, w1, w2);
+#else
+    return pack_four_pixels_16((uint8_t)(w0 >> 8), (uint8_t)w1, (uint8_t)(w1 >> 24), (uint8_t)(w2 >> 16));
+#endif
+}
+
+static inline uint16_t aos4_blue(uint32_t w0, uint32_t w1, uint32_t w2) {
+#ifdef VGA_HAVE_AOS4_BLUE_ASM
+    return (uint16_t)vga_aos4_blue_asm(w0, w1, w2);
+#else
+    return pack_four_pixels_16((uint8_t)(w0 >> 16), (uint8_t)(w1 >> 8), (uint8_t)w2, (uint8_t)(w2 >> 24));
+#endif
+}
+#endif
+
 ////////////////////////////////////////////////////////////
 // Write a single pixel byte (2 horizontal pixels) to the frame buffer
 // Expects pointer to 2 Color values:
@@ -46,6 +158,7 @@ static inline uint32_t pack_eight_pixels_32(uint8_t px_1, uint8_t px_2, uint8_t
 //   expressed in byte address units along X.
 ////////////////////////////////////////////////////////////
 void write_single_pixel_byte(const Color *restrict pixels, uint32_t y, uint32_t x_byte) {
+    vga_dma_wait();
     vga_write_single_pixel_byte_fast(pixels, y, x_byte);
 }
 
@@ -58,6 +171,21 @@ void write_single_pixel_byte(const Color *restrict pixels, uint32_t y, uint32_t
 //   expressed in byte address units along X.
 ////////////////////////////////////////////////////////////
 void write_quad_4_pixels(const Color *restrict block, uint32_t y, uint32_t x_byte) {
+    vga_dma_wait();
+#ifdef VGA_PACK_ASM
+    // Word-aligned block: each row of 4 Colors is 12 bytes = 3 LW instead of
+    // 12 LBU, split into planes by the AoS helpers above
+    if (((uintptr_t)block & 3u) == 0u) {
+        typedef uint32_t __attribute__((may_alias)) color_word_t;
+        const color_word_t *w = (const color_word_t *)block;
+        for (uint32_t row = 0; row < 4; ++row, w += 3) {
+            *(volatile uint16_t *)vga_color_addr_fast(VGA_RED_BASE,   y + row, x_byte) = aos4_red(w[0], w[1], w[2]);
+            *(volatile uint16_t *)vga_color_addr_fast(VGA_GREEN_BASE, y + row, x_byte) = aos4_green(w[0], w[1], w[2]);
+            *(volatile uint16_t *)vga_color_addr_fast(VGA_BLUE_BASE,  y + row, x_byte) = aos4_blue(w[0], w[1], w[2]);
+        }
+        return;
+    }
+#endif
     for (uint32_t row = 0; row < 4; ++row) {
         const Color *row_ptr = block + (row * 4u);
  
@@ -85,6 +213,7 @@ void write_quad_4_pixels(const Color *restrict block, uint32_t y, uint32_t x_byt
 //   expressed in byte address units along X.
 ////////////////////////////////////////////////////////////
 void write_quad_8_pixels(const Color *restrict block, uint32_t y, uint32_t x_byte) {
+    vga_dma_wait();
     for (uint32_t row = 0; row < 8; ++row) {
         const Color *row_ptr = block + (row * 8u);
  
@@ -108,6 +237,7 @@ void write_quad_8_pixels(const Color *restrict block, uint32_t y, uint32_t x_byt
 }
 
 void write_rgb_byte(uint32_t y, uint32_t x_byte, uint8_t red_byte, uint8_t green_byte, uint8_t blue_byte) {
+    vga_dma_wait();
     vga_write_rgb_byte_fast(y, x_byte, red_byte, green_byte, blue_byte);
 }
 
@@ -118,13 +248,43 @@ void write_rgb_row_bytes(
     const uint8_t *restrict blue_row,
     uint32_t count
 ) {
+    if (dma_rgb(y, 0u, count, 1u, 0u, red_row, green_row, blue_row, 0u, 0u, 0u)) {
+        return;
+    }
     vga_write_rgb_row_bytes_fast(y, red_row, green_row, blue_row, count);
 }
 
 void fill_rgb_row_constant(uint32_t y, uint8_t red_byte, uint8_t green_byte, uint8_t blue_byte, uint32_t count) {
+    if (dma_rgb(y, 0u, count, 1u, 0u, NULL, NULL, NULL, red_byte, green_byte, blue_byte)) {
+        return;
+    }
     vga_fill_rgb_row_constant_fast(y, red_byte, green_byte, blue_byte, count);
 }
 
+void fill_rgb_rect_constant(
+    uint32_t y,
+    uint32_t x_byte,
+    uint32_t width,
+    uint32_t height,
+    uint8_t red_byte,
+    uint8_t green_byte,
+    uint8_t blue_byte
+) {
+    if (dma_rgb(y, x_byte, width, height, 0u, NULL, NULL, NULL, red_byte, green_byte, blue_byte)) {
+        return;
+    }
+    for (uint32_t row = 0; row < height; ++row) {
+        volatile uint8_t *r = (volatile uint8_t *)vga_color_addr_fast(VGA_RED_BASE, y + row, x_byte);
+        volatile uint8_t *g = (volatile uint8_t *)vga_color_addr_fast(VGA_GREEN_BASE, y + row, x_byte);
+        volatile uint8_t *b = (volatile uint8_t *)vga_color_addr_fast(VGA_BLUE_BASE, y + row, x_byte);
+        for (uint32_t xb = 0; xb < width; ++xb) {
+            r[xb] = red_byte;
+            g[xb] = green_byte;
+            b[xb] = blue_byte;
+        }
+    }
+}
+
 void write_rgb_row_r_const_gb(
     uint32_t y,
     const uint8_t *restrict red_row,
@@ -132,6 +292,9 @@ void write_rgb_row_r_const_gb(
     uint8_t blue_byte,
     uint32_t count
 ) {
+    if (dma_rgb(y, 0u, count, 1u, 0u, red_row, NULL, NULL, 0u, green_byte, blue_byte)) {
+        return;
+    }
     vga_write_rgb_row_r_const_gb_fast(y, red_row, green_byte, blue_byte, count);
 }
 
@@ -142,6 +305,9 @@ void write_rgb_row_rb_const_g(
     uint8_t green_byte,
     uint32_t count
 ) {
+    if (dma_rgb(y, 0u, count, 1u, 0u, red_row, NULL, blue_row, 0u, green_byte, 0u)) {
+        return;
+    }
     vga_write_rgb_row_rb_const_g_fast(y, red_row, blue_row, green_byte, count);
 }
 
@@ -153,6 +319,9 @@ void write_rgb_column_bytes(
     const uint8_t *restrict blue_col,
     uint32_t count
 ) {
+    if (dma_rgb(y_start, x_byte, 1u, count, 1u, red_col, green_col, blue_col, 0u, 0u, 0u)) {
+        return;
+    }
     vga_write_rgb_column_bytes_fast(y_start, x_byte, red_col, green_col, blue_col, count);
 }
 
@@ -164,6 +333,9 @@ void fill_rgb_column_constant(
     uint8_t blue_byte,
     uint32_t count
 ) {
+    if (dma_rgb(y_start, x_byte, 1u, count, 0u, NULL, NULL, NULL, red_byte, green_byte, blue_byte)) {
+        return;
+    }
     vga_fill_rgb_column_constant_fast(y_start, x_byte, red_byte, green_byte, blue_byte, count);
 }
 
@@ -175,6 +347,9 @@ void write_rgb_column_r_const_gb(
     uint8_t blue_byte,
     uint32_t count
 ) {
+    if (dma_rgb(y_start, x_byte, 1u, count, 1u, red_col, NULL, NULL, 0u, green_byte, blue_byte)) {
+        return;
+    }
     vga_write_rgb_column_r_const_gb_fast(y_start, x_byte, red_col, green_byte, blue_byte, count);
 }
 
@@ -186,5 +361,8 @@ void write_rgb_column_rb_const_g(
     uint8_t green_byte,
     uint32_t count
 ) {
+    if (dma_rgb(y_start, x_byte, 1u, count, 1u, red_col, NULL, blue_col, 0u, green_byte, 0u)) {
+        return;
+    }
     vga_write_rgb_column_rb_const_g_fast(y_start, x_byte, red_col, blue_col, green_byte, count);
 }
\ No newline at end of file
@@ -3,6 +3,13 @@
 
 #include <stdint.h>
 
+// make EXTRA_CFLAGS=-DVGA_PACK_ASM: superoptimized packing kernels
+// (tools/superopt, regenerate with make superopt). Only kernels that beat a
+// literal lowering of the C are generated; each defines VGA_HAVE_<KERNEL>.
+#ifdef VGA_PACK_ASM
+#include "vga_pack_asm.h"
+#endif
+
 #define VGA_RED_BASE    0x10000000u
 #define VGA_GREEN_BASE  0x10010000u
 #define VGA_BLUE_BASE   0x10020000u
@@ -11,6 +18,40 @@
 #define VGA_HEIGHT      120u
 #define VGA_WIDTH_BYTES 80u
 #define VGA_ROW_ADDR_STRIDE 0x100u
+#define VGA_WIDTH_PIXELS (VGA_WIDTH_BYTES * 2u)
+#define VGA_WIDTH_WORDS (VGA_WIDTH_BYTES / 4u)
+
+// Blit/fill engine (proposed; modelled by tools/rvsim --dma, see
+// tools/vga_dma.h). One command fills or copies a width x height byte
+// rectangle of one plane and runs while the CPU continues.
+// make EXTRA_CFLAGS=-DVGA_DMA: the non-inline row/column/rect calls below
+// hand requests of at least VGA_DMA_MIN_BYTES bytes per plane (width x
+// height) to the engine.
+// Copy sources must stay unchanged until vga_dma_wait() (or swap_frame(),
+// which waits first). The other driver calls, and the compositor, gradient,
+// strip, row-cache and bitmap calls that write the planes, wait before
+// writing; the inline *_fast helpers do not, so call vga_dma_wait() before
+// using them on a region the engine may still be writing.
+#define VGA_DMA_BASE        0x10040000u
+#define VGA_DMA_SRC         (VGA_DMA_BASE + 0x00u)  /* copy source in RAM */
+#define VGA_DMA_SRC_STRIDE  (VGA_DMA_BASE + 0x04u)  /* bytes between source rows */
+#define VGA_DMA_DST         (VGA_DMA_BASE + 0x08u)  /* plane << 16 | y << 8 | x_byte */
+#define VGA_DMA_WIDTH       (VGA_DMA_BASE + 0x0Cu)  /* bytes per row */
+#define VGA_DMA_HEIGHT      (VGA_DMA_BASE + 0x10u)  /* rows */
+#define VGA_DMA_FILL        (VGA_DMA_BASE + 0x14u)
+#define VGA_DMA_CTRL        (VGA_DMA_BASE + 0x18u)  /* write VGA_DMA_CMD_* to queue */
+#define VGA_DMA_STATUS      (VGA_DMA_BASE + 0x1Cu)
+#define VGA_DMA_DONE        (VGA_DMA_BASE + 0x20u)  /* commands completed */
+
+#define VGA_DMA_CMD_FILL        0u
+#define VGA_DMA_CMD_COPY        1u
+#define VGA_DMA_STATUS_BUSY     0x1u
+#define VGA_DMA_STATUS_ERROR    0x2u
+#define VGA_DMA_STATUS_FULL     0x4u
+
+#ifndef VGA_DMA_MIN_BYTES
+#define VGA_DMA_MIN_BYTES   16u     /* smaller requests are cheaper as CPU stores */
+#endif
 
 typedef struct {
     uint8_t r;
@@ -23,9 +64,24 @@ static inline uint32_t vga_color_addr_fast(uint32_t color_base, uint32_t y, uint
 }
 
 static inline uint8_t vga_pack_two_pixels_fast(uint8_t even_x, uint8_t odd_x) {
+#ifdef VGA_HAVE_PACK_TWO_PIXELS_ASM
+    // asm does not constant-fold: keep C for compile-time pixels
+    if (!__builtin_constant_p(even_x) || !__builtin_constant_p(odd_x)) {
+        return (uint8_t)vga_pack_two_pixels_asm(even_x, odd_x);
+    }
+#endif
     return (uint8_t)(((odd_x & 0x0Fu) << 4) | (even_x & 0x0Fu));
 }
 
+// Replicate a 4-bit channel value across all 8 nibbles of a word
+// (shift/or rather than * 0x11111111u: no M extension, no __mulsi3)
+static inline uint32_t vga_nibble_splat(uint8_t value) {
+    uint32_t v = value & 0x0Fu;
+    v |= v << 4;
+    v |= v << 8;
+    return v | (v << 16);
+}
+
 static inline void vga_write_rgb_byte_fast(
     uint32_t y,
     uint32_t x_byte,
@@ -62,6 +118,25 @@ static inline void vga_write_rgb_row_bytes_fast(
     }
 }
 
+// Word-store variant of vga_write_rgb_row_bytes_fast for word-aligned row
+// buffers: 8 pixels per SW instead of 2 per SB. Row starts are word-aligned.
+static inline void vga_write_rgb_row_words_fast(
+    uint32_t y,
+    const uint32_t *restrict red_row,
+    const uint32_t *restrict green_row,
+    const uint32_t *restrict blue_row,
+    uint32_t word_count
+) {
+    volatile uint32_t *r = (volatile uint32_t *)vga_color_addr_fast(VGA_RED_BASE, y, 0u);
+    volatile uint32_t *g = (volatile uint32_t *)vga_color_addr_fast(VGA_GREEN_BASE, y, 0u);
+    volatile uint32_t *b = (volatile uint32_t *)vga_color_addr_fast(VGA_BLUE_BASE, y, 0u);
+    for (uint32_t xw = 0; xw < word_count; ++xw) {
+        r[xw] = red_row[xw];
+        g[xw] = green_row[xw];
+        b[xw] = blue_row[xw];
+    }
+}
+
 static inline void vga_fill_rgb_row_constant_fast(
     uint32_t y,
     uint8_t red_byte,
@@ -197,6 +272,14 @@ static inline void vga_write_rgb_column_rb_const_g_fast(
     }
 }
 
+// Wait until the engine has finished every queued command (no-op without VGA_DMA)
+static inline void vga_dma_wait(void) {
+#ifdef VGA_DMA
+    while ((*(volatile uint32_t *)VGA_DMA_STATUS & VGA_DMA_STATUS_BUSY) != 0u) {
+    }
+#endif
+}
+
 uint32_t color_addr(uint32_t color_base, uint32_t y, uint32_t x_byte);
 uint8_t pack_two_pixels(uint8_t even_x, uint8_t odd_x);
 void swap_frame(void);
@@ -214,6 +297,16 @@ void write_rgb_row_bytes(
     uint32_t count
 );
 void fill_rgb_row_constant(uint32_t y, uint8_t red_byte, uint8_t green_byte, uint8_t blue_byte, uint32_t count);
+// Fill width x height bytes per plane from (x_byte, y)
+void fill_rgb_rect_constant(
+    uint32_t y,
+    uint32_t x_byte,
+    uint32_t width,
+    uint32_t height,
+    uint8_t red_byte,
+    uint8_t green_byte,
+    uint8_t blue_byte
+);
 void write_rgb_row_r_const_gb(
     uint32_t y,
     const uint8_t *restrict red_row,
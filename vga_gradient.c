@@ -0,0 +1,238 @@
+#include "vga_gradient.h"
+
+/*
+ * Gradient fill kernels: see vga_gradient.h.
+ *
+ * Accumulators are 16.16 fixed point in uint32_t; steps may be negative and
+ * simply wrap. Each accumulator starts half a level up so truncation rounds.
+ */
+
+#define FX_SHIFT    16u
+#define FX_HALF     0x8000u
+
+typedef struct {
+    uint32_t r;
+    uint32_t g;
+    uint32_t b;
+} grad_fx_t;
+
+static inline uint32_t fx_from_nibble(uint8_t c) {
+    return ((uint32_t)(c & 0x0Fu) << FX_SHIFT) | FX_HALF;
+}
+
+// 1 / (points - 1) in 16.16: the per-step fraction across `points` samples
+static inline uint32_t fx_recip(uint32_t points) {
+    return (points > 1u) ? (0x10000u / (points - 1u)) : 0u;
+}
+
+static inline uint32_t fx_step(uint8_t c0, uint8_t c1, uint32_t recip) {
+    int32_t delta = (int32_t)(c1 & 0x0Fu) - (int32_t)(c0 & 0x0Fu);
+    return (uint32_t)delta * recip;
+}
+
+static inline void grad_setup(grad_fx_t *acc, grad_fx_t *step, Color c0, Color c1, uint32_t recip) {
+    acc->r = fx_from_nibble(c0.r);
+    acc->g = fx_from_nibble(c0.g);
+    acc->b = fx_from_nibble(c0.b);
+    step->r = fx_step(c0.r, c1.r, recip);
+    step->g = fx_step(c0.g, c1.g, recip);
+    step->b = fx_step(c0.b, c1.b, recip);
+}
+
+#define FX_NIBBLE(a) (((a) >> FX_SHIFT) & 0x0Fu)
+
+// Next 2 pixels of one channel as a packed byte
+static inline uint8_t grad_byte(uint32_t *acc, uint32_t step) {
+    uint32_t a = *acc;
+    uint32_t v = FX_NIBBLE(a);
+    a += step;
+    v |= FX_NIBBLE(a) << 4;
+    *acc = a + step;
+    return (uint8_t)v;
+}
+
+// Next 8 pixels of one channel as a packed word (unrolled, branch-free)
+static inline uint32_t grad_word(uint32_t *acc, uint32_t step) {
+    uint32_t a = *acc;
+    uint32_t v = FX_NIBBLE(a);
+    a += step; v |= FX_NIBBLE(a) << 4;
+    a += step; v |= FX_NIBBLE(a) << 8;
+    a += step; v |= FX_NIBBLE(a) << 12;
+    a += step; v |= FX_NIBBLE(a) << 16;
+    a += step; v |= FX_NIBBLE(a) << 20;
+    a += step; v |= FX_NIBBLE(a) << 24;
+    a += step; v |= FX_NIBBLE(a) << 28;
+    *acc = a + step;
+    return v;
+}
+
+// Emit count bytes of a horizontal gradient from prepared accumulators
+static void grad_row_fx(uint32_t y, uint32_t x_byte, uint32_t count, grad_fx_t acc, grad_fx_t step) {
+    uint32_t xb = x_byte;
+    uint32_t end = x_byte + count;
+
+    if (end > VGA_WIDTH_BYTES) {
+        end = VGA_WIDTH_BYTES;
+    }
+    // Leading bytes up to the first word boundary
+    while ((xb & 3u) != 0u && xb < end) {
+        uint8_t r = grad_byte(&acc.r, step.r);
+        uint8_t g = grad_byte(&acc.g, step.g);
+        uint8_t b = grad_byte(&acc.b, step.b);
+        vga_write_rgb_byte_fast(y, xb, r, g, b);
+        ++xb;
+    }
+    // Aligned body: 8 pixels per store
+    while (xb + 4u <= end) {
+        uint32_t r = grad_word(&acc.r, step.r);
+        uint32_t g = grad_word(&acc.g, step.g);
+        uint32_t b = grad_word(&acc.b, step.b);
+        *(volatile uint32_t *)vga_color_addr_fast(VGA_RED_BASE, y, xb) = r;
+        *(volatile uint32_t *)vga_color_addr_fast(VGA_GREEN_BASE, y, xb) = g;
+        *(volatile uint32_t *)vga_color_addr_fast(VGA_BLUE_BASE, y, xb) = b;
+        xb += 4u;
+    }
+    while (xb < end) {
+        uint8_t r = grad_byte(&acc.r, step.r);
+        uint8_t g = grad_byte(&acc.g, step.g);
+        uint8_t b = grad_byte(&acc.b, step.b);
+        vga_write_rgb_byte_fast(y, xb, r, g, b);
+        ++xb;
+    }
+}
+
+void vga_gradient_row(uint32_t y, uint32_t x_byte, uint32_t count, Color c0, Color c1) {
+    grad_fx_t acc;
+    grad_fx_t step;
+
+    if (y >= VGA_HEIGHT) {
+        return;
+    }
+    vga_dma_wait();
+    grad_setup(&acc, &step, c0, c1, fx_recip(count * 2u));
+    grad_row_fx(y, x_byte, count, acc, step);
+}
+
+void vga_gradient_column(uint32_t y_start, uint32_t x_byte, uint32_t count, Color c0, Color c1) {
+    volatile uint8_t *r = (volatile uint8_t *)vga_color_addr_fast(VGA_RED_BASE, y_start, x_byte);
+    volatile uint8_t *g = (volatile uint8_t *)vga_color_addr_fast(VGA_GREEN_BASE, y_start, x_byte);
+    volatile uint8_t *b = (volatile uint8_t *)vga_color_addr_fast(VGA_BLUE_BASE, y_start, x_byte);
+    grad_fx_t acc;
+    grad_fx_t step;
+    uint32_t rows = count;
+
+    if (x_byte >= VGA_WIDTH_BYTES || y_start >= VGA_HEIGHT) {
+        return;
+    }
+    if (rows > VGA_HEIGHT - y_start) {
+        rows = VGA_HEIGHT - y_start;
+    }
+    vga_dma_wait();
+    grad_setup(&acc, &step, c0, c1, fx_recip(count));
+    for (uint32_t i = 0; i < rows; ++i) {
+        // Same color in both nibbles: the run is one byte (2 pixels) wide
+        uint32_t rn = FX_NIBBLE(acc.r);
+        uint32_t gn = FX_NIBBLE(acc.g);
+        uint32_t bn = FX_NIBBLE(acc.b);
+        *r = (uint8_t)(rn | (rn << 4));
+        *g = (uint8_t)(gn | (gn << 4));
+        *b = (uint8_t)(bn | (bn << 4));
+        acc.r += step.r;
+        acc.g += step.g;
+        acc.b += step.b;
+        r = (volatile uint8_t *)((uintptr_t)r + VGA_ROW_ADDR_STRIDE);
+        g = (volatile uint8_t *)((uintptr_t)g + VGA_ROW_ADDR_STRIDE);
+        b = (volatile uint8_t *)((uintptr_t)b + VGA_ROW_ADDR_STRIDE);
+    }
+}
+
+// Signed 16.16 value divided by (points - 1); the divide is per rect, not per pixel
+static inline uint32_t fx_div_steps(uint32_t value, uint32_t points) {
+    return (points > 1u) ? (uint32_t)((int32_t)value / (int32_t)(points - 1u)) : 0u;
+}
+
+void vga_gradient_rect(
+    uint32_t y,
+    uint32_t x_byte,
+    uint32_t width_bytes,
+    uint32_t height,
+    Color top_left,
+    Color top_right,
+    Color bottom_left,
+    Color bottom_right
+) {
+    uint32_t recip = fx_recip(width_bytes * 2u);
+    grad_fx_t left;         // left-edge color, stepped down the rows
+    grad_fx_t left_step;
+    grad_fx_t span_step;    // per-pixel step, itself stepped down the rows
+    grad_fx_t span_step_bottom;
+    grad_fx_t span_dstep;
+    grad_fx_t unused;
+    uint32_t rows = height;
+
+    if (y >= VGA_HEIGHT || x_byte >= VGA_WIDTH_BYTES) {
+        return;
+    }
+    if (rows > VGA_HEIGHT - y) {
+        rows = VGA_HEIGHT - y;
+    }
+
+    grad_setup(&left, &left_step, top_left, bottom_left, fx_recip(height));
+    grad_setup(&unused, &span_step, top_left, top_right, recip);
+    grad_setup(&unused, &span_step_bottom, bottom_left, bottom_right, recip);
+    span_dstep.r = fx_div_steps(span_step_bottom.r - span_step.r, height);
+    span_dstep.g = fx_div_steps(span_step_bottom.g - span_step.g, height);
+    span_dstep.b = fx_div_steps(span_step_bottom.b - span_step.b, height);
+
+    vga_dma_wait();
+    for (uint32_t row = 0; row < rows; ++row) {
+        grad_row_fx(y + row, x_byte, width_bytes, left, span_step);
+        left.r += left_step.r;
+        left.g += left_step.g;
+        left.b += left_step.b;
+        span_step.r += span_dstep.r;
+        span_step.g += span_dstep.g;
+        span_step.b += span_dstep.b;
+    }
+}
+
+void vga_gradient_line_span(vga_line_t *line, uint32_t x0, uint32_t x1, Color c0, Color c1) {
+    grad_fx_t acc;
+    grad_fx_t step;
+    uint32_t lead;
+    uint32_t xw;
+    uint32_t last;
+
+    if (x1 > VGA_WIDTH_PIXELS) {
+        x1 = VGA_WIDTH_PIXELS;
+    }
+    if (x0 >= x1) {
+        return;
+    }
+    grad_setup(&acc, &step, c0, c1, fx_recip(x1 - x0));
+
+    // Back the accumulators up to the start of x0's word so every word is
+    // built the same way; the pixels before x0 are masked off below.
+    lead = x0 & 7u;
+    acc.r -= lead * step.r;
+    acc.g -= lead * step.g;
+    acc.b -= lead * step.b;
+
+    xw = x0 >> 3;
+    last = (x1 - 1u) >> 3;
+    for (; xw <= last; ++xw) {
+        uint32_t m = 0xFFFFFFFFu;
+        uint32_t r = grad_word(&acc.r, step.r);
+        uint32_t g = grad_word(&acc.g, step.g);
+        uint32_t b = grad_word(&acc.b, step.b);
+        if (xw == (x0 >> 3)) {
+            m &= 0xFFFFFFFFu << (lead * 4u);
+        }
+        if (xw == last) {
+            m &= 0xFFFFFFFFu >> ((7u - ((x1 - 1u) & 7u)) * 4u);
+        }
+        line->r[xw] = vga_blend_word(line->r[xw], r, m);
+        line->g[xw] = vga_blend_word(line->g[xw], g, m);
+        line->b[xw] = vga_blend_word(line->b[xw], b, m);
+    }
+}
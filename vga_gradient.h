@@ -0,0 +1,60 @@
+#ifndef VGA_GRADIENT_H
+#define VGA_GRADIENT_H
+
+#include <stdint.h>
+#include "vga_driver.h"
+#include "vga_compositor.h"
+
+/*
+ * Gradient (Gouraud) fill kernels.
+ *
+ * Colors are interpolated per channel with 16.16 fixed-point DDA
+ * accumulators: one add per pixel per channel, no divide or branch inside
+ * the pixel loop. Eight pixels are assembled into one packed plane word at
+ * a time and stored with SW wherever the destination is word-aligned.
+ * Setup costs one divide per span (rect: per edge).
+ *
+ * Endpoints are inclusive: the first pixel gets c0 and the last gets c1.
+ * Frame-buffer kernels work on whole bytes (2 pixels) like the rest of
+ * vga_driver.h, since partial bytes would need a read-modify-write of VGA
+ * memory. The line-buffer kernel is pixel exact.
+ *
+ * Steps always come from the requested extent; whatever falls off the
+ * screen (bytes past 79, rows past 119) is then skipped, so a clipped
+ * gradient shows the same colors as the visible part of the full one.
+ */
+
+////////////////////////////////////////////////////////////
+// Horizontal span: row y, bytes [x_byte, x_byte + count),
+// c0 at the left pixel to c1 at the right pixel.
+////////////////////////////////////////////////////////////
+void vga_gradient_row(uint32_t y, uint32_t x_byte, uint32_t count, Color c0, Color c1);
+
+////////////////////////////////////////////////////////////
+// Vertical run: byte column x_byte (2 pixels wide), rows
+// [y_start, y_start + count), c0 at the top to c1 at the bottom.
+////////////////////////////////////////////////////////////
+void vga_gradient_column(uint32_t y_start, uint32_t x_byte, uint32_t count, Color c0, Color c1);
+
+////////////////////////////////////////////////////////////
+// Rectangle with one color per corner, bilinearly interpolated
+// (top_left, top_right, bottom_left, bottom_right).
+////////////////////////////////////////////////////////////
+void vga_gradient_rect(
+    uint32_t y,
+    uint32_t x_byte,
+    uint32_t width_bytes,
+    uint32_t height,
+    Color top_left,
+    Color top_right,
+    Color bottom_left,
+    Color bottom_right
+);
+
+////////////////////////////////////////////////////////////
+// Pixel-exact span [x0, x1) into a compositor line buffer,
+// e.g. one scanline of a Gouraud-shaded triangle from a layer.
+////////////////////////////////////////////////////////////
+void vga_gradient_line_span(vga_line_t *line, uint32_t x0, uint32_t x1, Color c0, Color c1);
+
+#endif
@@ -0,0 +1,87 @@
+/* Generated by tools/superopt --seed 1 --iters 1000000 --max-len 3 --window 4;
+ * do not edit.
+ * Every kernel is proven equal to its C reference on all inputs
+ * (see tools/superopt.c). Results have no bits set above the packed
+ * pixels. Only kernels shorter than the literal lowering of the C
+ * (one instruction per operator, not measured GCC -O2 output) are
+ * here; each defines VGA_HAVE_<KERNEL> for its callers. */
+
+#ifndef VGA_PACK_ASM_H
+#define VGA_PACK_ASM_H
+
+#include <stdint.h>
+
+// pack_eight_pixels_32(px_1, ..., px_8): 21 instructions (literal lowering 22)
+#define VGA_HAVE_PACK_EIGHT_PIXELS_ASM
+static inline uint32_t vga_pack_eight_pixels_asm(uint8_t px_1, uint8_t px_2, uint8_t px_3, uint8_t px_4, uint8_t px_5, uint8_t px_6, uint8_t px_7, uint8_t px_8) {
+    uint32_t r0 = px_1, r1 = px_2, r2 = px_3, r3 = px_4, r4 = px_5, r5 = px_6, r6 = px_7, r7 = px_8;
+    __asm__(
+        "andi %0, %0, 0xf\n\t"
+        "andi %1, %1, 0xf\n\t"
+        "slli %1, %1, 4\n\t"
+        "or %0, %0, %1\n\t"
+        "andi %2, %2, 0xf\n\t"
+        "slli %2, %2, 8\n\t"
+        "or %0, %0, %2\n\t"
+        "andi %3, %3, 0xf\n\t"
+        "slli %3, %3, 0xc\n\t"
+        "or %0, %0, %3\n\t"
+        "andi %4, %4, 0xf\n\t"
+        "slli %4, %4, 0x10\n\t"
+        "or %0, %0, %4\n\t"
+        "andi %5, %5, 0xf\n\t"
+        "slli %5, %5, 0x14\n\t"
+        "or %0, %0, %5\n\t"
+        "andi %6, %6, 0xf\n\t"
+        "slli %6, %6, 0x18\n\t"
+        "or %0, %0, %6\n\t"
+        "slli %7, %7, 0x1c\n\t"
+        "or %0, %0, %7\n\t"
+        : "+r"(r0), "+r"(r1), "+r"(r2), "+r"(r3), "+r"(r4), "+r"(r5), "+r"(r6), "+r"(r7));
+    return r0;
+}
+
+// pack_four_pixels_16(c[0].r, ..., c[3].r), c[0..3] loaded as words w0..w2: 12 instructions (literal lowering 13)
+#define VGA_HAVE_AOS4_RED_ASM
+static inline uint32_t vga_aos4_red_asm(uint32_t w0, uint32_t w1, uint32_t w2) {
+    uint32_t r0 = w0, r1 = w1, r2 = w2;
+    uint32_t r3;
+    __asm__(
+        "andi %3, %0, 0xf\n\t"
+        "srli %0, %0, 0x14\n\t"
+        "andi %0, %0, 0xf0\n\t"
+        "add %3, %3, %0\n\t"
+        "srli %1, %1, 0x10\n\t"
+        "andi %1, %1, 0xf\n\t"
+        "slli %1, %1, 8\n\t"
+        "or %3, %3, %1\n\t"
+        "srli %2, %2, 8\n\t"
+        "andi %2, %2, 0xf\n\t"
+        "slli %2, %2, 0xc\n\t"
+        "or %3, %3, %2\n\t"
+        : "+r"(r0), "+r"(r1), "+r"(r2), "=r"(r3));
+    return r3;
+}
+
+// pack_four_pixels_16(c[0].b, ..., c[3].b), c[0..3] loaded as words w0..w2: 12 instructions (literal lowering 13)
+#define VGA_HAVE_AOS4_BLUE_ASM
+static inline uint32_t vga_aos4_blue_asm(uint32_t w0, uint32_t w1, uint32_t w2) {
+    uint32_t r0 = w0, r1 = w1, r2 = w2;
+    __asm__(
+        "srli %0, %0, 0x10\n\t"
+        "andi %0, %0, 0xf\n\t"
+        "srli %1, %1, 4\n\t"
+        "andi %1, %1, 0xf0\n\t"
+        "add %0, %0, %1\n\t"
+        "andi %1, %2, 0xf\n\t"
+        "slli %1, %1, 8\n\t"
+        "or %0, %0, %1\n\t"
+        "srli %2, %2, 0x18\n\t"
+        "andi %2, %2, 0xf\n\t"
+        "slli %2, %2, 0xc\n\t"
+        "or %0, %0, %2\n\t"
+        : "+r"(r0), "+r"(r1), "+r"(r2));
+    return r0;
+}
+
+#endif
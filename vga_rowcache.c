@@ -0,0 +1,84 @@
+#include "vga_rowcache.h"
+
+/*
+ * Row-template cache: see vga_rowcache.h.
+ */
+
+uint32_t vga_rowcache_init(
+    vga_rowcache_t *cache,
+    void *arena,
+    uint32_t arena_bytes,
+    const vga_row_gen_t *gens,
+    uint32_t gen_count
+) {
+    uint32_t n = 0;
+
+    cache->gens = gens;
+    cache->gen_count = gen_count;
+    cache->slots = (vga_rowcache_slot_t *)arena;
+    // Count whole slots by subtraction: no M extension, no __udivsi3
+    while (arena_bytes >= sizeof(vga_rowcache_slot_t)) {
+        cache->slots[n].gen = VGA_ROWCACHE_FREE;
+        arena_bytes -= sizeof(vga_rowcache_slot_t);
+        ++n;
+    }
+    cache->slot_count = n;
+    cache->clock = 0u;
+    cache->hits = 0u;
+    cache->misses = 0u;
+    cache->evictions = 0u;
+    return n;
+}
+
+const vga_rowcache_slot_t *vga_rowcache_get(vga_rowcache_t *cache, uint32_t gen, uint32_t param) {
+    vga_rowcache_slot_t *victim = NULL;
+    uint32_t victim_age = 0u;
+    uint32_t now;
+
+    if (gen >= cache->gen_count || cache->slot_count == 0u) {
+        return NULL;
+    }
+    now = ++cache->clock;
+    for (uint32_t i = 0; i < cache->slot_count; ++i) {
+        vga_rowcache_slot_t *s = &cache->slots[i];
+        uint32_t age;
+        if (s->gen == gen && s->param == param) {
+            s->stamp = now;
+            cache->hits++;
+            return s;
+        }
+        // Free slots first, then the longest unused (wrap-safe age)
+        age = (s->gen == VGA_ROWCACHE_FREE) ? 0xFFFFFFFFu : now - s->stamp;
+        if (victim == NULL || age > victim_age) {
+            victim = s;
+            victim_age = age;
+        }
+    }
+
+    cache->misses++;
+    cache->evictions += (victim->gen != VGA_ROWCACHE_FREE);
+    victim->gen = gen;
+    victim->param = param;
+    victim->stamp = now;
+    cache->gens[gen].fn(cache->gens[gen].ctx, param, (uint8_t *)victim->rows[0], (uint8_t *)victim->rows[1],
+                        (uint8_t *)victim->rows[2]);
+    return victim;
+}
+
+void vga_rowcache_write(vga_rowcache_t *cache, uint32_t y, uint32_t gen, uint32_t param) {
+    const vga_rowcache_slot_t *s = vga_rowcache_get(cache, gen, param);
+
+    if (s == NULL) {
+        return;
+    }
+    vga_dma_wait();
+    vga_write_rgb_row_words_fast(y, s->rows[0], s->rows[1], s->rows[2], VGA_WIDTH_WORDS);
+}
+
+void vga_rowcache_invalidate(vga_rowcache_t *cache, uint32_t gen) {
+    for (uint32_t i = 0; i < cache->slot_count; ++i) {
+        if (gen == VGA_ROWCACHE_ALL || cache->slots[i].gen == gen) {
+            cache->slots[i].gen = VGA_ROWCACHE_FREE;
+        }
+    }
+}
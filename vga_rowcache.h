@@ -0,0 +1,75 @@
+#ifndef VGA_ROWCACHE_H
+#define VGA_ROWCACHE_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "vga_driver.h"
+
+/*
+ * Row-template cache.
+ *
+ * Many frames are built from a few distinct full-width rows (gradients,
+ * checkers, stripes, glyph lines) repeated down the screen and from frame
+ * to frame. Callers register row generators; the cache keeps the packed
+ * red/green/blue rows each generator produced, keyed by generator id and a
+ * 32-bit parameter (pack several small parameters into it), in slots carved
+ * out of a caller-supplied arena. A hit costs a short scan and the row
+ * write; a miss calls the generator into the least recently used slot.
+ *
+ * Rows are word-aligned and written with SW (8 pixels per store per plane),
+ * like vga_write_rgb_row_words_fast.
+ *
+ * RAM: sizeof(vga_rowcache_slot_t) = 252 bytes per cached row.
+ */
+
+#define VGA_ROWCACHE_FREE   0xFFFFFFFFu     /* slot.gen of an empty slot */
+#define VGA_ROWCACHE_ALL    0xFFFFFFFFu     /* vga_rowcache_invalidate: every generator */
+
+// Fill the packed rows (VGA_WIDTH_BYTES bytes per plane) for param
+typedef void (*vga_row_gen_fn)(const void *ctx, uint32_t param, uint8_t *red, uint8_t *green, uint8_t *blue);
+
+typedef struct {
+    vga_row_gen_fn fn;
+    const void *ctx;
+} vga_row_gen_t;
+
+typedef struct {
+    uint32_t gen;
+    uint32_t param;
+    uint32_t stamp;             /* cache clock at last use */
+    uint32_t rows[3][VGA_WIDTH_WORDS];
+} vga_rowcache_slot_t;
+
+typedef struct {
+    const vga_row_gen_t *gens;  /* indexed by generator id */
+    uint32_t gen_count;
+    vga_rowcache_slot_t *slots;
+    uint32_t slot_count;
+    uint32_t clock;
+    uint32_t hits;
+    uint32_t misses;
+    uint32_t evictions;
+} vga_rowcache_t;
+
+// Carve whole slots out of arena (word-aligned, arena_bytes long) and
+// register gen_count generators. Returns the number of slots.
+uint32_t vga_rowcache_init(
+    vga_rowcache_t *cache,
+    void *arena,
+    uint32_t arena_bytes,
+    const vga_row_gen_t *gens,
+    uint32_t gen_count
+);
+
+// Cached rows for (gen, param), generated on a miss. Valid until the next
+// miss; NULL for an unknown generator or an arena too small for one slot.
+const vga_rowcache_slot_t *vga_rowcache_get(vga_rowcache_t *cache, uint32_t gen, uint32_t param);
+
+// Write the rows for (gen, param) to frame-buffer row y
+void vga_rowcache_write(vga_rowcache_t *cache, uint32_t y, uint32_t gen, uint32_t param);
+
+// Drop every row of generator gen (or VGA_ROWCACHE_ALL), e.g. after the
+// data behind its ctx changed
+void vga_rowcache_invalidate(vga_rowcache_t *cache, uint32_t gen);
+
+#endif
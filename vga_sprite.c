@@ -0,0 +1,141 @@
+#include "vga_sprite.h"
+
+/*
+ * Sprite conversion and SWAR collision: see vga_sprite.h.
+ */
+
+static inline int color_equal(const Color *a, const Color *b) {
+    return ((a->r ^ b->r) | (a->g ^ b->g) | (a->b ^ b->b)) == 0u;
+}
+
+void vga_sprite_convert(
+    const Color *pixels,
+    uint32_t width_words,
+    uint32_t height,
+    const Color *key,
+    uint32_t *planar,
+    uint32_t *mask
+) {
+    uint32_t mask_words = VGA_MASK_WORDS_PER_ROW(width_words * 8u);
+
+    for (uint32_t row = 0; row < height; ++row) {
+        for (uint32_t k = 0; k < mask_words; ++k) {
+            mask[k] = 0u;
+        }
+        for (uint32_t col = 0; col < width_words; ++col) {
+            uint32_t r = 0u;
+            uint32_t g = 0u;
+            uint32_t b = 0u;
+            uint32_t nibble_mask = 0u;
+            uint32_t occupancy = 0u;
+            for (uint32_t i = 0; i < 8u; ++i) {
+                const Color *p = &pixels[i];
+                uint32_t sh = i * 4u;
+                r |= (uint32_t)(p->r & 0x0Fu) << sh;
+                g |= (uint32_t)(p->g & 0x0Fu) << sh;
+                b |= (uint32_t)(p->b & 0x0Fu) << sh;
+                if (key == 0 || !color_equal(p, key)) {
+                    nibble_mask |= 0x0Fu << sh;
+                    occupancy |= 1u << i;
+                }
+            }
+            planar[0] = r & nibble_mask;
+            planar[1] = g & nibble_mask;
+            planar[2] = b & nibble_mask;
+            planar[3] = nibble_mask;
+            planar += 4;
+            pixels += 8;
+            // 8 occupancy bits land at pixel col * 8 of the row
+            mask[col >> 2] |= occupancy << ((col & 3u) * 8u);
+        }
+        mask += mask_words;
+    }
+}
+
+// 32 bits of a mask row starting at pixel `bit` (zero outside the row)
+static inline uint32_t row_bits_at(const uint32_t *row, uint32_t words, int32_t bit) {
+    uint32_t frac = (uint32_t)bit & 31u;
+    int32_t w = (bit - (int32_t)frac) / 32;
+    uint32_t lo = (w >= 0 && w < (int32_t)words) ? row[w] : 0u;
+    uint32_t hi;
+
+    if (frac == 0u) {
+        return lo;
+    }
+    hi = (w + 1 >= 0 && w + 1 < (int32_t)words) ? row[w + 1] : 0u;
+    return (lo >> frac) | (hi << (32u - frac));
+}
+
+int vga_mask_overlap(const vga_mask_t *a, int32_t ax, int32_t ay, const vga_mask_t *b, int32_t bx, int32_t by) {
+    int32_t y0 = (ay > by) ? ay : by;
+    int32_t y1;
+    int32_t dx = bx - ax;
+    const uint32_t *arow;
+    const uint32_t *brow;
+    uint32_t w_first = 0u;
+    uint32_t w_last = b->words_per_row;
+
+    // Bounding boxes first
+    if (bx >= ax + (int32_t)a->width || ax >= bx + (int32_t)b->width) {
+        return 0;
+    }
+    y1 = (ay + (int32_t)a->height < by + (int32_t)b->height) ? ay + (int32_t)a->height : by + (int32_t)b->height;
+    if (y0 >= y1) {
+        return 0;
+    }
+
+    // Only the words of b that can overlap a horizontally
+    if (dx < 0) {
+        w_first = (uint32_t)(-dx) >> 5;
+    }
+    if (dx + (int32_t)b->width > (int32_t)a->width) {
+        uint32_t cut = (uint32_t)(a->width - dx + 31) >> 5;
+        if (cut < w_last) {
+            w_last = cut;
+        }
+    }
+
+    arow = a->bits + (uint32_t)(y0 - ay) * a->words_per_row;
+    brow = b->bits + (uint32_t)(y0 - by) * b->words_per_row;
+    for (int32_t y = y0; y < y1; ++y) {
+        for (uint32_t w = w_first; w < w_last; ++w) {
+            if (row_bits_at(arow, a->words_per_row, (int32_t)(w * 32u) + dx) & brow[w]) {
+                return 1;
+            }
+        }
+        arow += a->words_per_row;
+        brow += b->words_per_row;
+    }
+    return 0;
+}
+
+int vga_mask_test_point(const vga_mask_t *m, int32_t mx, int32_t my, int32_t px, int32_t py) {
+    uint32_t x = (uint32_t)(px - mx);
+    uint32_t y = (uint32_t)(py - my);
+
+    if (x >= m->width || y >= m->height) {
+        return 0;
+    }
+    return (int)((m->bits[y * m->words_per_row + (x >> 5)] >> (x & 31u)) & 1u);
+}
+
+void vga_mask_fill_rect(uint32_t *bits, uint32_t words_per_row, uint32_t x, uint32_t y, uint32_t w, uint32_t h) {
+    uint32_t *row = bits + y * words_per_row;
+    uint32_t x_end = x + w;
+
+    for (uint32_t j = 0; j < h; ++j) {
+        uint32_t xi = x;
+        while (xi < x_end) {
+            uint32_t sh = xi & 31u;
+            uint32_t n = 32u - sh;
+            uint32_t m;
+            if (n > x_end - xi) {
+                n = x_end - xi;
+            }
+            m = (n == 32u) ? 0xFFFFFFFFu : (((1u << n) - 1u) << sh);
+            row[xi >> 5] |= m;
+            xi += n;
+        }
+        row += words_per_row;
+    }
+}
@@ -0,0 +1,59 @@
+#ifndef VGA_SPRITE_H
+#define VGA_SPRITE_H
+
+#include <stdint.h>
+#include "vga_driver.h"
+#include "vga_compositor.h"
+
+/*
+ * Sprite conversion and SWAR collision.
+ *
+ * vga_sprite_convert() turns a Color array into the planar layout used by
+ * the compositor's sprite layer and, in the same pass, into a 1-bpp
+ * occupancy mask: one bit per pixel, bit i of word k in a row = pixel
+ * 32 * k + i, rows padded to whole words. Collision tests then AND shifted
+ * mask words over the overlapping rows only; 32 pixels per AND, no pixel
+ * loops. A static collision map (walls, terrain) is just a large mask.
+ */
+
+#define VGA_MASK_WORDS_PER_ROW(width_px) (((width_px) + 31u) / 32u)
+#define VGA_SPRITE_PLANAR_WORDS(width_words, height) ((width_words) * (height) * 4u)
+
+typedef struct {
+    const uint32_t *bits;   // height rows of words_per_row words
+    uint16_t width;         // in pixels
+    uint16_t height;
+    uint8_t words_per_row;
+} vga_mask_t;
+
+////////////////////////////////////////////////////////////
+// Convert width_words * 8 by height Color pixels (row-major) into
+//   planar: VGA_SPRITE_PLANAR_WORDS(width_words, height) words
+//           (vga_sprite_t data for the compositor)
+//   mask:   height * VGA_MASK_WORDS_PER_ROW(width_words * 8) words
+// Pixels equal to *key are transparent; key == 0 makes all opaque.
+////////////////////////////////////////////////////////////
+void vga_sprite_convert(
+    const Color *pixels,
+    uint32_t width_words,
+    uint32_t height,
+    const Color *key,
+    uint32_t *planar,
+    uint32_t *mask
+);
+
+// Nonzero if mask a at (ax, ay) and mask b at (bx, by) share a set pixel
+int vga_mask_overlap(const vga_mask_t *a, int32_t ax, int32_t ay, const vga_mask_t *b, int32_t bx, int32_t by);
+
+// Sprite mask at (x, y) against a static map mask anchored at (0, 0)
+static inline int vga_mask_hits_map(const vga_mask_t *map, const vga_mask_t *sprite, int32_t x, int32_t y) {
+    return vga_mask_overlap(map, 0, 0, sprite, x, y);
+}
+
+// Nonzero if the pixel (px, py) is set in mask m placed at (mx, my)
+int vga_mask_test_point(const vga_mask_t *m, int32_t mx, int32_t my, int32_t px, int32_t py);
+
+// Set a rectangle of bits in a writable mask (for building collision maps)
+void vga_mask_fill_rect(uint32_t *bits, uint32_t words_per_row, uint32_t x, uint32_t y, uint32_t w, uint32_t h);
+
+#endif
@@ -0,0 +1,134 @@
+#include "vga_strip.h"
+
+/*
+ * Column strip buffer: see vga_strip.h.
+ */
+
+void vga_strip_clear(vga_strip_t *strip, Color color) {
+    uint32_t r = vga_nibble_splat(color.r);
+    uint32_t g = vga_nibble_splat(color.g);
+    uint32_t b = vga_nibble_splat(color.b);
+
+    for (uint32_t c = 0; c < VGA_STRIP_COLUMNS; ++c) {
+        for (uint32_t k = 0; k < VGA_STRIP_WORDS; ++k) {
+            strip->r[c][k] = r;
+            strip->g[c][k] = g;
+            strip->b[c][k] = b;
+        }
+    }
+}
+
+void vga_strip_vline(vga_strip_t *strip, uint32_t col, uint32_t y_start, uint32_t y_end, Color color) {
+    uint32_t r = vga_nibble_splat(color.r);
+    uint32_t g = vga_nibble_splat(color.g);
+    uint32_t b = vga_nibble_splat(color.b);
+    uint32_t *pr = strip->r[col];
+    uint32_t *pg = strip->g[col];
+    uint32_t *pb = strip->b[col];
+    uint32_t k;
+    uint32_t k_last;
+
+    if (y_end > VGA_HEIGHT) {
+        y_end = VGA_HEIGHT;
+    }
+    if (col >= VGA_STRIP_COLUMNS || y_start >= y_end) {
+        return;
+    }
+    k = y_start >> 3;
+    k_last = (y_end - 1u) >> 3;
+    // 8 rows per word; only the end words need a mask
+    for (; k <= k_last; ++k) {
+        uint32_t m = 0xFFFFFFFFu;
+        if (k == (y_start >> 3)) {
+            m &= 0xFFFFFFFFu << ((y_start & 7u) * 4u);
+        }
+        if (k == k_last) {
+            m &= 0xFFFFFFFFu >> ((7u - ((y_end - 1u) & 7u)) * 4u);
+        }
+        pr[k] ^= (pr[k] ^ r) & m;
+        pg[k] ^= (pg[k] ^ g) & m;
+        pb[k] ^= (pb[k] ^ b) & m;
+    }
+}
+
+void vga_strip_column(
+    vga_strip_t *strip,
+    uint32_t col,
+    uint32_t y_start,
+    const uint8_t *restrict red_col,
+    const uint8_t *restrict green_col,
+    const uint8_t *restrict blue_col,
+    uint32_t count
+) {
+    uint32_t y_end = y_start + count;
+
+    if (y_end > VGA_HEIGHT) {
+        y_end = VGA_HEIGHT;
+    }
+    if (col >= VGA_STRIP_COLUMNS) {
+        return;
+    }
+    for (uint32_t y = y_start; y < y_end; ++y) {
+        uint32_t i = y - y_start;
+        Color c = { red_col[i], green_col[i], blue_col[i] };
+        vga_strip_put(strip, col, y, c);
+    }
+}
+
+////////////////////////////////////////////////////////////
+// 8x8 nibble transpose: on entry w[c] nibble r is (row r, col c);
+// on exit w[r] nibble c is the same element. Three rounds of
+// block swaps (4x4, 2x2, 1x1), each a mask/shift exchange
+// between two words.
+////////////////////////////////////////////////////////////
+#define SWAP_BLOCKS(a, b, mask, shift) \
+    do { \
+        uint32_t _t = (((a) >> (shift)) ^ (b)) & (mask); \
+        (b) ^= _t; \
+        (a) ^= _t << (shift); \
+    } while (0)
+
+static inline void transpose_8x8_nibbles(uint32_t w[8]) {
+    SWAP_BLOCKS(w[0], w[4], 0x0000FFFFu, 16);
+    SWAP_BLOCKS(w[1], w[5], 0x0000FFFFu, 16);
+    SWAP_BLOCKS(w[2], w[6], 0x0000FFFFu, 16);
+    SWAP_BLOCKS(w[3], w[7], 0x0000FFFFu, 16);
+
+    SWAP_BLOCKS(w[0], w[2], 0x00FF00FFu, 8);
+    SWAP_BLOCKS(w[1], w[3], 0x00FF00FFu, 8);
+    SWAP_BLOCKS(w[4], w[6], 0x00FF00FFu, 8);
+    SWAP_BLOCKS(w[5], w[7], 0x00FF00FFu, 8);
+
+    SWAP_BLOCKS(w[0], w[1], 0x0F0F0F0Fu, 4);
+    SWAP_BLOCKS(w[2], w[3], 0x0F0F0F0Fu, 4);
+    SWAP_BLOCKS(w[4], w[5], 0x0F0F0F0Fu, 4);
+    SWAP_BLOCKS(w[6], w[7], 0x0F0F0F0Fu, 4);
+}
+
+static void flush_plane(const uint32_t (*cols)[VGA_STRIP_WORDS], uint32_t base, uint32_t x_byte) {
+    volatile uint32_t *dst = (volatile uint32_t *)vga_color_addr_fast(base, 0u, x_byte);
+
+    for (uint32_t k = 0; k < VGA_STRIP_WORDS; ++k) {
+        uint32_t w[8];
+        for (uint32_t c = 0; c < VGA_STRIP_COLUMNS; ++c) {
+            w[c] = cols[c][k];
+        }
+        transpose_8x8_nibbles(w);
+        for (uint32_t r = 0; r < 8u; ++r) {
+            *dst = w[r];
+            dst = (volatile uint32_t *)((uintptr_t)dst + VGA_ROW_ADDR_STRIDE);
+        }
+    }
+}
+
+void vga_strip_flush(const vga_strip_t *strip, uint32_t x_word) {
+    uint32_t x_byte = x_word * 4u;
+
+    if (x_word >= VGA_WIDTH_WORDS) {
+        return;
+    }
+    vga_dma_wait();
+    flush_plane(strip->r, VGA_RED_BASE, x_byte);
+    flush_plane(strip->g, VGA_GREEN_BASE, x_byte);
+    flush_plane(strip->b, VGA_BLUE_BASE, x_byte);
+}
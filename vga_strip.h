@@ -0,0 +1,61 @@
+#ifndef VGA_STRIP_H
+#define VGA_STRIP_H
+
+#include <stdint.h>
+#include "vga_driver.h"
+
+/*
+ * Column strip buffer for column-oriented renderers (raycasters, vertical
+ * bar graphs).
+ *
+ * Drawing a column straight to VGA memory costs one strided byte store per
+ * row and plane (vga_write_rgb_column_bytes_fast). Instead, render 8 pixel
+ * columns into a strip held column-major in RAM, packed 8 rows per word:
+ * pixel (col, y) is nibble y % 8 of word y / 8 of that column. On flush
+ * each 8x8 block of nibbles is transposed with SWAR mask/shift swaps into
+ * row words, and every row of the strip goes out as one SW per plane.
+ *
+ * RAM: 8 columns x 15 words x 3 planes = 1440 bytes.
+ */
+
+#define VGA_STRIP_COLUMNS   8u
+#define VGA_STRIP_WORDS     (VGA_HEIGHT / 8u)
+
+typedef struct {
+    uint32_t r[VGA_STRIP_COLUMNS][VGA_STRIP_WORDS];
+    uint32_t g[VGA_STRIP_COLUMNS][VGA_STRIP_WORDS];
+    uint32_t b[VGA_STRIP_COLUMNS][VGA_STRIP_WORDS];
+} vga_strip_t;
+
+// Fill the whole strip with one color
+void vga_strip_clear(vga_strip_t *strip, Color color);
+
+// Solid vertical run in strip column col (0..7), rows [y_start, y_end)
+void vga_strip_vline(vga_strip_t *strip, uint32_t col, uint32_t y_start, uint32_t y_end, Color color);
+
+// Arbitrary per-row 4-bit values (e.g. a scaled texture column), rows
+// [y_start, y_start + count); channel arrays hold one value per row
+void vga_strip_column(
+    vga_strip_t *strip,
+    uint32_t col,
+    uint32_t y_start,
+    const uint8_t *restrict red_col,
+    const uint8_t *restrict green_col,
+    const uint8_t *restrict blue_col,
+    uint32_t count
+);
+
+// Transpose and write the strip to frame-buffer pixels [8 * x_word, 8 * x_word + 8)
+void vga_strip_flush(const vga_strip_t *strip, uint32_t x_word);
+
+// Set one pixel (slow path; prefer vline/column)
+static inline void vga_strip_put(vga_strip_t *strip, uint32_t col, uint32_t y, Color color) {
+    uint32_t sh = (y & 7u) * 4u;
+    uint32_t m = 0x0Fu << sh;
+    uint32_t k = y >> 3;
+    strip->r[col][k] = (strip->r[col][k] & ~m) | ((uint32_t)(color.r & 0x0Fu) << sh);
+    strip->g[col][k] = (strip->g[col][k] & ~m) | ((uint32_t)(color.g & 0x0Fu) << sh);
+    strip->b[col][k] = (strip->b[col][k] & ~m) | ((uint32_t)(color.b & 0x0Fu) << sh);
+}
+
+#endif